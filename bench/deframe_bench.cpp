@@ -0,0 +1,203 @@
+/**
+ * @file deframe_bench.cpp
+ * @brief Sync marker search and deframing throughput, and a check that reads cut anywhere deframe the same.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Reports, in MB/s of input:
+ *
+ *   search    gs_asm_find(...) (vector) and gs_asm_find_scalar(...) over
+ *             random bytes with no sync marker, the cost of hunting for sync.
+ *   deframe   gs_deframe(...) over a CADU stream, with and without the CRC.
+ *
+ * Then deframes a stream with some corrupted frames, delivered in reads of
+ * random length, and checks every frame comes out once, in order, with the
+ * corrupted ones counted and dropped. Exits non-zero if not.
+ *
+ * make deframe_bench
+ * Usage: deframe_bench.out [MB]   (default 64; 1-2 MB keeps the input in cache, as the RX buffer is)
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gs_deframe.hpp"
+#include "gs_crc.hpp"
+
+#define BENCH_FRAME_LEN GS_DEFRAME_DEFAULT_LEN
+#define BENCH_READ_MAX 65536
+#define BENCH_ERROR_EVERY 97 // Every 97th frame is corrupted in the check.
+#define BENCH_TOTAL_MB 512    // Each throughput figure covers at least this much input.
+
+static uint64_t bench_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t bench_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Fills buf with back-to-back CADUs, frame n starting with n; returns the number of frames.
+ *
+ */
+static size_t bench_cadus(uint8_t *buf, size_t len, bool corrupt)
+{
+    const size_t cadu_len = GS_CCSDS_ASM_LEN + BENCH_FRAME_LEN;
+    size_t n = 0;
+    for (; (n + 1) * cadu_len <= len; n++)
+    {
+        uint8_t *cadu = buf + n * cadu_len;
+        uint8_t *frame = cadu + GS_CCSDS_ASM_LEN;
+        cadu[0] = 0x1A;
+        cadu[1] = 0xCF;
+        cadu[2] = 0xFC;
+        cadu[3] = 0x1D;
+        uint64_t seq = n;
+        memcpy(frame, &seq, sizeof(seq));
+        memset(frame + sizeof(seq), (uint8_t)n, BENCH_FRAME_LEN - sizeof(seq) - 2);
+        uint16_t crc = gs_crc16(GS_CRC16_INIT, frame, BENCH_FRAME_LEN - 2);
+        frame[BENCH_FRAME_LEN - 2] = crc >> 8;
+        frame[BENCH_FRAME_LEN - 1] = crc & 0xFF;
+        if (corrupt && n % BENCH_ERROR_EVERY == BENCH_ERROR_EVERY - 1)
+        {
+            frame[100] ^= 0x80;
+        }
+    }
+    return n;
+}
+
+static size_t bench_reps(size_t len)
+{
+    size_t reps = ((size_t)BENCH_TOTAL_MB << 20) / len;
+    return reps > 0 ? reps : 1;
+}
+
+static double bench_search(const uint8_t *(*find)(const uint8_t *, size_t), const uint8_t *buf, size_t len)
+{
+    size_t reps = bench_reps(len);
+    uint64_t start = bench_now_ns();
+    for (size_t r = 0; r < reps; r++)
+    {
+        for (size_t off = 0; off < len; off += BENCH_READ_MAX)
+        {
+            size_t n = len - off < BENCH_READ_MAX ? len - off : BENCH_READ_MAX;
+            if (find(buf + off, n) != NULL)
+            {
+                printf("Unexpected sync marker in random data.\n");
+            }
+        }
+    }
+    return reps * len / ((bench_now_ns() - start) / 1e9) / 1e6;
+}
+
+static double bench_deframe(bool crc, const uint8_t *buf, size_t len, uint8_t *out)
+{
+    gs_deframe_config_t config = {GS_DEFRAME_KEEP, BENCH_FRAME_LEN, crc};
+    static gs_deframe_t deframe;
+    gs_deframe_init(&deframe, &config);
+
+    size_t reps = bench_reps(len);
+    uint64_t start = bench_now_ns();
+    for (size_t r = 0; r < reps; r++)
+    {
+        for (size_t off = 0; off < len; off += BENCH_READ_MAX)
+        {
+            size_t n = len - off < BENCH_READ_MAX ? len - off : BENCH_READ_MAX;
+            gs_deframe(&deframe, buf + off, n, out);
+        }
+    }
+    return reps * len / ((bench_now_ns() - start) / 1e9) / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    size_t mb = argc > 1 ? atoi(argv[1]) : 64;
+    if (mb < 1)
+    {
+        mb = 1;
+    }
+    size_t len = mb << 20;
+    uint8_t *buf = (uint8_t *)malloc(len);
+    uint8_t *out = (uint8_t *)malloc(BENCH_READ_MAX + BENCH_FRAME_LEN);
+    if (buf == NULL || out == NULL)
+    {
+        return 1;
+    }
+
+    uint32_t rng = 1;
+    for (size_t i = 0; i < len; i++)
+    {
+        buf[i] = bench_rand(&rng);
+    }
+    // Random data may hold a marker by chance; break any up.
+    for (const uint8_t *p = buf; (p = gs_asm_find_scalar(p, buf + len - p)) != NULL; p++)
+    {
+        buf[p - buf] = 0;
+    }
+
+    printf("%zu MB, %d byte frames, read size %d, vector search: %s.\n", mb, BENCH_FRAME_LEN, BENCH_READ_MAX, gs_asm_find_name());
+    printf("%-24s %9.0f MB/s\n", "search (vector)", bench_search(gs_asm_find, buf, len));
+    printf("%-24s %9.0f MB/s\n", "search (scalar)", bench_search(gs_asm_find_scalar, buf, len));
+
+    size_t frames = bench_cadus(buf, len, false);
+    printf("%-24s %9.0f MB/s\n", "deframe, no CRC", bench_deframe(false, buf, len, out));
+    printf("%-24s %9.0f MB/s\n", "deframe, CRC", bench_deframe(true, buf, len, out));
+
+    // Reads of random length, cutting CADUs (and sync markers) anywhere.
+    frames = bench_cadus(buf, len, true);
+    gs_deframe_config_t config = {GS_DEFRAME_DROP, BENCH_FRAME_LEN, true};
+    static gs_deframe_t deframe;
+    gs_deframe_init(&deframe, &config);
+    uint64_t next = 0;
+    bool ok = true;
+    for (size_t off = 0; off < len && ok;)
+    {
+        size_t n = 1 + bench_rand(&rng) % BENCH_READ_MAX;
+        n = len - off < n ? len - off : n;
+        size_t got = gs_deframe(&deframe, buf + off, n, out);
+        for (size_t f = 0; f < got; f += BENCH_FRAME_LEN)
+        {
+            if (next % BENCH_ERROR_EVERY == BENCH_ERROR_EVERY - 1)
+            {
+                next++; // Dropped.
+            }
+            uint64_t seq;
+            memcpy(&seq, out + f, sizeof(seq));
+            if (seq != next)
+            {
+                printf("Frame %llu came out where %llu was expected.\n", (unsigned long long)seq, (unsigned long long)next);
+                ok = false;
+                break;
+            }
+            next++;
+        }
+        off += n;
+    }
+    uint64_t corrupted = frames / BENCH_ERROR_EVERY;
+    if (deframe.stats.frames != frames || deframe.stats.crc_errors != corrupted)
+    {
+        printf("Found %llu frames with %llu CRC errors, expected %zu with %llu.\n", (unsigned long long)deframe.stats.frames,
+               (unsigned long long)deframe.stats.crc_errors, frames, (unsigned long long)corrupted);
+        ok = false;
+    }
+    printf("%zu frames in random reads, %llu corrupted and dropped, %llu bytes out of sync: %s\n", frames,
+           (unsigned long long)deframe.stats.crc_errors, (unsigned long long)deframe.stats.skipped, ok ? "PASS" : "FAIL");
+
+    free(buf);
+    free(out);
+    return ok ? 0 : 1;
+}
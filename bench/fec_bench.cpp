@@ -0,0 +1,303 @@
+/**
+ * @file fec_bench.cpp
+ * @brief Reed-Solomon decoding throughput against synthetic noisy codeblocks.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Builds CCSDS codeblocks (1115 byte frames, interleave 5, dual basis,
+ * randomized; 1275 bytes each) and reports, in MB/s of codeblocks:
+ *
+ *   syndromes  gs_rs_syndromes(...) (vector) and gs_rs_syndromes_scalar(...)
+ *              over clean codewords, all a decoder does on a clean link.
+ *   decode     gs_fec_decode(...) on one thread at a range of byte error
+ *              rates, with the symbols corrected and codewords given up on;
+ *              every frame whose codewords all decoded is checked against
+ *              the original.
+ *   pool       The same through a gs_fec_t with 1, 2 and 4 decoder threads,
+ *              fed receive-sized buffers, with the frames checked to come
+ *              out whole and in order.
+ *
+ * make fec_bench
+ * Usage: fec_bench.out [MB]   (default 32)
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "gs_fec.hpp"
+#include "gs_rs.hpp"
+#include "gs_crc.hpp"
+#include "gs_bufpool.hpp"
+#include "gs_pipeline.hpp"
+#include "gs_config.hpp"
+
+#define BENCH_FRAME_LEN GS_DEFRAME_DEFAULT_LEN
+#define BENCH_BLOCKS_PER_BUF 50 // About 64 KB, one receive buffer.
+
+static const double bench_error_rates[] = {0, 1e-3, 1e-2, 3e-2, 6e-2};
+static const int bench_threads[] = {1, 2, 4};
+
+static gs_fec_config_t bench_config = {true, GS_FEC_DEFAULT_INTERLEAVE, true, true, 1};
+
+static uint64_t bench_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t bench_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static double bench_uniform(uint32_t *state)
+{
+    return bench_rand(state) / 4294967296.0;
+}
+
+/**
+ * @brief Frame n: its number, random bytes and a FECF.
+ *
+ */
+static void bench_frame(uint8_t *frame, uint64_t n, uint32_t *rng)
+{
+    memcpy(frame, &n, sizeof(n));
+    for (size_t i = sizeof(n); i < BENCH_FRAME_LEN - 2; i++)
+    {
+        frame[i] = bench_rand(rng);
+    }
+    uint16_t crc = gs_crc16(GS_CRC16_INIT, frame, BENCH_FRAME_LEN - 2);
+    frame[BENCH_FRAME_LEN - 2] = crc >> 8;
+    frame[BENCH_FRAME_LEN - 1] = crc & 0xFF;
+}
+
+static void bench_noise(uint8_t *data, size_t len, double rate, uint32_t *rng)
+{
+    if (rate <= 0)
+    {
+        return;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        if (bench_uniform(rng) < rate)
+        {
+            data[i] ^= 1 + bench_rand(rng) % 255;
+        }
+    }
+}
+
+static double bench_syndromes(void (*fn)(const uint8_t *, size_t, int, bool, uint8_t *), const uint8_t *blocks, size_t num_blocks, size_t block_len)
+{
+    int interleave = bench_config.interleave;
+    int pad = GS_RS_K - BENCH_FRAME_LEN / interleave;
+    uint8_t syndromes[GS_RS_PARITY];
+    uint8_t any = 0;
+    uint64_t start = bench_now_ns();
+    for (size_t b = 0; b < num_blocks; b++)
+    {
+        for (int k = 0; k < interleave; k++)
+        {
+            fn(blocks + b * block_len + k, interleave, pad, true, syndromes);
+            any |= syndromes[0];
+        }
+    }
+    double mbps = num_blocks * block_len / ((bench_now_ns() - start) / 1e9) / 1e6;
+    if (any != 0)
+    {
+        printf("Clean codeword with a nonzero syndrome.\n");
+    }
+    return mbps;
+}
+
+typedef struct
+{
+    gs_stage_t *stage;
+    uint64_t frames;
+    size_t expected;
+    bool in_order;
+} bench_sink_t;
+
+static void *bench_sink(void *args)
+{
+    bench_sink_t *sink = (bench_sink_t *)args;
+    while (sink->frames < sink->expected)
+    {
+        gs_buf_t *buf = gs_stage_pop(sink->stage, 1000);
+        if (buf == NULL)
+        {
+            break;
+        }
+        for (ssize_t off = 0; off + BENCH_FRAME_LEN <= buf->len; off += BENCH_FRAME_LEN)
+        {
+            uint64_t n;
+            memcpy(&n, buf->data + off, sizeof(n));
+            sink->in_order = sink->in_order && n == sink->frames;
+            sink->frames++;
+        }
+        gs_buf_release(buf);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Feeds blocks through a decoder pool; returns MB/s, or 0 if frames were lost or reordered.
+ *
+ */
+static double bench_pool(int threads, const uint8_t *blocks, size_t num_blocks, size_t block_len)
+{
+    gs_fec_config_t config = bench_config;
+    config.threads = threads;
+    gs_deframe_config_t frame = {GS_DEFRAME_KEEP, BENCH_FRAME_LEN, true};
+
+    static gs_bufpool_t pool[1];
+    static gs_stage_t out[1];
+    static gs_fec_t fec[1];
+    if (gs_bufpool_init(pool, GS_FEC_QUEUE_DEPTH * 2, BENCH_BLOCKS_PER_BUF * block_len) < 0 ||
+        gs_stage_init(out, "Bench", GS_FEC_QUEUE_DEPTH * 2, GS_STAGE_BLOCK, 1000) < 0 ||
+        gs_fec_init(fec, &config, &frame, out, 0) <= 0)
+    {
+        printf("Could not set up a decoder pool.\n");
+        return 0;
+    }
+
+    bench_sink_t sink = {out, 0, num_blocks, true};
+    pthread_t sink_tid;
+    pthread_create(&sink_tid, NULL, bench_sink, &sink);
+
+    uint64_t start = bench_now_ns();
+    for (size_t b = 0; b < num_blocks; b += BENCH_BLOCKS_PER_BUF)
+    {
+        size_t n = num_blocks - b < BENCH_BLOCKS_PER_BUF ? num_blocks - b : BENCH_BLOCKS_PER_BUF;
+        gs_buf_t *buf;
+        while ((buf = gs_bufpool_acquire(pool, n * block_len)) == NULL || buf->pool == NULL)
+        {
+            // Only pool buffers, so the feeder waits on the decoders instead of outrunning them.
+            if (buf != NULL)
+            {
+                gs_buf_release(buf);
+            }
+            struct timespec ts = {0, 20000};
+            nanosleep(&ts, NULL);
+        }
+        memcpy(buf->data, blocks + b * block_len, n * block_len);
+        buf->len = n * block_len;
+        while (gs_fec_submit(fec, buf) < 0)
+        {
+            struct timespec ts = {0, 20000};
+            nanosleep(&ts, NULL);
+        }
+        gs_buf_release(buf);
+    }
+    pthread_join(sink_tid, NULL);
+    double mbps = num_blocks * block_len / ((bench_now_ns() - start) / 1e9) / 1e6;
+
+    // Full-queue retries above are not losses.
+    fec->dropped = 0;
+    gs_fec_destroy(fec);
+    gs_stage_destroy(out);
+    gs_bufpool_destroy(pool);
+    return sink.frames == num_blocks && sink.in_order ? mbps : 0;
+}
+
+int main(int argc, char **argv)
+{
+    setenv("HAYSTACK_LOG_LEVEL", "1", 0);
+
+    size_t mb = argc > 1 ? atoi(argv[1]) : 32;
+    if (mb < 1)
+    {
+        mb = 1;
+    }
+    size_t block_len = gs_fec_block_len(&bench_config, BENCH_FRAME_LEN);
+    size_t num_blocks = (mb << 20) / block_len;
+    uint8_t *clean = (uint8_t *)malloc(num_blocks * block_len);
+    uint8_t *noisy = (uint8_t *)malloc(num_blocks * block_len);
+    uint8_t *frames = (uint8_t *)malloc(num_blocks * BENCH_FRAME_LEN);
+    bool *decoded = (bool *)malloc(num_blocks * sizeof(bool));
+    if (clean == NULL || noisy == NULL || frames == NULL || decoded == NULL)
+    {
+        return 1;
+    }
+
+    uint32_t rng = 1;
+    for (size_t b = 0; b < num_blocks; b++)
+    {
+        bench_frame(clean + b * block_len, b, &rng);
+        memcpy(frames + b * BENCH_FRAME_LEN, clean + b * block_len, BENCH_FRAME_LEN);
+        gs_fec_encode(&bench_config, clean + b * block_len, BENCH_FRAME_LEN);
+    }
+
+    printf("%zu codeblocks of %zu bytes (%d byte frames, interleave %d), syndromes with %s.\n",
+           num_blocks, block_len, BENCH_FRAME_LEN, bench_config.interleave, gs_rs_syndromes_name());
+
+    // Syndromes are taken after derandomizing, as gs_fec_decode(...) does.
+    memcpy(noisy, clean, num_blocks * block_len);
+    for (size_t b = 0; b < num_blocks; b++)
+    {
+        gs_ccsds_randomize(noisy + b * block_len, block_len);
+    }
+    printf("%-28s %9.1f MB/s\n", "syndromes (vector)", bench_syndromes(gs_rs_syndromes, noisy, num_blocks, block_len));
+    printf("%-28s %9.1f MB/s\n", "syndromes (scalar)", bench_syndromes(gs_rs_syndromes_scalar, noisy, num_blocks, block_len));
+
+    bool ok = true;
+    printf("\n%12s %12s %14s %14s %12s %10s\n", "error rate", "MB/s", "corrected", "uncorrectable", "frames ok", "wrong");
+    for (size_t e = 0; e < sizeof(bench_error_rates) / sizeof(bench_error_rates[0]); e++)
+    {
+        memcpy(noisy, clean, num_blocks * block_len);
+        bench_noise(noisy, num_blocks * block_len, bench_error_rates[e], &rng);
+
+        gs_fec_stats_t stats;
+        memset(&stats, 0x0, sizeof(stats));
+        uint64_t start = bench_now_ns();
+        uint64_t good = 0, wrong = 0;
+        for (size_t b = 0; b < num_blocks; b++)
+        {
+            decoded[b] = gs_fec_decode(&bench_config, noisy + b * block_len, BENCH_FRAME_LEN, &stats) >= 0;
+        }
+        double mbps = num_blocks * block_len / ((bench_now_ns() - start) / 1e9) / 1e6;
+
+        // A codeblock which decoded must give back its frame exactly.
+        for (size_t b = 0; b < num_blocks; b++)
+        {
+            if (decoded[b])
+            {
+                good++;
+                wrong += memcmp(frames + b * BENCH_FRAME_LEN, noisy + b * block_len, BENCH_FRAME_LEN) != 0;
+            }
+        }
+        ok = ok && wrong == 0;
+        printf("%12g %12.1f %14llu %14llu %12llu %10llu\n", bench_error_rates[e], mbps, (unsigned long long)stats.corrected,
+               (unsigned long long)stats.uncorrectable, (unsigned long long)good, (unsigned long long)wrong);
+    }
+
+    // Moderate noise for the pool: every codeword has errors to correct.
+    memcpy(noisy, clean, num_blocks * block_len);
+    bench_noise(noisy, num_blocks * block_len, 1e-2, &rng);
+    printf("\n%-28s %9s\n", "pool, error rate 0.01", "MB/s");
+    for (size_t t = 0; t < sizeof(bench_threads) / sizeof(bench_threads[0]); t++)
+    {
+        double mbps = bench_pool(bench_threads[t], noisy, num_blocks, block_len);
+        char label[32];
+        snprintf(label, sizeof(label), "%d thread(s)", bench_threads[t]);
+        printf("%-28s %9.1f%s\n", label, mbps, mbps > 0 ? "" : "  (frames lost or out of order)");
+        ok = ok && mbps > 0;
+    }
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    free(clean);
+    free(noisy);
+    free(frames);
+    free(decoded);
+    return ok ? 0 : 1;
+}
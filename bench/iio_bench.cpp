@@ -0,0 +1,124 @@
+/**
+ * @file iio_bench.cpp
+ * @brief Per-attribute versus batched radio attribute latency.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Times a full status read (and a write-back of the current tuning) done
+ * with the individual radio_get_* / radio_set_* operations against the same
+ * work done with radio_read_attrs / radio_write_attrs.
+ *
+ * make iio_bench      Against the AD9361; HAYSTACK_IIO_URI or IIOD_REMOTE
+ *                     select a networked context.
+ * make iio_bench_sim  Against the simulated radio; set
+ *                     HAYSTACK_SIM_IIO_LATENCY_US to model a round trip.
+ *
+ * Usage: iio_bench.out [iterations]
+ *
+ * The write pass rewrites the radio's current values, which still retunes
+ * the LO; do not run it against a radio that is receiving.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include "gs_haystack.hpp"
+#include "meb_debug.hpp"
+
+#define BENCH_READ_MASK (GS_RADIO_ALL & ~GS_RADIO_TX_GAIN)
+#define BENCH_WRITE_MASK (GS_RADIO_RX_LO | GS_RADIO_SAMP | GS_RADIO_RX_BW | GS_RADIO_RX_GAINMODE)
+
+typedef int (*bench_read_fn)(gs_chain_t *chain, gs_radio_attrs_t *attrs, uint32_t mask);
+typedef int (*bench_write_fn)(gs_chain_t *chain, const gs_radio_attrs_t *attrs, uint32_t mask);
+
+static inline uint64_t bench_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_report(const char *name, uint64_t *samples, int n, uint32_t done, uint32_t mask)
+{
+    std::sort(samples, samples + n);
+    uint64_t total = 0;
+    for (int i = 0; i < n; i++)
+    {
+        total += samples[i];
+    }
+    printf("%-16s %10.1f %10.1f %10.1f %10.1f   %s\n", name, total / 1e3 / n, samples[n / 2] / 1e3, samples[(n * 99) / 100] / 1e3,
+           samples[n - 1] / 1e3, done == mask ? "ok" : "INCOMPLETE");
+}
+
+int main(int argc, char **argv)
+{
+    int iters = argc > 1 ? atoi(argv[1]) : 200;
+    if (iters < 1)
+    {
+        iters = 1;
+    }
+
+    static gs_chain_t chain[1];
+#ifdef GS_BACKEND_SIM
+    chain->backend = &gs_backend_sim;
+#else
+    chain->backend = &gs_backend_hw;
+#endif
+    if (chain->backend->radio_init(chain) < 0)
+    {
+        dbprintlf(FATAL "Radio initialization failure.");
+        return -1;
+    }
+    meb_log_flush();
+
+    uint64_t *samples = (uint64_t *)malloc(iters * sizeof(uint64_t));
+    gs_radio_attrs_t attrs[1];
+    memset(attrs, 0x0, sizeof(attrs));
+
+    printf("%s backend, %d iterations, microseconds\n", chain->backend->name, iters);
+    printf("%-16s %10s %10s %10s %10s\n", "", "mean", "p50", "p99", "max");
+
+    struct
+    {
+        const char *name;
+        bench_read_fn fn;
+    } reads[] = {{"read each", gs_radio_read_each}, {"read batched", chain->backend->radio_read_attrs}};
+    for (auto &r : reads)
+    {
+        uint32_t done = 0;
+        for (int i = 0; i < iters; i++)
+        {
+            uint64_t start = bench_now_ns();
+            done = r.fn(chain, attrs, BENCH_READ_MASK);
+            samples[i] = bench_now_ns() - start;
+        }
+        bench_report(r.name, samples, iters, done, BENCH_READ_MASK);
+    }
+
+    // Write back exactly what was read.
+    struct
+    {
+        const char *name;
+        bench_write_fn fn;
+    } writes[] = {{"write each", gs_radio_write_each}, {"write batched", chain->backend->radio_write_attrs}};
+    for (auto &w : writes)
+    {
+        uint32_t done = 0;
+        for (int i = 0; i < iters; i++)
+        {
+            uint64_t start = bench_now_ns();
+            done = w.fn(chain, attrs, BENCH_WRITE_MASK);
+            samples[i] = bench_now_ns() - start;
+        }
+        bench_report(w.name, samples, iters, done, BENCH_WRITE_MASK);
+    }
+
+    free(samples);
+    chain->backend->radio_destroy(chain);
+    return 0;
+}
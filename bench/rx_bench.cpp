@@ -0,0 +1,487 @@
+/**
+ * @file rx_bench.cpp
+ * @brief Throughput and latency of the X-Band receive path, modem to server.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Runs the real receive worker and gs_xband_forward_thread against the
+ * simulated modem, with a local TCP sink standing in for the GS server. The
+ * sink parses the DATA frames and takes each packet's modem receive time
+ * from bytes 8-15 (see gs_backend_sim.cpp).
+ *
+ * Sweeps packet size, packet rate (0 = as fast as the modem is read) and sink
+ * slowness (a sleep after every frame, so the TCP window and then the
+ * forward queue fill up), and reports for each point:
+ *
+ *   Mbit/s     Payload delivered to the sink over the run.
+ *   p50..p999  Per-packet latency, modem receive to sink, in microseconds.
+ *   cpu ns/B   CPU time of the RX and forward threads per byte received.
+ *   drops      Packets dropped by the forward queue or failed sends.
+ *   no buf     Packets dropped because the buffer pool was empty.
+ *
+ * Each point is one arm / disarm pass of the worker. After the sweep it arms
+ * and disarms BENCH_ARM_CYCLES more times with the modem running flat out and
+ * reports the rx_arm and rx_disarm histograms (worker waiting on the modem /
+ * parked) and the time from arm to the first packet at the sink.
+ *
+ * make bench
+ * Usage: rx_bench.out [seconds per point]   (default 1)
+ *
+ * The HAYSTACK_POOL_*, HAYSTACK_FORWARD_* and HAYSTACK_CAPTURE* settings
+ * apply as in the program itself; capture is off unless HAYSTACK_CAPTURE is set.
+ * The connection keeps the kernel's default socket options, so small packets
+ * at low rates include Nagle / delayed-ACK waits.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include "gs_haystack.hpp"
+#include "gs_netframe.hpp"
+#include "gs_metrics.hpp"
+#include "gs_config.hpp"
+#include "meb_debug.hpp"
+
+#define BENCH_MAX_SAMPLES (1 << 21) // Latency samples kept per point; later packets are counted but not timed.
+#define BENCH_STALL_SEC 2           // Give up on the sink catching up after a point if it stops making progress for this long.
+#define BENCH_ARM_CYCLES 200
+#define BENCH_ARM_TIMEOUT_MS 1000 // Per wait for the worker or the sink during the arm cycles.
+
+static const ssize_t bench_sizes[] = {512, 4096, 32768};
+static const double bench_rates[] = {1000, 10000, 0};
+static const int bench_sink_delays_us[] = {0, 200};
+
+typedef struct
+{
+    int fd;
+    std::atomic<int> delay_us;
+    std::atomic<bool> running;
+
+    // Reset by main between points, while nothing is in flight.
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> bytes;
+    uint64_t last_ns;
+    uint64_t *samples; // BENCH_MAX_SAMPLES latencies, ns.
+} bench_sink_t;
+
+static uint64_t bench_clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) < 0)
+    {
+        return 0;
+    }
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool bench_recv_all(int fd, void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0)
+    {
+        ssize_t ret = recv(fd, p, len, MSG_WAITALL);
+        if (ret < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ret <= 0)
+        {
+            return false;
+        }
+        p += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+static void *bench_sink_thread(void *args)
+{
+    bench_sink_t *sink = (bench_sink_t *)args;
+    size_t cap = bench_sizes[sizeof(bench_sizes) / sizeof(bench_sizes[0]) - 1];
+    uint8_t *payload = (uint8_t *)malloc(cap);
+
+    while (sink->running)
+    {
+        gs_netframe_header_t header;
+        gs_netframe_footer_t footer;
+        if (!bench_recv_all(sink->fd, &header, sizeof(header)))
+        {
+            break;
+        }
+        if (header.guid != GS_NETFRAME_GUID || header.payload_size < 0 || (size_t)header.payload_size > cap)
+        {
+            dbprintlf(RED_FG "Sink lost frame sync (guid 0x%04x, %d bytes).", header.guid, header.payload_size);
+            break;
+        }
+        if (!bench_recv_all(sink->fd, payload, header.payload_size) || !bench_recv_all(sink->fd, &footer, sizeof(footer)))
+        {
+            break;
+        }
+        uint64_t now = bench_clock_ns(CLOCK_MONOTONIC);
+
+        if (header.type == NetType::DATA && header.payload_size >= 16)
+        {
+            // Bytes 0-7 are the sequence number.
+            uint64_t sent_ns;
+            memcpy(&sent_ns, payload + sizeof(uint64_t), sizeof(sent_ns));
+
+            uint64_t n = sink->frames.load(std::memory_order_relaxed);
+            if (n < BENCH_MAX_SAMPLES)
+            {
+                sink->samples[n] = now - sent_ns;
+            }
+            sink->last_ns = now;
+            sink->bytes.fetch_add(header.payload_size, std::memory_order_relaxed);
+            sink->frames.store(n + 1, std::memory_order_release);
+        }
+
+        int delay_us = sink->delay_us;
+        if (delay_us > 0)
+        {
+            usleep(delay_us);
+        }
+    }
+
+    free(payload);
+    return NULL;
+}
+
+/**
+ * @brief Disarms the receive worker and waits until it has parked, so nothing more is queued.
+ *
+ * @return bool false if it did not park within BENCH_ARM_TIMEOUT_MS.
+ */
+static bool bench_disarm(gs_chain_t *chain)
+{
+    // Too large for the stack; only main disarms.
+    static gs_metrics_snapshot_t snap;
+    gs_metrics_snapshot(&snap);
+    uint64_t parked = snap.hist[GS_HIST_RX_DISARM].count;
+
+    gs_xband_rx_disarm(chain);
+    uint64_t deadline = bench_clock_ns(CLOCK_MONOTONIC) + BENCH_ARM_TIMEOUT_MS * 1000000ULL;
+    while (bench_clock_ns(CLOCK_MONOTONIC) < deadline)
+    {
+        gs_metrics_snapshot(&snap);
+        if (snap.hist[GS_HIST_RX_DISARM].count > parked)
+        {
+            return true;
+        }
+        usleep(100);
+    }
+    return false;
+}
+
+/**
+ * @brief Connects a TCP socket to a listener on the loopback and returns both ends.
+ *
+ */
+static int bench_tcp_pair(int *client, int *server)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    memset(&addr, 0x0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0 ||
+        getsockname(listener, (struct sockaddr *)&addr, &addr_len) < 0)
+    {
+        erprintlf(errno);
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+        return -1;
+    }
+
+    *client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (*client < 0 || connect(*client, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        erprintlf(errno);
+        close(listener);
+        return -1;
+    }
+    *server = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+    close(listener);
+    if (*server < 0)
+    {
+        erprintlf(errno);
+        close(*client);
+        return -1;
+    }
+    return 1;
+}
+
+static uint64_t bench_quantile_us(uint64_t *samples, size_t n, double q)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    size_t i = q * (n - 1);
+    std::nth_element(samples, samples + i, samples + n);
+    return samples[i] / 1000;
+}
+
+static void bench_point(gs_chain_t *chain, bench_sink_t *sink, pthread_t forward_tid, ssize_t size, double rate, int delay_us, int seconds)
+{
+    gs_sim_config_t config;
+    gs_sim_config_load(&config);
+    config.pkt_size_min = size;
+    config.pkt_size_max = size;
+    config.pkt_rate = rate;
+    gs_sim_configure(&config);
+
+    sink->delay_us = delay_us;
+    sink->frames = 0;
+    sink->bytes = 0;
+    sink->last_ns = 0;
+
+    clockid_t forward_clock, rx_clock;
+    pthread_getcpuclockid(forward_tid, &forward_clock);
+    pthread_getcpuclockid(chain->rx_tid, &rx_clock);
+
+    gs_metrics_snapshot_t *before = (gs_metrics_snapshot_t *)malloc(sizeof(gs_metrics_snapshot_t));
+    gs_metrics_snapshot_t *after = (gs_metrics_snapshot_t *)malloc(sizeof(gs_metrics_snapshot_t));
+    gs_metrics_snapshot(before);
+    uint32_t exhausted = chain->rx_pool->exhausted;
+    uint64_t pushed = chain->forward->pushed;
+    uint64_t dropped = chain->forward->dropped;
+    uint32_t send_errors = chain->forward_send_errors;
+    uint64_t forward_cpu = bench_clock_ns(forward_clock);
+    uint64_t rx_cpu = bench_clock_ns(rx_clock);
+
+    uint64_t start = bench_clock_ns(CLOCK_MONOTONIC);
+    gs_xband_rx_arm(chain);
+    usleep(seconds * 1000000);
+    if (!bench_disarm(chain))
+    {
+        dbprintlf(RED_FG "The receive worker did not park after disarm.");
+    }
+    rx_cpu = bench_clock_ns(rx_clock) - rx_cpu;
+
+    // Everything queued for the forward stage either reaches the sink or fails to send.
+    uint64_t expected = (chain->forward->pushed - pushed) - (chain->forward_send_errors - send_errors);
+    uint64_t seen = 0;
+    uint64_t deadline = 0;
+    while (sink->frames.load(std::memory_order_acquire) < expected)
+    {
+        uint64_t now = bench_clock_ns(CLOCK_MONOTONIC);
+        if (sink->frames != seen)
+        {
+            seen = sink->frames;
+            deadline = now + BENCH_STALL_SEC * 1000000000ULL;
+        }
+        else if (now > deadline)
+        {
+            break;
+        }
+        usleep(1000);
+    }
+
+    forward_cpu = bench_clock_ns(forward_clock) - forward_cpu;
+    gs_metrics_snapshot(after);
+
+    uint64_t frames = sink->frames.load(std::memory_order_acquire);
+    uint64_t rx_packets = after->counters[GS_CTR_RX_PACKETS] - before->counters[GS_CTR_RX_PACKETS];
+    uint64_t rx_bytes = after->counters[GS_CTR_RX_BYTES] - before->counters[GS_CTR_RX_BYTES];
+    uint64_t drops = (chain->forward->dropped - dropped) + (chain->forward_send_errors - send_errors);
+    double elapsed = ((frames ? sink->last_ns : bench_clock_ns(CLOCK_MONOTONIC)) - start) / 1e9;
+    size_t n = frames < BENCH_MAX_SAMPLES ? frames : BENCH_MAX_SAMPLES;
+
+    printf("%6zd %7.0f %5d %9.1f %9llu %9llu %9llu %8.3f %9llu %9llu %7llu %7u %s\n",
+           size, rate, delay_us,
+           sink->bytes * 8 / elapsed / 1e6,
+           (unsigned long long)bench_quantile_us(sink->samples, n, 0.5),
+           (unsigned long long)bench_quantile_us(sink->samples, n, 0.99),
+           (unsigned long long)bench_quantile_us(sink->samples, n, 0.999),
+           rx_bytes ? (double)(rx_cpu + forward_cpu) / rx_bytes : 0.0,
+           (unsigned long long)rx_packets,
+           (unsigned long long)frames,
+           (unsigned long long)drops,
+           (unsigned)(chain->rx_pool->exhausted - exhausted),
+           frames < expected ? "(sink did not drain)" : "");
+    fflush(stdout);
+
+    free(before);
+    free(after);
+}
+
+/**
+ * @brief Arms and disarms the worker BENCH_ARM_CYCLES times and reports how long each takes.
+ *
+ */
+static void bench_arm_cycles(gs_chain_t *chain, bench_sink_t *sink)
+{
+    gs_sim_config_t config;
+    gs_sim_config_load(&config);
+    config.pkt_size_min = 512;
+    config.pkt_size_max = 512;
+    config.pkt_rate = 0;
+    gs_sim_configure(&config);
+    sink->delay_us = 0;
+
+    gs_metrics_snapshot_t *before = (gs_metrics_snapshot_t *)malloc(sizeof(gs_metrics_snapshot_t));
+    gs_metrics_snapshot_t *after = (gs_metrics_snapshot_t *)malloc(sizeof(gs_metrics_snapshot_t));
+    uint64_t first[BENCH_ARM_CYCLES];
+    int cycles = 0;
+    gs_metrics_snapshot(before);
+
+    for (int i = 0; i < BENCH_ARM_CYCLES; i++)
+    {
+        uint64_t frames = sink->frames;
+        uint64_t start = bench_clock_ns(CLOCK_MONOTONIC);
+        uint64_t deadline = start + BENCH_ARM_TIMEOUT_MS * 1000000ULL;
+        gs_xband_rx_arm(chain);
+        while (sink->frames == frames && bench_clock_ns(CLOCK_MONOTONIC) < deadline)
+        {
+            usleep(10);
+        }
+        if (sink->frames != frames)
+        {
+            first[cycles++] = bench_clock_ns(CLOCK_MONOTONIC) - start;
+        }
+        if (!bench_disarm(chain))
+        {
+            dbprintlf(RED_FG "The receive worker did not park after disarm.");
+            break;
+        }
+        // Let the forward stage drain so the next pass starts from an empty queue.
+        usleep(1000);
+    }
+    gs_metrics_snapshot(after);
+
+    // Only this run's passes; the histograms are cumulative.
+    gs_hist_snapshot_t hist[2];
+    gs_hist_t ids[2] = {GS_HIST_RX_ARM, GS_HIST_RX_DISARM};
+    for (int h = 0; h < 2; h++)
+    {
+        hist[h] = after->hist[ids[h]];
+        hist[h].count -= before->hist[ids[h]].count;
+        for (int b = 0; b < GS_METRICS_BUCKETS; b++)
+        {
+            hist[h].buckets[b] -= before->hist[ids[h]].buckets[b];
+        }
+    }
+
+    printf("\n%d arm / disarm cycles, 512 byte packets as fast as the modem is read:\n", cycles);
+    printf("%-22s %9s %9s %9s\n", "", "p50 us", "p99 us", "max us");
+    printf("%-22s %9.1f %9.1f %9.1f\n", "arm to receiving", gs_metrics_quantile(&hist[0], 0.5) / 1e3,
+           gs_metrics_quantile(&hist[0], 0.99) / 1e3, gs_metrics_quantile(&hist[0], 1.0) / 1e3);
+    printf("%-22s %9.1f %9.1f %9.1f\n", "disarm to parked", gs_metrics_quantile(&hist[1], 0.5) / 1e3,
+           gs_metrics_quantile(&hist[1], 0.99) / 1e3, gs_metrics_quantile(&hist[1], 1.0) / 1e3);
+    printf("%-22s %9.1f %9.1f %9.1f\n", "arm to first at sink", bench_quantile_us(first, cycles, 0.5) * 1.0,
+           bench_quantile_us(first, cycles, 0.99) * 1.0, bench_quantile_us(first, cycles, 1.0) * 1.0);
+    fflush(stdout);
+
+    free(before);
+    free(after);
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 1;
+    if (seconds < 1)
+    {
+        seconds = 1;
+    }
+    // Keep the per-packet log lines and disk writes out of the measurement.
+    setenv("HAYSTACK_LOG_LEVEL", "1", 0);
+    setenv("HAYSTACK_CAPTURE", "0", 0);
+    setenv("HAYSTACK_SPOOL", "0", 0);
+
+    gs_netframe_selftest();
+    if (!gs_netframe_is_direct())
+    {
+        printf("gs_netframe framing does not match NetFrame; the sink cannot parse it.\n");
+        return 1;
+    }
+
+    static global_data_t global[1];
+    global->num_chains = 1;
+    gs_chain_t *chain = &global->chain[0];
+    if (gs_chain_init(chain, global, 0, &gs_backend_sim) < 0)
+    {
+        dbprintlf(FATAL "Could not set up the receive chain.");
+        return 1;
+    }
+
+    if (chain->backend->rx_init(chain) < 0 || chain->backend->radio_init(chain) < 0)
+    {
+        dbprintlf(FATAL "Could not set up the simulated modem.");
+        return 1;
+    }
+    chain->rx_modem_ready = true;
+    chain->radio_ready = true;
+    chain->PLL_ready = true;
+
+    bench_sink_t sink[1];
+    sink->samples = (uint64_t *)malloc(BENCH_MAX_SAMPLES * sizeof(uint64_t));
+    sink->running = true;
+    sink->delay_us = 0;
+
+    int client;
+    if (sink->samples == NULL || bench_tcp_pair(&client, &sink->fd) < 0)
+    {
+        return 1;
+    }
+    global->network_data = new NetDataClient(NetPort::HAYSTACK, 1);
+    global->network_data->socket = client;
+    global->network_data->connection_ready = true;
+
+    pthread_t sink_tid;
+    pthread_create(&sink_tid, NULL, bench_sink_thread, sink);
+    chain->forward_running = true;
+    pthread_create(&chain->forward_tid, NULL, gs_xband_forward_thread, chain);
+
+    printf("%d s per point, %d pool buffers of %zd bytes, forward queue %u.\n",
+           seconds, chain->rx_pool->count, chain->rx_pool->buf_size, (unsigned)chain->forward->ring.capacity());
+    printf("%6s %7s %5s %9s %9s %9s %9s %8s %9s %9s %7s %7s\n",
+           "size", "rate", "sink", "Mbit/s", "p50 us", "p99 us", "p999 us", "cpu ns/B", "offered", "delivered", "drops", "no buf");
+
+    for (size_t d = 0; d < sizeof(bench_sink_delays_us) / sizeof(bench_sink_delays_us[0]); d++)
+    {
+        for (size_t r = 0; r < sizeof(bench_rates) / sizeof(bench_rates[0]); r++)
+        {
+            for (size_t s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]); s++)
+            {
+                bench_point(chain, sink, chain->forward_tid, bench_sizes[s], bench_rates[r], bench_sink_delays_us[d], seconds);
+            }
+        }
+    }
+
+    bench_arm_cycles(chain, sink);
+
+    chain->forward_running = false;
+    gs_stage_wake(chain->forward);
+    pthread_join(chain->forward_tid, NULL);
+    gs_xband_rx_exit(chain);
+
+    sink->running = false;
+    shutdown(client, SHUT_RDWR);
+    pthread_join(sink_tid, NULL);
+    close(client);
+    close(sink->fd);
+
+    chain->backend->rx_destroy(chain);
+    chain->backend->radio_destroy(chain);
+    gs_chain_destroy(chain);
+    delete global->network_data;
+    free(sink->samples);
+    return 0;
+}
@@ -0,0 +1,370 @@
+/**
+ * @file soak.cpp
+ * @brief Soak test of the command receive path: memory must stay flat.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * A stand-in server thread streams a repeating mix of ACK, NACK, POLL,
+ * XBAND_CONFIG, XBAND_COMMAND (PLL init / disable) and corrupt-CRC frames
+ * over a socketpair, in uneven chunks so frames arrive split. The main thread
+ * receives them exactly as the network reactor does, with gs_netframe_recv,
+ * gs_netframe_next and gs_network_handle_frame against the simulated radio.
+ *
+ * After a warm-up, RSS and the number of malloc/calloc/realloc calls are
+ * recorded; at the end both are compared, and the run fails if anything was
+ * allocated or RSS grew by more than SOAK_RSS_SLACK_KB.
+ *
+ * make soak
+ * Usage: soak.out [frames]   (default 2000000)
+ *
+ * Allocations are counted by wrapping glibc's allocator.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <atomic>
+#include "gs_haystack.hpp"
+#include "gs_netframe.hpp"
+#include "gs_crc.hpp"
+#include "gs_config.hpp"
+#include "meb_debug.hpp"
+
+#define SOAK_DEFAULT_FRAMES 2000000
+#define SOAK_CYCLE 64          // Frames in the repeating mix.
+#define SOAK_RSS_SLACK_KB 64
+#define SOAK_WARMUP_DIV 10     // The first 1/10th of the frames is warm-up.
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t nmemb, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static std::atomic<uint64_t> soak_allocs(0);
+
+extern "C" void *malloc(size_t size)
+{
+    soak_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t nmemb, size_t size)
+{
+    soak_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(nmemb, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    soak_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+typedef struct
+{
+    int fd;
+    uint8_t *stream; // SOAK_CYCLE frames back to back.
+    size_t len;
+    size_t frames_per_cycle;
+    long cycles;
+} soak_server_t;
+
+/**
+ * @brief Resident set size, read with plain open/read so the measurement itself does not allocate.
+ *
+ */
+static long soak_rss_kb()
+{
+    char buf[128];
+    int fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0)
+    {
+        return 0;
+    }
+    buf[len] = '\0';
+
+    long pages = 0, resident = 0;
+    if (sscanf(buf, "%ld %ld", &pages, &resident) != 2)
+    {
+        return 0;
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static size_t soak_frame(uint8_t *out, NetType type, const void *payload, int len, bool corrupt)
+{
+    gs_netframe_header_t header;
+    gs_netframe_footer_t footer;
+    uint16_t crc = gs_crc16(GS_CRC16_INIT, payload, len);
+
+    header.guid = GS_NETFRAME_GUID;
+    header.origin = NetVertex::SERVER;
+    header.destination = NetVertex::HAYSTACK;
+    header.type = type;
+    header.netstat = 0;
+    header.payload_size = len;
+    header.crc1 = corrupt ? crc ^ 0x5a5a : crc;
+    footer.crc2 = header.crc1;
+    footer.termination = GS_NETFRAME_TERMINATOR;
+
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), payload, len);
+    memcpy(out + sizeof(header) + len, &footer, sizeof(footer));
+    return sizeof(header) + len + sizeof(footer);
+}
+
+/**
+ * @brief Builds the repeating frame mix; returns the number of valid frames in it.
+ *
+ */
+static size_t soak_build_cycle(soak_server_t *server)
+{
+    server->stream = (uint8_t *)malloc(SOAK_CYCLE * GS_NETFRAME_RX_SIZE);
+    server->len = 0;
+    size_t valid = 0;
+
+    for (int i = 0; i < SOAK_CYCLE; i++)
+    {
+        uint8_t *out = server->stream + server->len;
+        switch (i % 8)
+        {
+        case 0:
+        case 4:
+        {
+            phy_config_t config;
+            memset(&config, 0x0, sizeof(config));
+            config.mode = FDD;
+            config.LO = 2400000000LL + (i % 16) * 1000000LL;
+            config.samp = 10000000;
+            config.bw = i % 16 ? 8000000 : 6000000;
+            snprintf(config.curr_gainmode, sizeof(config.curr_gainmode), "%s", i % 16 ? "slow_attack" : "fast_attack");
+            server->len += soak_frame(out, NetType::XBAND_CONFIG, &config, sizeof(config), false);
+            break;
+        }
+        case 1:
+        case 5:
+        {
+            XBAND_COMMAND command = i % 8 == 1 ? XBC_INIT_PLL : XBC_DISABLE_PLL;
+            server->len += soak_frame(out, NetType::XBAND_COMMAND, &command, sizeof(command), false);
+            break;
+        }
+        case 2:
+            server->len += soak_frame(out, NetType::ACK, NULL, 0, false);
+            break;
+        case 3:
+            server->len += soak_frame(out, NetType::NACK, NULL, 0, false);
+            break;
+        case 6:
+            server->len += soak_frame(out, NetType::POLL, NULL, 0, false);
+            break;
+        case 7:
+        {
+            uint8_t junk[32];
+            memset(junk, i, sizeof(junk));
+            server->len += soak_frame(out, NetType::XBAND_CONFIG, junk, sizeof(junk), true);
+            continue; // Dropped by gs_netframe_next, not counted.
+        }
+        }
+        valid++;
+    }
+    return valid;
+}
+
+static void *soak_server_thread(void *args)
+{
+    soak_server_t *server = (soak_server_t *)args;
+    // Uneven writes, so frames straddle reads.
+    static const size_t chunks[] = {1, 7, 64, 300, 1000, 1500, 17, 4096};
+    size_t c = 0;
+
+    for (long cycle = 0; cycle < server->cycles; cycle++)
+    {
+        size_t off = 0;
+        while (off < server->len)
+        {
+            size_t n = chunks[c++ % (sizeof(chunks) / sizeof(chunks[0]))];
+            if (n > server->len - off)
+            {
+                n = server->len - off;
+            }
+            ssize_t ret = send(server->fd, server->stream + off, n, MSG_NOSIGNAL);
+            if (ret < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return NULL;
+            }
+            off += ret;
+        }
+    }
+    shutdown(server->fd, SHUT_WR);
+
+    // Exit only once the receiver is finished: thread exit returns this thread's
+    // malloc cache to the arena, which shows up as RSS in the receiver's numbers.
+    uint8_t byte;
+    while (recv(server->fd, &byte, sizeof(byte), 0) > 0)
+    {
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    long frames = argc > 1 ? atol(argv[1]) : SOAK_DEFAULT_FRAMES;
+    // Keep the per-frame log lines out of the measurement.
+    setenv("HAYSTACK_LOG_LEVEL", "1", 0);
+
+    gs_netframe_selftest();
+    if (!gs_netframe_is_direct())
+    {
+        printf("gs_netframe framing does not match NetFrame; nothing to soak.\n");
+        return 1;
+    }
+
+    static global_data_t global[1];
+    global->num_chains = 1;
+    gs_chain_t *chain = &global->chain[0];
+    chain->global = global;
+    chain->backend = &gs_backend_sim;
+    if (chain->backend->radio_init(chain) < 0 || gs_status_init(chain->status) < 0 || gs_radio_config_init(chain->radio_config) < 0)
+    {
+        dbprintlf(FATAL "Could not set up the simulated radio.");
+        return 1;
+    }
+    chain->radio_ready = true;
+    gs_ftr_registry_load(global->ftr, gs_env_str("HAYSTACK_FTR_DIR", GS_FTR_DEFAULT_DIR));
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+    {
+        erprintlf(errno);
+        return 1;
+    }
+    global->network_data = new NetDataClient(NetPort::HAYSTACK, 1);
+    global->network_data->socket = sv[0];
+    global->network_data->connection_ready = true;
+
+    soak_server_t server[1];
+    server->fd = sv[1];
+    server->frames_per_cycle = soak_build_cycle(server);
+    server->cycles = (frames + server->frames_per_cycle - 1) / server->frames_per_cycle;
+    long expected = server->cycles * server->frames_per_cycle;
+    long warmup = expected / SOAK_WARMUP_DIV;
+
+    gs_netframe_rx_t *rx = (gs_netframe_rx_t *)calloc(1, sizeof(gs_netframe_rx_t));
+    pthread_t server_tid;
+    pthread_create(&server_tid, NULL, soak_server_thread, server);
+
+    long handled = 0;
+    long rss_start = 0, rss_end = 0;
+    uint64_t allocs_start = 0, allocs_end = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    // The first call faults in the pages of sscanf(...) and friends; keep that out of the comparison.
+    soak_rss_kb();
+
+    struct pollfd pfd = {sv[0], POLLIN, 0};
+    bool ok = true;
+    while (true)
+    {
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+        {
+            erprintlf(errno);
+            ok = false;
+            break;
+        }
+
+        ssize_t ret = gs_netframe_recv(global->network_data, rx);
+        if (ret == -404)
+        {
+            break;
+        }
+        if (ret < 0)
+        {
+            erprintlf(errno);
+            ok = false;
+            break;
+        }
+
+        const gs_netframe_header_t *header;
+        const uint8_t *payload;
+        int next;
+        while ((next = gs_netframe_next(rx, &header, &payload)) > 0)
+        {
+            gs_network_handle_frame(global, header->type, header->destination, payload, header->payload_size);
+            if (++handled == warmup)
+            {
+                rss_start = soak_rss_kb();
+                allocs_start = soak_allocs.load();
+            }
+            else if (handled == expected)
+            {
+                allocs_end = soak_allocs.load();
+                rss_end = soak_rss_kb();
+            }
+        }
+        if (next < 0)
+        {
+            printf("Stream out of sync after %ld frames.\n", handled);
+            ok = false;
+            break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    shutdown(sv[0], SHUT_WR);
+    pthread_join(server_tid, NULL);
+
+    uint64_t allocs = allocs_end - allocs_start;
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    printf("frames      %ld of %ld (%llu bad CRC dropped)\n", handled, expected, (unsigned long long)rx->bad_crc);
+    printf("rate        %.0f frames/s\n", handled / elapsed);
+    printf("rss         %ld KiB after warm-up, %ld KiB at end\n", rss_start, rss_end);
+    printf("allocations %llu after warm-up\n", (unsigned long long)allocs);
+
+    if (handled != expected || rx->bad_crc != (uint64_t)server->cycles * (SOAK_CYCLE - server->frames_per_cycle))
+    {
+        printf("FAIL: frames lost or miscounted.\n");
+        ok = false;
+    }
+    if (allocs != 0)
+    {
+        printf("FAIL: the command path allocated in steady state.\n");
+        ok = false;
+    }
+    if (rss_end - rss_start > SOAK_RSS_SLACK_KB)
+    {
+        printf("FAIL: RSS grew by %ld KiB.\n", rss_end - rss_start);
+        ok = false;
+    }
+    printf("%s\n", ok ? "PASS" : "FAIL");
+
+    close(sv[0]);
+    close(sv[1]);
+    free(rx);
+    free(server->stream);
+    delete global->network_data;
+    gs_ftr_registry_destroy(global->ftr);
+    gs_radio_config_destroy(chain->radio_config);
+    gs_status_destroy(chain->status);
+    chain->backend->radio_destroy(chain);
+    return ok ? 0 : 1;
+}
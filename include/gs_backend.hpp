@@ -0,0 +1,227 @@
+/**
+ * @file gs_backend.hpp
+ * @brief Pluggable radio / modem / PLL backend used by the Haystack threads.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The hardware backend forwards to rxmodem_*, adradio_* and adf4355_*. The
+ * simulated backend generates packets in software so the RX pipeline can be
+ * run and profiled without the Zynq board. The replay backend wraps either
+ * one and feeds recorded captures in place of the RX modem.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_BACKEND_HPP
+#define GS_BACKEND_HPP
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "libiio.h"
+
+// X-Band receive chains one process can drive (see gs_chain_t in gs_haystack.hpp).
+#define GS_MAX_CHAINS 4
+
+typedef struct gs_chain_t gs_chain_t;
+
+// Attribute bits for radio_read_attrs(...) / radio_write_attrs(...).
+#define GS_RADIO_ENSM_MODE 0x001
+#define GS_RADIO_RX_LO 0x002
+#define GS_RADIO_SAMP 0x004
+#define GS_RADIO_RX_BW 0x008
+#define GS_RADIO_RX_GAINMODE 0x010
+#define GS_RADIO_RX_GAIN 0x020
+#define GS_RADIO_RSSI 0x040
+#define GS_RADIO_TEMP 0x080
+#define GS_RADIO_TX_GAIN 0x100
+#define GS_RADIO_ALL 0x1ff
+
+/**
+ * @brief A set of AD9361 attributes read or written together.
+ *
+ * Only the fields named by the accompanying GS_RADIO_* mask are meaningful.
+ *
+ */
+typedef struct
+{
+    char ensm_mode[16];   // sleep, fdd or tdd
+    long long rx_lo;      // Hz
+    long long samp;       // Hz
+    long long rx_bw;      // Hz
+    char rx_gainmode[16]; // fast_attack, slow_attack, ...
+    double rx_gain;       // dB
+    double rssi;          // dB
+    long long temp;       // millidegrees C
+    double tx_gain;       // dB
+} gs_radio_attrs_t;
+
+/**
+ * @brief Table of operations for one X-Band receive chain.
+ *
+ * Every operation is given the chain it acts on; one table serves all chains.
+ * Return values follow the underlying hardware libraries (negative on error).
+ *
+ */
+typedef struct
+{
+    const char *name;
+
+    // RX modem.
+    int (*rx_init)(gs_chain_t *chain);
+    int (*rx_start)(gs_chain_t *chain);
+    ssize_t (*rx_receive)(gs_chain_t *chain);
+    ssize_t (*rx_read)(gs_chain_t *chain, uint8_t *buf, ssize_t size);
+    int (*rx_stop)(gs_chain_t *chain);
+    void (*rx_destroy)(gs_chain_t *chain);
+
+    // AD9361 radio.
+    int (*radio_init)(gs_chain_t *chain);
+    void (*radio_destroy)(gs_chain_t *chain);
+    int (*radio_set_ensm_mode)(gs_chain_t *chain, ensm_mode mode);
+    int (*radio_get_ensm_mode)(gs_chain_t *chain, char *buf, ssize_t len);
+    int (*radio_set_rx_lo)(gs_chain_t *chain, long long freq);
+    int (*radio_get_rx_lo)(gs_chain_t *chain, long long *freq);
+    int (*radio_set_samp)(gs_chain_t *chain, long long samp);
+    int (*radio_get_samp)(gs_chain_t *chain, long long *samp);
+    int (*radio_set_rx_bw)(gs_chain_t *chain, long long bw);
+    int (*radio_get_rx_bw)(gs_chain_t *chain, long long *bw);
+    int (*radio_set_tx_hardwaregain)(gs_chain_t *chain, double gain);
+    int (*radio_get_rx_hardwaregain)(gs_chain_t *chain, double *gain);
+    int (*radio_set_rx_hardwaregainmode)(gs_chain_t *chain, gainmode mode);
+    int (*radio_get_rx_hardwaregainmode)(gs_chain_t *chain, char *buf, ssize_t len);
+    int (*radio_get_rssi)(gs_chain_t *chain, double *rssi);
+    int (*radio_get_temp)(gs_chain_t *chain, long long *temp);
+
+    // Batched forms of the above, one round trip per IIO channel where possible.
+    // Return the GS_RADIO_* bits actually read or written, negative on error.
+    int (*radio_read_attrs)(gs_chain_t *chain, gs_radio_attrs_t *attrs, uint32_t mask);
+    int (*radio_write_attrs)(gs_chain_t *chain, const gs_radio_attrs_t *attrs, uint32_t mask);
+    // Loads and enables FIR taps in the AD9361 .ftr text format.
+    int (*radio_load_filter)(gs_chain_t *chain, const char *ftr, size_t len);
+
+    // ADF4355 PLL.
+    int (*pll_init)(gs_chain_t *chain);
+    int (*pll_set_rx)(gs_chain_t *chain);
+    int (*pll_pw_down)(gs_chain_t *chain);
+    void (*pll_destroy)(gs_chain_t *chain);
+} gs_backend_t;
+
+/**
+ * @brief Settings for the simulated backend.
+ *
+ * Loaded from HAYSTACK_SIM_* environment variables by gs_sim_config_load(...).
+ *
+ */
+typedef struct
+{
+    ssize_t pkt_size_min;   // Smallest generated packet, bytes.
+    ssize_t pkt_size_max;   // Largest generated packet, bytes.
+    double pkt_rate;        // Packets per second, 0 for as fast as possible.
+    double rx_error_rate;   // Probability that a receive fails.
+    double read_error_rate; // Probability that a read comes up short.
+    int iio_latency_us;     // Added to every radio attribute access.
+    int init_latency_ms;    // Added to rx/radio/pll initialization.
+    int init_failures;      // Initializations of each rx/radio/pll that fail before one succeeds.
+    uint32_t seed;          // PRNG seed for sizes, payloads and errors.
+    size_t frame_len;       // If set, packets carry a stream of CCSDS CADUs with frames this long (see gs_deframe.hpp).
+    double frame_error_rate; // Probability that a frame is corrupted, so its CRC fails.
+    bool randomize;          // Whether unencoded frames are XORed with the CCSDS pseudo-random sequence.
+    int fec_interleave;      // If set, frames are sent as RS(255,223) codeblocks interleaved this deep (see gs_fec.hpp).
+    double symbol_error_rate; // Probability that a codeblock byte is corrupted on the way, for the decoders to correct.
+} gs_sim_config_t;
+
+/**
+ * @brief Settings for the replay backend.
+ *
+ * Loaded from HAYSTACK_REPLAY* environment variables by gs_replay_config_load(...).
+ *
+ */
+typedef struct
+{
+    char path[256]; // Directory of captures or one .bin file; empty if not replaying.
+    double speed;   // 1 for recorded timing, 2 for twice as fast, ..., 0 for as fast as possible.
+    bool loop;      // Start over at the end instead of going quiet.
+} gs_replay_config_t;
+
+/**
+ * @brief Backend which talks to the rxmodem, AD9361 and ADF4355 hardware.
+ *
+ */
+extern const gs_backend_t gs_backend_hw;
+
+/**
+ * @brief Software backend; see gs_sim_config_t.
+ *
+ */
+extern const gs_backend_t gs_backend_sim;
+
+/**
+ * @brief radio_read_attrs(...) built from the per-attribute radio_get_* operations.
+ *
+ * For backends without a batched path, and as a baseline for bench/iio_bench.
+ *
+ * @param chain
+ * @param attrs
+ * @param mask GS_RADIO_* bits to read.
+ * @return int GS_RADIO_* bits read.
+ */
+int gs_radio_read_each(gs_chain_t *chain, gs_radio_attrs_t *attrs, uint32_t mask);
+
+/**
+ * @brief radio_write_attrs(...) built from the per-attribute radio_set_* operations.
+ *
+ * RSSI, temperature and RX gain are read-only here and are ignored.
+ *
+ * @param chain
+ * @param attrs
+ * @param mask GS_RADIO_* bits to write.
+ * @return int GS_RADIO_* bits written.
+ */
+int gs_radio_write_each(gs_chain_t *chain, const gs_radio_attrs_t *attrs, uint32_t mask);
+
+/**
+ * @brief Fills in the simulated backend settings from the environment.
+ *
+ * @param config
+ */
+void gs_sim_config_load(gs_sim_config_t *config);
+
+/**
+ * @brief Replaces the settings used by the simulated backend.
+ *
+ * Applies to every chain; chain n seeds its generator with config->seed + n.
+ * Must be called before the RX threads start receiving.
+ *
+ * @param config
+ */
+void gs_sim_configure(const gs_sim_config_t *config);
+
+/**
+ * @brief Fills in one chain's replay settings from the environment.
+ *
+ * HAYSTACK_REPLAY (path), HAYSTACK_REPLAY_SPEED (default 1) and HAYSTACK_REPLAY_LOOP (default 0),
+ * each overridden by HAYSTACK_CHAIN<n>_REPLAY... if set.
+ *
+ * @param config
+ * @param chain
+ */
+void gs_replay_config_load(gs_replay_config_t *config, int chain);
+
+/**
+ * @brief Builds a backend which replays captures in place of the RX modem.
+ *
+ * Capture segments and legacy rxdata<N>.bin files are found and ordered here.
+ * The radio and PLL operations are copied from radio. Called once for each
+ * chain that replays, each with a backend of its own; chains that do not
+ * replay keep using radio.
+ *
+ * @param backend Filled in; must outlive its use.
+ * @param radio Backend whose radio and PLL operations to use.
+ * @param config
+ * @param chain
+ * @return int 1 on success, negative if nothing can be replayed.
+ */
+int gs_backend_replay_init(gs_backend_t *backend, const gs_backend_t *radio, const gs_replay_config_t *config, int chain);
+
+#endif // GS_BACKEND_HPP
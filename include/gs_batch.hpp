@@ -0,0 +1,144 @@
+/**
+ * @file gs_batch.hpp
+ * @brief Packs small received packets into one DATA frame for the server.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Off by default, each packet the forward thread takes is its own DATA frame.
+ * With batching on, it copies packets into the chain's batch instead and
+ * sends the batch as one DATA frame once it holds HAYSTACK_FORWARD_BATCH_BYTES,
+ * or HAYSTACK_FORWARD_BATCH_MS after its first packet arrived, whichever
+ * comes first:
+ *
+ *   HAYSTACK_FORWARD_BATCH_BYTES  Batch size, 0 (default) for a frame per packet
+ *   HAYSTACK_FORWARD_BATCH_MS     Longest a packet waits for others (default 5)
+ *
+ * each settable per chain as HAYSTACK_CHAIN<n>_FORWARD_BATCH_... . A batched
+ * DATA payload is a run of entries, each a 4 byte little-endian length then
+ * that many packet bytes, followed by the chain byte as usual when there are
+ * several chains (see README.md). A packet too large for a batch is sent
+ * alone, as a one-entry batch, so the server can always unpack a DATA
+ * payload the same way; spooled batches are kept and sent as they are.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_BATCH_HPP
+#define GS_BATCH_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GS_BATCH_DEFAULT_MS 5
+#define GS_BATCH_MAX_BYTES (1 << 20)
+#define GS_BATCH_PREFIX_LEN 4
+
+typedef struct
+{
+    size_t bytes; // 0 if batching is off.
+    int max_delay_ms;
+} gs_batch_config_t;
+
+typedef struct
+{
+    gs_batch_config_t config;
+    uint8_t *data; // NULL if batching is off.
+
+    // Only the forward thread touches these, or gs_chain_destroy(...) once it has stopped.
+    size_t len;
+    uint32_t packets;
+    uint64_t deadline_ns; // When the batch goes out however full it is.
+    uint64_t batches;
+    uint64_t batched; // Packets sent or spooled in batches.
+} gs_batch_t;
+
+/**
+ * @brief Reads one chain's HAYSTACK_FORWARD_BATCH_* settings.
+ *
+ * @param config
+ * @param chain
+ */
+void gs_batch_config_load(gs_batch_config_t *config, int chain);
+
+/**
+ * @brief Allocates the batch buffer.
+ *
+ * @param batch
+ * @param config
+ * @return int 1 on success, 0 if batching is off, negative on failure.
+ */
+int gs_batch_init(gs_batch_t *batch, const gs_batch_config_t *config);
+
+/**
+ * @brief Whether batching is on.
+ *
+ */
+static inline bool gs_batch_enabled(const gs_batch_t *batch)
+{
+    return batch->data != NULL;
+}
+
+/**
+ * @brief Whether a len byte packet fits in what is left of the batch.
+ *
+ */
+static inline bool gs_batch_fits(const gs_batch_t *batch, size_t len)
+{
+    return batch->len + GS_BATCH_PREFIX_LEN + len <= batch->config.bytes;
+}
+
+/**
+ * @brief Whether the batch should be sent now: full, or its deadline has passed.
+ *
+ * @param batch
+ * @param now_ns gs_metrics_now_ns()
+ */
+static inline bool gs_batch_due(const gs_batch_t *batch, uint64_t now_ns)
+{
+    return batch->packets > 0 && (batch->len + GS_BATCH_PREFIX_LEN >= batch->config.bytes || now_ns >= batch->deadline_ns);
+}
+
+/**
+ * @brief Appends one packet, which must fit (see gs_batch_fits(...)); the first starts the deadline.
+ *
+ * @param batch
+ * @param data
+ * @param len
+ * @param now_ns gs_metrics_now_ns()
+ */
+void gs_batch_add(gs_batch_t *batch, const uint8_t *data, size_t len, uint64_t now_ns);
+
+/**
+ * @brief Writes the length prefix of a packet sent on its own.
+ *
+ * @param prefix GS_BATCH_PREFIX_LEN bytes.
+ * @param len
+ */
+void gs_batch_prefix(uint8_t *prefix, size_t len);
+
+/**
+ * @brief How long the forward thread may wait for another packet before the batch is due.
+ *
+ * @param batch
+ * @param now_ns gs_metrics_now_ns()
+ * @param idle_ms What to wait with an empty batch.
+ * @return int Milliseconds, rounded up so the wait does not end just short of the deadline.
+ */
+int gs_batch_timeout_ms(const gs_batch_t *batch, uint64_t now_ns, int idle_ms);
+
+/**
+ * @brief Empties the batch once it has been sent or spooled, counting it.
+ *
+ * @param batch
+ */
+void gs_batch_reset(gs_batch_t *batch);
+
+/**
+ * @brief Frees the batch buffer, logging how well packets packed; anything in it must have been sent or spooled.
+ *
+ * @param batch
+ */
+void gs_batch_destroy(gs_batch_t *batch);
+
+#endif // GS_BATCH_HPP
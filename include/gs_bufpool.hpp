@@ -0,0 +1,114 @@
+/**
+ * @file gs_bufpool.hpp
+ * @brief Fixed-size pool of preallocated, cache-aligned receive buffers.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Buffers are reference counted so that each consumer of a received packet
+ * (network send, capture write) releases its own reference, and the buffer
+ * returns to the pool once the last one is done.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_BUFPOOL_HPP
+#define GS_BUFPOOL_HPP
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <pthread.h>
+#include <atomic>
+
+#define GS_BUFPOOL_ALIGN 64
+#define GS_BUFPOOL_DEFAULT_COUNT 32
+#define GS_BUFPOOL_DEFAULT_BUF_SIZE 65536
+
+typedef struct gs_bufpool_t gs_bufpool_t;
+
+/**
+ * @brief Receive conditions recorded alongside each packet.
+ *
+ */
+typedef struct
+{
+    uint64_t timestamp_ns; // CLOCK_REALTIME when the receive completed.
+    uint64_t seq;
+    int32_t rx_status;
+    int64_t LO;
+    int64_t samp;
+    int64_t bw;
+} gs_rx_meta_t;
+
+typedef struct gs_buf_t
+{
+    uint8_t *data;
+    ssize_t len; // Valid bytes.
+    ssize_t cap; // Allocated bytes.
+    gs_rx_meta_t meta;
+    std::atomic<int> refs;
+    gs_bufpool_t *pool; // NULL for an oversize heap allocation.
+    struct gs_buf_t *next;
+} gs_buf_t;
+
+struct gs_bufpool_t
+{
+    gs_buf_t *bufs;
+    uint8_t *mem;
+    int count;
+    ssize_t buf_size;
+
+    pthread_mutex_t lock;
+    gs_buf_t *free_list;
+
+    std::atomic<uint32_t> in_use;
+    std::atomic<uint32_t> high_water;
+    std::atomic<uint32_t> exhausted; // Acquires that found the pool empty, and failed.
+    std::atomic<uint32_t> oversize;  // Acquires larger than buf_size.
+};
+
+/**
+ * @brief Allocates and prefaults all buffers.
+ *
+ * @param pool
+ * @param count Number of buffers.
+ * @param buf_size Size of each buffer; rounded up to GS_BUFPOOL_ALIGN.
+ * @return int 1 on success, negative on failure.
+ */
+int gs_bufpool_init(gs_bufpool_t *pool, int count, ssize_t buf_size);
+
+/**
+ * @brief Takes a buffer holding at least size bytes, with one reference.
+ *
+ * Fails if the pool is empty, so a backlog drops packets instead of growing
+ * the heap; only a size larger than the pool's buffers gets a one-off heap
+ * allocation. Both are counted.
+ *
+ * @param pool
+ * @param size
+ * @return gs_buf_t* NULL if the pool is empty or the oversize allocation fails.
+ */
+gs_buf_t *gs_bufpool_acquire(gs_bufpool_t *pool, ssize_t size);
+
+/**
+ * @brief Adds a reference to a buffer.
+ *
+ * @param buf
+ */
+void gs_buf_ref(gs_buf_t *buf);
+
+/**
+ * @brief Drops a reference, recycling the buffer when none remain.
+ *
+ * @param buf
+ */
+void gs_buf_release(gs_buf_t *buf);
+
+/**
+ * @brief Frees the pool. All buffers must have been released.
+ *
+ * @param pool
+ */
+void gs_bufpool_destroy(gs_bufpool_t *pool);
+
+#endif // GS_BUFPOOL_HPP
@@ -0,0 +1,120 @@
+/**
+ * @file gs_capture.hpp
+ * @brief Asynchronous writer which persists received packets to segment files.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The RX thread hands received buffers to gs_capture_submit(...), which only
+ * pushes a reference into the persist stage's ring. A dedicated thread batches queued packets into a staging
+ * buffer and appends them to large preallocated segment files, rotating to a
+ * new segment by size or age.
+ *
+ * Segments use the indexed container format in gs_capture_store.hpp.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_CAPTURE_HPP
+#define GS_CAPTURE_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <atomic>
+#include "gs_bufpool.hpp"
+#include "gs_capture_store.hpp"
+#include "gs_pipeline.hpp"
+#include "gs_compress.hpp"
+
+#define GS_CAPTURE_DEFAULT_DIR "."
+#define GS_CAPTURE_DEFAULT_PREFIX "rxdata"
+#define GS_CAPTURE_DEFAULT_SEGMENT_MB 256
+#define GS_CAPTURE_DEFAULT_ROTATE_SEC 3600
+#define GS_CAPTURE_DEFAULT_QUEUE_DEPTH 64
+#define GS_CAPTURE_STAGE_SIZE (1 << 20)
+#define GS_CAPTURE_DIRECT_ALIGN 4096
+#define GS_CAPTURE_BATCH 32
+
+typedef struct
+{
+    bool enabled;
+    char dir[256];
+    char prefix[64];
+    size_t segment_size; // Preallocated size, and size at which to rotate.
+    int rotate_sec;      // Rotate segments older than this, 0 to disable.
+    bool direct;         // Open segments with O_DIRECT.
+    int queue_depth;
+    gs_stage_policy_t policy; // When the writer falls behind.
+    int block_ms;
+    gs_compress_config_t compress; // Applied to each segment once it is sealed.
+    int chain;                     // Receive chain, for the writer's scheduling (see gs_rt.hpp).
+} gs_capture_config_t;
+
+typedef struct
+{
+    gs_capture_config_t config;
+
+    // Persist stage: ring from the RX thread to the writer thread.
+    gs_stage_t queue[1];
+    std::atomic<bool> running;
+    pthread_t tid;
+
+    // Compresses sealed segments off the writer thread.
+    gs_compress_t compress[1];
+
+    // Writer thread state.
+    char session[32];
+    char seg_path[512];
+    int fd;
+    int idx_fd;
+    int seg_index;
+    uint64_t seg_written;
+    time_t seg_opened;
+    uint8_t *stage;
+    size_t stage_len;
+    gs_capture_record_t records[GS_CAPTURE_BATCH];
+    int records_len;
+
+    std::atomic<uint64_t> packets;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> write_errors;
+    std::atomic<uint32_t> segments;
+} gs_capture_t;
+
+/**
+ * @brief Fills in capture settings from HAYSTACK_CAPTURE_* environment variables.
+ *
+ * @param config
+ */
+void gs_capture_config_load(gs_capture_config_t *config);
+
+/**
+ * @brief Starts the writer thread.
+ *
+ * @param capture
+ * @param config
+ * @return int 1 on success, 0 if capture is disabled, negative on failure.
+ */
+int gs_capture_init(gs_capture_t *capture, const gs_capture_config_t *config);
+
+/**
+ * @brief Queues a received buffer for writing. Never blocks on disk.
+ *
+ * Takes its own reference to buf; the caller keeps theirs.
+ *
+ * @param capture
+ * @param buf
+ * @return int 1 if queued, 0 if capture is disabled, -1 if the writer was behind and the packet was dropped.
+ */
+int gs_capture_submit(gs_capture_t *capture, gs_buf_t *buf);
+
+/**
+ * @brief Writes out everything queued, closes the segment and stops the writer thread.
+ *
+ * @param capture
+ */
+void gs_capture_destroy(gs_capture_t *capture);
+
+#endif // GS_CAPTURE_HPP
@@ -0,0 +1,149 @@
+/**
+ * @file gs_capture_store.hpp
+ * @brief On-disk capture container format and memory-mapped reader.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * A capture segment is a pair of files written by gs_capture:
+ *
+ *   <prefix>_<UTC start>_<NNNN>.bin  Packet payloads, back to back, append-only.
+ *   <prefix>_<UTC start>_<NNNN>.idx  A gs_capture_index_header_t followed by one
+ *                                    fixed-size gs_capture_record_t per packet.
+ *
+ * All integers are little-endian. Records are in receive order, so timestamps
+ * are non-decreasing unless the wall clock was stepped during the pass.
+ *
+ * Once sealed, the .bin may be replaced by <...>.bin.zst or <...>.bin.lz4
+ * (see gs_compress.hpp); the .idx is kept, its offsets still into the raw
+ * data. The reader opens either form. For a compressed one, the data is an
+ * anonymous mapping which each compressed frame is decompressed into when a
+ * packet in it is first asked for, so a reader touching one packet pays for
+ * one frame; such a reader must not be shared between threads.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_CAPTURE_STORE_HPP
+#define GS_CAPTURE_STORE_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gs_compress.hpp"
+
+#define GS_CAPTURE_INDEX_MAGIC 0x58444948 // "HIDX"
+#define GS_CAPTURE_INDEX_VERSION 1
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size; // sizeof(gs_capture_record_t) when written.
+    uint64_t created_ns;  // CLOCK_REALTIME when the segment was opened.
+    uint32_t segment;     // NNNN from the file name.
+    uint8_t reserved[44];
+} gs_capture_index_header_t;
+
+typedef struct __attribute__((packed))
+{
+    uint64_t timestamp_ns;  // CLOCK_REALTIME when rxmodem_receive returned.
+    uint64_t offset;        // Byte offset of the payload in the .bin file.
+    uint32_t length;        // Payload length.
+    int32_t last_rx_status; // rxmodem_receive return for this packet.
+    int64_t LO;             // RX LO at receive time.
+    int64_t samp;           // Sampling rate at receive time.
+    int64_t bw;             // RX bandwidth at receive time.
+    uint64_t seq;           // Packet number since the process started.
+} gs_capture_record_t;
+
+typedef struct
+{
+    int data_fd;
+    int idx_fd;
+    const uint8_t *data;
+    size_t data_size;
+    const uint8_t *idx;
+    size_t idx_size;
+    const gs_capture_index_header_t *header;
+    const gs_capture_record_t *records;
+    size_t count;
+
+    // Compressed segments only; data is then an anonymous mapping, filled frame by frame.
+    gs_compress_codec_t codec;
+    uint8_t *raw;
+    const uint8_t *packed; // The compressed file.
+    size_t packed_size;
+    gs_compress_frame_t *frames;
+    size_t num_frames;
+    uint8_t *frame_ready; // Per frame, non-zero once decompressed into raw.
+} gs_capture_reader_t;
+
+/**
+ * @brief Callback for gs_capture_reader_scan(...).
+ *
+ * @return int Non-zero stops the scan.
+ */
+typedef int (*gs_capture_scan_cb)(const gs_capture_record_t *record, const uint8_t *payload, void *user);
+
+/**
+ * @brief Builds the index file path that belongs to a segment's .bin, .bin.zst or .bin.lz4 file.
+ *
+ * @param data_path
+ * @param idx_path
+ * @param size
+ * @return int 1 on success, -1 if data_path is not a segment data file or idx_path is too small.
+ */
+int gs_capture_index_path(const char *data_path, char *idx_path, size_t size);
+
+/**
+ * @brief Whether a file name is a segment's data file, raw or compressed.
+ *
+ */
+bool gs_capture_is_data_file(const char *path);
+
+/**
+ * @brief Maps a capture segment and its index read-only.
+ *
+ * Records whose payload lies past the end of the data file, as after a crash
+ * mid-write, are not counted.
+ *
+ * @param reader
+ * @param data_path Path to the segment's .bin, .bin.zst or .bin.lz4 file.
+ * @return int 1 on success, negative on failure (including a codec this build cannot read).
+ */
+int gs_capture_reader_open(gs_capture_reader_t *reader, const char *data_path);
+
+/**
+ * @brief Returns record i, or NULL if out of range.
+ *
+ */
+const gs_capture_record_t *gs_capture_reader_record(const gs_capture_reader_t *reader, size_t i);
+
+/**
+ * @brief Returns a pointer into the mapping for record i's payload, or NULL if out of range or it cannot be decompressed.
+ *
+ */
+const uint8_t *gs_capture_reader_payload(const gs_capture_reader_t *reader, size_t i, uint32_t *len);
+
+/**
+ * @brief Index of the first record at or after timestamp_ns, or count if there is none.
+ *
+ */
+size_t gs_capture_reader_find(const gs_capture_reader_t *reader, uint64_t timestamp_ns);
+
+/**
+ * @brief Calls cb for every record with from_ns <= timestamp < to_ns, in order.
+ *
+ * Stops early at a payload which cannot be decompressed.
+ *
+ * @return size_t Number of records visited.
+ */
+size_t gs_capture_reader_scan(const gs_capture_reader_t *reader, uint64_t from_ns, uint64_t to_ns, gs_capture_scan_cb cb, void *user);
+
+/**
+ * @brief Unmaps and closes the segment.
+ *
+ */
+void gs_capture_reader_close(gs_capture_reader_t *reader);
+
+#endif // GS_CAPTURE_STORE_HPP
@@ -0,0 +1,176 @@
+/**
+ * @file gs_compress.hpp
+ * @brief Compresses sealed capture segments on a small worker pool.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * When gs_capture closes a segment it queues the .bin file here; a worker
+ * then writes <segment>.bin.zst or <segment>.bin.lz4 and, unless told to keep
+ * it, removes the raw file. The .idx file is left as it is; its offsets refer
+ * to the uncompressed data.
+ *
+ * The output is a series of independent zstd or LZ4 frames, each holding
+ * whole packets and about frame_size bytes of input, followed by a skippable
+ * frame with a seek table in the zstd seekable format:
+ *
+ *   u32 0x184D2A5E  u32 size  { u32 compressed, u32 decompressed } x n
+ *   u32 n  u8 0  u32 0x8F92EAB1
+ *
+ * zstd -d and lz4 -d skip that frame and restore the .bin byte for byte; a
+ * reader which wants a packet, or wants to decompress in parallel, reads the
+ * table from the end of the file and decompresses only the frames it needs.
+ * gs_capture_reader_open(...), and so replay, read compressed segments that
+ * way (see gs_capture_store.hpp), given a build with the same codec.
+ *
+ * Each codec is built in only if its library is: make ZSTD=1 and/or LZ4=1.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_COMPRESS_HPP
+#define GS_COMPRESS_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <atomic>
+
+#define GS_COMPRESS_DEFAULT_THREADS 2
+#define GS_COMPRESS_MAX_THREADS 8
+#define GS_COMPRESS_DEFAULT_FRAME_KB 1024
+#define GS_COMPRESS_QUEUE_DEPTH 16 // Sealed segments waiting; more are left uncompressed.
+#define GS_COMPRESS_NICE 10        // Workers run below the receive path.
+
+#define GS_COMPRESS_SKIPPABLE_MAGIC 0x184D2A5E
+#define GS_COMPRESS_SEEKABLE_MAGIC 0x8F92EAB1
+
+typedef enum
+{
+    GS_COMPRESS_NONE = 0,
+    GS_COMPRESS_ZSTD = 1,
+    GS_COMPRESS_LZ4 = 2,
+} gs_compress_codec_t;
+
+typedef struct
+{
+    gs_compress_codec_t codec;
+    int level;         // Codec compression level; 0 for the codec's default.
+    int threads;
+    size_t frame_size; // Input bytes per independent frame (whole packets, so frames can be larger).
+    bool keep;         // Keep the raw .bin once compressed.
+} gs_compress_config_t;
+
+// One frame of a compressed segment, from its seek table.
+typedef struct
+{
+    uint64_t offset;     // In the compressed file.
+    uint64_t length;
+    uint64_t raw_offset; // In the .bin it was compressed from.
+    uint64_t raw_length;
+} gs_compress_frame_t;
+
+typedef struct
+{
+    gs_compress_config_t config;
+    pthread_t tids[GS_COMPRESS_MAX_THREADS];
+    int num_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    char queue[GS_COMPRESS_QUEUE_DEPTH][512];
+    int head;
+    int len;
+    bool running;
+
+    std::atomic<uint64_t> segments;
+    std::atomic<uint64_t> in_bytes;
+    std::atomic<uint64_t> out_bytes;
+    std::atomic<uint64_t> errors;
+    std::atomic<uint64_t> skipped; // Segments left raw because the queue was full.
+} gs_compress_t;
+
+/**
+ * @brief Parses "zstd", "lz4" or "none" from an environment variable.
+ *
+ * @param name
+ * @param fallback Used if the variable is unset or not recognized.
+ * @return gs_compress_codec_t
+ */
+gs_compress_codec_t gs_compress_codec_env(const char *name, gs_compress_codec_t fallback);
+
+/**
+ * @brief Whether this build can write codec.
+ *
+ */
+bool gs_compress_available(gs_compress_codec_t codec);
+
+/**
+ * @brief The codec a segment file name says it was compressed with.
+ *
+ * @param path
+ * @return gs_compress_codec_t GS_COMPRESS_NONE unless path ends in .bin.zst or .bin.lz4.
+ */
+gs_compress_codec_t gs_compress_codec_of(const char *path);
+
+/**
+ * @brief Reads the seek table at the end of a compressed segment.
+ *
+ * @param data The whole compressed file.
+ * @param size
+ * @param frames Set to a malloc'd array the caller frees, NULL if there are no frames.
+ * @return ssize_t Number of frames, negative if the table is missing or does not match the file.
+ */
+ssize_t gs_compress_frames(const uint8_t *data, size_t size, gs_compress_frame_t **frames);
+
+/**
+ * @brief Decompresses one frame of a compressed segment.
+ *
+ * @param codec
+ * @param src
+ * @param len
+ * @param dst
+ * @param cap The frame's raw_length.
+ * @return ssize_t Bytes written to dst, negative on failure or if the codec is not built in.
+ */
+ssize_t gs_decompress_frame(gs_compress_codec_t codec, const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+/**
+ * @brief Compresses one capture segment and replaces it with the compressed file.
+ *
+ * Blocking; for offline use and for the workers.
+ *
+ * @param config
+ * @param path The segment's .bin file.
+ * @param in_bytes Set to the bytes read.
+ * @param out_bytes Set to the bytes written.
+ * @return int 1 on success, negative on failure (the raw file is then left in place).
+ */
+int gs_compress_file(const gs_compress_config_t *config, const char *path, uint64_t *in_bytes, uint64_t *out_bytes);
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param compress
+ * @param config
+ * @return int 1 on success, 0 if compression is off or the codec is not built in, negative on failure.
+ */
+int gs_compress_init(gs_compress_t *compress, const gs_compress_config_t *config);
+
+/**
+ * @brief Queues a sealed segment. Never blocks on compression.
+ *
+ * @param compress
+ * @param path
+ * @return int 1 if queued, 0 if compression is off, -1 if the queue was full.
+ */
+int gs_compress_submit(gs_compress_t *compress, const char *path);
+
+/**
+ * @brief Finishes the queued segments and stops the workers.
+ *
+ * @param compress
+ */
+void gs_compress_destroy(gs_compress_t *compress);
+
+#endif // GS_COMPRESS_HPP
@@ -0,0 +1,67 @@
+/**
+ * @file gs_config.hpp
+ * @brief Helpers for reading HAYSTACK_* runtime settings from the environment.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_CONFIG_HPP
+#define GS_CONFIG_HPP
+
+#include <stdint.h>
+
+/**
+ * @brief Reads an integer environment variable.
+ *
+ * @param name Variable name.
+ * @param fallback Returned if the variable is unset or unparsable.
+ * @return int64_t
+ */
+int64_t gs_env_int(const char *name, int64_t fallback);
+
+/**
+ * @brief Reads a floating-point environment variable.
+ *
+ * @param name Variable name.
+ * @param fallback Returned if the variable is unset or unparsable.
+ * @return double
+ */
+double gs_env_double(const char *name, double fallback);
+
+/**
+ * @brief Reads a string environment variable.
+ *
+ * @param name Variable name.
+ * @param fallback Returned if the variable is unset or empty.
+ * @return const char*
+ */
+const char *gs_env_str(const char *name, const char *fallback);
+
+/**
+ * @brief Reads an integer setting for one receive chain.
+ *
+ * HAYSTACK_CHAIN<chain>_<name> if set, else HAYSTACK_<name>, else fallback.
+ *
+ * @param chain Chain index.
+ * @param name Setting name without the HAYSTACK_ prefix, e.g. "POOL_BUFFERS".
+ * @param fallback
+ * @return int64_t
+ */
+int64_t gs_chain_env_int(int chain, const char *name, int64_t fallback);
+
+/**
+ * @brief Reads a floating-point setting for one receive chain; see gs_chain_env_int(...).
+ *
+ */
+double gs_chain_env_double(int chain, const char *name, double fallback);
+
+/**
+ * @brief Reads a string setting for one receive chain; see gs_chain_env_int(...).
+ *
+ */
+const char *gs_chain_env_str(int chain, const char *name, const char *fallback);
+
+#endif // GS_CONFIG_HPP
@@ -0,0 +1,32 @@
+/**
+ * @file gs_crc.hpp
+ * @brief Table-sliced CRC-16/CCITT (poly 0x1021, init 0xFFFF).
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * This is the CRC used in NetFrame headers and in the CCSDS frame error
+ * control field.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_CRC_HPP
+#define GS_CRC_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GS_CRC16_INIT 0xFFFF
+
+/**
+ * @brief Continues a CRC-16/CCITT over len more bytes.
+ *
+ * @param crc GS_CRC16_INIT to start, or the previous return value.
+ * @param data
+ * @param len
+ * @return uint16_t
+ */
+uint16_t gs_crc16(uint16_t crc, const void *data, size_t len);
+
+#endif // GS_CRC_HPP
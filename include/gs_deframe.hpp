@@ -0,0 +1,142 @@
+/**
+ * @file gs_deframe.hpp
+ * @brief Splits the modem's output into CCSDS transfer frames and checks their CRC.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The modem delivers a byte stream of CADUs: the attached sync marker
+ * 0x1ACFFC1D followed by a fixed-length transfer frame whose last two bytes
+ * are the frame error control field (CRC-16/CCITT, see gs_crc.hpp). A CADU
+ * may be split across two reads; the deframer keeps the partial one until
+ * the next read completes it.
+ *
+ * With HAYSTACK_DEFRAME set, the RX thread still captures what the modem
+ * returned, but forwards only the transfer frames (sync marker removed), so
+ * a DATA payload is a whole number of HAYSTACK_DEFRAME_LEN byte frames:
+ *
+ *   off   Forward what the modem returned (default).
+ *   keep  Forward every frame found, CRC errors included.
+ *   drop  Forward only frames whose CRC checks.
+ *
+ * Bytes between frames (lost sync, noise) are never forwarded. On a link
+ * whose frames are XORed with the CCSDS pseudo-random sequence but not
+ * Reed-Solomon coded, set HAYSTACK_DEFRAME_DERANDOMIZE=1 so frames are
+ * derandomized before the CRC check and forwarded in the clear. With
+ * HAYSTACK_FEC as well, the CADUs carry Reed-Solomon codeblocks which are
+ * decoded before the CRC check (see gs_fec.hpp).
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_DEFRAME_HPP
+#define GS_DEFRAME_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GS_CCSDS_ASM 0x1ACFFC1D
+#define GS_CCSDS_ASM_LEN 4
+#define GS_DEFRAME_DEFAULT_LEN 1115 // Transfer frame bytes, FECF included (5 x 223, one interleaved RS codeblock).
+#define GS_DEFRAME_MAX_LEN 8192
+#define GS_CCSDS_PN_PERIOD 255 // Bytes before the pseudo-random sequence repeats.
+
+typedef enum
+{
+    GS_DEFRAME_OFF = 0,
+    GS_DEFRAME_KEEP,
+    GS_DEFRAME_DROP,
+} gs_deframe_mode_t;
+
+typedef struct
+{
+    gs_deframe_mode_t mode;
+    size_t frame_len; // Transfer frame length after the sync marker, FECF included.
+    bool crc;         // Whether frames end in a FECF; if not, every frame is kept.
+    bool derandomize; // Whether frames are XORed with the pseudo-random sequence; see gs_ccsds_randomize(...).
+} gs_deframe_config_t;
+
+/**
+ * @brief Frame and error counts, since gs_deframe_init(...) or the last gs_deframe_reset(...).
+ *
+ */
+typedef struct
+{
+    uint64_t frames;     // Frames found.
+    uint64_t crc_errors; // Frames whose FECF did not check.
+    uint64_t skipped;    // Bytes outside any frame.
+} gs_deframe_stats_t;
+
+typedef struct
+{
+    gs_deframe_config_t config;
+    uint8_t carry[GS_CCSDS_ASM_LEN + GS_DEFRAME_MAX_LEN]; // Start of a CADU cut off by the end of the last read.
+    size_t carry_len;
+    gs_deframe_stats_t stats;
+} gs_deframe_t;
+
+/**
+ * @brief Reads one chain's HAYSTACK_DEFRAME, HAYSTACK_DEFRAME_LEN, HAYSTACK_DEFRAME_CRC and HAYSTACK_DEFRAME_DERANDOMIZE settings.
+ *
+ * @param config
+ * @param chain
+ */
+void gs_deframe_config_load(gs_deframe_config_t *config, int chain);
+
+/**
+ * @brief
+ *
+ * @param deframe
+ * @param config
+ * @return int 1 on success, negative if the frame length is out of range.
+ */
+int gs_deframe_init(gs_deframe_t *deframe, const gs_deframe_config_t *config);
+
+/**
+ * @brief Drops any partial CADU and zeroes the counts, e.g. at the start of a pass.
+ *
+ * @param deframe
+ */
+void gs_deframe_reset(gs_deframe_t *deframe);
+
+/**
+ * @brief Extracts the transfer frames from the next len bytes of the stream.
+ *
+ * @param deframe
+ * @param data
+ * @param len
+ * @param out Receives the frames back to back; must hold len + frame_len bytes.
+ * @return size_t Bytes written to out, a multiple of frame_len.
+ */
+size_t gs_deframe(gs_deframe_t *deframe, const uint8_t *data, size_t len, uint8_t *out);
+
+/**
+ * @brief XORs data with the CCSDS pseudo-random sequence (x^8 + x^7 + x^5 + x^3 + 1, from all ones); its own inverse.
+ *
+ * @param data
+ * @param len
+ */
+void gs_ccsds_randomize(uint8_t *data, size_t len);
+
+/**
+ * @brief Finds the first attached sync marker, using the widest vector unit available.
+ *
+ * @param data
+ * @param len
+ * @return const uint8_t* The marker's first byte, NULL if there is none.
+ */
+const uint8_t *gs_asm_find(const uint8_t *data, size_t len);
+
+/**
+ * @brief gs_asm_find(...) without vector instructions; the fallback, and a baseline for bench/deframe_bench.
+ *
+ */
+const uint8_t *gs_asm_find_scalar(const uint8_t *data, size_t len);
+
+/**
+ * @brief Which gs_asm_find(...) implementation this machine uses: avx2, sse2, neon or scalar.
+ *
+ */
+const char *gs_asm_find_name();
+
+#endif // GS_DEFRAME_HPP
@@ -0,0 +1,160 @@
+/**
+ * @file gs_fec.hpp
+ * @brief Reed-Solomon decoding of CCSDS codeblocks on a per-chain worker pool.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * With HAYSTACK_FEC=rs each CADU after the sync marker is a CCSDS codeblock:
+ * the transfer frame (HAYSTACK_DEFRAME_LEN bytes, a multiple of the
+ * interleave depth I, at most 223 * I) followed by 32 * I check symbols,
+ * interleaved symbol by symbol across I RS(255,223) codewords and then
+ * XORed with the CCSDS pseudo-random sequence:
+ *
+ *   HAYSTACK_FEC              off (default) or rs; needs HAYSTACK_DEFRAME
+ *   HAYSTACK_FEC_INTERLEAVE   I, 1-8 (default 5)
+ *   HAYSTACK_FEC_RANDOMIZED   1 (default) if the codeblock is randomized
+ *   HAYSTACK_FEC_DUAL_BASIS   1 (default) for dual basis symbols, 0 for conventional
+ *   HAYSTACK_FEC_THREADS      decoder threads per chain, 1-8 (default 2)
+ *
+ * each settable per chain as HAYSTACK_CHAIN<n>_FEC_... . The receive worker
+ * hands each buffer of codeblocks found by the deframer to the pool and goes
+ * back to the modem; a decoder corrects the codewords, checks the frame CRC,
+ * keeps or drops the frame as HAYSTACK_DEFRAME says and queues the frames for
+ * forwarding, in the order they were received. Capture is unaffected.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_FEC_HPP
+#define GS_FEC_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <atomic>
+#include "gs_bufpool.hpp"
+#include "gs_deframe.hpp"
+#include "gs_pipeline.hpp"
+
+#define GS_FEC_DEFAULT_INTERLEAVE 5
+#define GS_FEC_MAX_INTERLEAVE 8
+#define GS_FEC_DEFAULT_THREADS 2
+#define GS_FEC_MAX_THREADS 8
+#define GS_FEC_QUEUE_DEPTH 32 // Buffers waiting for a decoder; more are dropped.
+
+typedef struct
+{
+    bool enabled;
+    int interleave;
+    bool randomized;
+    bool dual_basis;
+    int threads;
+} gs_fec_config_t;
+
+/**
+ * @brief Decoder counts, see gs_fec_decode(...).
+ *
+ */
+typedef struct
+{
+    uint64_t codewords;
+    uint64_t corrected;     // Symbols corrected.
+    uint64_t uncorrectable; // Codewords with more than 16 symbol errors.
+} gs_fec_stats_t;
+
+typedef struct
+{
+    gs_fec_config_t config;
+    gs_deframe_config_t frame; // Transfer frame length, CRC and keep/drop mode, applied after decoding.
+    size_t block_len;
+    gs_stage_t *out;
+
+    pthread_t tids[GS_FEC_MAX_THREADS];
+    int num_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond; // A buffer was queued, or the pool is stopping.
+    pthread_cond_t turn; // next_out moved on.
+    gs_buf_t *queue[GS_FEC_QUEUE_DEPTH];
+    int head;
+    int len;
+    uint64_t taken;    // Buffers handed to decoders, so the sequence number of the next.
+    uint64_t next_out; // Sequence number of the next buffer to be queued for forwarding.
+    bool running;
+
+    std::atomic<uint64_t> codewords;
+    std::atomic<uint64_t> corrected;
+    std::atomic<uint64_t> uncorrectable;
+    std::atomic<uint64_t> crc_errors; // Frames whose CRC did not check after decoding.
+    std::atomic<uint64_t> dropped;    // Buffers not decoded because the queue was full.
+} gs_fec_t;
+
+/**
+ * @brief Reads one chain's HAYSTACK_FEC_* settings.
+ *
+ * @param config
+ * @param chain
+ */
+void gs_fec_config_load(gs_fec_config_t *config, int chain);
+
+/**
+ * @brief Length of a codeblock carrying a frame_len byte transfer frame.
+ *
+ * @param config
+ * @param frame_len
+ * @return size_t 0 if frame_len is not a multiple of the interleave depth or is too long.
+ */
+size_t gs_fec_block_len(const gs_fec_config_t *config, size_t frame_len);
+
+/**
+ * @brief Turns a transfer frame into a codeblock in place, for the simulated modem and the benchmark.
+ *
+ * @param config
+ * @param block The frame, followed by room for gs_fec_block_len(...) - frame_len check symbols.
+ * @param frame_len
+ */
+void gs_fec_encode(const gs_fec_config_t *config, uint8_t *block, size_t frame_len);
+
+/**
+ * @brief Derandomizes and corrects a codeblock in place, leaving the transfer frame in its first frame_len bytes.
+ *
+ * @param config
+ * @param block
+ * @param frame_len
+ * @param stats Counts are added to.
+ * @return int Symbols corrected, or -1 if some codeword could not be corrected.
+ */
+int gs_fec_decode(const gs_fec_config_t *config, uint8_t *block, size_t frame_len, gs_fec_stats_t *stats);
+
+/**
+ * @brief Starts the decoder threads.
+ *
+ * @param fec
+ * @param config
+ * @param frame The transfer frames' deframing settings.
+ * @param out Where decoded frames are queued.
+ * @param chain For the decoder threads' scheduling settings (see gs_rt.hpp).
+ * @return int 1 on success, 0 if FEC is off, negative on failure.
+ */
+int gs_fec_init(gs_fec_t *fec, const gs_fec_config_t *config, const gs_deframe_config_t *frame, gs_stage_t *out, int chain);
+
+/**
+ * @brief Queues a buffer of whole codeblocks for decoding. Never blocks on decoding.
+ *
+ * Takes its own reference on buf if it is queued.
+ *
+ * @param fec
+ * @param buf
+ * @return int 1 if queued, -1 if the queue was full.
+ */
+int gs_fec_submit(gs_fec_t *fec, gs_buf_t *buf);
+
+/**
+ * @brief Decodes what is queued and stops the decoder threads.
+ *
+ * @param fec
+ */
+void gs_fec_destroy(gs_fec_t *fec);
+
+#endif // GS_FEC_HPP
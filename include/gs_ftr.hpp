@@ -0,0 +1,97 @@
+/**
+ * @file gs_ftr.hpp
+ * @brief In-memory registry of AD9361 FIR filter (.ftr) files.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Every .ftr file in HAYSTACK_FTR_DIR (default /home/sunip) is read and
+ * validated once at startup, so an XBAND_CONFIG only has to hand cached
+ * text to radio_load_filter(...). The registry also remembers which filter
+ * is loaded and skips the write when a config asks for it again.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_FTR_HPP
+#define GS_FTR_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "gs_backend.hpp"
+
+#define GS_FTR_DEFAULT_DIR "/home/sunip"
+#define GS_FTR_NAME_LEN 64     // Same as phy_config_t::ftr_name.
+#define GS_FTR_MAX_SIZE 65536  // Largest .ftr file accepted.
+#define GS_FTR_MAX_TAPS 128    // AD9361 FIR limit.
+
+typedef struct gs_chain_t gs_chain_t;
+
+typedef struct
+{
+    char name[GS_FTR_NAME_LEN]; // File name without .ftr.
+    char *text;                 // File contents, written as-is to filter_fir_config.
+    size_t len;
+    int taps;
+    int rx_dec;  // RX decimation, 0 if the file has no RX line.
+    int tx_int;  // TX interpolation, 0 if the file has no TX line.
+} gs_ftr_t;
+
+typedef struct
+{
+    gs_ftr_t *filters; // Sorted by name.
+    int count;
+
+    pthread_mutex_t lock;                        // Protects active.
+    char active[GS_MAX_CHAINS][GS_FTR_NAME_LEN]; // Filter last loaded into each chain's radio, empty if unknown.
+} gs_ftr_registry_t;
+
+/**
+ * @brief Reads and validates every .ftr file in dir.
+ *
+ * Invalid files are logged and left out.
+ *
+ * @param reg
+ * @param dir
+ * @return int Number of filters loaded, negative if dir cannot be read.
+ */
+int gs_ftr_registry_load(gs_ftr_registry_t *reg, const char *dir);
+
+/**
+ * @brief Looks up a filter by name.
+ *
+ * @param reg
+ * @param name Need not be NUL-terminated within GS_FTR_NAME_LEN.
+ * @return const gs_ftr_t* NULL if not registered.
+ */
+const gs_ftr_t *gs_ftr_find(const gs_ftr_registry_t *reg, const char *name);
+
+/**
+ * @brief Loads a registered filter into a chain's radio unless it is already active there.
+ *
+ * @param reg
+ * @param chain
+ * @param name
+ * @return int 1 if loaded, 0 if already active, negative if unknown or the load failed.
+ */
+int gs_ftr_apply(gs_ftr_registry_t *reg, gs_chain_t *chain, const char *name);
+
+/**
+ * @brief Copies the name of the filter active in a chain's radio.
+ *
+ * @param reg
+ * @param chain Chain index.
+ * @param buf
+ * @param len
+ */
+void gs_ftr_active(gs_ftr_registry_t *reg, int chain, char *buf, size_t len);
+
+/**
+ * @brief Frees every cached filter.
+ *
+ * @param reg
+ */
+void gs_ftr_registry_destroy(gs_ftr_registry_t *reg);
+
+#endif // GS_FTR_HPP
@@ -13,30 +13,137 @@
 #define GS_HAYSTACK_HPP
 
 #include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <atomic>
 #include "rxmodem.h"
 #include "adf4355.h"
 #include "network.hpp"
 #include "libiio.h"
+#include "gs_backend.hpp"
+#include "gs_iio.hpp"
+#include "gs_bufpool.hpp"
+#include "gs_capture.hpp"
+#include "gs_deframe.hpp"
+#include "gs_fec.hpp"
+#include "gs_spool.hpp"
+#include "gs_batch.hpp"
+#include "gs_pipeline.hpp"
+#include "gs_status.hpp"
+#include "gs_radio_config.hpp"
+#include "gs_ftr.hpp"
+#include "gs_reactor.hpp"
+#include "gs_startup.hpp"
 
 #define SERVER_POLL_RATE 5 // Once per this many seconds
 #define SEC *1000000
 #define RECV_TIMEOUT 15
 #define SERVER_PORT 54230
+#define GS_RX_NOT_READY_MS 5000 // How often an armed worker rechecks an uninitialized modem or radio.
+#define GS_RX_EXIT_SEC 2          // How long gs_xband_rx_exit(...) waits for the worker.
 
-typedef struct
+/**
+ * @brief What a chain's receive worker is doing.
+ *
+ * Set by gs_xband_rx_arm(...), gs_xband_rx_disarm(...) and gs_xband_rx_exit(...);
+ * the worker reads it between packets and parks on rx_efd unless armed.
+ *
+ */
+typedef enum
+{
+    GS_RX_DISARMED = 0,
+    GS_RX_ARMED,
+    GS_RX_EXIT,
+} gs_rx_state_t;
+
+/**
+ * @brief One X-Band receive chain: modem, PLL and radio with its own RX
+ * thread, buffer pool, capture stream and forward stage.
+ *
+ * Chains share the server connection, the network reactor (which ticks each
+ * chain's status in turn) and the FIR filter files.
+ *
+ */
+typedef struct gs_chain_t
 {
+    int index; // Position in global_data_t::chain; the chain byte on the wire.
+    global_data_t *global;
+
+    // Radio, modem and PLL access, selected at build time (see gs_backend.hpp).
+    const gs_backend_t *backend;
+
     // Three separate objects for a single x-band radio.
     rxmodem rx_modem[1]; // from rxmodem.h
     adf4355 PLL[1]; // from adf4355.h, aka pll
     adradio_t radio[1];// from libiio.h
+    gs_iio_t iio[1]; // Batched attribute access to the same radio (hardware backend).
 
-    bool rx_modem_ready;
-    bool rx_armed;
-    bool PLL_ready;
-    bool radio_ready;
+    // Set by the startup workers (see gs_startup.hpp) while the reactor and RX worker read them.
+    std::atomic<bool> rx_modem_ready;
+    std::atomic<bool> PLL_ready;
+    std::atomic<bool> radio_ready;
     int last_rx_status;
     int last_read_status;
 
+    // Current RX tuning, recorded with every captured packet.
+    std::atomic<int64_t> rx_LO;
+    std::atomic<int64_t> rx_samp;
+    std::atomic<int64_t> rx_bw;
+    uint64_t rx_seq;
+
+    // Receive worker, started by gs_chain_init(...) with the RX role's scheduling (see gs_rt.hpp)
+    // and kept for the life of the chain; arming only flips rx_state and writes rx_efd.
+    pthread_t rx_tid;
+    int rx_efd; // eventfd; -1 once the worker has exited.
+    bool rx_stuck; // The worker did not exit in time; what it uses is never freed.
+    std::atomic<int> rx_state; // gs_rx_state_t
+    std::atomic<uint64_t> rx_cmd_ns; // When the last arm or disarm was asked for, for the rx_arm/rx_disarm histograms.
+
+    // Preallocated buffers for rxmodem_read.
+    gs_bufpool_t rx_pool[1];
+    // One pool buffer's worth, where a packet is read and dropped while the pool is empty.
+    uint8_t *rx_discard;
+
+    // Writes received packets to disk off the RX thread (persist stage).
+    gs_capture_t capture[1];
+
+    // Splits received data into CCSDS frames for forwarding (HAYSTACK_DEFRAME); only the RX thread touches it.
+    gs_deframe_t deframe[1];
+
+    // Reed-Solomon decoders between the deframer and the forward stage (HAYSTACK_FEC).
+    gs_fec_t fec[1];
+
+    // Sends received packets to the server off the RX thread (forward stage).
+    gs_stage_t forward[1];
+    pthread_t forward_tid;
+    std::atomic<bool> forward_running;
+    std::atomic<uint32_t> forward_send_errors;
+    // DATA frames the server could not take, kept on disk until it can (HAYSTACK_SPOOL); only the forward thread writes it.
+    gs_spool_t spool[1];
+    // Packs small packets into one DATA frame (HAYSTACK_FORWARD_BATCH_BYTES); only the forward thread touches it.
+    gs_batch_t batch[1];
+
+    // Radio attributes last read for a status frame.
+    gs_status_cache_t status[1];
+
+    // Last XBAND_CONFIG applied, and how the last one went.
+    gs_radio_config_t radio_config[1];
+} gs_chain_t;
+
+typedef struct global_data_t
+{
+    gs_chain_t chain[GS_MAX_CHAINS];
+    int num_chains; // HAYSTACK_CHAINS, default 1.
+
+    // FIR filters preloaded from HAYSTACK_FTR_DIR, shared by every chain.
+    gs_ftr_registry_t ftr[1];
+
+    // Event loop for the server connection: receive, POLL and status sends, reconnects.
+    gs_reactor_t reactor[1];
+
+    // Concurrent bring-up of every chain's modem, radio and PLL, and the time each took.
+    gs_startup_t startup[1];
+
     NetDataClient *network_data;
     uint8_t netstat;
 } global_data_t;
@@ -72,30 +179,98 @@ enum XBAND_COMMAND
 };
 
 /**
- * @brief Initializes radio.
- * 
- * Called from X-Band RX thread if necessary.
- * 
- * @param global_data 
- * @return int 
+ * @brief Sets up one receive chain's buffer pool, capture stream, forward stage and status cache.
+ *
+ * Reads the chain's HAYSTACK_CHAIN<n>_* settings (see gs_chain_env_int(...)).
+ *
+ * @param chain
+ * @param global
+ * @param index
+ * @param backend
+ * @return int 1 on success, negative on failure.
+ */
+int gs_chain_init(gs_chain_t *chain, global_data_t *global, int index, const gs_backend_t *backend);
+
+/**
+ * @brief Releases what gs_chain_init(...) set up, stopping the receive worker if still running.
+ *
+ * The forward thread must have been stopped; anything still queued for it is spooled.
+ *
+ * @param chain
  */
-int gs_xband_init(global_data_t *global_data);
+void gs_chain_destroy(gs_chain_t *chain);
 
 /**
  * @brief Listens for X-Band packets from SPACE-HAUC.
- * 
- * @param args 
- * @return void* 
+ *
+ * One per chain for the life of the chain. Parked on rx_efd while disarmed;
+ * receives, captures and queues packets for forwarding while armed; returns
+ * once rx_state is GS_RX_EXIT.
+ *
+ * @param args gs_chain_t *
+ * @return void*
  */
 void *gs_xband_rx_thread(void *args);
 
 /**
- * @brief Listens for NetworkFrames from the Ground Station Network.
- * 
- * @param args 
- * @return void* 
+ * @brief Resumes the modem and wakes the receive worker. Does not block on the worker.
+ *
+ * @param chain
+ * @return int 1 on success, negative if the modem could not be started.
+ */
+int gs_xband_rx_arm(gs_chain_t *chain);
+
+/**
+ * @brief Stops the modem so a pending receive returns, and lets the worker park.
+ *
+ * Packets received after this are not captured or forwarded. Does not block on the worker.
+ *
+ * @param chain
+ * @return int The backend's rx_stop(...) result.
  */
-void *gs_network_rx_thread(void *args);
+int gs_xband_rx_disarm(gs_chain_t *chain);
+
+/**
+ * @brief Stops and joins the receive worker. Safe to call more than once.
+ *
+ * A worker which does not exit within GS_RX_EXIT_SEC is left running, and
+ * later calls fail at once; the modem, buffer pool and stages it may still
+ * be using must then not be destroyed.
+ *
+ * @param chain
+ * @return int 1 once the worker has exited, negative if it is still running.
+ */
+int gs_xband_rx_exit(gs_chain_t *chain);
+
+/**
+ * @brief Sends packets queued by one chain's gs_xband_rx_thread to the server.
+ *
+ * Runs for the life of the process, until forward_running is cleared.
+ * With more than one chain, each DATA frame ends in the chain's index byte.
+ * With batching on, a DATA frame carries several length-prefixed packets
+ * and waits at most HAYSTACK_FORWARD_BATCH_MS for them (see gs_batch.hpp).
+ * Frames that cannot be sent go to the chain's spool, which is drained
+ * whenever the connection is up and no live frame or batch is waiting.
+ *
+ * @param args gs_chain_t *
+ * @return void*
+ */
+void *gs_xband_forward_thread(void *args);
+
+/**
+ * @brief Acts on one NetworkFrame received from the Ground Station Network.
+ *
+ * Called from the network reactor (see gs_reactor.hpp). XBAND_CONFIG and
+ * XBAND_COMMAND payloads may be followed by one byte naming the chain they
+ * are for; without it they go to chain 0.
+ *
+ * @param global
+ * @param type
+ * @param destination
+ * @param payload
+ * @param payload_size
+ */
+void gs_network_handle_frame(global_data_t *global, NetType type, NetVertex destination, const unsigned char *payload, int payload_size);
 
 /**
  * @brief 
@@ -105,10 +280,17 @@ void *gs_network_rx_thread(void *args);
 int gs_xband_apply_config();
 
 /**
- * @brief 
- * 
- * @return void* 
+ * @brief Builds a chain's status frame and sends it if kicked, changed, or due as a keepalive.
+ *
+ * Called from the network reactor on every status tick and kick. With more
+ * than one chain, the frame ends in the chain's index byte.
+ *
+ * @param chain
+ * @param last Last frame sent, updated on send.
+ * @param last_send CLOCK_MONOTONIC time of the last send; zero forces a send.
+ * @param kicked Send even if nothing changed.
+ * @return int 1 if sent, 0 if nothing to send, negative if the send failed.
  */
-void *xband_status_thread(void *);
+int gs_xband_status_tick(gs_chain_t *chain, phy_status_t *last, struct timespec *last_send, bool kicked);
 
 #endif // GS_HAYSTACK_HPP
\ No newline at end of file
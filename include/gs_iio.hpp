@@ -0,0 +1,97 @@
+/**
+ * @file gs_iio.hpp
+ * @brief Batched AD9361 attribute access through libiio.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Each adradio_get_* / adradio_set_* call is one attribute round trip, which
+ * costs milliseconds over a network IIO context. gs_iio_read(...) and
+ * gs_iio_write(...) instead move every requested attribute of a channel with
+ * a single iio_channel_attr_read_all / iio_channel_attr_write_all (and the
+ * device equivalents), so a full status read is at most five round trips
+ * rather than nine. Contexts which do not support the bulk calls fall back
+ * to one attribute at a time.
+ *
+ * The handles are our own context on the same ad9361-phy adradio_t drives,
+ * so no knowledge of adradio_t's internals is needed.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_IIO_HPP
+#define GS_IIO_HPP
+
+#include <stdint.h>
+#include <pthread.h>
+#include "gs_backend.hpp"
+
+struct iio_context;
+struct iio_device;
+struct iio_channel;
+
+#define GS_IIO_PHY_NAME "ad9361-phy"
+
+typedef struct
+{
+    struct iio_context *ctx;
+    struct iio_device *phy;     // ensm_mode
+    struct iio_channel *rx;     // voltage0 in: sampling_frequency, rf_bandwidth, gain_control_mode, hardwaregain, rssi
+    struct iio_channel *rx_lo;  // altvoltage0 out: frequency
+    struct iio_channel *tx;     // voltage0 out: hardwaregain
+    struct iio_channel *temp;   // temp0 in: input
+    pthread_mutex_t lock;       // libiio contexts are not safe to share between threads.
+    bool bulk;                  // Cleared if the context rejects the *_attr_*_all calls.
+} gs_iio_t;
+
+/**
+ * @brief Opens an IIO context and looks up the AD9361 channels.
+ *
+ * @param iio
+ * @param uri e.g. "ip:192.168.2.1"; NULL for the default (local or IIOD_REMOTE) context.
+ * @return int 1 on success, negative on failure (iio->phy is then NULL).
+ */
+int gs_iio_init(gs_iio_t *iio, const char *uri);
+
+/**
+ * @brief Reads every attribute named in mask, one round trip per channel.
+ *
+ * @param iio
+ * @param attrs
+ * @param mask GS_RADIO_* bits.
+ * @return int GS_RADIO_* bits read, negative if iio is not open.
+ */
+int gs_iio_read(gs_iio_t *iio, gs_radio_attrs_t *attrs, uint32_t mask);
+
+/**
+ * @brief Writes every writable attribute named in mask, one round trip per channel.
+ *
+ * Channels are written in the order ENSM, LO, RX (sampling frequency,
+ * bandwidth, gain mode), TX; within a channel the driver's attribute order
+ * applies. Callers that need a stricter order write one bit at a time.
+ *
+ * @param iio
+ * @param attrs
+ * @param mask GS_RADIO_* bits.
+ * @return int GS_RADIO_* bits written, negative if iio is not open.
+ */
+int gs_iio_write(gs_iio_t *iio, const gs_radio_attrs_t *attrs, uint32_t mask);
+
+/**
+ * @brief Writes filter_fir_config and enables the RX/TX FIR.
+ *
+ * @param iio
+ * @param ftr Contents of an AD9361 .ftr file.
+ * @param len
+ * @return int 1 on success, negative on failure.
+ */
+int gs_iio_load_filter(gs_iio_t *iio, const char *ftr, size_t len);
+
+/**
+ * @brief Closes the context.
+ *
+ * @param iio
+ */
+void gs_iio_destroy(gs_iio_t *iio);
+
+#endif // GS_IIO_HPP
@@ -0,0 +1,203 @@
+/**
+ * @file gs_metrics.hpp
+ * @brief Per-thread latency histograms and counters.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Each thread records into its own shard, so gs_metric_time(...) and
+ * gs_metric_add(...) are plain relaxed loads and stores with no locks or
+ * atomic read-modify-writes. Readers sum the shards on demand.
+ *
+ * Histograms are HDR-style: exact below 16 ns, then 16 linear sub-buckets
+ * per power of two, so any recorded value is known to within ~6%. Values are
+ * nanoseconds up to 2^40 (about 18 minutes); longer ones land in the last
+ * bucket.
+ *
+ * The totals go out two ways:
+ *   - a GS_NETTYPE_STATS frame carrying gs_metrics_frame_t (see gs_reactor.cpp);
+ *     the capture compression ratio is compress_in_bytes / compress_out_bytes
+ *     and its throughput compress_in_bytes / the compress_frame sum;
+ *   - Prometheus text on the Unix socket HAYSTACK_METRICS_SOCKET, which also
+ *     carries the ratio and throughput as gauges, e.g.
+ *       socat - UNIX-CONNECT:/tmp/haystack-metrics.sock > /var/lib/node_exporter/haystack.prom
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_METRICS_HPP
+#define GS_METRICS_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include "network.hpp"
+
+// Not one of the network submodule's types; the server forwards it to the client like XBAND_DATA.
+#define GS_NETTYPE_STATS ((NetType)0x40)
+
+#define GS_METRICS_DEFAULT_SOCKET "/tmp/haystack-metrics.sock" // HAYSTACK_METRICS_SOCKET=none disables.
+#define GS_METRICS_DEFAULT_FRAME_SEC 10
+
+#define GS_METRICS_SUB_BITS 4
+#define GS_METRICS_MAX_EXP 40
+#define GS_METRICS_BUCKETS ((GS_METRICS_MAX_EXP - GS_METRICS_SUB_BITS + 1) << GS_METRICS_SUB_BITS)
+#define GS_METRICS_MAX_THREADS 16
+
+typedef enum
+{
+    GS_HIST_RX_RECEIVE = 0, // rx_receive (rxmodem_receive)
+    GS_HIST_RX_READ,        // rx_read (rxmodem_read)
+    GS_HIST_CAPTURE_WRITE,  // One capture batch: payload and index writes
+    GS_HIST_NET_SEND,       // One frame to the server
+    GS_HIST_CONFIG_APPLY,   // One XBAND_CONFIG pass
+    GS_HIST_STATUS_READ,    // One status radio_read_attrs (the adradio_get_* reads)
+    GS_HIST_COMPRESS_FRAME, // Compressing one frame of a sealed capture segment
+    GS_HIST_SCHED_WAKEUP,   // How late the gs_rt probe woke up (HAYSTACK_RT_PROBE_US)
+    GS_HIST_RX_ARM,         // XBC_ARM_RX until the receive worker is waiting on the modem
+    GS_HIST_RX_DISARM,      // XBC_DISARM_RX until the receive worker is parked
+    GS_HIST_FEC_DECODE,     // Decoding the codeblocks of one receive buffer (HAYSTACK_FEC)
+    GS_HIST_NUM
+} gs_hist_t;
+
+typedef enum
+{
+    GS_CTR_RX_PACKETS = 0,
+    GS_CTR_RX_BYTES,
+    GS_CTR_RX_ERRORS, // Failed or short receives and reads
+    GS_CTR_CAPTURE_PACKETS,
+    GS_CTR_CAPTURE_BYTES,
+    GS_CTR_CAPTURE_ERRORS,
+    GS_CTR_NET_FRAMES,
+    GS_CTR_NET_BYTES,
+    GS_CTR_NET_ERRORS,
+    GS_CTR_CONFIG_PASSES,
+    GS_CTR_CONFIG_FAILURES,
+    GS_CTR_STATUS_READS,
+    GS_CTR_STATUS_ERRORS, // Status reads which left some attribute unread
+    GS_CTR_COMPRESS_SEGMENTS,
+    GS_CTR_COMPRESS_IN_BYTES,
+    GS_CTR_COMPRESS_OUT_BYTES,
+    GS_CTR_COMPRESS_ERRORS,
+    GS_CTR_DEFRAME_FRAMES,
+    GS_CTR_DEFRAME_CRC_ERRORS,
+    GS_CTR_DEFRAME_SKIPPED_BYTES, // Received bytes outside any CCSDS frame
+    GS_CTR_FEC_CODEWORDS,
+    GS_CTR_FEC_CORRECTED_SYMBOLS,
+    GS_CTR_FEC_UNCORRECTABLE, // Codewords with more errors than RS(255,223) corrects
+    GS_CTR_FEC_DROPPED,       // Receive buffers the decoders fell behind on
+    GS_CTR_SPOOL_FRAMES,      // DATA frames written to the spool instead of the server
+    GS_CTR_SPOOL_BYTES,
+    GS_CTR_SPOOL_DRAINED_FRAMES,
+    GS_CTR_SPOOL_DRAINED_BYTES,
+    GS_CTR_SPOOL_DROPPED, // DATA frames that could neither be sent nor spooled
+    GS_CTR_SPOOL_ERRORS,  // Failed spool reads and writes
+    GS_CTR_FORWARD_BATCHES, // DATA frames packed from several received packets (HAYSTACK_FORWARD_BATCH_BYTES)
+    GS_CTR_FORWARD_BATCHED_PACKETS,
+    GS_CTR_NUM
+} gs_counter_t;
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[GS_METRICS_BUCKETS];
+} gs_hist_snapshot_t;
+
+typedef struct
+{
+    uint64_t counters[GS_CTR_NUM];
+    gs_hist_snapshot_t hist[GS_HIST_NUM];
+} gs_metrics_snapshot_t;
+
+/**
+ * @brief Payload of a GS_NETTYPE_STATS frame.
+ *
+ */
+typedef struct __attribute__((packed))
+{
+    uint32_t version; // GS_METRICS_FRAME_VERSION
+    uint64_t counters[GS_CTR_NUM];
+    struct __attribute__((packed))
+    {
+        uint64_t count;
+        uint64_t sum_ns;
+        uint64_t p50_ns;
+        uint64_t p90_ns;
+        uint64_t p99_ns;
+        uint64_t p999_ns;
+        uint64_t max_ns;
+    } hist[GS_HIST_NUM];
+} gs_metrics_frame_t;
+
+#define GS_METRICS_FRAME_VERSION 8 // 2: compression counters and histogram added. 3: sched_wakeup histogram added. 4: rx_arm and rx_disarm histograms added. 5: deframe counters added. 6: fec_decode histogram and fec counters added. 7: spool counters added. 8: forward batch counters added.
+
+static inline uint64_t gs_metrics_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Records one latency sample for the calling thread.
+ *
+ * @param hist
+ * @param ns
+ */
+void gs_metric_time(gs_hist_t hist, uint64_t ns);
+
+/**
+ * @brief Adds to one of the calling thread's counters.
+ *
+ * @param counter
+ * @param n
+ */
+void gs_metric_add(gs_counter_t counter, uint64_t n);
+
+/**
+ * @brief Sums every thread's shard.
+ *
+ * @param snap
+ */
+void gs_metrics_snapshot(gs_metrics_snapshot_t *snap);
+
+/**
+ * @brief Value at quantile q (0 to 1) of a histogram, to bucket resolution.
+ *
+ */
+uint64_t gs_metrics_quantile(const gs_hist_snapshot_t *hist, double q);
+
+/**
+ * @brief Fills a stats frame from a snapshot.
+ *
+ */
+void gs_metrics_frame(const gs_metrics_snapshot_t *snap, gs_metrics_frame_t *frame);
+
+/**
+ * @brief Writes a snapshot in the Prometheus text exposition format.
+ *
+ * @param snap
+ * @param buf
+ * @param len
+ * @return size_t Bytes written (truncated to len - 1).
+ */
+size_t gs_metrics_format(const gs_metrics_snapshot_t *snap, char *buf, size_t len);
+
+/**
+ * @brief Creates a listening Unix socket at path, replacing a stale one.
+ *
+ * @param path
+ * @return int Listening descriptor, negative on failure.
+ */
+int gs_metrics_listen(const char *path);
+
+/**
+ * @brief Accepts one connection on the metrics socket, writes the current metrics and closes it.
+ *
+ * @param listen_fd
+ */
+void gs_metrics_serve(int listen_fd);
+
+#endif // GS_METRICS_HPP
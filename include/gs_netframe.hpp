@@ -0,0 +1,155 @@
+/**
+ * @file gs_netframe.hpp
+ * @brief Copy-free NetFrame sends from caller-owned payloads.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * NetFrame::sendFrame copies the payload into the frame and then again into a
+ * send buffer. gs_netframe_send(...) instead builds the header and footer on
+ * the stack and hands header, payload and footer to the kernel in one
+ * sendmsg(...), straight from the caller's buffer.
+ *
+ * The header and footer below mirror NetFrame's wire layout. Because that
+ * layout lives in the network submodule, gs_netframe_selftest(...) compares
+ * our bytes with NetFrame::sendFrame's over a socketpair at startup, and the
+ * sends fall back to NetFrame if they differ.
+ *
+ * Frames from the server are read the same way: gs_netframe_recv(...) fills
+ * a per-connection buffer and gs_netframe_next(...) hands out each complete
+ * frame in place, so the command path does no heap allocation.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_NETFRAME_HPP
+#define GS_NETFRAME_HPP
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "network.hpp"
+
+#define GS_NETFRAME_GUID 0x1a1c
+#define GS_NETFRAME_TERMINATOR 0xaaaa
+#define GS_NETFRAME_RX_SIZE 4096 // Largest frame accepted from the server, header and footer included.
+
+typedef struct __attribute__((packed))
+{
+    uint16_t guid;
+    NetVertex origin;
+    NetVertex destination;
+    NetType type;
+    uint8_t netstat;
+    int payload_size;
+    uint16_t crc1;
+} gs_netframe_header_t;
+
+typedef struct __attribute__((packed))
+{
+    uint16_t crc2;
+    uint16_t termination;
+} gs_netframe_footer_t;
+
+typedef struct
+{
+    uint8_t buf[GS_NETFRAME_RX_SIZE];
+    size_t len;      // Bytes buffered.
+    size_t consumed; // Bytes at the front of buf already handed out.
+    uint64_t frames;
+    uint64_t bad_crc; // Frames dropped for a payload CRC mismatch.
+} gs_netframe_rx_t;
+
+/**
+ * @brief Checks our framing against NetFrame::sendFrame and enables the copy-free path if they match.
+ *
+ * @return int 1 if copy-free sends are enabled, 0 if NetFrame is used instead.
+ */
+int gs_netframe_selftest();
+
+/**
+ * @brief Whether gs_netframe_selftest(...) found our framing identical to NetFrame's.
+ *
+ */
+bool gs_netframe_is_direct();
+
+/**
+ * @brief Empties a receive buffer, e.g. for a new connection.
+ *
+ * @param rx
+ */
+void gs_netframe_rx_reset(gs_netframe_rx_t *rx);
+
+/**
+ * @brief Reads whatever the socket has buffered into rx, without blocking.
+ *
+ * Invalidates frames previously returned by gs_netframe_next(...).
+ *
+ * @param network_data
+ * @param rx
+ * @return ssize_t Bytes read, 0 if none were waiting, -404 if the server closed the connection, -1 on error.
+ */
+ssize_t gs_netframe_recv(NetData *network_data, gs_netframe_rx_t *rx);
+
+/**
+ * @brief Takes the next complete frame out of rx.
+ *
+ * Frames whose CRC does not match are counted in bad_crc and skipped.
+ *
+ * @param rx
+ * @param header Set to the frame's header inside rx->buf.
+ * @param payload Set to the frame's payload inside rx->buf; valid until the next gs_netframe_recv(...).
+ * @return int 1 if a frame was returned, 0 if more bytes are needed, negative if the stream is out of sync.
+ */
+int gs_netframe_next(gs_netframe_rx_t *rx, const gs_netframe_header_t **header, const uint8_t **payload);
+
+/**
+ * @brief Sends one frame whose payload is gathered from iovcnt caller-owned pieces.
+ *
+ * Sends from all threads are serialized so frames never interleave on the socket.
+ *
+ * @param network_data
+ * @param type
+ * @param destination
+ * @param payload
+ * @param iovcnt At most GS_NETFRAME_MAX_IOV.
+ * @return ssize_t Bytes sent including header and footer, negative on failure.
+ */
+ssize_t gs_netframe_sendv(NetData *network_data, NetType type, NetVertex destination, const struct iovec *payload, int iovcnt);
+
+/**
+ * @brief Sends one frame from a single caller-owned payload buffer.
+ *
+ */
+ssize_t gs_netframe_send(NetData *network_data, NetType type, NetVertex destination, const void *payload, size_t len);
+
+/**
+ * @brief Sends count frames, one per payload, in as few sendmsg(...) calls as the socket allows.
+ *
+ * For backlogs of small frames, where a sendmsg(...) per frame would cost more
+ * than the bytes. If it fails, some of the frames may already have been sent.
+ *
+ * @param network_data
+ * @param type
+ * @param destination
+ * @param payloads One contiguous payload per frame.
+ * @param count At most GS_NETFRAME_MAX_BATCH.
+ * @return ssize_t Bytes sent including headers and footers, negative on failure.
+ */
+ssize_t gs_netframe_send_batch(NetData *network_data, NetType type, NetVertex destination, const struct iovec *payloads, int count);
+
+/**
+ * @brief Closes the server socket and marks the connection down.
+ *
+ * Waits for any send in progress, so no thread writes to the descriptor after
+ * it is closed (and possibly reused).
+ *
+ * @param network_data
+ * @param reason Copied to disconnect_reason.
+ */
+void gs_netframe_disconnect(NetData *network_data, const char *reason);
+
+#define GS_NETFRAME_MAX_IOV 62
+#define GS_NETFRAME_MAX_BATCH 64 // Frames per gs_netframe_send_batch(...); three iovecs each, well under IOV_MAX.
+
+#endif // GS_NETFRAME_HPP
@@ -0,0 +1,125 @@
+/**
+ * @file gs_pipeline.hpp
+ * @brief Bounded hand-off between the receive, persist and forward stages.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The receive stage (gs_xband_rx_thread) pushes each received buffer into one
+ * gs_stage_t per downstream stage: the capture writer (persist) and the
+ * network forwarder (forward). Each stage owns its own ring, so a slow TCP
+ * send never holds up the modem or the disk and vice versa.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_PIPELINE_HPP
+#define GS_PIPELINE_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include "gs_bufpool.hpp"
+#include "gs_spsc_ring.hpp"
+
+#define GS_STAGE_DEFAULT_DEPTH 64
+#define GS_STAGE_DEFAULT_BLOCK_MS 50
+
+/**
+ * @brief What the receive stage does when a downstream stage's ring is full.
+ *
+ */
+typedef enum
+{
+    GS_STAGE_DROP = 0,  // Drop the packet for that stage only.
+    GS_STAGE_BLOCK = 1, // Wait up to block_ms for room, then drop.
+} gs_stage_policy_t;
+
+typedef struct
+{
+    char name[16];
+    gs_spsc_ring<gs_buf_t *> ring;
+    gs_stage_policy_t policy;
+    int block_ms;
+
+    // Consumer wakeup; only written to when the consumer is asleep.
+    int efd;
+    std::atomic<bool> waiting;
+
+    // Producer wakeup for GS_STAGE_BLOCK, written after a pop while the producer waits for room.
+    // A real sleep rather than sched_yield(), which never lets a SCHED_OTHER consumer run under a SCHED_FIFO producer.
+    int space_efd;
+    std::atomic<bool> space_waiting;
+
+    std::atomic<uint64_t> pushed;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint32_t> high_water;
+} gs_stage_t;
+
+/**
+ * @brief Reads a stage policy from an environment variable ("drop" or "block").
+ *
+ * @param name Variable name.
+ * @param fallback
+ * @return gs_stage_policy_t
+ */
+gs_stage_policy_t gs_stage_policy_env(const char *name, gs_stage_policy_t fallback);
+
+/**
+ * @brief Allocates the stage's ring and wakeups.
+ *
+ * @param stage
+ * @param name For log messages.
+ * @param depth Ring capacity, rounded up to a power of two.
+ * @param policy
+ * @param block_ms Longest a GS_STAGE_BLOCK push waits before dropping.
+ * @return int 1 on success, negative on failure.
+ */
+int gs_stage_init(gs_stage_t *stage, const char *name, int depth, gs_stage_policy_t policy, int block_ms);
+
+/**
+ * @brief Producer side. Takes its own reference on buf if it is queued.
+ *
+ * @param stage
+ * @param buf
+ * @return int 1 if queued, -1 if dropped.
+ */
+int gs_stage_push(gs_stage_t *stage, gs_buf_t *buf);
+
+/**
+ * @brief Consumer side. Waits up to timeout_ms for a buffer.
+ *
+ * The caller owns the returned reference and must gs_buf_release(...) it.
+ *
+ * @param stage
+ * @param timeout_ms
+ * @return gs_buf_t* NULL on timeout or gs_stage_wake(...).
+ */
+gs_buf_t *gs_stage_pop(gs_stage_t *stage, int timeout_ms);
+
+/**
+ * @brief Consumer side. Takes a buffer if one is queued, without waiting.
+ *
+ */
+gs_buf_t *gs_stage_try_pop(gs_stage_t *stage);
+
+/**
+ * @brief Wakes a consumer blocked in gs_stage_pop(...), e.g. for shutdown.
+ *
+ * @param stage
+ */
+void gs_stage_wake(gs_stage_t *stage);
+
+/**
+ * @brief Number of buffers waiting in the stage.
+ *
+ */
+uint32_t gs_stage_occupancy(const gs_stage_t *stage);
+
+/**
+ * @brief Releases anything still queued and frees the stage.
+ *
+ * @param stage
+ */
+void gs_stage_destroy(gs_stage_t *stage);
+
+#endif // GS_PIPELINE_HPP
@@ -0,0 +1,105 @@
+/**
+ * @file gs_radio_config.hpp
+ * @brief Diff-based, transactional application of XBAND_CONFIG frames.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Each XBAND_CONFIG is compared with the last configuration applied, and
+ * only the fields which differ are written, one at a time, in the order of
+ * gs_config_field_t:
+ *
+ *   filter    The FIR taps limit which sample rates are valid (see gs_ftr.hpp).
+ *   samp      Bandwidth is clamped against the sample rate.
+ *   bw
+ *   gain mode
+ *   LO        Tuned once the baseband is final, so the synthesizer calibrates once.
+ *   TX gain
+ *   mode      Last, so the radio only enters FDD/TDD fully configured.
+ *
+ * If a write fails, the fields already written in that pass are restored in
+ * reverse order and the applied configuration is left unchanged. Should a
+ * restore fail too, or there be nothing to restore, the radio holds a mix of
+ * old and new values: the applied configuration is forgotten, so the next
+ * pass rewrites every field, and the fields in doubt are reported.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_RADIO_CONFIG_HPP
+#define GS_RADIO_CONFIG_HPP
+
+#include <stdint.h>
+#include <pthread.h>
+#include "phy.hpp"
+
+// TX is never used on Haystack; the transmitter is kept attenuated.
+#define GS_RADIO_CONFIG_TX_GAIN -85
+
+typedef enum
+{
+    GS_CONFIG_FILTER = 0,
+    GS_CONFIG_SAMP,
+    GS_CONFIG_BW,
+    GS_CONFIG_GAINMODE,
+    GS_CONFIG_LO,
+    GS_CONFIG_TX_GAIN,
+    GS_CONFIG_MODE,
+    GS_CONFIG_NUM_FIELDS
+} gs_config_field_t;
+
+#define GS_CONFIG_BIT(field) (1 << (field))
+#define GS_CONFIG_ALL (GS_CONFIG_BIT(GS_CONFIG_NUM_FIELDS) - 1)
+
+typedef struct gs_chain_t gs_chain_t;
+
+typedef struct
+{
+    pthread_mutex_t lock; // Protects the results below, which the status thread reads.
+
+    phy_config_t applied; // Last configuration written in full; network thread only.
+    bool have_applied;    // Until the first success every field counts as changed.
+
+    // Outcome of the last pass, see phy_status_t.
+    uint16_t changed;
+    uint16_t done;
+    uint16_t failed;
+    uint16_t rolled_back;
+    uint16_t unknown; // Until a pass succeeds.
+    uint32_t pass_us;
+    uint32_t field_us[GS_CONFIG_NUM_FIELDS];
+} gs_radio_config_t;
+
+/**
+ * @brief Sets up an empty configuration state.
+ *
+ * @param rc
+ * @return int 1 on success, negative on failure.
+ */
+int gs_radio_config_init(gs_radio_config_t *rc);
+
+/**
+ * @brief Applies the fields of config which differ from the applied configuration.
+ *
+ * @param chain
+ * @param config
+ * @return int 1 if every changed field was applied (or none changed), negative if the pass was rolled back.
+ */
+int gs_radio_config_apply(gs_chain_t *chain, const phy_config_t *config);
+
+/**
+ * @brief Copies the outcome of the last pass into a status frame.
+ *
+ * @param rc
+ * @param status
+ */
+void gs_radio_config_report(gs_radio_config_t *rc, phy_status_t *status);
+
+/**
+ * @brief Frees the configuration state.
+ *
+ * @param rc
+ */
+void gs_radio_config_destroy(gs_radio_config_t *rc);
+
+#endif // GS_RADIO_CONFIG_HPP
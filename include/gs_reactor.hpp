@@ -0,0 +1,93 @@
+/**
+ * @file gs_reactor.hpp
+ * @brief Single-threaded epoll event loop for the server connection.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Replaces the network receive, polling and status threads, which each slept
+ * in usleep(...) or a blocking recv(...). One thread now waits in
+ * epoll_wait(...) on:
+ *
+ *   socket     Frames from the server, parsed in place by gs_netframe_next(...)
+ *              and handed to gs_network_handle_frame(...).
+ *   poll       timerfd, every polling_rate seconds: POLL frame to the server.
+ *   status     timerfd, every polling_rate seconds: gs_xband_status_tick(...)
+ *              for every chain.
+ *   kick       One per chain, its status cache's eventfd: that chain's status
+ *              frame now.
+ *   connect    One-shot timerfd: next gs_connect_to_server(...) attempt,
+ *              backed off exponentially with jitter (see gs_startup.hpp).
+ *   idle       One-shot timerfd, re-armed by every frame received: the
+ *              connection is dropped if the server goes quiet for
+ *              HAYSTACK_NET_IDLE_SEC (default RECV_TIMEOUT, 0 disables).
+ *   stats      timerfd, every HAYSTACK_STATS_SEC (default 10, 0 disables):
+ *              GS_NETTYPE_STATS frame (see gs_metrics.hpp).
+ *   metrics    Listening Unix socket HAYSTACK_METRICS_SOCKET: Prometheus text.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_REACTOR_HPP
+#define GS_REACTOR_HPP
+
+#include <time.h>
+#include "phy.hpp"
+#include "gs_netframe.hpp"
+#include "gs_backend.hpp"
+#include "gs_startup.hpp"
+
+
+typedef struct global_data_t global_data_t;
+
+typedef struct
+{
+    int epfd;
+    int poll_tfd;
+    int status_tfd;
+    int connect_tfd;
+    int idle_tfd;
+    int stats_tfd;
+    int metrics_fd; // -1 if the metrics socket is disabled or failed.
+    int sock; // Socket registered with epfd, -1 if none.
+    int idle_sec;
+    int stats_sec;
+    gs_backoff_t connect_backoff[1]; // Reset on every connection.
+
+    // Frames from the server are parsed in place here; reset on every connection.
+    gs_netframe_rx_t rx[1];
+
+    // Last status frame sent for each chain on this connection.
+    phy_status_t last_status[GS_MAX_CHAINS];
+    struct timespec last_send[GS_MAX_CHAINS];
+} gs_reactor_t;
+
+/**
+ * @brief Creates the epoll set and timers.
+ *
+ * Reads HAYSTACK_NET_IDLE_SEC, HAYSTACK_STATS_SEC and HAYSTACK_METRICS_SOCKET.
+ *
+ * @param reactor
+ * @param global The chains' status caches must already be initialized.
+ * @return int 1 on success, negative on failure.
+ */
+int gs_reactor_init(gs_reactor_t *reactor, global_data_t *global);
+
+/**
+ * @brief Runs the event loop until recv_active is cleared or thread_status drops to 0 or below.
+ *
+ * Connects (and reconnects) to the server; the radios are brought up by gs_startup_start(...).
+ *
+ * @param args global_data_t *
+ * @return void*
+ */
+void *gs_network_reactor_thread(void *args);
+
+/**
+ * @brief Closes the epoll set, timers and metrics socket. The server socket is left to the caller.
+ *
+ * @param reactor
+ */
+void gs_reactor_destroy(gs_reactor_t *reactor);
+
+#endif // GS_REACTOR_HPP
@@ -0,0 +1,78 @@
+/**
+ * @file gs_rs.hpp
+ * @brief CCSDS Reed-Solomon (255,223) encoder and decoder.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The code of CCSDS 131.0-B: GF(256) with field polynomial 0x187, generator
+ * roots alpha^(11 * (112 + i)), i = 0..31. It corrects up to 16 symbol errors
+ * in each 255 symbol codeword. Symbols may be in the Berlekamp dual basis the
+ * standard transmits, or in the conventional basis.
+ *
+ * A codeword is read and written in place with a stride, so an interleaved
+ * codeblock (symbol m of codeword k at m * I + k) needs no reshuffling, and
+ * may be shortened: pad leading data symbols are taken to be zero and are not
+ * stored.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_RS_HPP
+#define GS_RS_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GS_RS_N 255
+#define GS_RS_K 223
+#define GS_RS_PARITY 32 // Check symbols per codeword; up to 16 symbol errors are corrected.
+
+/**
+ * @brief Fills in a codeword's check symbols from its data symbols.
+ *
+ * @param codeword 223 - pad data symbols followed by room for 32 check symbols, stride bytes apart.
+ * @param stride
+ * @param pad
+ * @param dual_basis
+ */
+void gs_rs_encode(uint8_t *codeword, size_t stride, int pad, bool dual_basis);
+
+/**
+ * @brief Corrects a codeword in place.
+ *
+ * @param codeword 255 - pad symbols, stride bytes apart.
+ * @param stride
+ * @param pad
+ * @param dual_basis
+ * @return int Symbols corrected, or -1 if there were more errors than the code can correct (the codeword is left as it was).
+ */
+int gs_rs_decode(uint8_t *codeword, size_t stride, int pad, bool dual_basis);
+
+/**
+ * @brief The codeword's 32 syndromes, all zero if it has no errors, using the widest vector unit available.
+ *
+ * gs_rs_decode(...) computes these first and stops there for an error-free
+ * codeword, so they are most of its cost on a clean link.
+ *
+ * @param codeword
+ * @param stride
+ * @param pad
+ * @param dual_basis
+ * @param syndromes Conventional basis.
+ */
+void gs_rs_syndromes(const uint8_t *codeword, size_t stride, int pad, bool dual_basis, uint8_t syndromes[GS_RS_PARITY]);
+
+/**
+ * @brief gs_rs_syndromes(...) with log/antilog tables and no vector instructions; the fallback, and a baseline for bench/fec_bench.
+ *
+ */
+void gs_rs_syndromes_scalar(const uint8_t *codeword, size_t stride, int pad, bool dual_basis, uint8_t syndromes[GS_RS_PARITY]);
+
+/**
+ * @brief Which gs_rs_syndromes(...) implementation this machine uses: avx2, ssse3, neon or scalar.
+ *
+ */
+const char *gs_rs_syndromes_name();
+
+#endif // GS_RS_HPP
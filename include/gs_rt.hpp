@@ -0,0 +1,105 @@
+/**
+ * @file gs_rt.hpp
+ * @brief Scheduling policy, CPU affinity and memory locking for the Haystack threads.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Each thread Haystack starts has a role. A role's settings come from
+ *
+ *   HAYSTACK_RT_<ROLE>_SCHED  other (default), fifo:<priority> or rr:<priority>
+ *   HAYSTACK_RT_<ROLE>_CPUS   CPU list such as 2 or 2,3 or 4-7; unset for no pinning
+ *
+ * where ROLE is RX, FORWARD, NETWORK, WRITER, COMPRESS or FEC. The per-chain
+ * roles (RX, FORWARD, WRITER, FEC) may be set for one chain as
+ * HAYSTACK_CHAIN<n>_RT_<ROLE>_... . Status frames are built on the network
+ * reactor, so NETWORK covers status polling as well. Every other thread
+ * (main, logging, the modem library's own) is moved to HAYSTACK_RT_OTHER_CPUS
+ * if set, so it can be kept off the receive cores.
+ *
+ * Threads get a HAYSTACK_RT_STACK_KB stack (default 512) whose first half is
+ * touched before the thread's function runs, so it does not take page faults
+ * later. HAYSTACK_RT_MLOCK=1 locks all current and future memory; it is off by
+ * default since MCL_FUTURE makes allocations past RLIMIT_MEMLOCK fail.
+ *
+ * Jitter is reported two ways:
+ *   - HAYSTACK_RT_PROBE_US=<interval> runs a probe thread with the RX role's
+ *     settings which sleeps to absolute deadlines and records how late each
+ *     wakeup was in the sched_wakeup histogram (see gs_metrics.hpp);
+ *   - every role thread's time spent runnable but waiting for a CPU, and its
+ *     involuntary context switches, are exported with the metrics and logged
+ *     by gs_rt_report(...).
+ *
+ * SCHED_FIFO/SCHED_RR need CAP_SYS_NICE or an RLIMIT_RTPRIO allowance; without
+ * them threads are started with the default policy and a warning.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_RT_HPP
+#define GS_RT_HPP
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define GS_RT_DEFAULT_STACK_KB 512
+#define GS_RT_MAX_THREADS 32 // Threads tracked for the report; more still run.
+
+typedef enum
+{
+    GS_RT_RX = 0,
+    GS_RT_FORWARD,
+    GS_RT_NETWORK,
+    GS_RT_WRITER,
+    GS_RT_COMPRESS,
+    GS_RT_FEC,
+    GS_RT_PROBE, // Uses the RX role's settings.
+    GS_RT_NUM_ROLES
+} gs_rt_role_t;
+
+/**
+ * @brief Reads the HAYSTACK_RT_* settings, moves existing threads to HAYSTACK_RT_OTHER_CPUS and locks memory if asked.
+ *
+ * Call before the role threads are started; with HAYSTACK_RT_MLOCK=1 buffers
+ * allocated afterwards are locked as well.
+ *
+ * @return int 1 on success, negative if memory locking was asked for and failed (the rest still applies).
+ */
+int gs_rt_init();
+
+/**
+ * @brief pthread_create(...) with the role's policy, priority, CPUs and stack.
+ *
+ * Falls back to the default policy and no pinning if the role's cannot be applied.
+ *
+ * @param tid
+ * @param role
+ * @param chain Chain index for the per-chain roles, -1 otherwise.
+ * @param fn
+ * @param arg
+ * @return int 0 on success, an error number as from pthread_create(...) otherwise.
+ */
+int gs_rt_thread_create(pthread_t *tid, gs_rt_role_t role, int chain, void *(*fn)(void *), void *arg);
+
+/**
+ * @brief Writes each role thread's scheduling and runqueue wait in the Prometheus text format.
+ *
+ * @param buf
+ * @param len
+ * @return size_t Bytes written (truncated to len - 1).
+ */
+size_t gs_rt_format(char *buf, size_t len);
+
+/**
+ * @brief Logs one line per role thread, and the probe's wakeup latencies if it runs.
+ *
+ */
+void gs_rt_report();
+
+/**
+ * @brief Stops the probe thread.
+ *
+ */
+void gs_rt_destroy();
+
+#endif // GS_RT_HPP
@@ -0,0 +1,175 @@
+/**
+ * @file gs_spool.hpp
+ * @brief On-disk store-and-forward ring for DATA frames the server could not take.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * While the server connection is down, or a send fails, the forward thread
+ * appends each DATA payload to its chain's spool file instead of dropping it:
+ *
+ *   HAYSTACK_SPOOL       1 (default) to spool, 0 to drop as before
+ *   HAYSTACK_SPOOL_DIR   Directory of the spool files (default .)
+ *   HAYSTACK_SPOOL_MB    Ring size (default 1024); frames that do not fit are dropped
+ *
+ * each settable per chain as HAYSTACK_CHAIN<n>_SPOOL_... . The file is
+ * <dir>/haystack.spool, or haystack_ch<n>.spool with several chains: a
+ * gs_spool_header_t, then a ring of gs_spool_record_t records, each followed
+ * by its payload. A record never wraps; the space left at the end of the ring
+ * is skipped, marked by a GS_SPOOL_PAD_MAGIC record if there is room for one.
+ *
+ * Records are staged in memory and written in large batches, and the header
+ * is only rewritten after the records it counts are on disk, so the spool
+ * survives a restart: whatever an earlier run left is sent once the server is
+ * back. Once connected, the forward thread sends live frames first and drains
+ * the backlog whenever it has none, reading the ring in large chunks and
+ * sending up to GS_NETFRAME_MAX_BATCH frames per write. Backlog frames are
+ * ordinary DATA frames and so reach the server after newer live ones; a frame
+ * being sent when the connection drops may be sent twice.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_SPOOL_HPP
+#define GS_SPOOL_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#include <atomic>
+#include "gs_netframe.hpp"
+#include "gs_pipeline.hpp"
+
+#define GS_SPOOL_DEFAULT_DIR "."
+#define GS_SPOOL_DEFAULT_MB 1024
+#define GS_SPOOL_STAGE_SIZE (1 << 20) // Records written per batch; also the largest record.
+#define GS_SPOOL_READ_SIZE (1 << 20)  // Ring read per drain pass.
+
+#define GS_SPOOL_MAGIC 0x4c505348 // "HSPL"
+#define GS_SPOOL_VERSION 1
+#define GS_SPOOL_HEADER_SIZE 4096 // The ring starts here.
+#define GS_SPOOL_RECORD_MAGIC 0x52505348 // "HSPR"
+#define GS_SPOOL_PAD_MAGIC 0x50505348    // "HSPP", the rest of the ring up to its end is unused.
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint64_t capacity; // Ring bytes after the header.
+    uint64_t head;     // Ring offset of the oldest unsent record, counted from creation (so mod capacity).
+    uint64_t tail;     // Likewise, just past the newest record on disk.
+    uint64_t records;  // Records between head and tail.
+} gs_spool_header_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t length; // Payload bytes that follow.
+} gs_spool_record_t;
+
+typedef struct
+{
+    bool enabled;
+    char path[512];
+    uint64_t capacity;
+    int chain; // For log messages.
+} gs_spool_config_t;
+
+typedef struct
+{
+    gs_spool_config_t config;
+    int fd; // -1 if the spool is off.
+
+    // Only the forward thread touches these.
+    uint64_t capacity;
+    uint64_t head;
+    uint64_t tail;    // Includes staged records.
+    uint64_t flushed; // Ring offset where the staged records go; everything before is on disk.
+    uint64_t records; // Includes staged records.
+    uint8_t *stage;
+    size_t stage_len;
+    uint64_t stage_records;
+    uint8_t *read_buf;
+    bool full; // Dropping frames until some are drained.
+    bool draining;
+    uint64_t drain_start_ns;
+    uint64_t drain_start_bytes;
+    uint64_t window_start_ns; // Drain rate is measured over windows of about a second.
+    uint64_t window_bytes;
+
+    // Read by the status tick.
+    std::atomic<uint64_t> depth_bytes;
+    std::atomic<uint64_t> depth_frames;
+    std::atomic<uint64_t> drain_rate; // Bytes per second over the last window.
+    std::atomic<uint64_t> spooled;    // Frames appended.
+    std::atomic<uint64_t> drained;    // Bytes sent from the spool.
+    std::atomic<uint64_t> dropped;    // Frames that did not fit.
+    std::atomic<uint64_t> errors;     // Failed reads and writes.
+} gs_spool_t;
+
+/**
+ * @brief Reads one chain's HAYSTACK_SPOOL_* settings.
+ *
+ * @param config
+ * @param chain
+ * @param num_chains The file name carries the chain number if there are several.
+ */
+void gs_spool_config_load(gs_spool_config_t *config, int chain, int num_chains);
+
+/**
+ * @brief Opens the spool file, picking up any backlog an earlier run left in it.
+ *
+ * @param spool
+ * @param config
+ * @return int 1 on success, 0 if spooling is off, negative on failure.
+ */
+int gs_spool_init(gs_spool_t *spool, const gs_spool_config_t *config);
+
+/**
+ * @brief Appends one frame's payload, gathered from iovcnt pieces. Forward thread only.
+ *
+ * @param spool
+ * @param payload
+ * @param iovcnt
+ * @return int 1 if spooled, -1 if it was dropped (spool off or full, or a write failed).
+ */
+int gs_spool_append(gs_spool_t *spool, const struct iovec *payload, int iovcnt);
+
+/**
+ * @brief Whether there is a backlog to drain.
+ *
+ */
+static inline bool gs_spool_pending(const gs_spool_t *spool)
+{
+    return spool->records > 0;
+}
+
+/**
+ * @brief Sends backlog frames as DATA frames to the client, oldest first. Forward thread only.
+ *
+ * Reads up to GS_SPOOL_READ_SIZE of the ring and returns early if a live
+ * buffer is waiting in live.
+ *
+ * @param spool
+ * @param network_data
+ * @param live The forward stage.
+ * @return int Frames sent, negative if a send failed.
+ */
+int gs_spool_drain(gs_spool_t *spool, NetData *network_data, gs_stage_t *live);
+
+/**
+ * @brief Writes out staged records; for when the forward thread is idle. Forward thread only.
+ *
+ * @param spool
+ */
+void gs_spool_flush(gs_spool_t *spool);
+
+/**
+ * @brief Writes out staged records and closes the spool file.
+ *
+ * @param spool
+ */
+void gs_spool_destroy(gs_spool_t *spool);
+
+#endif // GS_SPOOL_HPP
@@ -0,0 +1,106 @@
+/**
+ * @file gs_spsc_ring.hpp
+ * @brief Bounded lock-free single-producer/single-consumer ring.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_SPSC_RING_HPP
+#define GS_SPSC_RING_HPP
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+template <typename T>
+class gs_spsc_ring
+{
+public:
+    gs_spsc_ring() : slots(nullptr), mask(0), head(0), tail(0) {}
+    ~gs_spsc_ring() { delete[] slots; }
+
+    gs_spsc_ring(const gs_spsc_ring &) = delete;
+    gs_spsc_ring &operator=(const gs_spsc_ring &) = delete;
+
+    /**
+     * @brief Allocates the ring. Capacity is rounded up to a power of two.
+     *
+     * @return int 1 on success, -1 on failure.
+     */
+    int init(uint32_t capacity)
+    {
+        uint32_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        delete[] slots;
+        slots = new (std::nothrow) T[size];
+        if (slots == nullptr)
+        {
+            return -1;
+        }
+        mask = size - 1;
+        head = 0;
+        tail = 0;
+        return 1;
+    }
+
+    uint32_t capacity() const { return mask + 1; }
+
+    /**
+     * @brief Producer only. Returns false if the ring is full.
+     *
+     */
+    bool push(const T &item)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) > mask)
+        {
+            return false;
+        }
+        slots[h & mask] = item;
+        // seq_cst so that a consumer announcing it is about to sleep either sees this item or is seen by the producer.
+        head.store(h + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    /**
+     * @brief Consumer only. Returns false if the ring is empty.
+     *
+     */
+    bool pop(T *item)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_seq_cst))
+        {
+            return false;
+        }
+        *item = slots[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Approximate number of queued items; exact from either end's own thread.
+     *
+     */
+    uint32_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    T *slots;
+    uint32_t mask;
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) std::atomic<uint32_t> tail;
+};
+
+#endif // GS_SPSC_RING_HPP
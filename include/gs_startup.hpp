@@ -0,0 +1,160 @@
+/**
+ * @file gs_startup.hpp
+ * @brief Brings up the server connection and every chain's RX modem, radio and PLL at once.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Each chain's RX modem, radio and PLL is initialized on a worker of its own
+ * while the network reactor connects to the server, so cold start takes as
+ * long as the slowest of them rather than their sum. Failed attempts, and the
+ * reactor's connection attempts, are retried with exponential backoff and
+ * jitter (gs_backoff_t) instead of a fixed sleep:
+ *
+ *   HAYSTACK_RETRY_MIN_MS  First retry delay (default 100)
+ *   HAYSTACK_RETRY_MAX_MS  Longest retry delay (default 5000)
+ *   HAYSTACK_STARTUP_PLL   1 (default) to set up the PLL at startup, 0 to
+ *                          wait for XBC_INIT_PLL as before
+ *
+ * Once everything is up, the time each part took to become ready, and how
+ * many attempts it needed, is logged as one line.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_STARTUP_HPP
+#define GS_STARTUP_HPP
+
+#include <stdint.h>
+#include <pthread.h>
+#include "gs_backend.hpp"
+
+#define GS_BACKOFF_DEFAULT_MIN_MS 100
+#define GS_BACKOFF_DEFAULT_MAX_MS 5000 // The fixed retry interval this replaced.
+
+typedef struct global_data_t global_data_t;
+
+/**
+ * @brief Exponential backoff with jitter: each delay is between half and all of min_ms << attempts, at most max_ms.
+ *
+ */
+typedef struct
+{
+    int min_ms;
+    int max_ms;
+    int attempts; // Failures since the last gs_backoff_reset(...).
+    uint32_t rng;
+} gs_backoff_t;
+
+/**
+ * @brief Reads HAYSTACK_RETRY_MIN_MS and HAYSTACK_RETRY_MAX_MS.
+ *
+ * @param backoff
+ * @param seed Different for every user, so retries that failed together do not retry together.
+ */
+void gs_backoff_init(gs_backoff_t *backoff, uint32_t seed);
+
+/**
+ * @brief Counts a failure and returns how long to wait before the next attempt.
+ *
+ * @param backoff
+ * @return int Milliseconds.
+ */
+int gs_backoff_next_ms(gs_backoff_t *backoff);
+
+/**
+ * @brief Starts over from min_ms, after a success.
+ *
+ * @param backoff
+ */
+static inline void gs_backoff_reset(gs_backoff_t *backoff)
+{
+    backoff->attempts = 0;
+}
+
+typedef enum
+{
+    GS_STARTUP_SERVER = 0, // Connected by the network reactor, not a worker.
+    GS_STARTUP_MODEM,
+    GS_STARTUP_RADIO,
+    GS_STARTUP_PLL,
+    GS_STARTUP_NUM_PARTS
+} gs_startup_part_t;
+
+#define GS_STARTUP_MAX_TASKS (1 + GS_MAX_CHAINS * (GS_STARTUP_NUM_PARTS - 1))
+
+typedef struct gs_startup_t gs_startup_t;
+
+typedef struct
+{
+    gs_startup_t *startup;
+    gs_chain_t *chain; // NULL for the server connection.
+    gs_startup_part_t part;
+    bool wanted;  // Counts toward ready; false for a PLL left to XBC_INIT_PLL.
+    bool started; // Has a worker to join.
+    pthread_t tid;
+
+    // Under the startup lock.
+    bool busy; // The worker is still trying.
+    bool ready;
+    uint64_t ready_ns; // After start_ns.
+    int attempts;
+} gs_startup_task_t;
+
+struct gs_startup_t
+{
+    uint64_t start_ns;
+    int num_tasks;
+    gs_startup_task_t task[GS_STARTUP_MAX_TASKS]; // The server, then each chain's modem, radio and PLL.
+    int pending; // Wanted tasks not yet ready.
+
+    // Guards the tasks' progress, and wakes workers waiting out a backoff when gs_startup_stop(...) is called.
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool running;
+};
+
+/**
+ * @brief Starts a worker for every chain's RX modem, radio and (HAYSTACK_STARTUP_PLL) PLL.
+ *
+ * Each sets its chain's rx_modem_ready, radio_ready or PLL_ready and kicks
+ * its status once the part is up. The chains must be initialized.
+ *
+ * @param startup
+ * @param global
+ * @param start_ns gs_metrics_now_ns() when the process started; ready times are counted from it.
+ * @return int 1 on success, negative if a worker could not be started.
+ */
+int gs_startup_start(gs_startup_t *startup, global_data_t *global, uint64_t start_ns);
+
+/**
+ * @brief Records that a part is up; once all are, logs the time-to-ready breakdown.
+ *
+ * Later calls for a part already up are ignored, so the reactor may call it on every connection.
+ *
+ * @param startup
+ * @param part
+ * @param chain -1 for the server connection.
+ * @param attempts
+ */
+void gs_startup_ready(gs_startup_t *startup, gs_startup_part_t part, int chain, int attempts);
+
+/**
+ * @brief Whether a worker is still bringing up this part, so it must not be touched.
+ *
+ * Once false it stays so: the worker has returned, and its chain's ready flag is final.
+ *
+ * @param startup
+ * @param part
+ * @param chain
+ */
+bool gs_startup_busy(gs_startup_t *startup, gs_startup_part_t part, int chain);
+
+/**
+ * @brief Stops workers still retrying, and waits for them.
+ *
+ * @param startup
+ */
+void gs_startup_stop(gs_startup_t *startup);
+
+#endif // GS_STARTUP_HPP
@@ -0,0 +1,125 @@
+/**
+ * @file gs_status.hpp
+ * @brief Cached radio status for the network reactor's status frames.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * LO, sample rate, bandwidth, gain mode and ENSM mode only change when we call
+ * radio_set_*, so they are read once and kept until the config path marks
+ * them stale. RSSI, temperature and RX gain (which moves under AGC) are
+ * re-read every poll tick. Marking fields stale or kicking the cache wakes
+ * the status thread so the change goes out immediately.
+ *
+ * A tick only sends a frame when the radio or the chain's state changed:
+ * the stable fields, the ready and armed flags, the last XBAND_CONFIG's
+ * outcome, or RSSI, temperature or RX gain beyond their deadbands. Queue,
+ * drop, FEC and spool counters move with every packet during a pass, so
+ * they ride along on those frames and on the keepalive.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef GS_STATUS_HPP
+#define GS_STATUS_HPP
+
+#include <stdint.h>
+#include <pthread.h>
+#include "phy.hpp"
+#include "gs_backend.hpp"
+
+// Fields which only change on our own radio_set_* calls.
+#define GS_STATUS_STABLE (GS_RADIO_ENSM_MODE | GS_RADIO_RX_LO | GS_RADIO_SAMP | GS_RADIO_RX_BW | GS_RADIO_RX_GAINMODE)
+// Fields re-read on every poll.
+#define GS_STATUS_VOLATILE (GS_RADIO_RX_GAIN | GS_RADIO_RSSI | GS_RADIO_TEMP)
+
+#define GS_STATUS_DEFAULT_KEEPALIVE_SEC 30
+#define GS_STATUS_DEFAULT_RSSI_DB 1.0
+#define GS_STATUS_DEFAULT_TEMP_MC 1000 // Millidegrees C.
+#define GS_STATUS_DEFAULT_GAIN_DB 1.0
+
+typedef struct gs_chain_t gs_chain_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint32_t stale; // GS_RADIO_* fields to re-read on the next refresh.
+    int kick_fd;    // eventfd, readable when a frame should go out before the next tick.
+
+    gs_radio_attrs_t attrs; // Last good value of each stable field.
+
+    int keepalive_sec;    // Longest gap between frames when nothing changes.
+    double rssi_deadband; // RSSI moves smaller than this (dB) are not a change.
+    int64_t temp_deadband; // Likewise temperature, millidegrees C.
+    double gain_deadband;  // Likewise RX gain, dB.
+} gs_status_cache_t;
+
+/**
+ * @brief Sets up the cache with every stable field stale.
+ *
+ * Reads HAYSTACK_STATUS_KEEPALIVE_SEC and the deadbands HAYSTACK_STATUS_RSSI_DB,
+ * HAYSTACK_STATUS_TEMP_MC and HAYSTACK_STATUS_GAIN_DB.
+ *
+ * @param cache
+ * @return int 1 on success, negative on failure.
+ */
+int gs_status_init(gs_status_cache_t *cache);
+
+/**
+ * @brief Marks fields stale and wakes the network reactor to send them.
+ *
+ * Called by the config path after radio_set_*, whether or not the set succeeded.
+ *
+ * @param cache
+ * @param fields GS_RADIO_* bits.
+ */
+void gs_status_invalidate(gs_status_cache_t *cache, uint32_t fields);
+
+/**
+ * @brief Wakes the network reactor to send a frame now, e.g. after arming RX.
+ *
+ * @param cache
+ */
+void gs_status_kick(gs_status_cache_t *cache);
+
+/**
+ * @brief Clears a pending kick; called when kick_fd polls readable.
+ *
+ * @param cache
+ * @return true if kicked or invalidated since the last call.
+ */
+bool gs_status_take_kick(gs_status_cache_t *cache);
+
+/**
+ * @brief Fills the radio fields of status, reading only stale and volatile attributes.
+ *
+ * Everything needed is fetched with one radio_read_attrs(...) call.
+ *
+ * Network reactor only.
+ *
+ * @param chain
+ * @param status
+ */
+void gs_status_refresh(gs_chain_t *chain, phy_status_t *status);
+
+/**
+ * @brief Whether status differs from the last frame sent enough to be worth sending.
+ *
+ * Counters are not compared; see above.
+ *
+ * @param cache
+ * @param last
+ * @param status
+ * @return true
+ * @return false
+ */
+bool gs_status_changed(const gs_status_cache_t *cache, const phy_status_t *last, const phy_status_t *status);
+
+/**
+ * @brief Frees the cache.
+ *
+ * @param cache
+ */
+void gs_status_destroy(gs_status_cache_t *cache);
+
+#endif // GS_STATUS_HPP
@@ -2,34 +2,131 @@
  * @file gs_debug.hpp
  * @author Mit Bailey (mitbailey99@gmail.com)
  * @brief Contains debug-related macros and function-like macros.
- * @version 0.1
+ * @version 0.2
  * @date 2021.07.26
- * 
+ *
+ * dbprintlf, dbprintf and erprintlf format into a per-thread lock-free ring
+ * buffer; a background thread drains the rings to stderr. The log level of a
+ * message is taken from its color prefix at compile time (FATAL, RED = error,
+ * YELLOW = warning, other colors = info, uncolored = debug). Levels above
+ * MEB_LOG_LEVEL_MAX compile to nothing; levels above the runtime level set by
+ * HAYSTACK_LOG_LEVEL or meb_log_set_level(...) are skipped before formatting.
+ *
  * @copyright Copyright (c) 2021
- * 
+ *
  */
 
 #ifndef MEB_DEBUG_HPP
 #define MEB_DEBUG_HPP
 
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+
+#define MEB_LOG_FATAL 0
+#define MEB_LOG_ERROR 1
+#define MEB_LOG_WARN 2
+#define MEB_LOG_INFO 3
+#define MEB_LOG_DEBUG 4
+
+#ifndef MEB_LOG_LEVEL_MAX
+#define MEB_LOG_LEVEL_MAX MEB_LOG_DEBUG
+#endif // MEB_LOG_LEVEL_MAX
+
+// Hex dumps are limited to this many per second and this many bytes each.
+#define MEB_HEXDUMP_PER_SEC 2
+#define MEB_HEXDUMP_MAX_BYTES 64
+
+extern std::atomic<int> meb_log_level;
+
+/**
+ * @brief Formats a message into the calling thread's ring buffer.
+ *
+ * Fatal messages are written to stderr synchronously instead.
+ *
+ */
+void meb_log_write(int level, const char *file, int line, const char *func, const char *format, ...) __attribute__((format(printf, 5, 6)));
+
+/**
+ * @brief Logs the first MEB_HEXDUMP_MAX_BYTES bytes of a buffer, at most MEB_HEXDUMP_PER_SEC times a second.
+ *
+ */
+void meb_log_hexdump(int level, const char *file, int line, const char *func, const void *buf, size_t len);
+
+/**
+ * @brief Sets the runtime log level.
+ *
+ * @param level One of MEB_LOG_*.
+ */
+void meb_log_set_level(int level);
+
+/**
+ * @brief Writes out everything currently buffered. Called automatically at exit.
+ *
+ */
+void meb_log_flush();
+
+constexpr bool meb_log_prefix(const char *str, const char *prefix)
+{
+    while (*prefix)
+    {
+        if (*str++ != *prefix++)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr int meb_log_level_of(const char *format)
+{
+    return meb_log_prefix(format, "\033[1m") ? MEB_LOG_FATAL
+           : (meb_log_prefix(format, "\x1b[91m") || meb_log_prefix(format, "\x1b[101m")) ? MEB_LOG_ERROR
+           : (meb_log_prefix(format, "\x1b[33m") || meb_log_prefix(format, "\x1b[43m")) ? MEB_LOG_WARN
+           : meb_log_prefix(format, "\x1b[") ? MEB_LOG_INFO
+                                             : MEB_LOG_DEBUG;
+}
+
+#define meb_log_at(level, ...)                                                     \
+    do                                                                             \
+    {                                                                              \
+        constexpr int _meb_level = (level);                                        \
+        if constexpr (_meb_level <= MEB_LOG_LEVEL_MAX)                             \
+        {                                                                          \
+            if (_meb_level <= meb_log_level.load(std::memory_order_relaxed))       \
+            {                                                                      \
+                meb_log_write(_meb_level, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+            }                                                                      \
+        }                                                                          \
+    } while (0)
+
 #ifndef dbprintlf
-#define dbprintlf(format, ...)                                                                        \
-    fprintf(stderr, "[%s:%d | %s] " format "\x1b[0m\n", __FILE__, __LINE__, __func__, ##__VA_ARGS__); \
-    fflush(stderr);
+#define dbprintlf(format, ...) meb_log_at(meb_log_level_of(format), format "\x1b[0m\n", ##__VA_ARGS__)
 #endif // dbprintlf
 
 #ifndef dbprintf
-#define dbprintf(format, ...)                                                                       \
-    fprintf(stderr, "[%s:%d | %s] " format "\x1b[0m", __FILE__, __LINE__, __func__, ##__VA_ARGS__); \
-    fflush(stderr);
+#define dbprintf(format, ...) meb_log_at(meb_log_level_of(format), format "\x1b[0m", ##__VA_ARGS__)
 #endif // dbprintf
 
 #ifndef erprintlf
-#define erprintlf(error)                                                                                               \
-    fprintf(stderr, "[%s:%d | %s] \x1b[94m>>> %d: %s\x1b[0m\n", __FILE__, __LINE__, __func__, error, strerror(error)); \
-    fflush(stderr);
+#define erprintlf(error) meb_log_at(MEB_LOG_ERROR, "\x1b[94m>>> %d: %s\x1b[0m\n", error, strerror(error))
 #endif // erprintlf
 
+#ifndef dbhexdump
+#define dbhexdump(buf, len)                                                          \
+    do                                                                               \
+    {                                                                                \
+        if constexpr (MEB_LOG_DEBUG <= MEB_LOG_LEVEL_MAX)                            \
+        {                                                                            \
+            if (MEB_LOG_DEBUG <= meb_log_level.load(std::memory_order_relaxed))      \
+            {                                                                        \
+                meb_log_hexdump(MEB_LOG_DEBUG, __FILE__, __LINE__, __func__, buf, len); \
+            }                                                                        \
+        }                                                                            \
+    } while (0)
+#endif // dbhexdump
+
 #ifndef MEB_COLORS
 #define MEB_COLORS
 #define RESET_ALL "\x1b[0m"
@@ -52,4 +149,4 @@
 #define FATAL "\033[1m\x1b[107m\x1b[31m(FATAL) "
 #endif // MEB_CODES
 
-#endif // MEB_DEBUG_HPP
\ No newline at end of file
+#endif // MEB_DEBUG_HPP
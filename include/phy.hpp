@@ -60,6 +60,29 @@ typedef struct __attribute__((packed))
     uint32_t MTU;
     int32_t last_rx_status;
     int32_t last_read_status;
+    uint32_t pool_in_use;    // Receive buffers currently held
+    uint32_t pool_exhausted; // Receives dropped because the buffer pool was empty
+    uint32_t pool_oversize;  // Receives larger than a pool buffer
+    uint32_t persist_queued;      // Packets waiting for the capture writer
+    uint32_t persist_dropped;     // Packets the capture writer fell behind on
+    uint32_t forward_queued;      // Packets waiting to be sent to the server
+    uint32_t forward_dropped;     // Packets the network sender fell behind on
+    uint32_t forward_send_errors; // Failed DATA frame sends
+    uint16_t config_changed;      // Fields of the last XBAND_CONFIG that differed from the applied config (GS_CONFIG_* bits)
+    uint16_t config_applied;      // Of those, fields written successfully
+    uint16_t config_failed;       // Bit of the field whose write failed and triggered a rollback, 0 if none
+    uint16_t config_rolled_back;  // Fields restored to their previous value after a failure
+    uint32_t config_pass_us;      // Duration of the last XBAND_CONFIG pass
+    uint32_t config_field_us[7];  // Per-field write time in the last pass, indexed by gs_config_field_t
+    uint32_t fec_codewords;       // Reed-Solomon codewords decoded (HAYSTACK_FEC=rs)
+    uint32_t fec_corrected;       // Symbols they corrected
+    uint32_t fec_uncorrectable;   // Codewords with more errors than could be corrected
+    uint32_t fec_dropped;         // Receive buffers the decoders fell behind on
+    uint32_t spool_frames;        // DATA frames waiting in the spool for the server (HAYSTACK_SPOOL)
+    uint32_t spool_kb;            // Their size, KiB
+    uint32_t spool_drain_kbps;    // Spool drain rate over the last second, KiB/s
+    uint32_t spool_dropped;       // DATA frames lost because the spool was off, full or failed
+    uint16_t config_unknown;      // Fields left in an unknown state by a failed pass or rollback; the next XBAND_CONFIG rewrites every field
 } phy_status_t;
 
 #endif // PHY_HPP
\ No newline at end of file
@@ -0,0 +1,101 @@
+/**
+ * @file gs_backend.cpp
+ * @brief Helpers shared by the radio backends.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include "gs_backend.hpp"
+#include "gs_haystack.hpp"
+
+int gs_radio_read_each(gs_chain_t *chain, gs_radio_attrs_t *attrs, uint32_t mask)
+{
+    const gs_backend_t *backend = chain->backend;
+    uint32_t done = 0;
+
+    if ((mask & GS_RADIO_ENSM_MODE) && backend->radio_get_ensm_mode(chain, attrs->ensm_mode, sizeof(attrs->ensm_mode)) >= 0)
+    {
+        done |= GS_RADIO_ENSM_MODE;
+    }
+    if ((mask & GS_RADIO_RX_LO) && backend->radio_get_rx_lo(chain, &attrs->rx_lo) >= 0)
+    {
+        done |= GS_RADIO_RX_LO;
+    }
+    if ((mask & GS_RADIO_SAMP) && backend->radio_get_samp(chain, &attrs->samp) >= 0)
+    {
+        done |= GS_RADIO_SAMP;
+    }
+    if ((mask & GS_RADIO_RX_BW) && backend->radio_get_rx_bw(chain, &attrs->rx_bw) >= 0)
+    {
+        done |= GS_RADIO_RX_BW;
+    }
+    if ((mask & GS_RADIO_RX_GAINMODE) && backend->radio_get_rx_hardwaregainmode(chain, attrs->rx_gainmode, sizeof(attrs->rx_gainmode)) >= 0)
+    {
+        done |= GS_RADIO_RX_GAINMODE;
+    }
+    if ((mask & GS_RADIO_RX_GAIN) && backend->radio_get_rx_hardwaregain(chain, &attrs->rx_gain) >= 0)
+    {
+        done |= GS_RADIO_RX_GAIN;
+    }
+    if ((mask & GS_RADIO_RSSI) && backend->radio_get_rssi(chain, &attrs->rssi) >= 0)
+    {
+        done |= GS_RADIO_RSSI;
+    }
+    if ((mask & GS_RADIO_TEMP) && backend->radio_get_temp(chain, &attrs->temp) >= 0)
+    {
+        done |= GS_RADIO_TEMP;
+    }
+    // There is no per-attribute TX gain getter.
+
+    return done;
+}
+
+int gs_radio_write_each(gs_chain_t *chain, const gs_radio_attrs_t *attrs, uint32_t mask)
+{
+    const gs_backend_t *backend = chain->backend;
+    uint32_t done = 0;
+
+    if (mask & GS_RADIO_ENSM_MODE)
+    {
+        ensm_mode mode = SLEEP;
+        if (strcmp(attrs->ensm_mode, "fdd") == 0)
+        {
+            mode = FDD;
+        }
+        else if (strcmp(attrs->ensm_mode, "tdd") == 0)
+        {
+            mode = TDD;
+        }
+        if (backend->radio_set_ensm_mode(chain, mode) >= 0)
+        {
+            done |= GS_RADIO_ENSM_MODE;
+        }
+    }
+    if ((mask & GS_RADIO_RX_LO) && backend->radio_set_rx_lo(chain, attrs->rx_lo) >= 0)
+    {
+        done |= GS_RADIO_RX_LO;
+    }
+    if ((mask & GS_RADIO_SAMP) && backend->radio_set_samp(chain, attrs->samp) >= 0)
+    {
+        done |= GS_RADIO_SAMP;
+    }
+    if ((mask & GS_RADIO_RX_BW) && backend->radio_set_rx_bw(chain, attrs->rx_bw) >= 0)
+    {
+        done |= GS_RADIO_RX_BW;
+    }
+    if ((mask & GS_RADIO_TX_GAIN) && backend->radio_set_tx_hardwaregain(chain, attrs->tx_gain) >= 0)
+    {
+        done |= GS_RADIO_TX_GAIN;
+    }
+    if ((mask & GS_RADIO_RX_GAINMODE) &&
+        backend->radio_set_rx_hardwaregainmode(chain, strcmp(attrs->rx_gainmode, "fast_attack") == 0 ? FAST_ATTACK : SLOW_ATTACK) >= 0)
+    {
+        done |= GS_RADIO_RX_GAINMODE;
+    }
+
+    return done;
+}
@@ -0,0 +1,418 @@
+/**
+ * @file gs_backend_hw.cpp
+ * @brief Hardware backend: rxmodem, AD9361 (libiio) and ADF4355.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Each chain finds its devices through HAYSTACK_CHAIN<n>_* settings:
+ * UIO_RX_IPCORE, UIO_RX_DMA, IIO_URI and PLL_SPI_CS. Chain 0 defaults to the
+ * single-chain board (rx_ipcore, rx_dma, the local context and 1). Any other
+ * chain must name all four, and its radio is driven only through the IIO
+ * context it names: adradio_init(...) always opens the local AD9361, which
+ * belongs to chain 0.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include "gs_haystack.hpp"
+#include "gs_backend.hpp"
+#include "gs_config.hpp"
+#include "gs_iio.hpp"
+#include "meb_debug.hpp"
+
+/**
+ * @brief Whether this chain's radio is the board's own AD9361, reached through adradio_t.
+ *
+ */
+static bool hw_local_radio(const gs_chain_t *chain)
+{
+    return chain->index == 0;
+}
+
+/**
+ * @brief Looks up one of a chain's device settings.
+ *
+ * Chain 0 falls back to HAYSTACK_<name>, then to the single-chain board's
+ * device; other chains have no default, so they never drive chain 0's.
+ *
+ * @return const char* NULL if a chain other than 0 does not set it.
+ */
+static const char *hw_device(const gs_chain_t *chain, const char *name, const char *fallback)
+{
+    if (hw_local_radio(chain))
+    {
+        return gs_chain_env_str(chain->index, name, fallback);
+    }
+    char var[64];
+    snprintf(var, sizeof(var), "HAYSTACK_CHAIN%d_%s", chain->index, name);
+    const char *val = gs_env_str(var, NULL);
+    if (val == NULL)
+    {
+        dbprintlf(RED_FG "Chain %d needs %s set; only chain 0 has default devices.", chain->index, var);
+    }
+    return val;
+}
+
+static int hw_iio_get(gs_chain_t *chain, gs_radio_attrs_t *attrs, uint32_t bit)
+{
+    int done = gs_iio_read(chain->iio, attrs, bit);
+    return done >= 0 && (done & bit) ? 1 : -1;
+}
+
+static int hw_iio_set(gs_chain_t *chain, const gs_radio_attrs_t *attrs, uint32_t bit)
+{
+    int done = gs_iio_write(chain->iio, attrs, bit);
+    return done >= 0 && (done & bit) ? 1 : -1;
+}
+
+static int hw_rx_init(gs_chain_t *chain)
+{
+    const char *ipcore = hw_device(chain, "UIO_RX_IPCORE", "rx_ipcore");
+    const char *dma = hw_device(chain, "UIO_RX_DMA", "rx_dma");
+    if (ipcore == NULL || dma == NULL)
+    {
+        return -1;
+    }
+    return rxmodem_init(chain->rx_modem, uio_get_id(ipcore), uio_get_id(dma));
+}
+
+static int hw_rx_start(gs_chain_t *chain)
+{
+    return rxmodem_start(chain->rx_modem);
+}
+
+static ssize_t hw_rx_receive(gs_chain_t *chain)
+{
+    return rxmodem_receive(chain->rx_modem);
+}
+
+static ssize_t hw_rx_read(gs_chain_t *chain, uint8_t *buf, ssize_t size)
+{
+    return rxmodem_read(chain->rx_modem, buf, size);
+}
+
+static int hw_rx_stop(gs_chain_t *chain)
+{
+    int retval = rxmodem_stop(chain->rx_modem);
+    // The modem's internal IRQ thread does not exit on stop.
+    pthread_cancel(*(chain->rx_modem->thr));
+    return retval;
+}
+
+static void hw_rx_destroy(gs_chain_t *chain)
+{
+    rxmodem_destroy(chain->rx_modem);
+}
+
+static int hw_radio_init(gs_chain_t *chain)
+{
+    if (!hw_local_radio(chain))
+    {
+        const char *uri = hw_device(chain, "IIO_URI", NULL);
+        if (uri == NULL)
+        {
+            return -1;
+        }
+        if (gs_iio_init(chain->iio, uri) < 0)
+        {
+            dbprintlf(RED_FG "Chain %d could not open its radio at %s.", chain->index, uri);
+            return -1;
+        }
+        return 1;
+    }
+
+    int retval = adradio_init(chain->radio);
+    if (retval >= 0 && gs_iio_init(chain->iio, gs_chain_env_str(chain->index, "IIO_URI", NULL)) < 0)
+    {
+        dbprintlf(YELLOW_FG "Batched IIO access unavailable, reading radio attributes one at a time.");
+    }
+    return retval;
+}
+
+static void hw_radio_destroy(gs_chain_t *chain)
+{
+    gs_iio_destroy(chain->iio);
+    if (hw_local_radio(chain))
+    {
+        adradio_destroy(chain->radio);
+    }
+}
+
+static int hw_radio_set_ensm_mode(gs_chain_t *chain, ensm_mode mode)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        snprintf(attrs.ensm_mode, sizeof(attrs.ensm_mode), "%s", mode == FDD ? "fdd" : mode == TDD ? "tdd" : "sleep");
+        return hw_iio_set(chain, &attrs, GS_RADIO_ENSM_MODE);
+    }
+    return adradio_set_ensm_mode(chain->radio, mode);
+}
+
+static int hw_radio_get_ensm_mode(gs_chain_t *chain, char *buf, ssize_t len)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        if (hw_iio_get(chain, &attrs, GS_RADIO_ENSM_MODE) < 0)
+        {
+            return -1;
+        }
+        snprintf(buf, len, "%s", attrs.ensm_mode);
+        return 1;
+    }
+    return adradio_get_ensm_mode(chain->radio, buf, len);
+}
+
+static int hw_radio_set_rx_lo(gs_chain_t *chain, long long freq)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        attrs.rx_lo = freq;
+        return hw_iio_set(chain, &attrs, GS_RADIO_RX_LO);
+    }
+    return adradio_set_rx_lo(chain->radio, freq);
+}
+
+static int hw_radio_get_rx_lo(gs_chain_t *chain, long long *freq)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        if (hw_iio_get(chain, &attrs, GS_RADIO_RX_LO) < 0)
+        {
+            return -1;
+        }
+        *freq = attrs.rx_lo;
+        return 1;
+    }
+    return adradio_get_rx_lo(chain->radio, freq);
+}
+
+static int hw_radio_set_samp(gs_chain_t *chain, long long samp)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        attrs.samp = samp;
+        return hw_iio_set(chain, &attrs, GS_RADIO_SAMP);
+    }
+    return adradio_set_samp(chain->radio, samp);
+}
+
+static int hw_radio_get_samp(gs_chain_t *chain, long long *samp)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        if (hw_iio_get(chain, &attrs, GS_RADIO_SAMP) < 0)
+        {
+            return -1;
+        }
+        *samp = attrs.samp;
+        return 1;
+    }
+    return adradio_get_samp(chain->radio, samp);
+}
+
+static int hw_radio_set_rx_bw(gs_chain_t *chain, long long bw)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        attrs.rx_bw = bw;
+        return hw_iio_set(chain, &attrs, GS_RADIO_RX_BW);
+    }
+    return adradio_set_rx_bw(chain->radio, bw);
+}
+
+static int hw_radio_get_rx_bw(gs_chain_t *chain, long long *bw)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        if (hw_iio_get(chain, &attrs, GS_RADIO_RX_BW) < 0)
+        {
+            return -1;
+        }
+        *bw = attrs.rx_bw;
+        return 1;
+    }
+    return adradio_get_rx_bw(chain->radio, bw);
+}
+
+static int hw_radio_set_tx_hardwaregain(gs_chain_t *chain, double gain)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        attrs.tx_gain = gain;
+        return hw_iio_set(chain, &attrs, GS_RADIO_TX_GAIN);
+    }
+    return adradio_set_tx_hardwaregain(chain->radio, gain);
+}
+
+static int hw_radio_get_rx_hardwaregain(gs_chain_t *chain, double *gain)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        if (hw_iio_get(chain, &attrs, GS_RADIO_RX_GAIN) < 0)
+        {
+            return -1;
+        }
+        *gain = attrs.rx_gain;
+        return 1;
+    }
+    return adradio_get_rx_hardwaregain(chain->radio, gain);
+}
+
+static int hw_radio_set_rx_hardwaregainmode(gs_chain_t *chain, gainmode mode)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        snprintf(attrs.rx_gainmode, sizeof(attrs.rx_gainmode), "%s", mode == FAST_ATTACK ? "fast_attack" : "slow_attack");
+        return hw_iio_set(chain, &attrs, GS_RADIO_RX_GAINMODE);
+    }
+    return adradio_set_rx_hardwaregainmode(chain->radio, mode);
+}
+
+static int hw_radio_get_rx_hardwaregainmode(gs_chain_t *chain, char *buf, ssize_t len)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        if (hw_iio_get(chain, &attrs, GS_RADIO_RX_GAINMODE) < 0)
+        {
+            return -1;
+        }
+        snprintf(buf, len, "%s", attrs.rx_gainmode);
+        return 1;
+    }
+    return adradio_get_rx_hardwaregainmode(chain->radio, buf, len);
+}
+
+static int hw_radio_get_rssi(gs_chain_t *chain, double *rssi)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        if (hw_iio_get(chain, &attrs, GS_RADIO_RSSI) < 0)
+        {
+            return -1;
+        }
+        *rssi = attrs.rssi;
+        return 1;
+    }
+    return adradio_get_rssi(chain->radio, rssi);
+}
+
+static int hw_radio_get_temp(gs_chain_t *chain, long long *temp)
+{
+    if (!hw_local_radio(chain))
+    {
+        gs_radio_attrs_t attrs;
+        if (hw_iio_get(chain, &attrs, GS_RADIO_TEMP) < 0)
+        {
+            return -1;
+        }
+        *temp = attrs.temp;
+        return 1;
+    }
+    return adradio_get_temp(chain->radio, temp);
+}
+
+static int hw_radio_read_attrs(gs_chain_t *chain, gs_radio_attrs_t *attrs, uint32_t mask)
+{
+    if (chain->iio->phy == NULL && hw_local_radio(chain))
+    {
+        return gs_radio_read_each(chain, attrs, mask);
+    }
+    return gs_iio_read(chain->iio, attrs, mask);
+}
+
+static int hw_radio_write_attrs(gs_chain_t *chain, const gs_radio_attrs_t *attrs, uint32_t mask)
+{
+    if (chain->iio->phy == NULL && hw_local_radio(chain))
+    {
+        return gs_radio_write_each(chain, attrs, mask);
+    }
+    return gs_iio_write(chain->iio, attrs, mask);
+}
+
+static int hw_radio_load_filter(gs_chain_t *chain, const char *ftr, size_t len)
+{
+    // adradio_t has no filter loader, so this needs the batched IIO context.
+    return gs_iio_load_filter(chain->iio, ftr, len);
+}
+
+static int hw_pll_init(gs_chain_t *chain)
+{
+    if (hw_device(chain, "PLL_SPI_CS", "1") == NULL)
+    {
+        return -1;
+    }
+
+    // PLL initialization data.
+    chain->PLL->spi_bus = 0;
+    chain->PLL->spi_cs = gs_chain_env_int(chain->index, "PLL_SPI_CS", 1);
+    chain->PLL->spi_cs_internal = 1;
+    chain->PLL->cs_gpio = -1;
+    chain->PLL->single = 1;
+    chain->PLL->muxval = 6;
+
+    return adf4355_init(chain->PLL);
+}
+
+static int hw_pll_set_rx(gs_chain_t *chain)
+{
+    return adf4355_set_rx(chain->PLL);
+}
+
+static int hw_pll_pw_down(gs_chain_t *chain)
+{
+    return adf4355_pw_down(chain->PLL);
+}
+
+static void hw_pll_destroy(gs_chain_t *chain)
+{
+    adf4355_destroy(chain->PLL);
+}
+
+const gs_backend_t gs_backend_hw = {
+    .name = "hardware",
+    .rx_init = hw_rx_init,
+    .rx_start = hw_rx_start,
+    .rx_receive = hw_rx_receive,
+    .rx_read = hw_rx_read,
+    .rx_stop = hw_rx_stop,
+    .rx_destroy = hw_rx_destroy,
+    .radio_init = hw_radio_init,
+    .radio_destroy = hw_radio_destroy,
+    .radio_set_ensm_mode = hw_radio_set_ensm_mode,
+    .radio_get_ensm_mode = hw_radio_get_ensm_mode,
+    .radio_set_rx_lo = hw_radio_set_rx_lo,
+    .radio_get_rx_lo = hw_radio_get_rx_lo,
+    .radio_set_samp = hw_radio_set_samp,
+    .radio_get_samp = hw_radio_get_samp,
+    .radio_set_rx_bw = hw_radio_set_rx_bw,
+    .radio_get_rx_bw = hw_radio_get_rx_bw,
+    .radio_set_tx_hardwaregain = hw_radio_set_tx_hardwaregain,
+    .radio_get_rx_hardwaregain = hw_radio_get_rx_hardwaregain,
+    .radio_set_rx_hardwaregainmode = hw_radio_set_rx_hardwaregainmode,
+    .radio_get_rx_hardwaregainmode = hw_radio_get_rx_hardwaregainmode,
+    .radio_get_rssi = hw_radio_get_rssi,
+    .radio_get_temp = hw_radio_get_temp,
+    .radio_read_attrs = hw_radio_read_attrs,
+    .radio_write_attrs = hw_radio_write_attrs,
+    .radio_load_filter = hw_radio_load_filter,
+    .pll_init = hw_pll_init,
+    .pll_set_rx = hw_pll_set_rx,
+    .pll_pw_down = hw_pll_pw_down,
+    .pll_destroy = hw_pll_destroy,
+};
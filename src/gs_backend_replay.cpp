@@ -0,0 +1,477 @@
+/**
+ * @file gs_backend_replay.cpp
+ * @brief Replays recorded captures in place of the RX modem.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Sources, from a directory or a single .bin file:
+ *   - capture segments (<prefix>_<UTC start>_<NNNN>.bin with a .idx beside
+ *     them, or .bin.zst / .bin.lz4 once compressed), timed by their index
+ *     records; a compressed segment whose .bin is still there is skipped;
+ *   - legacy rxdata<N>.bin files, one packet each, timed by their
+ *     modification time.
+ *
+ * Sources are played in order of their first timestamp, ties broken by
+ * natural name order (rxdata2.bin before rxdata10.bin). Packets are released
+ * at their original spacing divided by the replay speed, or back to back if
+ * the speed is 0. Gaps which run backwards (the wall clock was stepped) are
+ * played as no gap.
+ *
+ * The radio and PLL operations are those of the backend being wrapped.
+ * Each chain replays its own path (HAYSTACK_CHAIN<n>_REPLAY, falling back to
+ * HAYSTACK_REPLAY) with its own cursor and timing.
+ *
+ * Replay starts when RX is armed, as for a pass. The forward and capture
+ * stages keep their drop policies, so a full-speed replay which must be
+ * lossless wants HAYSTACK_FORWARD_POLICY=block (and likewise for capture).
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include "gs_haystack.hpp"
+#include "gs_backend.hpp"
+#include "gs_capture_store.hpp"
+#include "gs_config.hpp"
+#include "meb_debug.hpp"
+
+#define REPLAY_IDLE_US 100000 // Poll for rx_stop(...) this often once the replay is finished.
+
+typedef struct
+{
+    char path[PATH_MAX];
+    uint64_t first_ns;
+    bool segment; // false: one legacy packet per file.
+} replay_source_t;
+
+typedef struct
+{
+    gs_replay_config_t config;
+    replay_source_t *sources;
+    size_t num_sources;
+
+    // RX state, only touched by the receiving thread.
+    size_t source;          // Index into sources.
+    size_t record;          // Next record in the open segment.
+    gs_capture_reader_t reader[1];
+    bool reader_open;
+    const uint8_t *pending; // Segment payload for the next read, or NULL for a legacy file.
+    ssize_t pending_len;
+    int pending_fd;         // Legacy file for the next read, or -1.
+    bool timing;            // base_* are valid.
+    uint64_t base_ns;       // Capture timestamp played at base_mono_ns.
+    uint64_t base_mono_ns;
+    uint64_t last_ns;
+    uint64_t packets;
+    uint32_t passes;
+    std::atomic<bool> stopped;
+} replay_state_t;
+
+static replay_state_t replay[GS_MAX_CHAINS] = {};
+
+static uint64_t replay_mono_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void gs_replay_config_load(gs_replay_config_t *config, int chain)
+{
+    snprintf(config->path, sizeof(config->path), "%s", gs_chain_env_str(chain, "REPLAY", ""));
+    config->speed = gs_chain_env_double(chain, "REPLAY_SPEED", 1.0);
+    config->loop = gs_chain_env_int(chain, "REPLAY_LOOP", 0) != 0;
+
+    if (config->speed < 0)
+    {
+        config->speed = 0;
+    }
+}
+
+/**
+ * @brief Whether path is a segment's data file, and not a compressed copy of a .bin beside it.
+ *
+ */
+static bool replay_is_data_file(const char *path)
+{
+    if (!gs_capture_is_data_file(path))
+    {
+        return false;
+    }
+    if (gs_compress_codec_of(path) == GS_COMPRESS_NONE)
+    {
+        return true;
+    }
+    char raw[PATH_MAX];
+    snprintf(raw, sizeof(raw), "%.*s", (int)(strrchr(path, '.') - path), path);
+    return access(raw, F_OK) != 0;
+}
+
+/**
+ * @brief Fills in a source's kind and first timestamp; returns false if it has nothing to play.
+ *
+ */
+static bool replay_probe(replay_source_t *source)
+{
+    char idx_path[PATH_MAX];
+    struct stat st;
+
+    source->segment = gs_capture_index_path(source->path, idx_path, sizeof(idx_path)) > 0 && access(idx_path, R_OK) == 0;
+    if (source->segment)
+    {
+        gs_capture_reader_t reader[1];
+        if (gs_capture_reader_open(reader, source->path) < 0)
+        {
+            return false;
+        }
+        bool ok = reader->count > 0;
+        if (ok)
+        {
+            source->first_ns = gs_capture_reader_record(reader, 0)->timestamp_ns;
+        }
+        gs_capture_reader_close(reader);
+        return ok;
+    }
+
+    // Only segments are compressed, so a compressed file without its index is not a legacy packet.
+    if (gs_compress_codec_of(source->path) != GS_COMPRESS_NONE ||
+        stat(source->path, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    {
+        return false;
+    }
+    source->first_ns = st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+static int replay_add(replay_state_t *r, const char *path)
+{
+    replay_source_t *sources = (replay_source_t *)realloc(r->sources, (r->num_sources + 1) * sizeof(replay_source_t));
+    if (sources == NULL)
+    {
+        return -1;
+    }
+    r->sources = sources;
+
+    replay_source_t *source = &sources[r->num_sources];
+    snprintf(source->path, sizeof(source->path), "%s", path);
+    if (replay_probe(source))
+    {
+        r->num_sources++;
+    }
+    else
+    {
+        dbprintlf(YELLOW_FG "Skipping %s: nothing to replay.", path);
+    }
+    return 1;
+}
+
+static int replay_scan(replay_state_t *r, const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) < 0)
+    {
+        dbprintlf(RED_FG "Cannot replay %s.", path);
+        erprintlf(errno);
+        return -1;
+    }
+
+    if (!S_ISDIR(st.st_mode))
+    {
+        return replay_add(r, path);
+    }
+
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+    {
+        erprintlf(errno);
+        return -1;
+    }
+
+    int ret = 1;
+    struct dirent *entry;
+    while (ret > 0 && (entry = readdir(dir)) != NULL)
+    {
+        char file[PATH_MAX];
+        snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        if (!replay_is_data_file(file))
+        {
+            continue;
+        }
+        ret = replay_add(r, file);
+    }
+    closedir(dir);
+    return ret;
+}
+
+static void replay_close_source(replay_state_t *r)
+{
+    if (r->reader_open)
+    {
+        gs_capture_reader_close(r->reader);
+        r->reader_open = false;
+    }
+    if (r->pending_fd >= 0)
+    {
+        close(r->pending_fd);
+        r->pending_fd = -1;
+    }
+}
+
+/**
+ * @brief Finds the next packet, opening sources as needed.
+ *
+ * @return ssize_t Packet length and capture timestamp in *timestamp_ns, 0 at the end of the replay, -1 on error.
+ */
+static ssize_t replay_next(replay_state_t *r, uint64_t *timestamp_ns)
+{
+    while (r->source < r->num_sources)
+    {
+        replay_source_t *source = &r->sources[r->source];
+
+        if (!source->segment)
+        {
+            r->source++;
+            r->pending_fd = open(source->path, O_RDONLY | O_CLOEXEC);
+            struct stat st;
+            if (r->pending_fd < 0 || fstat(r->pending_fd, &st) < 0)
+            {
+                dbprintlf(RED_FG "Failed to open %s.", source->path);
+                erprintlf(errno);
+                replay_close_source(r);
+                return -1;
+            }
+            *timestamp_ns = st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec;
+            r->pending = NULL;
+            return st.st_size;
+        }
+
+        if (!r->reader_open)
+        {
+            if (gs_capture_reader_open(r->reader, source->path) < 0)
+            {
+                r->source++;
+                return -1;
+            }
+            r->reader_open = true;
+            r->record = 0;
+        }
+
+        if (r->record < r->reader->count)
+        {
+            uint32_t len;
+            *timestamp_ns = gs_capture_reader_record(r->reader, r->record)->timestamp_ns;
+            r->pending = gs_capture_reader_payload(r->reader, r->record, &len);
+            r->record++;
+            return r->pending != NULL ? (ssize_t)len : -1;
+        }
+
+        replay_close_source(r);
+        r->source++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sleeps until the packet captured at timestamp_ns is due.
+ *
+ */
+static void replay_pace(replay_state_t *r, uint64_t timestamp_ns)
+{
+    if (r->config.speed <= 0)
+    {
+        return;
+    }
+
+    uint64_t now = replay_mono_ns();
+    if (!r->timing || timestamp_ns < r->last_ns)
+    {
+        r->timing = true;
+        r->base_ns = timestamp_ns;
+        r->base_mono_ns = now;
+    }
+    r->last_ns = timestamp_ns;
+
+    uint64_t due = r->base_mono_ns + (uint64_t)((timestamp_ns - r->base_ns) / r->config.speed);
+    if (due > now)
+    {
+        struct timespec ts;
+        ts.tv_sec = due / 1000000000ULL;
+        ts.tv_nsec = due % 1000000000ULL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR && !r->stopped)
+            ;
+    }
+}
+
+static int replay_rx_init(gs_chain_t *chain)
+{
+    replay_state_t *r = &replay[chain->index];
+    if (r->num_sources == 0)
+    {
+        dbprintlf(RED_FG "Chain %d has nothing to replay.", chain->index);
+        return -1;
+    }
+    dbprintlf(GREEN_FG "Chain %d replaying %zu capture file(s) from %s at %s.", chain->index, r->num_sources, r->config.path,
+              r->config.speed > 0 ? "recorded timing" : "full speed");
+    if (r->config.speed > 0 && r->config.speed != 1)
+    {
+        dbprintlf(GREEN_FG "Replay speed %.1fx.", r->config.speed);
+    }
+    return 1;
+}
+
+static int replay_rx_start(gs_chain_t *chain)
+{
+    replay_state_t *r = &replay[chain->index];
+    r->stopped = false;
+    // Pick up the timing afresh after a disarm, rather than bursting to catch up.
+    r->timing = false;
+    return 1;
+}
+
+static ssize_t replay_rx_receive(gs_chain_t *chain)
+{
+    replay_state_t *r = &replay[chain->index];
+
+    if (r->stopped)
+    {
+        return -1;
+    }
+
+    // A packet received but never read is skipped, as with the modem.
+    if (r->pending_fd >= 0)
+    {
+        close(r->pending_fd);
+        r->pending_fd = -1;
+    }
+    r->pending = NULL;
+    r->pending_len = 0;
+
+    uint64_t timestamp_ns = 0;
+    ssize_t len = replay_next(r, &timestamp_ns);
+    if (len == 0 && r->config.loop && r->num_sources > 0)
+    {
+        r->passes++;
+        r->source = 0;
+        r->timing = false;
+        dbprintlf(GREEN_FG "Replay pass %u complete (%llu packets), starting over.", r->passes, (unsigned long long)r->packets);
+        len = replay_next(r, &timestamp_ns);
+    }
+
+    if (len == 0)
+    {
+        if (r->source == r->num_sources)
+        {
+            dbprintlf(GREEN_FG "Replay finished: %llu packets.", (unsigned long long)r->packets);
+            r->source++; // Only say so once.
+        }
+        // Nothing more will arrive; idle like a modem with no signal until stopped.
+        while (!r->stopped)
+        {
+            usleep(REPLAY_IDLE_US);
+        }
+        return -1;
+    }
+    if (len < 0)
+    {
+        return -1;
+    }
+
+    replay_pace(r, timestamp_ns);
+    r->pending_len = len;
+    r->packets++;
+    return len;
+}
+
+static ssize_t replay_rx_read(gs_chain_t *chain, uint8_t *buf, ssize_t size)
+{
+    replay_state_t *r = &replay[chain->index];
+
+    if (r->pending_len <= 0)
+    {
+        return -1;
+    }
+
+    ssize_t len = size < r->pending_len ? size : r->pending_len;
+    r->pending_len = 0;
+
+    if (r->pending != NULL)
+    {
+        memcpy(buf, r->pending, len);
+        r->pending = NULL;
+        return len;
+    }
+
+    ssize_t done = 0;
+    while (done < len)
+    {
+        ssize_t ret = read(r->pending_fd, buf + done, len - done);
+        if (ret < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ret <= 0)
+        {
+            break;
+        }
+        done += ret;
+    }
+    close(r->pending_fd);
+    r->pending_fd = -1;
+    return done;
+}
+
+static int replay_rx_stop(gs_chain_t *chain)
+{
+    replay[chain->index].stopped = true;
+    return 1;
+}
+
+static void replay_rx_destroy(gs_chain_t *chain)
+{
+    replay_state_t *r = &replay[chain->index];
+    replay_close_source(r);
+    free(r->sources);
+    r->sources = NULL;
+    r->num_sources = 0;
+}
+
+int gs_backend_replay_init(gs_backend_t *backend, const gs_backend_t *radio, const gs_replay_config_t *config, int chain)
+{
+    replay_state_t *r = &replay[chain];
+    r->config = *config;
+    r->pending_fd = -1;
+
+    if (replay_scan(r, config->path) < 0)
+    {
+        return -1;
+    }
+    if (r->num_sources == 0)
+    {
+        dbprintlf(RED_FG "No capture segments or rxdata files found in %s.", config->path);
+        return -1;
+    }
+
+    std::sort(r->sources, r->sources + r->num_sources, [](const replay_source_t &a, const replay_source_t &b)
+              { return a.first_ns != b.first_ns ? a.first_ns < b.first_ns : strverscmp(a.path, b.path) < 0; });
+
+    *backend = *radio;
+    backend->name = "replay";
+    backend->rx_init = replay_rx_init;
+    backend->rx_start = replay_rx_start;
+    backend->rx_receive = replay_rx_receive;
+    backend->rx_read = replay_rx_read;
+    backend->rx_stop = replay_rx_stop;
+    backend->rx_destroy = replay_rx_destroy;
+    return 1;
+}
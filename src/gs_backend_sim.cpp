@@ -0,0 +1,670 @@
+/**
+ * @file gs_backend_sim.cpp
+ * @brief Simulated backend: software packet source and fake radio/PLL.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Packets carry an 8-byte little-endian sequence number, then (if there is room)
+ * the 8-byte CLOCK_MONOTONIC time in ns at which rx_receive returned, then
+ * filler, so that drops, reordering and end-to-end latency can be measured
+ * downstream (see bench/rx_bench.cpp).
+ *
+ * With HAYSTACK_SIM_FRAME_LEN set, packets instead carry a continuous stream
+ * of CCSDS CADUs (sync marker, then a transfer frame starting with its 8-byte
+ * frame number and ending in a FECF), cut at packet boundaries regardless of
+ * where a CADU ends; HAYSTACK_SIM_FRAME_ERROR_RATE corrupts whole frames,
+ * and HAYSTACK_SIM_RANDOMIZE=1 sends them randomized.
+ * HAYSTACK_SIM_FEC_INTERLEAVE sends each frame as a Reed-Solomon codeblock,
+ * encoded with the chain's HAYSTACK_FEC_* basis and randomization settings,
+ * and HAYSTACK_SIM_SYMBOL_ERROR_RATE then corrupts single bytes of it.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <atomic>
+#include "gs_haystack.hpp"
+#include "gs_backend.hpp"
+#include "gs_config.hpp"
+#include "gs_crc.hpp"
+#include "gs_deframe.hpp"
+#include "gs_fec.hpp"
+#include "meb_debug.hpp"
+
+#define SIM_DEFAULT_PKT_SIZE 4096
+#define SIM_DEFAULT_PKT_RATE 100.0
+
+typedef struct
+{
+    gs_sim_config_t config;
+
+    // RX state, only touched by the receiving thread.
+    uint32_t rx_rng;
+    uint64_t seq;
+    ssize_t pending;
+    uint64_t pending_ns; // When the pending packet was received.
+    struct timespec next_pkt;
+    std::atomic<bool> stopped;
+
+    // CADU stream, with config.frame_len.
+    uint8_t cadu[GS_CCSDS_ASM_LEN + GS_DEFRAME_MAX_LEN];
+    size_t cadu_len;
+    size_t cadu_off; // Bytes of cadu already sent; cadu_len once it is used up.
+    uint64_t frame_seq;
+    gs_fec_config_t fec; // Encoding for config.fec_interleave.
+
+    // Initialization attempts so far, by gs_startup_part_t; each part is brought up on its own thread.
+    int init_attempts[GS_STARTUP_NUM_PARTS];
+
+    // Radio state, shared between the status and network threads.
+    pthread_mutex_t radio_lock;
+    uint32_t radio_rng;
+    ensm_mode mode;
+    long long rx_lo;
+    long long samp;
+    long long rx_bw;
+    double tx_gain;
+    gainmode gain_mode;
+    size_t filter_len;
+} sim_state_t;
+
+static sim_state_t sim[GS_MAX_CHAINS] = {};
+static pthread_once_t sim_once = PTHREAD_ONCE_INIT;
+
+static void sim_seed(sim_state_t *s, int chain)
+{
+    // Distinct streams per chain, so their packets and readings differ.
+    s->rx_rng = (s->config.seed ? s->config.seed : 1) + chain;
+    s->radio_rng = s->rx_rng ^ 0x9e3779b9;
+}
+
+/**
+ * @brief CADU length and encoding for s->config.
+ *
+ */
+static void sim_cadu_setup(sim_state_t *s, int chain)
+{
+    const gs_sim_config_t *config = &s->config;
+    s->cadu_len = GS_CCSDS_ASM_LEN + config->frame_len;
+    gs_fec_config_load(&s->fec, chain);
+    s->fec.enabled = config->frame_len > 0 && config->fec_interleave > 0;
+    s->fec.interleave = config->fec_interleave;
+    if (s->fec.enabled)
+    {
+        size_t block_len = gs_fec_block_len(&s->fec, config->frame_len);
+        if (block_len == 0 || block_len > GS_DEFRAME_MAX_LEN)
+        {
+            dbprintlf(YELLOW_FG "Simulated %zu byte frames do not fit RS(255,223) codewords interleaved %d deep; sending them unencoded.", config->frame_len, config->fec_interleave);
+            s->fec.enabled = false;
+        }
+        else
+        {
+            s->cadu_len = GS_CCSDS_ASM_LEN + block_len;
+        }
+    }
+}
+
+static void sim_defaults()
+{
+    for (int i = 0; i < GS_MAX_CHAINS; i++)
+    {
+        sim_state_t *s = &sim[i];
+        gs_sim_config_load(&s->config);
+        sim_seed(s, i);
+        sim_cadu_setup(s, i);
+        pthread_mutex_init(&s->radio_lock, NULL);
+        s->mode = SLEEP;
+        s->rx_lo = 2450000000LL;
+        s->samp = 10000000;
+        s->rx_bw = 8000000;
+        s->tx_gain = -85;
+        s->gain_mode = SLOW_ATTACK;
+    }
+}
+
+static inline sim_state_t *sim_get(gs_chain_t *chain)
+{
+    pthread_once(&sim_once, sim_defaults);
+    return &sim[chain->index];
+}
+
+static inline uint32_t sim_rand(uint32_t *state)
+{
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static inline double sim_uniform(uint32_t *state)
+{
+    return sim_rand(state) / 4294967296.0;
+}
+
+static inline void sim_iio_delay(sim_state_t *s)
+{
+    if (s->config.iio_latency_us > 0)
+    {
+        usleep(s->config.iio_latency_us);
+    }
+}
+
+/**
+ * @brief Takes init_latency_ms, then fails the first init_failures attempts at a part.
+ *
+ */
+static inline int sim_init(sim_state_t *s, gs_startup_part_t part)
+{
+    if (s->config.init_latency_ms > 0)
+    {
+        usleep(s->config.init_latency_ms * 1000);
+    }
+    return s->init_attempts[part]++ < s->config.init_failures ? -1 : 1;
+}
+
+void gs_sim_config_load(gs_sim_config_t *config)
+{
+    config->pkt_size_min = gs_env_int("HAYSTACK_SIM_PKT_SIZE", SIM_DEFAULT_PKT_SIZE);
+    config->pkt_size_max = gs_env_int("HAYSTACK_SIM_PKT_SIZE_MAX", config->pkt_size_min);
+    config->pkt_rate = gs_env_double("HAYSTACK_SIM_PKT_RATE", SIM_DEFAULT_PKT_RATE);
+    config->rx_error_rate = gs_env_double("HAYSTACK_SIM_RX_ERROR_RATE", 0);
+    config->read_error_rate = gs_env_double("HAYSTACK_SIM_READ_ERROR_RATE", 0);
+    config->iio_latency_us = gs_env_int("HAYSTACK_SIM_IIO_LATENCY_US", 0);
+    config->init_latency_ms = gs_env_int("HAYSTACK_SIM_INIT_LATENCY_MS", 0);
+    config->init_failures = gs_env_int("HAYSTACK_SIM_INIT_FAILURES", 0);
+    config->seed = gs_env_int("HAYSTACK_SIM_SEED", 1);
+    config->frame_len = gs_env_int("HAYSTACK_SIM_FRAME_LEN", 0);
+    config->frame_error_rate = gs_env_double("HAYSTACK_SIM_FRAME_ERROR_RATE", 0);
+    config->randomize = gs_env_int("HAYSTACK_SIM_RANDOMIZE", 0) != 0;
+    config->fec_interleave = gs_env_int("HAYSTACK_SIM_FEC_INTERLEAVE", 0);
+    config->symbol_error_rate = gs_env_double("HAYSTACK_SIM_SYMBOL_ERROR_RATE", 0);
+
+    if (config->pkt_size_min < 8)
+    {
+        config->pkt_size_min = 8;
+    }
+    if (config->pkt_size_max < config->pkt_size_min)
+    {
+        config->pkt_size_max = config->pkt_size_min;
+    }
+    if (config->frame_len > GS_DEFRAME_MAX_LEN)
+    {
+        config->frame_len = GS_DEFRAME_MAX_LEN;
+    }
+    if (config->frame_len > 0 && config->frame_len < 10)
+    {
+        config->frame_len = 10; // Frame number and FECF.
+    }
+}
+
+void gs_sim_configure(const gs_sim_config_t *config)
+{
+    pthread_once(&sim_once, sim_defaults);
+    for (int i = 0; i < GS_MAX_CHAINS; i++)
+    {
+        sim_state_t *s = &sim[i];
+        s->config = *config;
+        sim_seed(s, i);
+        s->seq = 0;
+        s->pending = 0;
+        s->cadu_off = 0;
+        s->frame_seq = 0;
+        sim_cadu_setup(s, i);
+        s->next_pkt.tv_sec = 0;
+        s->next_pkt.tv_nsec = 0;
+    }
+}
+
+static int sim_rx_init(gs_chain_t *chain)
+{
+    sim_state_t *s = sim_get(chain);
+    if (sim_init(s, GS_STARTUP_MODEM) < 0)
+    {
+        return -1;
+    }
+    dbprintlf(GREEN_FG "Simulated RX modem %d: %zd-%zd byte packets at %.1f Hz, %.3f receive / %.3f read error rate.",
+              chain->index, s->config.pkt_size_min, s->config.pkt_size_max, s->config.pkt_rate, s->config.rx_error_rate, s->config.read_error_rate);
+    return 1;
+}
+
+static int sim_rx_start(gs_chain_t *chain)
+{
+    sim_state_t *s = sim_get(chain);
+    s->stopped = false;
+    s->next_pkt.tv_sec = 0;
+    s->next_pkt.tv_nsec = 0;
+    return 1;
+}
+
+static ssize_t sim_rx_receive(gs_chain_t *chain)
+{
+    sim_state_t *s = sim_get(chain);
+
+    if (s->stopped)
+    {
+        return -1;
+    }
+
+    if (s->config.pkt_rate > 0)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t period_ns = 1e9 / s->config.pkt_rate;
+        int64_t next_ns = s->next_pkt.tv_sec * 1000000000LL + s->next_pkt.tv_nsec;
+        int64_t now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+
+        // Do not try to catch up on more than a second of backlog.
+        if (next_ns == 0 || now_ns - next_ns > 1000000000LL)
+        {
+            next_ns = now_ns;
+        }
+        else
+        {
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &s->next_pkt, NULL) == EINTR)
+                ;
+        }
+
+        next_ns += period_ns;
+        s->next_pkt.tv_sec = next_ns / 1000000000LL;
+        s->next_pkt.tv_nsec = next_ns % 1000000000LL;
+    }
+
+    if (s->config.rx_error_rate > 0 && sim_uniform(&s->rx_rng) < s->config.rx_error_rate)
+    {
+        s->pending = 0;
+        return -1;
+    }
+
+    ssize_t size = s->config.pkt_size_min;
+    if (s->config.pkt_size_max > s->config.pkt_size_min)
+    {
+        size += sim_rand(&s->rx_rng) % (s->config.pkt_size_max - s->config.pkt_size_min + 1);
+    }
+    s->pending = size;
+    struct timespec arrived;
+    clock_gettime(CLOCK_MONOTONIC, &arrived);
+    s->pending_ns = arrived.tv_sec * 1000000000ULL + arrived.tv_nsec;
+    return size;
+}
+
+/**
+ * @brief Builds the next CADU: sync marker, frame number, filler and FECF, as a codeblock with check symbols if encoding.
+ *
+ */
+static void sim_next_cadu(sim_state_t *s)
+{
+    size_t frame_len = s->config.frame_len;
+    uint8_t *frame = s->cadu + GS_CCSDS_ASM_LEN;
+    uint64_t seq = s->frame_seq++;
+
+    s->cadu[0] = 0x1A;
+    s->cadu[1] = 0xCF;
+    s->cadu[2] = 0xFC;
+    s->cadu[3] = 0x1D;
+    memcpy(frame, &seq, sizeof(seq));
+    memset(frame + sizeof(seq), (uint8_t)seq, frame_len - sizeof(seq) - 2);
+    uint16_t crc = gs_crc16(GS_CRC16_INIT, frame, frame_len - 2);
+    frame[frame_len - 2] = crc >> 8;
+    frame[frame_len - 1] = crc & 0xFF;
+
+    if (s->config.frame_error_rate > 0 && sim_uniform(&s->rx_rng) < s->config.frame_error_rate)
+    {
+        frame[sim_rand(&s->rx_rng) % frame_len] ^= 0x01;
+    }
+
+    if (s->fec.enabled)
+    {
+        gs_fec_encode(&s->fec, frame, frame_len);
+        if (s->config.symbol_error_rate > 0)
+        {
+            for (size_t i = GS_CCSDS_ASM_LEN; i < s->cadu_len; i++)
+            {
+                if (sim_uniform(&s->rx_rng) < s->config.symbol_error_rate)
+                {
+                    s->cadu[i] ^= 1 + sim_rand(&s->rx_rng) % 255;
+                }
+            }
+        }
+    }
+    else if (s->config.randomize)
+    {
+        gs_ccsds_randomize(frame, frame_len);
+    }
+    s->cadu_off = 0;
+}
+
+static ssize_t sim_read_cadus(sim_state_t *s, uint8_t *buf, ssize_t len)
+{
+    size_t cadu_len = s->cadu_len;
+    ssize_t done = 0;
+    while (done < len)
+    {
+        if (s->cadu_off == 0 || s->cadu_off >= cadu_len)
+        {
+            sim_next_cadu(s);
+        }
+        size_t n = cadu_len - s->cadu_off;
+        n = n < (size_t)(len - done) ? n : len - done;
+        memcpy(buf + done, s->cadu + s->cadu_off, n);
+        s->cadu_off += n;
+        done += n;
+    }
+    return len;
+}
+
+static ssize_t sim_rx_read(gs_chain_t *chain, uint8_t *buf, ssize_t size)
+{
+    sim_state_t *s = sim_get(chain);
+
+    if (s->pending <= 0)
+    {
+        return -1;
+    }
+
+    ssize_t len = size < s->pending ? size : s->pending;
+    s->pending = 0;
+
+    if (s->config.read_error_rate > 0 && sim_uniform(&s->rx_rng) < s->config.read_error_rate)
+    {
+        len /= 2;
+    }
+
+    if (s->config.frame_len > 0)
+    {
+        return sim_read_cadus(s, buf, len);
+    }
+
+    uint64_t seq = s->seq++;
+    if (len >= (ssize_t)(sizeof(seq) + sizeof(s->pending_ns)))
+    {
+        memcpy(buf, &seq, sizeof(seq));
+        memcpy(buf + sizeof(seq), &s->pending_ns, sizeof(s->pending_ns));
+        memset(buf + sizeof(seq) + sizeof(s->pending_ns), (uint8_t)seq, len - sizeof(seq) - sizeof(s->pending_ns));
+    }
+    else if (len >= (ssize_t)sizeof(seq))
+    {
+        memcpy(buf, &seq, sizeof(seq));
+        memset(buf + sizeof(seq), (uint8_t)seq, len - sizeof(seq));
+    }
+    return len;
+}
+
+static int sim_rx_stop(gs_chain_t *chain)
+{
+    sim_get(chain)->stopped = true;
+    return 1;
+}
+
+static void sim_rx_destroy(gs_chain_t *chain)
+{
+}
+
+static int sim_radio_init(gs_chain_t *chain)
+{
+    return sim_init(sim_get(chain), GS_STARTUP_RADIO);
+}
+
+static void sim_radio_destroy(gs_chain_t *chain)
+{
+}
+
+static int sim_radio_set_ensm_mode(gs_chain_t *chain, ensm_mode mode)
+{
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    pthread_mutex_lock(&s->radio_lock);
+    s->mode = mode;
+    pthread_mutex_unlock(&s->radio_lock);
+    return 1;
+}
+
+static int sim_radio_get_ensm_mode(gs_chain_t *chain, char *buf, ssize_t len)
+{
+    static const char *names[] = {"sleep", "fdd", "tdd"};
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    pthread_mutex_lock(&s->radio_lock);
+    int mode = s->mode;
+    pthread_mutex_unlock(&s->radio_lock);
+    snprintf(buf, len, "%s", (mode >= 0 && mode <= 2) ? names[mode] : "unknown");
+    return 1;
+}
+
+#define SIM_RADIO_LL_ATTR(attr, field)                                  \
+    static int sim_radio_set_##attr(gs_chain_t *chain, long long v) \
+    {                                                                   \
+        sim_state_t *s = sim_get(chain);                                     \
+        sim_iio_delay(s);                                               \
+        pthread_mutex_lock(&s->radio_lock);                             \
+        s->field = v;                                                   \
+        pthread_mutex_unlock(&s->radio_lock);                           \
+        return 1;                                                       \
+    }                                                                   \
+    static int sim_radio_get_##attr(gs_chain_t *chain, long long *v) \
+    {                                                                   \
+        sim_state_t *s = sim_get(chain);                                     \
+        sim_iio_delay(s);                                               \
+        pthread_mutex_lock(&s->radio_lock);                             \
+        *v = s->field;                                                  \
+        pthread_mutex_unlock(&s->radio_lock);                           \
+        return 1;                                                       \
+    }
+
+SIM_RADIO_LL_ATTR(rx_lo, rx_lo)
+SIM_RADIO_LL_ATTR(samp, samp)
+SIM_RADIO_LL_ATTR(rx_bw, rx_bw)
+
+static int sim_radio_set_tx_hardwaregain(gs_chain_t *chain, double gain)
+{
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    pthread_mutex_lock(&s->radio_lock);
+    s->tx_gain = gain;
+    pthread_mutex_unlock(&s->radio_lock);
+    return 1;
+}
+
+static int sim_radio_get_rx_hardwaregain(gs_chain_t *chain, double *gain)
+{
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    pthread_mutex_lock(&s->radio_lock);
+    *gain = 40 + (sim_rand(&s->radio_rng) % 8);
+    pthread_mutex_unlock(&s->radio_lock);
+    return 1;
+}
+
+static int sim_radio_set_rx_hardwaregainmode(gs_chain_t *chain, gainmode mode)
+{
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    pthread_mutex_lock(&s->radio_lock);
+    s->gain_mode = mode;
+    pthread_mutex_unlock(&s->radio_lock);
+    return 1;
+}
+
+static int sim_radio_get_rx_hardwaregainmode(gs_chain_t *chain, char *buf, ssize_t len)
+{
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    pthread_mutex_lock(&s->radio_lock);
+    gainmode mode = s->gain_mode;
+    pthread_mutex_unlock(&s->radio_lock);
+    snprintf(buf, len, "%s", mode == FAST_ATTACK ? "fast_attack" : "slow_attack");
+    return 1;
+}
+
+static int sim_radio_get_rssi(gs_chain_t *chain, double *rssi)
+{
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    pthread_mutex_lock(&s->radio_lock);
+    *rssi = -60.0 - sim_uniform(&s->radio_rng) * 10.0;
+    pthread_mutex_unlock(&s->radio_lock);
+    return 1;
+}
+
+static int sim_radio_get_temp(gs_chain_t *chain, long long *temp)
+{
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    pthread_mutex_lock(&s->radio_lock);
+    *temp = 35000 + (sim_rand(&s->radio_rng) % 2000);
+    pthread_mutex_unlock(&s->radio_lock);
+    return 1;
+}
+
+/**
+ * @brief Charges one IIO round trip per channel touched, as a batched hardware access would.
+ *
+ */
+static void sim_iio_batch_delay(sim_state_t *s, uint32_t mask)
+{
+    static const uint32_t groups[] = {
+        GS_RADIO_ENSM_MODE,
+        GS_RADIO_RX_LO,
+        GS_RADIO_SAMP | GS_RADIO_RX_BW | GS_RADIO_RX_GAINMODE | GS_RADIO_RX_GAIN | GS_RADIO_RSSI,
+        GS_RADIO_TX_GAIN,
+        GS_RADIO_TEMP,
+    };
+    for (size_t i = 0; i < sizeof(groups) / sizeof(groups[0]); i++)
+    {
+        if (mask & groups[i])
+        {
+            sim_iio_delay(s);
+        }
+    }
+}
+
+static int sim_radio_read_attrs(gs_chain_t *chain, gs_radio_attrs_t *attrs, uint32_t mask)
+{
+    static const char *names[] = {"sleep", "fdd", "tdd"};
+    sim_state_t *s = sim_get(chain);
+    sim_iio_batch_delay(s, mask);
+
+    pthread_mutex_lock(&s->radio_lock);
+    snprintf(attrs->ensm_mode, sizeof(attrs->ensm_mode), "%s", (s->mode >= 0 && s->mode <= 2) ? names[s->mode] : "unknown");
+    attrs->rx_lo = s->rx_lo;
+    attrs->samp = s->samp;
+    attrs->rx_bw = s->rx_bw;
+    snprintf(attrs->rx_gainmode, sizeof(attrs->rx_gainmode), "%s", s->gain_mode == FAST_ATTACK ? "fast_attack" : "slow_attack");
+    attrs->rx_gain = 40 + (sim_rand(&s->radio_rng) % 8);
+    attrs->rssi = -60.0 - sim_uniform(&s->radio_rng) * 10.0;
+    attrs->temp = 35000 + (sim_rand(&s->radio_rng) % 2000);
+    attrs->tx_gain = s->tx_gain;
+    pthread_mutex_unlock(&s->radio_lock);
+
+    return mask & GS_RADIO_ALL;
+}
+
+static int sim_radio_write_attrs(gs_chain_t *chain, const gs_radio_attrs_t *attrs, uint32_t mask)
+{
+    sim_state_t *s = sim_get(chain);
+    mask &= GS_RADIO_ENSM_MODE | GS_RADIO_RX_LO | GS_RADIO_SAMP | GS_RADIO_RX_BW | GS_RADIO_RX_GAINMODE | GS_RADIO_TX_GAIN;
+    sim_iio_batch_delay(s, mask);
+
+    pthread_mutex_lock(&s->radio_lock);
+    if (mask & GS_RADIO_ENSM_MODE)
+    {
+        s->mode = strcmp(attrs->ensm_mode, "fdd") == 0 ? FDD : strcmp(attrs->ensm_mode, "tdd") == 0 ? TDD : SLEEP;
+    }
+    if (mask & GS_RADIO_RX_LO)
+    {
+        s->rx_lo = attrs->rx_lo;
+    }
+    if (mask & GS_RADIO_SAMP)
+    {
+        s->samp = attrs->samp;
+    }
+    if (mask & GS_RADIO_RX_BW)
+    {
+        s->rx_bw = attrs->rx_bw;
+    }
+    if (mask & GS_RADIO_RX_GAINMODE)
+    {
+        s->gain_mode = strcmp(attrs->rx_gainmode, "fast_attack") == 0 ? FAST_ATTACK : SLOW_ATTACK;
+    }
+    if (mask & GS_RADIO_TX_GAIN)
+    {
+        s->tx_gain = attrs->tx_gain;
+    }
+    pthread_mutex_unlock(&s->radio_lock);
+
+    return mask;
+}
+
+static int sim_radio_load_filter(gs_chain_t *chain, const char *ftr, size_t len)
+{
+    sim_state_t *s = sim_get(chain);
+    sim_iio_delay(s);
+    if (len == 0)
+    {
+        return -1;
+    }
+    pthread_mutex_lock(&s->radio_lock);
+    s->filter_len = len;
+    pthread_mutex_unlock(&s->radio_lock);
+    return 1;
+}
+
+static int sim_pll_init(gs_chain_t *chain)
+{
+    return sim_init(sim_get(chain), GS_STARTUP_PLL);
+}
+
+static int sim_pll_set_rx(gs_chain_t *chain)
+{
+    return 1;
+}
+
+static int sim_pll_pw_down(gs_chain_t *chain)
+{
+    return 1;
+}
+
+static void sim_pll_destroy(gs_chain_t *chain)
+{
+}
+
+const gs_backend_t gs_backend_sim = {
+    .name = "simulated",
+    .rx_init = sim_rx_init,
+    .rx_start = sim_rx_start,
+    .rx_receive = sim_rx_receive,
+    .rx_read = sim_rx_read,
+    .rx_stop = sim_rx_stop,
+    .rx_destroy = sim_rx_destroy,
+    .radio_init = sim_radio_init,
+    .radio_destroy = sim_radio_destroy,
+    .radio_set_ensm_mode = sim_radio_set_ensm_mode,
+    .radio_get_ensm_mode = sim_radio_get_ensm_mode,
+    .radio_set_rx_lo = sim_radio_set_rx_lo,
+    .radio_get_rx_lo = sim_radio_get_rx_lo,
+    .radio_set_samp = sim_radio_set_samp,
+    .radio_get_samp = sim_radio_get_samp,
+    .radio_set_rx_bw = sim_radio_set_rx_bw,
+    .radio_get_rx_bw = sim_radio_get_rx_bw,
+    .radio_set_tx_hardwaregain = sim_radio_set_tx_hardwaregain,
+    .radio_get_rx_hardwaregain = sim_radio_get_rx_hardwaregain,
+    .radio_set_rx_hardwaregainmode = sim_radio_set_rx_hardwaregainmode,
+    .radio_get_rx_hardwaregainmode = sim_radio_get_rx_hardwaregainmode,
+    .radio_get_rssi = sim_radio_get_rssi,
+    .radio_get_temp = sim_radio_get_temp,
+    .radio_read_attrs = sim_radio_read_attrs,
+    .radio_write_attrs = sim_radio_write_attrs,
+    .radio_load_filter = sim_radio_load_filter,
+    .pll_init = sim_pll_init,
+    .pll_set_rx = sim_pll_set_rx,
+    .pll_pw_down = sim_pll_pw_down,
+    .pll_destroy = sim_pll_destroy,
+};
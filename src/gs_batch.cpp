@@ -0,0 +1,119 @@
+/**
+ * @file gs_batch.cpp
+ * @brief Packs small received packets into one DATA frame for the server.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "gs_batch.hpp"
+#include "gs_config.hpp"
+#include "gs_metrics.hpp"
+#include "meb_debug.hpp"
+
+void gs_batch_config_load(gs_batch_config_t *config, int chain)
+{
+    int64_t bytes = gs_chain_env_int(chain, "FORWARD_BATCH_BYTES", 0);
+    if (bytes > GS_BATCH_MAX_BYTES)
+    {
+        dbprintlf(YELLOW_FG "HAYSTACK_FORWARD_BATCH_BYTES %lld is over the %d byte limit; using the limit.", (long long)bytes, GS_BATCH_MAX_BYTES);
+        bytes = GS_BATCH_MAX_BYTES;
+    }
+    config->bytes = bytes > 0 ? bytes : 0;
+    int64_t ms = gs_chain_env_int(chain, "FORWARD_BATCH_MS", GS_BATCH_DEFAULT_MS);
+    config->max_delay_ms = ms > 0 ? ms : 0;
+}
+
+int gs_batch_init(gs_batch_t *batch, const gs_batch_config_t *config)
+{
+    batch->config = *config;
+    batch->data = NULL;
+    batch->len = 0;
+    batch->packets = 0;
+    batch->deadline_ns = 0;
+    batch->batches = 0;
+    batch->batched = 0;
+
+    if (config->bytes == 0)
+    {
+        return 0;
+    }
+    if (config->bytes <= GS_BATCH_PREFIX_LEN)
+    {
+        dbprintlf(RED_FG "A %zu byte batch cannot hold a packet.", config->bytes);
+        return -1;
+    }
+
+    batch->data = (uint8_t *)malloc(config->bytes);
+    if (batch->data == NULL)
+    {
+        dbprintlf(RED_FG "Could not allocate a %zu byte batch.", config->bytes);
+        return -1;
+    }
+    return 1;
+}
+
+void gs_batch_prefix(uint8_t *prefix, size_t len)
+{
+    // Little-endian whatever the host, so the server need not know what it is talking to.
+    prefix[0] = len & 0xFF;
+    prefix[1] = (len >> 8) & 0xFF;
+    prefix[2] = (len >> 16) & 0xFF;
+    prefix[3] = (len >> 24) & 0xFF;
+}
+
+void gs_batch_add(gs_batch_t *batch, const uint8_t *data, size_t len, uint64_t now_ns)
+{
+    if (batch->packets == 0)
+    {
+        batch->deadline_ns = now_ns + batch->config.max_delay_ms * 1000000ULL;
+    }
+    gs_batch_prefix(batch->data + batch->len, len);
+    memcpy(batch->data + batch->len + GS_BATCH_PREFIX_LEN, data, len);
+    batch->len += GS_BATCH_PREFIX_LEN + len;
+    batch->packets++;
+}
+
+int gs_batch_timeout_ms(const gs_batch_t *batch, uint64_t now_ns, int idle_ms)
+{
+    if (batch->packets == 0)
+    {
+        return idle_ms;
+    }
+    if (now_ns >= batch->deadline_ns)
+    {
+        return 0;
+    }
+    uint64_t ms = (batch->deadline_ns - now_ns + 999999) / 1000000;
+    return ms < (uint64_t)idle_ms ? (int)ms : idle_ms;
+}
+
+void gs_batch_reset(gs_batch_t *batch)
+{
+    if (batch->packets > 0)
+    {
+        batch->batches++;
+        batch->batched += batch->packets;
+        gs_metric_add(GS_CTR_FORWARD_BATCHES, 1);
+        gs_metric_add(GS_CTR_FORWARD_BATCHED_PACKETS, batch->packets);
+    }
+    batch->len = 0;
+    batch->packets = 0;
+}
+
+void gs_batch_destroy(gs_batch_t *batch)
+{
+    if (batch->batches > 0)
+    {
+        dbprintlf(GREEN_FG "Sent %llu packets in %llu batches, %.1f per DATA frame.", (unsigned long long)batch->batched,
+                  (unsigned long long)batch->batches, (double)batch->batched / batch->batches);
+    }
+    free(batch->data);
+    batch->data = NULL;
+    batch->len = 0;
+    batch->packets = 0;
+}
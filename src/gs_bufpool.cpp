@@ -0,0 +1,155 @@
+/**
+ * @file gs_bufpool.cpp
+ * @brief Fixed-size pool of preallocated, cache-aligned receive buffers.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include "gs_bufpool.hpp"
+#include "meb_debug.hpp"
+
+int gs_bufpool_init(gs_bufpool_t *pool, int count, ssize_t buf_size)
+{
+    if (count <= 0 || buf_size <= 0)
+    {
+        return -1;
+    }
+
+    buf_size = (buf_size + GS_BUFPOOL_ALIGN - 1) & ~((ssize_t)GS_BUFPOOL_ALIGN - 1);
+
+    pool->mem = (uint8_t *)aligned_alloc(GS_BUFPOOL_ALIGN, count * buf_size);
+    pool->bufs = new (std::nothrow) gs_buf_t[count];
+    if (pool->mem == NULL || pool->bufs == NULL)
+    {
+        dbprintlf(RED_FG "Failed to allocate %d receive buffers of %zd bytes.", count, buf_size);
+        free(pool->mem);
+        delete[] pool->bufs;
+        pool->mem = NULL;
+        pool->bufs = NULL;
+        return -1;
+    }
+
+    // Touch every page now so the first pass does not take the page faults.
+    memset(pool->mem, 0x0, count * buf_size);
+
+    pool->count = count;
+    pool->buf_size = buf_size;
+    pool->free_list = NULL;
+    for (int i = count - 1; i >= 0; i--)
+    {
+        gs_buf_t *buf = &pool->bufs[i];
+        buf->data = pool->mem + i * buf_size;
+        buf->len = 0;
+        buf->cap = buf_size;
+        buf->refs = 0;
+        buf->pool = pool;
+        buf->next = pool->free_list;
+        pool->free_list = buf;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->in_use = 0;
+    pool->high_water = 0;
+    pool->exhausted = 0;
+    pool->oversize = 0;
+
+    dbprintlf(GREEN_FG "Receive buffer pool ready: %d x %zd bytes.", count, buf_size);
+    return 1;
+}
+
+gs_buf_t *gs_bufpool_acquire(gs_bufpool_t *pool, ssize_t size)
+{
+    gs_buf_t *buf = NULL;
+
+    if (size <= pool->buf_size)
+    {
+        pthread_mutex_lock(&pool->lock);
+        buf = pool->free_list;
+        if (buf != NULL)
+        {
+            pool->free_list = buf->next;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        if (buf == NULL)
+        {
+            pool->exhausted++;
+            return NULL;
+        }
+        uint32_t in_use = ++pool->in_use;
+        uint32_t high_water = pool->high_water;
+        while (in_use > high_water && !pool->high_water.compare_exchange_weak(high_water, in_use))
+            ;
+    }
+    else
+    {
+        // Only for sizes no pool buffer can hold; a busy pool is not grown behind its back.
+        pool->oversize++;
+        buf = new (std::nothrow) gs_buf_t;
+        if (buf == NULL)
+        {
+            return NULL;
+        }
+        buf->data = (uint8_t *)aligned_alloc(GS_BUFPOOL_ALIGN, (size + GS_BUFPOOL_ALIGN - 1) & ~((ssize_t)GS_BUFPOOL_ALIGN - 1));
+        if (buf->data == NULL)
+        {
+            delete buf;
+            return NULL;
+        }
+        buf->cap = size;
+        buf->pool = NULL;
+    }
+
+    buf->len = 0;
+    buf->refs = 1;
+    buf->next = NULL;
+    return buf;
+}
+
+void gs_buf_ref(gs_buf_t *buf)
+{
+    buf->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void gs_buf_release(gs_buf_t *buf)
+{
+    if (buf->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+
+    gs_bufpool_t *pool = buf->pool;
+    if (pool == NULL)
+    {
+        free(buf->data);
+        delete buf;
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    buf->next = pool->free_list;
+    pool->free_list = buf;
+    pthread_mutex_unlock(&pool->lock);
+    pool->in_use--;
+}
+
+void gs_bufpool_destroy(gs_bufpool_t *pool)
+{
+    if (pool->in_use > 0)
+    {
+        dbprintlf(YELLOW_FG "Destroying receive buffer pool with %u buffers still in use.", (unsigned)pool->in_use);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->mem);
+    delete[] pool->bufs;
+    pool->mem = NULL;
+    pool->bufs = NULL;
+    pool->free_list = NULL;
+}
@@ -0,0 +1,429 @@
+/**
+ * @file gs_capture.cpp
+ * @brief Asynchronous writer which persists received packets to segment files.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "gs_capture.hpp"
+#include "gs_config.hpp"
+#include "gs_metrics.hpp"
+#include "gs_rt.hpp"
+#include "meb_debug.hpp"
+
+void gs_capture_config_load(gs_capture_config_t *config)
+{
+    config->enabled = gs_env_int("HAYSTACK_CAPTURE", 1) != 0;
+    snprintf(config->dir, sizeof(config->dir), "%s", gs_env_str("HAYSTACK_CAPTURE_DIR", GS_CAPTURE_DEFAULT_DIR));
+    snprintf(config->prefix, sizeof(config->prefix), "%s", gs_env_str("HAYSTACK_CAPTURE_PREFIX", GS_CAPTURE_DEFAULT_PREFIX));
+    config->segment_size = (size_t)gs_env_int("HAYSTACK_CAPTURE_SEGMENT_MB", GS_CAPTURE_DEFAULT_SEGMENT_MB) << 20;
+    config->rotate_sec = gs_env_int("HAYSTACK_CAPTURE_ROTATE_SEC", GS_CAPTURE_DEFAULT_ROTATE_SEC);
+    config->direct = gs_env_int("HAYSTACK_CAPTURE_DIRECT", 0) != 0;
+    config->queue_depth = gs_env_int("HAYSTACK_CAPTURE_QUEUE", GS_CAPTURE_DEFAULT_QUEUE_DEPTH);
+    config->policy = gs_stage_policy_env("HAYSTACK_CAPTURE_POLICY", GS_STAGE_DROP);
+    config->block_ms = gs_env_int("HAYSTACK_CAPTURE_BLOCK_MS", GS_STAGE_DEFAULT_BLOCK_MS);
+    config->compress.codec = gs_compress_codec_env("HAYSTACK_CAPTURE_COMPRESS", GS_COMPRESS_NONE);
+    config->compress.level = gs_env_int("HAYSTACK_CAPTURE_COMPRESS_LEVEL", 0);
+    config->compress.threads = gs_env_int("HAYSTACK_CAPTURE_COMPRESS_THREADS", GS_COMPRESS_DEFAULT_THREADS);
+    config->compress.frame_size = (size_t)gs_env_int("HAYSTACK_CAPTURE_COMPRESS_FRAME_KB", GS_COMPRESS_DEFAULT_FRAME_KB) << 10;
+    config->compress.keep = gs_env_int("HAYSTACK_CAPTURE_COMPRESS_KEEP", 0) != 0;
+    config->chain = 0;
+}
+
+/**
+ * @brief Throws away the staged bytes after a failed write.
+ *
+ * Records of the current batch whose payload was (even partly) staged go with
+ * them, so the index only describes bytes that reached the file. Later
+ * payloads are written from seg_written again, keeping their offsets right.
+ *
+ */
+static void capture_discard_stage(gs_capture_t *cap)
+{
+    int kept = cap->records_len;
+    while (kept > 0 && cap->records[kept - 1].offset + cap->records[kept - 1].length > cap->seg_written)
+    {
+        kept--;
+    }
+    dbprintlf(RED_FG "Capture write failed, dropped %zu staged bytes and %d packet(s) from the index.", cap->stage_len, cap->records_len - kept);
+    cap->records_len = kept;
+    cap->stage_len = 0;
+}
+
+/**
+ * @brief Writes the staging buffer to the current segment.
+ *
+ * With O_DIRECT only whole blocks can be written; a trailing partial block
+ * stays staged unless final is set, in which case it is written padded and
+ * the file is truncated back to its real length.
+ *
+ */
+static int capture_flush(gs_capture_t *cap, bool final)
+{
+    if (cap->fd < 0 || cap->stage_len == 0)
+    {
+        return 1;
+    }
+
+    size_t len = cap->stage_len;
+    size_t keep = 0;
+    if (cap->config.direct)
+    {
+        keep = len & (GS_CAPTURE_DIRECT_ALIGN - 1);
+        len -= keep;
+        if (final && keep > 0)
+        {
+            memset(cap->stage + cap->stage_len, 0x0, GS_CAPTURE_DIRECT_ALIGN - keep);
+            len += GS_CAPTURE_DIRECT_ALIGN;
+        }
+    }
+
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t ret = pwrite(cap->fd, cap->stage + done, len - done, cap->seg_written + done);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            cap->write_errors++;
+            gs_metric_add(GS_CTR_CAPTURE_ERRORS, 1);
+            erprintlf(errno);
+            capture_discard_stage(cap);
+            return -1;
+        }
+        done += ret;
+    }
+
+    if (cap->config.direct && final && keep > 0)
+    {
+        // Drop the padding.
+        cap->seg_written += cap->stage_len;
+        if (ftruncate(cap->fd, cap->seg_written) < 0)
+        {
+            erprintlf(errno);
+        }
+        cap->stage_len = 0;
+        return 1;
+    }
+
+    cap->seg_written += len;
+    if (keep > 0)
+    {
+        memmove(cap->stage, cap->stage + len, keep);
+    }
+    cap->stage_len = keep;
+    return 1;
+}
+
+/**
+ * @brief Appends the batch's index records.
+ *
+ * Called after the payloads they describe have been handed to the kernel, so
+ * the index never gets ahead of the data.
+ *
+ */
+static void capture_flush_index(gs_capture_t *cap)
+{
+    if (cap->idx_fd < 0 || cap->records_len == 0)
+    {
+        cap->records_len = 0;
+        return;
+    }
+
+    size_t len = cap->records_len * sizeof(gs_capture_record_t);
+    const uint8_t *ptr = (const uint8_t *)cap->records;
+    while (len > 0)
+    {
+        ssize_t ret = write(cap->idx_fd, ptr, len);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            cap->write_errors++;
+            gs_metric_add(GS_CTR_CAPTURE_ERRORS, 1);
+            erprintlf(errno);
+            break;
+        }
+        ptr += ret;
+        len -= ret;
+    }
+    cap->records_len = 0;
+}
+
+static void capture_close_segment(gs_capture_t *cap)
+{
+    if (cap->fd < 0)
+    {
+        return;
+    }
+    capture_flush(cap, true);
+    capture_flush_index(cap);
+    close(cap->fd);
+    cap->fd = -1;
+    if (cap->idx_fd >= 0)
+    {
+        close(cap->idx_fd);
+        cap->idx_fd = -1;
+    }
+    gs_compress_submit(cap->compress, cap->seg_path);
+}
+
+static int capture_open_segment(gs_capture_t *cap)
+{
+    char *path = cap->seg_path;
+    char idx_path[512];
+    int segment = cap->seg_index++;
+    snprintf(path, sizeof(cap->seg_path), "%s/%s_%s_%04d.bin", cap->config.dir, cap->config.prefix, cap->session, segment);
+    gs_capture_index_path(path, idx_path, sizeof(idx_path));
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    cap->fd = open(path, flags | (cap->config.direct ? O_DIRECT : 0), 0644);
+    if (cap->fd < 0 && cap->config.direct && errno == EINVAL)
+    {
+        dbprintlf(YELLOW_FG "O_DIRECT is not supported for %s, using buffered writes.", path);
+        cap->config.direct = false;
+        cap->fd = open(path, flags, 0644);
+    }
+    if (cap->fd < 0)
+    {
+        dbprintlf(RED_FG "Failed to open capture segment %s.", path);
+        erprintlf(errno);
+        cap->write_errors++;
+        return -1;
+    }
+
+    cap->idx_fd = open(idx_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (cap->idx_fd < 0)
+    {
+        dbprintlf(RED_FG "Failed to open capture index %s.", idx_path);
+        erprintlf(errno);
+        cap->write_errors++;
+        close(cap->fd);
+        cap->fd = -1;
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    gs_capture_index_header_t header[1];
+    memset(header, 0x0, sizeof(header));
+    header->magic = GS_CAPTURE_INDEX_MAGIC;
+    header->version = GS_CAPTURE_INDEX_VERSION;
+    header->record_size = sizeof(gs_capture_record_t);
+    header->created_ns = now.tv_sec * 1000000000ULL + now.tv_nsec;
+    header->segment = segment;
+    if (write(cap->idx_fd, header, sizeof(header)) != sizeof(header))
+    {
+        dbprintlf(RED_FG "Failed to write capture index header to %s.", idx_path);
+        cap->write_errors++;
+    }
+
+    // Reserve the whole segment up front without changing the visible file size.
+    if (fallocate(cap->fd, FALLOC_FL_KEEP_SIZE, 0, cap->config.segment_size) < 0 && errno != EOPNOTSUPP)
+    {
+        dbprintlf(YELLOW_FG "Could not preallocate %zu bytes for %s (%d).", cap->config.segment_size, path, errno);
+    }
+
+    cap->seg_written = 0;
+    cap->stage_len = 0;
+    cap->records_len = 0;
+    cap->seg_opened = time(NULL);
+    cap->segments++;
+    dbprintlf(GREEN_FG "Capturing to %s.", path);
+    return 1;
+}
+
+static void capture_stage(gs_capture_t *cap, const uint8_t *data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t room = GS_CAPTURE_STAGE_SIZE - cap->stage_len;
+        size_t n = len < room ? len : room;
+        memcpy(cap->stage + cap->stage_len, data, n);
+        cap->stage_len += n;
+        data += n;
+        len -= n;
+        if (cap->stage_len == GS_CAPTURE_STAGE_SIZE)
+        {
+            capture_flush(cap, false);
+        }
+    }
+}
+
+static void capture_append(gs_capture_t *cap, const gs_buf_t *buf)
+{
+    uint64_t used = cap->seg_written + cap->stage_len;
+
+    if (cap->fd >= 0 && used > 0 &&
+        (used + buf->len > cap->config.segment_size ||
+         (cap->config.rotate_sec > 0 && time(NULL) - cap->seg_opened >= cap->config.rotate_sec)))
+    {
+        capture_close_segment(cap);
+    }
+
+    if (cap->fd < 0 && capture_open_segment(cap) < 0)
+    {
+        return;
+    }
+
+    if (cap->records_len == GS_CAPTURE_BATCH)
+    {
+        capture_flush(cap, false);
+        capture_flush_index(cap);
+    }
+
+    gs_capture_record_t *record = &cap->records[cap->records_len++];
+    record->timestamp_ns = buf->meta.timestamp_ns;
+    record->offset = cap->seg_written + cap->stage_len;
+    record->length = buf->len;
+    record->last_rx_status = buf->meta.rx_status;
+    record->LO = buf->meta.LO;
+    record->samp = buf->meta.samp;
+    record->bw = buf->meta.bw;
+    record->seq = buf->meta.seq;
+
+    capture_stage(cap, buf->data, buf->len);
+
+    cap->packets++;
+    cap->bytes += buf->len;
+}
+
+static void *gs_capture_thread(void *args)
+{
+    gs_capture_t *cap = (gs_capture_t *)args;
+
+    while (true)
+    {
+        gs_buf_t *buf = gs_stage_pop(cap->queue, 100);
+        if (buf == NULL)
+        {
+            if (!cap->running)
+            {
+                break;
+            }
+            continue;
+        }
+
+        // Take whatever else is already queued, then write it all at once.
+        int n = 0;
+        size_t bytes = 0;
+        do
+        {
+            bytes += buf->len;
+            capture_append(cap, buf);
+            gs_buf_release(buf);
+            n++;
+        } while (n < GS_CAPTURE_BATCH && (buf = gs_stage_try_pop(cap->queue)) != NULL);
+
+        uint64_t start = gs_metrics_now_ns();
+        capture_flush(cap, false);
+        capture_flush_index(cap);
+        gs_metric_time(GS_HIST_CAPTURE_WRITE, gs_metrics_now_ns() - start);
+        gs_metric_add(GS_CTR_CAPTURE_PACKETS, n);
+        gs_metric_add(GS_CTR_CAPTURE_BYTES, bytes);
+    }
+
+    capture_close_segment(cap);
+    return NULL;
+}
+
+int gs_capture_init(gs_capture_t *capture, const gs_capture_config_t *config)
+{
+    capture->config = *config;
+    capture->fd = -1;
+    capture->idx_fd = -1;
+    capture->running = false;
+
+    if (!config->enabled)
+    {
+        dbprintlf(YELLOW_FG "Packet capture is disabled.");
+        return 0;
+    }
+
+    if (gs_stage_init(capture->queue, "Persist", config->queue_depth, config->policy, config->block_ms) < 0)
+    {
+        return -1;
+    }
+
+    capture->stage = (uint8_t *)aligned_alloc(GS_CAPTURE_DIRECT_ALIGN, GS_CAPTURE_STAGE_SIZE + GS_CAPTURE_DIRECT_ALIGN);
+    if (capture->stage == NULL)
+    {
+        gs_stage_destroy(capture->queue);
+        return -1;
+    }
+
+    // Segments are then kept raw; not a reason to stop capturing.
+    if (gs_compress_init(capture->compress, &config->compress) < 0)
+    {
+        dbprintlf(RED_FG "Could not start capture compression, segments will stay uncompressed.");
+    }
+
+    // Name segments after the start time so a restart never overwrites a previous pass.
+    time_t now = time(NULL);
+    struct tm tm_now;
+    gmtime_r(&now, &tm_now);
+    strftime(capture->session, sizeof(capture->session), "%Y%m%d_%H%M%S", &tm_now);
+
+    capture->seg_index = 0;
+    capture->stage_len = 0;
+    capture->packets = 0;
+    capture->bytes = 0;
+    capture->write_errors = 0;
+    capture->segments = 0;
+    capture->running = true;
+
+    if (gs_rt_thread_create(&capture->tid, GS_RT_WRITER, config->chain, gs_capture_thread, capture) != 0)
+    {
+        dbprintlf(RED_FG "Failed to start the capture writer thread.");
+        capture->running = false;
+        gs_compress_destroy(capture->compress);
+        gs_stage_destroy(capture->queue);
+        return -1;
+    }
+    return 1;
+}
+
+int gs_capture_submit(gs_capture_t *capture, gs_buf_t *buf)
+{
+    if (!capture->running)
+    {
+        return 0;
+    }
+    return gs_stage_push(capture->queue, buf);
+}
+
+void gs_capture_destroy(gs_capture_t *capture)
+{
+    if (!capture->running)
+    {
+        return;
+    }
+
+    capture->running = false;
+    gs_stage_wake(capture->queue);
+    pthread_join(capture->tid, NULL);
+
+    dbprintlf(GREEN_FG "Capture closed: %llu packets, %llu bytes, %u segments, %llu dropped, %llu write errors.",
+              (unsigned long long)capture->packets, (unsigned long long)capture->bytes, (unsigned)capture->segments,
+              (unsigned long long)capture->queue->dropped, (unsigned long long)capture->write_errors);
+
+    // The writer sealed the last segment on its way out; finish compressing it.
+    gs_compress_destroy(capture->compress);
+    gs_stage_destroy(capture->queue);
+    free(capture->stage);
+    capture->stage = NULL;
+}
@@ -0,0 +1,347 @@
+/**
+ * @file gs_capture_store.cpp
+ * @brief On-disk capture container format and memory-mapped reader.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gs_capture_store.hpp"
+#include "gs_compress.hpp"
+#include "meb_debug.hpp"
+
+static_assert(sizeof(gs_capture_index_header_t) == 64, "Capture index header must stay 64 bytes.");
+static_assert(sizeof(gs_capture_record_t) == 56, "Capture index record must stay 56 bytes.");
+
+/**
+ * @brief Length of data_path up to and including ".bin", or 0 if it is not a segment data file.
+ *
+ */
+static size_t capture_bin_len(const char *data_path)
+{
+    size_t len = strlen(data_path);
+    if (gs_compress_codec_of(data_path) != GS_COMPRESS_NONE)
+    {
+        len = strrchr(data_path, '.') - data_path;
+    }
+    return len >= 4 && strncmp(data_path + len - 4, ".bin", 4) == 0 ? len : 0;
+}
+
+int gs_capture_index_path(const char *data_path, char *idx_path, size_t size)
+{
+    size_t len = capture_bin_len(data_path);
+    if (len == 0 || len + 1 > size)
+    {
+        return -1;
+    }
+    memcpy(idx_path, data_path, len - 4);
+    memcpy(idx_path + len - 4, ".idx", 5);
+    return 1;
+}
+
+bool gs_capture_is_data_file(const char *path)
+{
+    return capture_bin_len(path) > 0;
+}
+
+static const uint8_t *reader_map(const char *path, int *fd, size_t *size)
+{
+    *fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (*fd < 0)
+    {
+        dbprintlf(RED_FG "Failed to open %s.", path);
+        erprintlf(errno);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(*fd, &st) < 0)
+    {
+        erprintlf(errno);
+        return NULL;
+    }
+    *size = st.st_size;
+    if (*size == 0)
+    {
+        return NULL;
+    }
+
+    void *map = mmap(NULL, *size, PROT_READ, MAP_SHARED, *fd, 0);
+    if (map == MAP_FAILED)
+    {
+        erprintlf(errno);
+        return NULL;
+    }
+    return (const uint8_t *)map;
+}
+
+/**
+ * @brief Maps a compressed segment, reads its seek table and reserves the raw data's address space.
+ *
+ */
+static int reader_open_packed(gs_capture_reader_t *reader, const char *data_path)
+{
+    if (!gs_compress_available(reader->codec))
+    {
+        dbprintlf(RED_FG "Cannot read %s: this build has no %s support (make ZSTD=1 / LZ4=1).", data_path,
+                  reader->codec == GS_COMPRESS_ZSTD ? "zstd" : "lz4");
+        return -5;
+    }
+
+    reader->packed = reader_map(data_path, &reader->data_fd, &reader->packed_size);
+    ssize_t frames = reader->packed == NULL ? -1 : gs_compress_frames(reader->packed, reader->packed_size, &reader->frames);
+    if (frames < 0)
+    {
+        dbprintlf(RED_FG "Compressed segment %s is truncated or has no seek table.", data_path);
+        return -4;
+    }
+    reader->num_frames = frames;
+    if (frames == 0)
+    {
+        return 1;
+    }
+
+    const gs_compress_frame_t *last = &reader->frames[frames - 1];
+    reader->data_size = last->raw_offset + last->raw_length;
+    if (reader->data_size == 0)
+    {
+        return 1;
+    }
+    reader->frame_ready = (uint8_t *)calloc(frames, 1);
+    void *raw = mmap(NULL, reader->data_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reader->frame_ready == NULL || raw == MAP_FAILED)
+    {
+        erprintlf(errno);
+        return -4;
+    }
+    reader->raw = (uint8_t *)raw;
+    reader->data = reader->raw;
+    return 1;
+}
+
+/**
+ * @brief Decompresses whatever frames of [offset, offset + length) are not yet in raw.
+ *
+ * @return bool false if a frame failed to decompress.
+ */
+static bool reader_ensure(const gs_capture_reader_t *reader, uint64_t offset, uint64_t length)
+{
+    if (reader->codec == GS_COMPRESS_NONE)
+    {
+        return true;
+    }
+
+    // First frame ending past offset.
+    size_t lo = 0, hi = reader->num_frames;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (reader->frames[mid].raw_offset + reader->frames[mid].raw_length <= offset)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    for (size_t f = lo; f < reader->num_frames && reader->frames[f].raw_offset < offset + length; f++)
+    {
+        if (reader->frame_ready[f])
+        {
+            continue;
+        }
+        const gs_compress_frame_t *frame = &reader->frames[f];
+        ssize_t ret = gs_decompress_frame(reader->codec, reader->packed + frame->offset, frame->length, reader->raw + frame->raw_offset, frame->raw_length);
+        if (ret != (ssize_t)frame->raw_length)
+        {
+            dbprintlf(RED_FG "Compressed frame %zu of a capture segment is corrupt.", f);
+            return false;
+        }
+        reader->frame_ready[f] = 1;
+    }
+    return true;
+}
+
+int gs_capture_reader_open(gs_capture_reader_t *reader, const char *data_path)
+{
+    memset(reader, 0x0, sizeof(gs_capture_reader_t));
+    reader->data_fd = -1;
+    reader->idx_fd = -1;
+
+    char idx_path[512];
+    if (gs_capture_index_path(data_path, idx_path, sizeof(idx_path)) < 0)
+    {
+        dbprintlf(RED_FG "%s is not a capture segment.", data_path);
+        return -1;
+    }
+
+    reader->idx = reader_map(idx_path, &reader->idx_fd, &reader->idx_size);
+    if (reader->idx == NULL || reader->idx_size < sizeof(gs_capture_index_header_t))
+    {
+        dbprintlf(RED_FG "Capture index %s is missing or truncated.", idx_path);
+        gs_capture_reader_close(reader);
+        return -2;
+    }
+
+    reader->header = (const gs_capture_index_header_t *)reader->idx;
+    if (reader->header->magic != GS_CAPTURE_INDEX_MAGIC ||
+        reader->header->version != GS_CAPTURE_INDEX_VERSION ||
+        reader->header->record_size != sizeof(gs_capture_record_t))
+    {
+        dbprintlf(RED_FG "Capture index %s has an unknown format.", idx_path);
+        gs_capture_reader_close(reader);
+        return -3;
+    }
+
+    reader->records = (const gs_capture_record_t *)(reader->idx + sizeof(gs_capture_index_header_t));
+    size_t count = (reader->idx_size - sizeof(gs_capture_index_header_t)) / sizeof(gs_capture_record_t);
+
+    reader->codec = gs_compress_codec_of(data_path);
+    if (reader->codec != GS_COMPRESS_NONE)
+    {
+        int ret = reader_open_packed(reader, data_path);
+        if (ret < 0)
+        {
+            gs_capture_reader_close(reader);
+            return ret;
+        }
+    }
+    else
+    {
+        // An empty segment has an index but no data to map.
+        reader->data = reader_map(data_path, &reader->data_fd, &reader->data_size);
+        if (reader->data_fd < 0 || (reader->data == NULL && reader->data_size > 0))
+        {
+            gs_capture_reader_close(reader);
+            return -4;
+        }
+    }
+
+    // Drop trailing records that point past the data actually on disk.
+    while (count > 0 && reader->records[count - 1].offset + reader->records[count - 1].length > reader->data_size)
+    {
+        count--;
+    }
+    reader->count = count;
+
+    return 1;
+}
+
+const gs_capture_record_t *gs_capture_reader_record(const gs_capture_reader_t *reader, size_t i)
+{
+    return i < reader->count ? &reader->records[i] : NULL;
+}
+
+const uint8_t *gs_capture_reader_payload(const gs_capture_reader_t *reader, size_t i, uint32_t *len)
+{
+    if (i >= reader->count)
+    {
+        return NULL;
+    }
+    if (!reader_ensure(reader, reader->records[i].offset, reader->records[i].length))
+    {
+        return NULL;
+    }
+    if (len != NULL)
+    {
+        *len = reader->records[i].length;
+    }
+    return reader->data + reader->records[i].offset;
+}
+
+size_t gs_capture_reader_find(const gs_capture_reader_t *reader, uint64_t timestamp_ns)
+{
+    size_t lo = 0, hi = reader->count;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (reader->records[mid].timestamp_ns < timestamp_ns)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t gs_capture_reader_scan(const gs_capture_reader_t *reader, uint64_t from_ns, uint64_t to_ns, gs_capture_scan_cb cb, void *user)
+{
+    size_t first = gs_capture_reader_find(reader, from_ns);
+    size_t last = gs_capture_reader_find(reader, to_ns);
+    if (first >= last)
+    {
+        return 0;
+    }
+
+    // Let the kernel read ahead over the range we are about to walk.
+    const gs_capture_record_t *a = &reader->records[first];
+    const gs_capture_record_t *b = &reader->records[last - 1];
+    if (reader->codec == GS_COMPRESS_NONE)
+    {
+        uintptr_t page = sysconf(_SC_PAGESIZE);
+        uintptr_t start = ((uintptr_t)(reader->data + a->offset)) & ~(page - 1);
+        uintptr_t end = (uintptr_t)(reader->data + b->offset + b->length);
+        madvise((void *)start, end - start, MADV_SEQUENTIAL);
+        madvise((void *)start, end - start, MADV_WILLNEED);
+    }
+
+    size_t visited = 0;
+    for (size_t i = first; i < last; i++)
+    {
+        if (!reader_ensure(reader, reader->records[i].offset, reader->records[i].length))
+        {
+            break;
+        }
+        visited++;
+        if (cb(&reader->records[i], reader->data + reader->records[i].offset, user))
+        {
+            break;
+        }
+    }
+    return visited;
+}
+
+void gs_capture_reader_close(gs_capture_reader_t *reader)
+{
+    // For a compressed segment, data is raw.
+    if (reader->data != NULL)
+    {
+        munmap((void *)reader->data, reader->data_size);
+    }
+    if (reader->packed != NULL)
+    {
+        munmap((void *)reader->packed, reader->packed_size);
+    }
+    free(reader->frames);
+    free(reader->frame_ready);
+    if (reader->idx != NULL)
+    {
+        munmap((void *)reader->idx, reader->idx_size);
+    }
+    if (reader->data_fd >= 0)
+    {
+        close(reader->data_fd);
+    }
+    if (reader->idx_fd >= 0)
+    {
+        close(reader->idx_fd);
+    }
+    memset(reader, 0x0, sizeof(gs_capture_reader_t));
+    reader->data_fd = -1;
+    reader->idx_fd = -1;
+}
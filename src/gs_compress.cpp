@@ -0,0 +1,653 @@
+/**
+ * @file gs_compress.cpp
+ * @brief Compresses sealed capture segments on a small worker pool.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#ifdef GS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef GS_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+#include "gs_compress.hpp"
+#include "gs_capture_store.hpp"
+#include "gs_config.hpp"
+#include "gs_metrics.hpp"
+#include "gs_rt.hpp"
+#include "meb_debug.hpp"
+
+// Per-worker scratch, reused from segment to segment.
+typedef struct
+{
+#ifdef GS_HAVE_ZSTD
+    ZSTD_CCtx *zstd;
+#endif
+    uint8_t *out;
+    size_t out_cap;
+    uint32_t *table; // Seek table: compressed, decompressed size per frame.
+    size_t table_len;
+    size_t table_cap;
+} compress_ctx_t;
+
+static const char *compress_ext[] = {"", ".zst", ".lz4"};
+static const char *compress_names[] = {"none", "zstd", "lz4"};
+
+gs_compress_codec_t gs_compress_codec_env(const char *name, gs_compress_codec_t fallback)
+{
+    const char *value = gs_env_str(name, NULL);
+    if (value == NULL)
+    {
+        return fallback;
+    }
+    for (int codec = GS_COMPRESS_NONE; codec <= GS_COMPRESS_LZ4; codec++)
+    {
+        if (strcasecmp(value, compress_names[codec]) == 0)
+        {
+            return (gs_compress_codec_t)codec;
+        }
+    }
+    dbprintlf(YELLOW_FG "Unknown %s \"%s\", using %s.", name, value, compress_names[fallback]);
+    return fallback;
+}
+
+bool gs_compress_available(gs_compress_codec_t codec)
+{
+    switch (codec)
+    {
+#ifdef GS_HAVE_ZSTD
+    case GS_COMPRESS_ZSTD:
+        return true;
+#endif
+#ifdef GS_HAVE_LZ4
+    case GS_COMPRESS_LZ4:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+gs_compress_codec_t gs_compress_codec_of(const char *path)
+{
+    size_t len = strlen(path);
+    for (int codec = GS_COMPRESS_ZSTD; codec <= GS_COMPRESS_LZ4; codec++)
+    {
+        size_t ext = strlen(compress_ext[codec]);
+        if (len > ext + 4 && strcmp(path + len - ext, compress_ext[codec]) == 0 && strncmp(path + len - ext - 4, ".bin", 4) == 0)
+        {
+            return (gs_compress_codec_t)codec;
+        }
+    }
+    return GS_COMPRESS_NONE;
+}
+
+ssize_t gs_compress_frames(const uint8_t *data, size_t size, gs_compress_frame_t **frames)
+{
+    *frames = NULL;
+
+    // Footer: u32 frames, u8 descriptor (bit 7: entries carry a checksum), u32 magic.
+    uint32_t count, magic;
+    if (size < 8 + 9)
+    {
+        return -1;
+    }
+    memcpy(&count, data + size - 9, 4);
+    memcpy(&magic, data + size - 4, 4);
+    size_t entry = (data[size - 5] & 0x80) ? 12 : 8;
+    if (magic != GS_COMPRESS_SEEKABLE_MAGIC || count > (size - 8 - 9) / entry)
+    {
+        return -1;
+    }
+
+    size_t table_size = count * entry + 9;
+    const uint8_t *header = data + size - table_size - 8;
+    uint32_t header_magic, header_size;
+    memcpy(&header_magic, header, 4);
+    memcpy(&header_size, header + 4, 4);
+    if (header_magic != GS_COMPRESS_SKIPPABLE_MAGIC || header_size != table_size)
+    {
+        return -1;
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    gs_compress_frame_t *out = (gs_compress_frame_t *)malloc(count * sizeof(gs_compress_frame_t));
+    if (out == NULL)
+    {
+        return -1;
+    }
+    uint64_t offset = 0, raw_offset = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t sizes[2];
+        memcpy(sizes, header + 8 + i * entry, sizeof(sizes));
+        out[i].offset = offset;
+        out[i].length = sizes[0];
+        out[i].raw_offset = raw_offset;
+        out[i].raw_length = sizes[1];
+        offset += sizes[0];
+        raw_offset += sizes[1];
+    }
+    // The frames must fill the file up to the table exactly.
+    if (offset != (uint64_t)(header - data))
+    {
+        free(out);
+        return -1;
+    }
+    *frames = out;
+    return count;
+}
+
+ssize_t gs_decompress_frame(gs_compress_codec_t codec, const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+    switch (codec)
+    {
+#ifdef GS_HAVE_ZSTD
+    case GS_COMPRESS_ZSTD:
+    {
+        size_t ret = ZSTD_decompress(dst, cap, src, len);
+        if (ZSTD_isError(ret))
+        {
+            dbprintlf(RED_FG "zstd: %s", ZSTD_getErrorName(ret));
+            return -1;
+        }
+        return ret;
+    }
+#endif
+#ifdef GS_HAVE_LZ4
+    case GS_COMPRESS_LZ4:
+    {
+        LZ4F_dctx *dctx;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)))
+        {
+            return -1;
+        }
+        size_t in = 0, out = 0;
+        size_t ret = 1;
+        while (ret != 0 && in < len)
+        {
+            size_t dst_size = cap - out;
+            size_t src_size = len - in;
+            ret = LZ4F_decompress(dctx, dst + out, &dst_size, src + in, &src_size, NULL);
+            if (LZ4F_isError(ret))
+            {
+                dbprintlf(RED_FG "lz4: %s", LZ4F_getErrorName(ret));
+                break;
+            }
+            if (src_size == 0 && dst_size == 0)
+            {
+                break; // Output full with the frame unfinished.
+            }
+            in += src_size;
+            out += dst_size;
+        }
+        LZ4F_freeDecompressionContext(dctx);
+        return ret == 0 ? (ssize_t)out : -1;
+    }
+#endif
+    default:
+        return -1;
+    }
+}
+
+static void compress_ctx_destroy(compress_ctx_t *ctx)
+{
+#ifdef GS_HAVE_ZSTD
+    ZSTD_freeCCtx(ctx->zstd);
+#endif
+    free(ctx->out);
+    free(ctx->table);
+    memset(ctx, 0x0, sizeof(compress_ctx_t));
+}
+
+static size_t compress_bound(gs_compress_codec_t codec, size_t len)
+{
+    switch (codec)
+    {
+#ifdef GS_HAVE_ZSTD
+    case GS_COMPRESS_ZSTD:
+        return ZSTD_compressBound(len);
+#endif
+#ifdef GS_HAVE_LZ4
+    case GS_COMPRESS_LZ4:
+        return LZ4F_compressFrameBound(len, NULL);
+#endif
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Compresses src into one self-contained frame in ctx->out.
+ *
+ * @return ssize_t Compressed size, negative on failure.
+ */
+static ssize_t compress_frame(compress_ctx_t *ctx, const gs_compress_config_t *config, const uint8_t *src, size_t len)
+{
+    size_t bound = compress_bound(config->codec, len);
+    if (bound == 0)
+    {
+        return -1;
+    }
+    if (bound > ctx->out_cap)
+    {
+        uint8_t *out = (uint8_t *)realloc(ctx->out, bound);
+        if (out == NULL)
+        {
+            return -1;
+        }
+        ctx->out = out;
+        ctx->out_cap = bound;
+    }
+
+    switch (config->codec)
+    {
+#ifdef GS_HAVE_ZSTD
+    case GS_COMPRESS_ZSTD:
+    {
+        if (ctx->zstd == NULL && (ctx->zstd = ZSTD_createCCtx()) == NULL)
+        {
+            return -1;
+        }
+        size_t ret = ZSTD_compressCCtx(ctx->zstd, ctx->out, ctx->out_cap, src, len, config->level ? config->level : ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(ret))
+        {
+            dbprintlf(RED_FG "zstd: %s", ZSTD_getErrorName(ret));
+            return -1;
+        }
+        return ret;
+    }
+#endif
+#ifdef GS_HAVE_LZ4
+    case GS_COMPRESS_LZ4:
+    {
+        LZ4F_preferences_t prefs;
+        memset(&prefs, 0x0, sizeof(prefs));
+        prefs.compressionLevel = config->level;
+        prefs.frameInfo.contentSize = len;
+        size_t ret = LZ4F_compressFrame(ctx->out, ctx->out_cap, src, len, &prefs);
+        if (LZ4F_isError(ret))
+        {
+            dbprintlf(RED_FG "lz4: %s", LZ4F_getErrorName(ret));
+            return -1;
+        }
+        return ret;
+    }
+#endif
+    default:
+        return -1;
+    }
+}
+
+static int compress_write(int fd, const void *buf, size_t len)
+{
+    const uint8_t *ptr = (const uint8_t *)buf;
+    while (len > 0)
+    {
+        ssize_t ret = write(fd, ptr, len);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            erprintlf(errno);
+            return -1;
+        }
+        ptr += ret;
+        len -= ret;
+    }
+    return 1;
+}
+
+static int compress_table_add(compress_ctx_t *ctx, uint32_t compressed, uint32_t decompressed)
+{
+    if (ctx->table_len + 2 > ctx->table_cap)
+    {
+        size_t cap = ctx->table_cap ? ctx->table_cap * 2 : 512;
+        uint32_t *table = (uint32_t *)realloc(ctx->table, cap * sizeof(uint32_t));
+        if (table == NULL)
+        {
+            return -1;
+        }
+        ctx->table = table;
+        ctx->table_cap = cap;
+    }
+    ctx->table[ctx->table_len++] = compressed;
+    ctx->table[ctx->table_len++] = decompressed;
+    return 1;
+}
+
+/**
+ * @brief Appends the seek table as a skippable frame (zstd seekable format, no checksums).
+ *
+ */
+static int compress_write_table(int fd, const compress_ctx_t *ctx)
+{
+    uint32_t frames = ctx->table_len / 2;
+    uint32_t header[2] = {GS_COMPRESS_SKIPPABLE_MAGIC, (uint32_t)(ctx->table_len * sizeof(uint32_t) + 9)};
+    uint8_t footer[9];
+    uint32_t magic = GS_COMPRESS_SEEKABLE_MAGIC;
+    memcpy(footer, &frames, 4);
+    footer[4] = 0; // Seek table descriptor: no checksums.
+    memcpy(footer + 5, &magic, 4);
+
+    if (compress_write(fd, header, sizeof(header)) < 0 ||
+        compress_write(fd, ctx->table, ctx->table_len * sizeof(uint32_t)) < 0 ||
+        compress_write(fd, footer, sizeof(footer)) < 0)
+    {
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * @brief End of the next frame starting at pos: whole packets adding up to about frame_size.
+ *
+ * Data past the last indexed packet is cut into plain frame_size pieces.
+ *
+ */
+static size_t compress_frame_end(const gs_capture_reader_t *reader, size_t *record, size_t pos, size_t total, size_t frame_size)
+{
+    size_t end = pos;
+    while (*record < reader->count)
+    {
+        const gs_capture_record_t *rec = &reader->records[*record];
+        size_t rec_end = rec->offset + rec->length;
+        if (rec_end <= pos)
+        {
+            (*record)++;
+            continue;
+        }
+        if (rec_end > total || (end > pos && rec_end - pos > frame_size))
+        {
+            break;
+        }
+        end = rec_end;
+        (*record)++;
+    }
+
+    if (end == pos)
+    {
+        end = pos + frame_size < total ? pos + frame_size : total;
+    }
+    return end;
+}
+
+static int compress_segment(compress_ctx_t *ctx, const gs_compress_config_t *config, const char *path, uint64_t *in_bytes, uint64_t *out_bytes)
+{
+    *in_bytes = 0;
+    *out_bytes = 0;
+
+    if (!gs_compress_available(config->codec))
+    {
+        return -1;
+    }
+
+    gs_capture_reader_t reader[1];
+    if (gs_capture_reader_open(reader, path) < 0)
+    {
+        return -1;
+    }
+
+    char out_path[512 + 8];
+    char tmp_path[512 + 16];
+    snprintf(out_path, sizeof(out_path), "%s%s", path, compress_ext[config->codec]);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", out_path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        dbprintlf(RED_FG "Failed to open %s.", tmp_path);
+        erprintlf(errno);
+        gs_capture_reader_close(reader);
+        return -1;
+    }
+
+    int ret = 1;
+    size_t total = reader->data_size;
+    size_t frame_size = config->frame_size > 0 ? config->frame_size : (size_t)GS_COMPRESS_DEFAULT_FRAME_KB << 10;
+    size_t record = 0;
+    size_t pos = 0;
+    ctx->table_len = 0;
+
+    while (pos < total && ret > 0)
+    {
+        size_t end = compress_frame_end(reader, &record, pos, total, frame_size);
+
+        uint64_t start = gs_metrics_now_ns();
+        ssize_t len = compress_frame(ctx, config, reader->data + pos, end - pos);
+        gs_metric_time(GS_HIST_COMPRESS_FRAME, gs_metrics_now_ns() - start);
+
+        if (len < 0 || compress_write(fd, ctx->out, len) < 0 || compress_table_add(ctx, len, end - pos) < 0)
+        {
+            ret = -1;
+            break;
+        }
+        *out_bytes += len;
+        pos = end;
+    }
+    *in_bytes = pos;
+
+    if (ret > 0 && (compress_write_table(fd, ctx) < 0 || fdatasync(fd) < 0))
+    {
+        ret = -1;
+    }
+    *out_bytes += 8 + ctx->table_len * sizeof(uint32_t) + 9;
+    close(fd);
+    gs_capture_reader_close(reader);
+
+    // Only once the compressed copy is safely on disk does the raw one go.
+    if (ret > 0 && rename(tmp_path, out_path) < 0)
+    {
+        erprintlf(errno);
+        ret = -1;
+    }
+    if (ret < 0)
+    {
+        unlink(tmp_path);
+        return -1;
+    }
+    if (!config->keep && unlink(path) < 0)
+    {
+        erprintlf(errno);
+    }
+    return 1;
+}
+
+int gs_compress_file(const gs_compress_config_t *config, const char *path, uint64_t *in_bytes, uint64_t *out_bytes)
+{
+    compress_ctx_t ctx[1];
+    memset(ctx, 0x0, sizeof(compress_ctx_t));
+    int ret = compress_segment(ctx, config, path, in_bytes, out_bytes);
+    compress_ctx_destroy(ctx);
+    return ret;
+}
+
+static void *gs_compress_thread(void *args)
+{
+    gs_compress_t *compress = (gs_compress_t *)args;
+    compress_ctx_t ctx[1];
+    memset(ctx, 0x0, sizeof(compress_ctx_t));
+
+    // Per-thread on Linux: only this worker is deprioritized.
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), GS_COMPRESS_NICE);
+
+    while (true)
+    {
+        char path[512];
+
+        pthread_mutex_lock(&compress->lock);
+        while (compress->running && compress->len == 0)
+        {
+            pthread_cond_wait(&compress->cond, &compress->lock);
+        }
+        if (compress->len == 0)
+        {
+            pthread_mutex_unlock(&compress->lock);
+            break;
+        }
+        memcpy(path, compress->queue[compress->head], sizeof(path));
+        compress->head = (compress->head + 1) % GS_COMPRESS_QUEUE_DEPTH;
+        compress->len--;
+        pthread_mutex_unlock(&compress->lock);
+
+        uint64_t in_bytes, out_bytes;
+        uint64_t start = gs_metrics_now_ns();
+        if (compress_segment(ctx, &compress->config, path, &in_bytes, &out_bytes) < 0)
+        {
+            dbprintlf(RED_FG "Failed to compress %s, leaving it uncompressed.", path);
+            compress->errors++;
+            gs_metric_add(GS_CTR_COMPRESS_ERRORS, 1);
+            continue;
+        }
+        double elapsed = (gs_metrics_now_ns() - start) / 1e9;
+
+        compress->segments++;
+        compress->in_bytes += in_bytes;
+        compress->out_bytes += out_bytes;
+        gs_metric_add(GS_CTR_COMPRESS_SEGMENTS, 1);
+        gs_metric_add(GS_CTR_COMPRESS_IN_BYTES, in_bytes);
+        gs_metric_add(GS_CTR_COMPRESS_OUT_BYTES, out_bytes);
+
+        dbprintlf(GREEN_FG "Compressed %s: %llu -> %llu bytes (%.2fx) at %.1f MB/s.", path,
+                  (unsigned long long)in_bytes, (unsigned long long)out_bytes,
+                  out_bytes ? (double)in_bytes / out_bytes : 0.0, elapsed > 0 ? in_bytes / elapsed / 1e6 : 0.0);
+    }
+
+    compress_ctx_destroy(ctx);
+    return NULL;
+}
+
+int gs_compress_init(gs_compress_t *compress, const gs_compress_config_t *config)
+{
+    compress->config = *config;
+    compress->num_threads = 0;
+    compress->head = 0;
+    compress->len = 0;
+    compress->running = false;
+    compress->segments = 0;
+    compress->in_bytes = 0;
+    compress->out_bytes = 0;
+    compress->errors = 0;
+    compress->skipped = 0;
+
+    if (config->codec == GS_COMPRESS_NONE)
+    {
+        return 0;
+    }
+    if (!gs_compress_available(config->codec))
+    {
+        dbprintlf(YELLOW_FG "Capture compression with %s is not built in (make ZSTD=1 / LZ4=1); segments stay uncompressed.", compress_names[config->codec]);
+        return 0;
+    }
+
+    int threads = config->threads;
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    if (threads > GS_COMPRESS_MAX_THREADS)
+    {
+        threads = GS_COMPRESS_MAX_THREADS;
+    }
+
+    pthread_mutex_init(&compress->lock, NULL);
+    pthread_cond_init(&compress->cond, NULL);
+    compress->running = true;
+
+    for (int i = 0; i < threads; i++)
+    {
+        if (gs_rt_thread_create(&compress->tids[i], GS_RT_COMPRESS, -1, gs_compress_thread, compress) != 0)
+        {
+            dbprintlf(RED_FG "Failed to start capture compression thread %d.", i);
+            break;
+        }
+        compress->num_threads++;
+    }
+
+    if (compress->num_threads == 0)
+    {
+        compress->running = false;
+        pthread_cond_destroy(&compress->cond);
+        pthread_mutex_destroy(&compress->lock);
+        return -1;
+    }
+
+    dbprintlf(GREEN_FG "Compressing sealed capture segments with %s on %d thread(s).", compress_names[config->codec], compress->num_threads);
+    return 1;
+}
+
+int gs_compress_submit(gs_compress_t *compress, const char *path)
+{
+    if (!compress->running)
+    {
+        return 0;
+    }
+
+    int ret = 1;
+    pthread_mutex_lock(&compress->lock);
+    if (compress->len == GS_COMPRESS_QUEUE_DEPTH)
+    {
+        ret = -1;
+    }
+    else
+    {
+        int tail = (compress->head + compress->len) % GS_COMPRESS_QUEUE_DEPTH;
+        snprintf(compress->queue[tail], sizeof(compress->queue[tail]), "%s", path);
+        compress->len++;
+        pthread_cond_signal(&compress->cond);
+    }
+    pthread_mutex_unlock(&compress->lock);
+
+    if (ret < 0)
+    {
+        compress->skipped++;
+        dbprintlf(YELLOW_FG "Compression is behind, leaving %s uncompressed.", path);
+    }
+    return ret;
+}
+
+void gs_compress_destroy(gs_compress_t *compress)
+{
+    if (!compress->running)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&compress->lock);
+    compress->running = false;
+    pthread_cond_broadcast(&compress->cond);
+    pthread_mutex_unlock(&compress->lock);
+
+    for (int i = 0; i < compress->num_threads; i++)
+    {
+        pthread_join(compress->tids[i], NULL);
+    }
+
+    uint64_t in_bytes = compress->in_bytes;
+    uint64_t out_bytes = compress->out_bytes;
+    dbprintlf(GREEN_FG "Compression closed: %llu segments, %llu -> %llu bytes (%.2fx), %llu left raw, %llu errors.",
+              (unsigned long long)compress->segments, (unsigned long long)in_bytes, (unsigned long long)out_bytes,
+              out_bytes ? (double)in_bytes / out_bytes : 0.0,
+              (unsigned long long)compress->skipped, (unsigned long long)compress->errors);
+
+    pthread_cond_destroy(&compress->cond);
+    pthread_mutex_destroy(&compress->lock);
+}
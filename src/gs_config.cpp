@@ -0,0 +1,94 @@
+/**
+ * @file gs_config.cpp
+ * @brief Helpers for reading HAYSTACK_* runtime settings from the environment.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gs_config.hpp"
+#include "meb_debug.hpp"
+
+int64_t gs_env_int(const char *name, int64_t fallback)
+{
+    const char *val = getenv(name);
+    if (val == NULL || val[0] == '\0')
+    {
+        return fallback;
+    }
+
+    char *end = NULL;
+    long long ret = strtoll(val, &end, 0);
+    if (end == val || *end != '\0')
+    {
+        dbprintlf(YELLOW_FG "Ignoring invalid %s=\"%s\", using %lld.", name, val, (long long)fallback);
+        return fallback;
+    }
+    return ret;
+}
+
+double gs_env_double(const char *name, double fallback)
+{
+    const char *val = getenv(name);
+    if (val == NULL || val[0] == '\0')
+    {
+        return fallback;
+    }
+
+    char *end = NULL;
+    double ret = strtod(val, &end);
+    if (end == val || *end != '\0')
+    {
+        dbprintlf(YELLOW_FG "Ignoring invalid %s=\"%s\", using %f.", name, val, fallback);
+        return fallback;
+    }
+    return ret;
+}
+
+const char *gs_env_str(const char *name, const char *fallback)
+{
+    const char *val = getenv(name);
+    if (val == NULL || val[0] == '\0')
+    {
+        return fallback;
+    }
+    return val;
+}
+
+/**
+ * @brief Picks HAYSTACK_CHAIN<chain>_<name> if it is set, else HAYSTACK_<name>.
+ *
+ */
+static const char *chain_env_name(int chain, const char *name, char *buf, size_t len)
+{
+    snprintf(buf, len, "HAYSTACK_CHAIN%d_%s", chain, name);
+    const char *val = getenv(buf);
+    if (val == NULL || val[0] == '\0')
+    {
+        snprintf(buf, len, "HAYSTACK_%s", name);
+    }
+    return buf;
+}
+
+int64_t gs_chain_env_int(int chain, const char *name, int64_t fallback)
+{
+    char buf[128];
+    return gs_env_int(chain_env_name(chain, name, buf, sizeof(buf)), fallback);
+}
+
+double gs_chain_env_double(int chain, const char *name, double fallback)
+{
+    char buf[128];
+    return gs_env_double(chain_env_name(chain, name, buf, sizeof(buf)), fallback);
+}
+
+const char *gs_chain_env_str(int chain, const char *name, const char *fallback)
+{
+    char buf[128];
+    return gs_env_str(chain_env_name(chain, name, buf, sizeof(buf)), fallback);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file gs_crc.cpp
+ * @brief Table-sliced CRC-16/CCITT (poly 0x1021, init 0xFFFF).
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Slicing-by-8: eight 256-entry tables let the inner loop consume eight
+ * bytes per iteration with independent lookups.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include "gs_crc.hpp"
+
+static uint16_t crc_table[8][256];
+
+static struct crc_table_init
+{
+    crc_table_init()
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            uint16_t crc = i << 8;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+            crc_table[0][i] = crc;
+        }
+        for (int i = 0; i < 256; i++)
+        {
+            for (int t = 1; t < 8; t++)
+            {
+                uint16_t prev = crc_table[t - 1][i];
+                crc_table[t][i] = (prev << 8) ^ crc_table[0][prev >> 8];
+            }
+        }
+    }
+} crc_table_init_once;
+
+uint16_t gs_crc16(uint16_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (len >= 8)
+    {
+        crc = crc_table[7][(p[0] ^ (crc >> 8)) & 0xFF] ^
+              crc_table[6][(p[1] ^ crc) & 0xFF] ^
+              crc_table[5][p[2]] ^
+              crc_table[4][p[3]] ^
+              crc_table[3][p[4]] ^
+              crc_table[2][p[5]] ^
+              crc_table[1][p[6]] ^
+              crc_table[0][p[7]];
+        p += 8;
+        len -= 8;
+    }
+
+    while (len--)
+    {
+        crc = (crc << 8) ^ crc_table[0][((crc >> 8) ^ *p++) & 0xFF];
+    }
+    return crc;
+}
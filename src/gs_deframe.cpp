@@ -0,0 +1,350 @@
+/**
+ * @file gs_deframe.cpp
+ * @brief Splits the modem's output into CCSDS transfer frames and checks their CRC.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The sync marker search tests 16 (NEON), 32 (SSE2) or 64 (AVX2) positions
+ * a pass against the marker's first and last bytes, two loads and compares
+ * per vector; the few positions where both match get a full check. AVX2 is
+ * chosen at run time, so the build needs no -mavx2.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include <strings.h>
+#include "gs_deframe.hpp"
+#include "gs_crc.hpp"
+#include "gs_config.hpp"
+#include "meb_debug.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static const uint8_t asm_bytes[GS_CCSDS_ASM_LEN] = {0x1A, 0xCF, 0xFC, 0x1D};
+
+static uint8_t ccsds_pn[GS_CCSDS_PN_PERIOD]; // One period of the pseudo-random sequence.
+
+static struct ccsds_pn_init
+{
+    ccsds_pn_init()
+    {
+        // a[n + 8] = a[n + 7] ^ a[n + 5] ^ a[n + 3] ^ a[n], from a[0..7] = 1; first bit is the MSB of the first byte.
+        uint8_t sr = 0xFF;
+        for (int i = 0; i < GS_CCSDS_PN_PERIOD; i++)
+        {
+            uint8_t byte = 0;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                byte = (byte << 1) | (sr >> 7);
+                uint8_t next = ((sr >> 7) ^ (sr >> 4) ^ (sr >> 2) ^ sr) & 1; // a[n], a[n + 3], a[n + 5], a[n + 7].
+                sr = (sr << 1) | next;
+            }
+            ccsds_pn[i] = byte;
+        }
+    }
+} ccsds_pn_init_once;
+
+void gs_ccsds_randomize(uint8_t *data, size_t len)
+{
+    for (size_t off = 0; off < len; off += GS_CCSDS_PN_PERIOD)
+    {
+        size_t n = len - off < GS_CCSDS_PN_PERIOD ? len - off : GS_CCSDS_PN_PERIOD;
+        for (size_t i = 0; i < n; i++)
+        {
+            data[off + i] ^= ccsds_pn[i];
+        }
+    }
+}
+
+const uint8_t *gs_asm_find_scalar(const uint8_t *data, size_t len)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+    while (end - p >= GS_CCSDS_ASM_LEN && (p = (const uint8_t *)memchr(p, asm_bytes[0], end - p - (GS_CCSDS_ASM_LEN - 1))) != NULL)
+    {
+        if (p[1] == asm_bytes[1] && p[2] == asm_bytes[2] && p[3] == asm_bytes[3])
+        {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+#if defined(__SSE2__)
+static const uint8_t *asm_find_sse2(const uint8_t *data, size_t len)
+{
+    const __m128i b0 = _mm_set1_epi8((char)asm_bytes[0]);
+    const __m128i b3 = _mm_set1_epi8((char)asm_bytes[3]);
+
+    size_t i = 0;
+    for (; i + 32 + GS_CCSDS_ASM_LEN - 1 <= len; i += 32)
+    {
+        __m128i lo = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i)), b0),
+                                   _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 3)), b3));
+        __m128i hi = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 16)), b0),
+                                   _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 19)), b3));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(lo) | ((uint32_t)_mm_movemask_epi8(hi) << 16);
+        while (mask != 0)
+        {
+            const uint8_t *p = data + i + __builtin_ctz(mask);
+            if (p[1] == asm_bytes[1] && p[2] == asm_bytes[2])
+            {
+                return p;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return gs_asm_find_scalar(data + i, len - i);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static const uint8_t *asm_find_avx2(const uint8_t *data, size_t len)
+{
+    const __m256i b0 = _mm256_set1_epi8((char)asm_bytes[0]);
+    const __m256i b3 = _mm256_set1_epi8((char)asm_bytes[3]);
+
+    // First and last byte only, 64 positions a pass; the rare candidates are checked in full.
+    size_t i = 0;
+    for (; i + 64 + GS_CCSDS_ASM_LEN - 1 <= len; i += 64)
+    {
+        __m256i lo = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i)), b0),
+                                      _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i + 3)), b3));
+        __m256i hi = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i + 32)), b0),
+                                      _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i + 35)), b3));
+        uint64_t mask = (uint32_t)_mm256_movemask_epi8(lo) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(hi) << 32);
+        while (mask != 0)
+        {
+            const uint8_t *p = data + i + __builtin_ctzll(mask);
+            if (p[1] == asm_bytes[1] && p[2] == asm_bytes[2])
+            {
+                return p;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return gs_asm_find_scalar(data + i, len - i);
+}
+#endif
+
+#if defined(__ARM_NEON)
+static const uint8_t *asm_find_neon(const uint8_t *data, size_t len)
+{
+    const uint8x16_t b0 = vdupq_n_u8(asm_bytes[0]);
+    const uint8x16_t b3 = vdupq_n_u8(asm_bytes[3]);
+
+    size_t i = 0;
+    for (; i + 16 + GS_CCSDS_ASM_LEN - 1 <= len; i += 16)
+    {
+        uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(data + i), b0), vceqq_u8(vld1q_u8(data + i + 3), b3));
+        // No movemask on ARMv7; a candidate is rare, so check these 16 positions the slow way.
+        uint64x2_t any = vreinterpretq_u64_u8(eq);
+        if ((vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) != 0)
+        {
+            const uint8_t *p = gs_asm_find_scalar(data + i, 16 + GS_CCSDS_ASM_LEN - 1);
+            if (p != NULL)
+            {
+                return p;
+            }
+        }
+    }
+    return gs_asm_find_scalar(data + i, len - i);
+}
+#endif
+
+typedef const uint8_t *(*asm_find_fn)(const uint8_t *data, size_t len);
+
+static asm_find_fn asm_find = gs_asm_find_scalar;
+static const char *asm_find_name = "scalar";
+
+static struct asm_find_init
+{
+    asm_find_init()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2"))
+        {
+            asm_find = asm_find_avx2;
+            asm_find_name = "avx2";
+            return;
+        }
+#endif
+#if defined(__SSE2__)
+        asm_find = asm_find_sse2;
+        asm_find_name = "sse2";
+#elif defined(__ARM_NEON)
+        asm_find = asm_find_neon;
+        asm_find_name = "neon";
+#endif
+    }
+} asm_find_init_once;
+
+const uint8_t *gs_asm_find(const uint8_t *data, size_t len)
+{
+    return asm_find(data, len);
+}
+
+const char *gs_asm_find_name()
+{
+    return asm_find_name;
+}
+
+void gs_deframe_config_load(gs_deframe_config_t *config, int chain)
+{
+    const char *mode = gs_chain_env_str(chain, "DEFRAME", "off");
+    if (strcasecmp(mode, "keep") == 0)
+    {
+        config->mode = GS_DEFRAME_KEEP;
+    }
+    else if (strcasecmp(mode, "drop") == 0)
+    {
+        config->mode = GS_DEFRAME_DROP;
+    }
+    else
+    {
+        if (strcasecmp(mode, "off") != 0)
+        {
+            dbprintlf(YELLOW_FG "Unknown HAYSTACK_DEFRAME \"%s\", expected off, keep or drop; not deframing.", mode);
+        }
+        config->mode = GS_DEFRAME_OFF;
+    }
+    config->frame_len = gs_chain_env_int(chain, "DEFRAME_LEN", GS_DEFRAME_DEFAULT_LEN);
+    config->crc = gs_chain_env_int(chain, "DEFRAME_CRC", 1) != 0;
+    config->derandomize = gs_chain_env_int(chain, "DEFRAME_DERANDOMIZE", 0) != 0;
+}
+
+int gs_deframe_init(gs_deframe_t *deframe, const gs_deframe_config_t *config)
+{
+    if (config->frame_len < 3 || config->frame_len > GS_DEFRAME_MAX_LEN)
+    {
+        dbprintlf(RED_FG "Transfer frame length %zu is outside 3-%d bytes.", config->frame_len, GS_DEFRAME_MAX_LEN);
+        return -1;
+    }
+    deframe->config = *config;
+    gs_deframe_reset(deframe);
+    return 1;
+}
+
+void gs_deframe_reset(gs_deframe_t *deframe)
+{
+    deframe->carry_len = 0;
+    memset(&deframe->stats, 0x0, sizeof(deframe->stats));
+}
+
+/**
+ * @brief Counts one frame and copies it to out unless it is to be dropped.
+ *
+ * @return size_t Bytes written to out.
+ */
+static size_t deframe_emit(gs_deframe_t *deframe, const uint8_t *frame, uint8_t *out)
+{
+    size_t frame_len = deframe->config.frame_len;
+    deframe->stats.frames++;
+    if (deframe->config.derandomize)
+    {
+        // The input may not be written to; derandomize the copy and check that.
+        memcpy(out, frame, frame_len);
+        gs_ccsds_randomize(out, frame_len);
+        frame = out;
+    }
+    // Over the whole frame, FECF included, a good CRC leaves no remainder.
+    if (deframe->config.crc && gs_crc16(GS_CRC16_INIT, frame, frame_len) != 0)
+    {
+        deframe->stats.crc_errors++;
+        if (deframe->config.mode == GS_DEFRAME_DROP)
+        {
+            return 0;
+        }
+    }
+    if (frame != out)
+    {
+        memcpy(out, frame, frame_len);
+    }
+    return frame_len;
+}
+
+/**
+ * @brief Length of the longest proper prefix of the sync marker that ends the buffer.
+ *
+ * The marker does not overlap itself, so there is at most one.
+ */
+static size_t deframe_tail_prefix(const uint8_t *data, size_t len)
+{
+    for (size_t n = GS_CCSDS_ASM_LEN - 1; n > 0; n--)
+    {
+        if (len >= n && memcmp(data + len - n, asm_bytes, n) == 0)
+        {
+            return n;
+        }
+    }
+    return 0;
+}
+
+size_t gs_deframe(gs_deframe_t *deframe, const uint8_t *data, size_t len, uint8_t *out)
+{
+    const size_t cadu_len = GS_CCSDS_ASM_LEN + deframe->config.frame_len;
+    size_t out_len = 0;
+    size_t pos = 0;
+
+    if (deframe->carry_len > 0)
+    {
+        // A carried marker prefix only counts if this read completes it.
+        if (deframe->carry_len < GS_CCSDS_ASM_LEN)
+        {
+            size_t rest = GS_CCSDS_ASM_LEN - deframe->carry_len;
+            size_t have = len < rest ? len : rest;
+            if (memcmp(data, asm_bytes + deframe->carry_len, have) != 0)
+            {
+                deframe->stats.skipped += deframe->carry_len;
+                deframe->carry_len = 0;
+            }
+        }
+
+        if (deframe->carry_len > 0)
+        {
+            size_t need = cadu_len - deframe->carry_len;
+            size_t take = len < need ? len : need;
+            memcpy(deframe->carry + deframe->carry_len, data, take);
+            deframe->carry_len += take;
+            pos = take;
+            if (deframe->carry_len < cadu_len)
+            {
+                return 0;
+            }
+            out_len += deframe_emit(deframe, deframe->carry + GS_CCSDS_ASM_LEN, out);
+            deframe->carry_len = 0;
+        }
+    }
+
+    while (pos < len)
+    {
+        const uint8_t *found = gs_asm_find(data + pos, len - pos);
+        if (found == NULL)
+        {
+            size_t prefix = deframe_tail_prefix(data + pos, len - pos);
+            deframe->stats.skipped += len - pos - prefix;
+            memcpy(deframe->carry, data + len - prefix, prefix);
+            deframe->carry_len = prefix;
+            break;
+        }
+
+        size_t at = found - data;
+        deframe->stats.skipped += at - pos;
+        if (len - at < cadu_len)
+        {
+            memcpy(deframe->carry, found, len - at);
+            deframe->carry_len = len - at;
+            break;
+        }
+        out_len += deframe_emit(deframe, found + GS_CCSDS_ASM_LEN, out + out_len);
+        pos = at + cadu_len;
+    }
+    return out_len;
+}
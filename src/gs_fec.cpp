@@ -0,0 +1,297 @@
+/**
+ * @file gs_fec.cpp
+ * @brief Reed-Solomon decoding of CCSDS codeblocks on a per-chain worker pool.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Decoders take buffers in the order they were queued and number them as they
+ * do; each then waits for its turn (next_out) before queuing its frames for
+ * forwarding, so the server sees frames in receive order however long any one
+ * buffer took.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include <strings.h>
+#include "gs_fec.hpp"
+#include "gs_rs.hpp"
+#include "gs_crc.hpp"
+#include "gs_config.hpp"
+#include "gs_metrics.hpp"
+#include "gs_rt.hpp"
+#include "meb_debug.hpp"
+
+void gs_fec_config_load(gs_fec_config_t *config, int chain)
+{
+    const char *mode = gs_chain_env_str(chain, "FEC", "off");
+    config->enabled = strcasecmp(mode, "rs") == 0;
+    if (!config->enabled && strcasecmp(mode, "off") != 0)
+    {
+        dbprintlf(YELLOW_FG "Unknown HAYSTACK_FEC \"%s\", expected off or rs; not decoding.", mode);
+    }
+    config->interleave = gs_chain_env_int(chain, "FEC_INTERLEAVE", GS_FEC_DEFAULT_INTERLEAVE);
+    config->randomized = gs_chain_env_int(chain, "FEC_RANDOMIZED", 1) != 0;
+    config->dual_basis = gs_chain_env_int(chain, "FEC_DUAL_BASIS", 1) != 0;
+    config->threads = gs_chain_env_int(chain, "FEC_THREADS", GS_FEC_DEFAULT_THREADS);
+}
+
+size_t gs_fec_block_len(const gs_fec_config_t *config, size_t frame_len)
+{
+    size_t interleave = config->interleave;
+    if (interleave < 1 || interleave > GS_FEC_MAX_INTERLEAVE || frame_len % interleave != 0 || frame_len / interleave > GS_RS_K)
+    {
+        return 0;
+    }
+    return frame_len + GS_RS_PARITY * interleave;
+}
+
+void gs_fec_encode(const gs_fec_config_t *config, uint8_t *block, size_t frame_len)
+{
+    int interleave = config->interleave;
+    int pad = GS_RS_K - frame_len / interleave;
+    for (int k = 0; k < interleave; k++)
+    {
+        gs_rs_encode(block + k, interleave, pad, config->dual_basis);
+    }
+    if (config->randomized)
+    {
+        gs_ccsds_randomize(block, gs_fec_block_len(config, frame_len));
+    }
+}
+
+int gs_fec_decode(const gs_fec_config_t *config, uint8_t *block, size_t frame_len, gs_fec_stats_t *stats)
+{
+    int interleave = config->interleave;
+    int pad = GS_RS_K - frame_len / interleave;
+    if (config->randomized)
+    {
+        gs_ccsds_randomize(block, gs_fec_block_len(config, frame_len));
+    }
+
+    int corrected = 0;
+    bool failed = false;
+    for (int k = 0; k < interleave; k++)
+    {
+        int ret = gs_rs_decode(block + k, interleave, pad, config->dual_basis);
+        stats->codewords++;
+        if (ret < 0)
+        {
+            stats->uncorrectable++;
+            failed = true;
+        }
+        else
+        {
+            stats->corrected += ret;
+            corrected += ret;
+        }
+    }
+    return failed ? -1 : corrected;
+}
+
+/**
+ * @brief Decodes each codeblock in buf and packs the frames to keep at its start.
+ *
+ */
+static void fec_decode_buf(gs_fec_t *fec, gs_buf_t *buf)
+{
+    size_t frame_len = fec->frame.frame_len;
+    gs_fec_stats_t stats;
+    memset(&stats, 0x0, sizeof(stats));
+    uint64_t crc_errors = 0;
+
+    ssize_t out = 0;
+    for (ssize_t off = 0; off + (ssize_t)fec->block_len <= buf->len; off += fec->block_len)
+    {
+        uint8_t *block = buf->data + off;
+        bool bad = gs_fec_decode(&fec->config, block, frame_len, &stats) < 0;
+        if (fec->frame.crc && gs_crc16(GS_CRC16_INIT, block, frame_len) != 0)
+        {
+            crc_errors++;
+            bad = true;
+        }
+        if (bad && fec->frame.mode == GS_DEFRAME_DROP)
+        {
+            continue;
+        }
+        memmove(buf->data + out, block, frame_len);
+        out += frame_len;
+    }
+    buf->len = out;
+
+    fec->codewords += stats.codewords;
+    fec->corrected += stats.corrected;
+    fec->uncorrectable += stats.uncorrectable;
+    fec->crc_errors += crc_errors;
+    gs_metric_add(GS_CTR_FEC_CODEWORDS, stats.codewords);
+    gs_metric_add(GS_CTR_FEC_CORRECTED_SYMBOLS, stats.corrected);
+    gs_metric_add(GS_CTR_FEC_UNCORRECTABLE, stats.uncorrectable);
+    gs_metric_add(GS_CTR_DEFRAME_CRC_ERRORS, crc_errors);
+}
+
+static void *gs_fec_thread(void *args)
+{
+    gs_fec_t *fec = (gs_fec_t *)args;
+
+    while (true)
+    {
+        pthread_mutex_lock(&fec->lock);
+        while (fec->running && fec->len == 0)
+        {
+            pthread_cond_wait(&fec->cond, &fec->lock);
+        }
+        if (fec->len == 0)
+        {
+            pthread_mutex_unlock(&fec->lock);
+            break;
+        }
+        gs_buf_t *buf = fec->queue[fec->head];
+        fec->head = (fec->head + 1) % GS_FEC_QUEUE_DEPTH;
+        fec->len--;
+        uint64_t seq = fec->taken++;
+        pthread_mutex_unlock(&fec->lock);
+
+        uint64_t start = gs_metrics_now_ns();
+        fec_decode_buf(fec, buf);
+        gs_metric_time(GS_HIST_FEC_DECODE, gs_metrics_now_ns() - start);
+
+        pthread_mutex_lock(&fec->lock);
+        while (fec->next_out != seq)
+        {
+            pthread_cond_wait(&fec->turn, &fec->lock);
+        }
+        pthread_mutex_unlock(&fec->lock);
+
+        if (buf->len > 0)
+        {
+            gs_stage_push(fec->out, buf);
+        }
+        gs_buf_release(buf);
+
+        pthread_mutex_lock(&fec->lock);
+        fec->next_out++;
+        pthread_cond_broadcast(&fec->turn);
+        pthread_mutex_unlock(&fec->lock);
+    }
+    return NULL;
+}
+
+int gs_fec_init(gs_fec_t *fec, const gs_fec_config_t *config, const gs_deframe_config_t *frame, gs_stage_t *out, int chain)
+{
+    fec->config = *config;
+    fec->frame = *frame;
+    fec->out = out;
+    fec->num_threads = 0;
+    fec->head = 0;
+    fec->len = 0;
+    fec->taken = 0;
+    fec->next_out = 0;
+    fec->running = false;
+    fec->codewords = 0;
+    fec->corrected = 0;
+    fec->uncorrectable = 0;
+    fec->crc_errors = 0;
+    fec->dropped = 0;
+
+    if (!config->enabled)
+    {
+        return 0;
+    }
+    fec->block_len = gs_fec_block_len(config, frame->frame_len);
+    if (fec->block_len == 0 || fec->block_len > GS_DEFRAME_MAX_LEN)
+    {
+        dbprintlf(RED_FG "A %zu byte transfer frame does not fit RS(255,223) codewords interleaved %d deep.", frame->frame_len, config->interleave);
+        return -1;
+    }
+
+    int threads = config->threads;
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    if (threads > GS_FEC_MAX_THREADS)
+    {
+        threads = GS_FEC_MAX_THREADS;
+    }
+
+    pthread_mutex_init(&fec->lock, NULL);
+    pthread_cond_init(&fec->cond, NULL);
+    pthread_cond_init(&fec->turn, NULL);
+    fec->running = true;
+
+    for (int i = 0; i < threads; i++)
+    {
+        if (gs_rt_thread_create(&fec->tids[i], GS_RT_FEC, chain, gs_fec_thread, fec) != 0)
+        {
+            dbprintlf(RED_FG "Failed to start chain %d decoder thread %d.", chain, i);
+            break;
+        }
+        fec->num_threads++;
+    }
+
+    if (fec->num_threads == 0)
+    {
+        fec->running = false;
+        pthread_cond_destroy(&fec->turn);
+        pthread_cond_destroy(&fec->cond);
+        pthread_mutex_destroy(&fec->lock);
+        return -1;
+    }
+
+    dbprintlf(GREEN_FG "Chain %d decoding RS(255,223) codeblocks of %zu bytes (interleave %d, %s basis%s) on %d thread(s), syndromes with %s.",
+              chain, fec->block_len, config->interleave, config->dual_basis ? "dual" : "conventional",
+              config->randomized ? ", randomized" : "", fec->num_threads, gs_rs_syndromes_name());
+    return 1;
+}
+
+int gs_fec_submit(gs_fec_t *fec, gs_buf_t *buf)
+{
+    int ret = 1;
+    pthread_mutex_lock(&fec->lock);
+    if (fec->len == GS_FEC_QUEUE_DEPTH)
+    {
+        ret = -1;
+    }
+    else
+    {
+        gs_buf_ref(buf);
+        fec->queue[(fec->head + fec->len) % GS_FEC_QUEUE_DEPTH] = buf;
+        fec->len++;
+        pthread_cond_signal(&fec->cond);
+    }
+    pthread_mutex_unlock(&fec->lock);
+
+    if (ret < 0)
+    {
+        fec->dropped++;
+        gs_metric_add(GS_CTR_FEC_DROPPED, 1);
+    }
+    return ret;
+}
+
+void gs_fec_destroy(gs_fec_t *fec)
+{
+    if (!fec->running)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&fec->lock);
+    fec->running = false;
+    pthread_cond_broadcast(&fec->cond);
+    pthread_mutex_unlock(&fec->lock);
+
+    for (int i = 0; i < fec->num_threads; i++)
+    {
+        pthread_join(fec->tids[i], NULL);
+    }
+
+    dbprintlf(GREEN_FG "Decoders closed: %llu codewords, %llu symbols corrected, %llu uncorrectable, %llu frame CRC errors, %llu buffers dropped.",
+              (unsigned long long)fec->codewords, (unsigned long long)fec->corrected, (unsigned long long)fec->uncorrectable,
+              (unsigned long long)fec->crc_errors, (unsigned long long)fec->dropped);
+
+    pthread_cond_destroy(&fec->turn);
+    pthread_cond_destroy(&fec->cond);
+    pthread_mutex_destroy(&fec->lock);
+}
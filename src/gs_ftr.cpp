@@ -0,0 +1,249 @@
+/**
+ * @file gs_ftr.cpp
+ * @brief In-memory registry of AD9361 FIR filter (.ftr) files.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include "gs_ftr.hpp"
+#include "gs_haystack.hpp"
+#include "meb_debug.hpp"
+
+static int ftr_compare(const void *a, const void *b)
+{
+    return strncmp(((const gs_ftr_t *)a)->name, ((const gs_ftr_t *)b)->name, GS_FTR_NAME_LEN);
+}
+
+static bool ftr_coefficient_ok(const char *s, char **end)
+{
+    long val = strtol(s, end, 10);
+    return *end != s && val >= -32768 && val <= 32767;
+}
+
+/**
+ * @brief Checks the header lines and coefficient table of a .ftr file.
+ *
+ * Header lines are "TX <ch> GAIN <dB> INT <n>", "RX <ch> GAIN <dB> DEC <n>",
+ * and the optional RTX/RRX/BWTX/BWRX lines; each remaining line holds one
+ * coefficient (shared by TX and RX) or a "tx,rx" pair.
+ *
+ * @return int 1 if valid, negative otherwise.
+ */
+static int ftr_parse(gs_ftr_t *ftr, const char *path)
+{
+    int taps = 0;
+    const char *line = ftr->text;
+    const char *end = ftr->text + ftr->len;
+
+    while (line < end)
+    {
+        const char *cur = line;
+        const char *next = (const char *)memchr(line, '\n', end - line);
+        line = next != NULL ? next + 1 : end;
+
+        while (cur < line && isspace((unsigned char)*cur))
+        {
+            cur++;
+        }
+        if (cur == line || *cur == '#' || strncmp(cur, "RTX", 3) == 0 || strncmp(cur, "RRX", 3) == 0 ||
+            strncmp(cur, "BWTX", 4) == 0 || strncmp(cur, "BWRX", 4) == 0)
+        {
+            // Blank, comment, or rate/bandwidth hints the driver does not need.
+            continue;
+        }
+
+        int ch, gain, factor;
+        char *after;
+        if (sscanf(cur, "RX %d GAIN %d DEC %d", &ch, &gain, &factor) == 3)
+        {
+            ftr->rx_dec = factor;
+        }
+        else if (sscanf(cur, "TX %d GAIN %d INT %d", &ch, &gain, &factor) == 3)
+        {
+            ftr->tx_int = factor;
+        }
+        else if (ftr_coefficient_ok(cur, &after))
+        {
+            if (*after == ',' && !ftr_coefficient_ok(after + 1, &after))
+            {
+                dbprintlf(YELLOW_FG "%s: bad coefficient pair on tap %d.", path, taps);
+                return -1;
+            }
+            taps++;
+        }
+        else
+        {
+            dbprintlf(YELLOW_FG "%s: unrecognized line \"%.*s\".", path, (int)(line - cur > 32 ? 32 : line - cur), cur);
+            return -1;
+        }
+    }
+
+    if (taps < 16 || taps > GS_FTR_MAX_TAPS || taps % 16 != 0)
+    {
+        dbprintlf(YELLOW_FG "%s: %d taps, expected a multiple of 16 up to %d.", path, taps, GS_FTR_MAX_TAPS);
+        return -1;
+    }
+    if ((ftr->rx_dec != 0 && ftr->rx_dec != 1 && ftr->rx_dec != 2 && ftr->rx_dec != 4) ||
+        (ftr->tx_int != 0 && ftr->tx_int != 1 && ftr->tx_int != 2 && ftr->tx_int != 4))
+    {
+        dbprintlf(YELLOW_FG "%s: decimation/interpolation must be 1, 2 or 4.", path);
+        return -1;
+    }
+
+    ftr->taps = taps;
+    return 1;
+}
+
+static int ftr_read(gs_ftr_t *ftr, const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        return -1;
+    }
+
+    ftr->text = (char *)malloc(GS_FTR_MAX_SIZE + 1);
+    ftr->len = ftr->text != NULL ? fread(ftr->text, 1, GS_FTR_MAX_SIZE + 1, fp) : 0;
+    fclose(fp);
+
+    if (ftr->len == 0 || ftr->len > GS_FTR_MAX_SIZE)
+    {
+        dbprintlf(YELLOW_FG "%s: empty or larger than %d bytes.", path, GS_FTR_MAX_SIZE);
+        return -1;
+    }
+    ftr->text[ftr->len] = '\0';
+    char *shrunk = (char *)realloc(ftr->text, ftr->len + 1);
+    if (shrunk != NULL)
+    {
+        ftr->text = shrunk;
+    }
+    return ftr_parse(ftr, path);
+}
+
+int gs_ftr_registry_load(gs_ftr_registry_t *reg, const char *dir)
+{
+    reg->filters = NULL;
+    reg->count = 0;
+    memset(reg->active, 0x0, sizeof(reg->active));
+    pthread_mutex_init(&reg->lock, NULL);
+
+    DIR *dp = opendir(dir);
+    if (dp == NULL)
+    {
+        dbprintlf(YELLOW_FG "Cannot open filter directory %s, no filters available.", dir);
+        return -1;
+    }
+
+    int capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dp)) != NULL)
+    {
+        size_t len = strlen(entry->d_name);
+        if (len <= 4 || strcmp(entry->d_name + len - 4, ".ftr") != 0 || len - 4 >= GS_FTR_NAME_LEN)
+        {
+            continue;
+        }
+
+        if (reg->count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 16;
+            gs_ftr_t *filters = (gs_ftr_t *)realloc(reg->filters, capacity * sizeof(gs_ftr_t));
+            if (filters == NULL)
+            {
+                break;
+            }
+            reg->filters = filters;
+        }
+
+        gs_ftr_t *ftr = &reg->filters[reg->count];
+        memset(ftr, 0x0, sizeof(gs_ftr_t));
+        memcpy(ftr->name, entry->d_name, len - 4);
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (ftr_read(ftr, path) < 0)
+        {
+            free(ftr->text);
+            continue;
+        }
+        reg->count++;
+    }
+    closedir(dp);
+
+    qsort(reg->filters, reg->count, sizeof(gs_ftr_t), ftr_compare);
+    dbprintlf(GREEN_FG "Loaded %d FIR filters from %s.", reg->count, dir);
+    return reg->count;
+}
+
+const gs_ftr_t *gs_ftr_find(const gs_ftr_registry_t *reg, const char *name)
+{
+    gs_ftr_t key;
+    memset(key.name, 0x0, sizeof(key.name));
+    memcpy(key.name, name, strnlen(name, GS_FTR_NAME_LEN));
+    if (reg->count == 0)
+    {
+        return NULL;
+    }
+    return (const gs_ftr_t *)bsearch(&key, reg->filters, reg->count, sizeof(gs_ftr_t), ftr_compare);
+}
+
+int gs_ftr_apply(gs_ftr_registry_t *reg, gs_chain_t *chain, const char *name)
+{
+    char *active_name = reg->active[chain->index];
+    pthread_mutex_lock(&reg->lock);
+    bool active = strncmp(active_name, name, GS_FTR_NAME_LEN) == 0;
+    pthread_mutex_unlock(&reg->lock);
+    if (active)
+    {
+        return 0;
+    }
+
+    const gs_ftr_t *ftr = gs_ftr_find(reg, name);
+    if (ftr == NULL)
+    {
+        dbprintlf(RED_FG "Filter \"%.*s\" is not registered.", GS_FTR_NAME_LEN, name);
+        return -1;
+    }
+
+    // The radio's filter is unknown until the load below succeeds.
+    pthread_mutex_lock(&reg->lock);
+    memset(active_name, 0x0, GS_FTR_NAME_LEN);
+    pthread_mutex_unlock(&reg->lock);
+
+    if (chain->backend->radio_load_filter(chain, ftr->text, ftr->len) < 0)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&reg->lock);
+    memcpy(active_name, ftr->name, GS_FTR_NAME_LEN);
+    pthread_mutex_unlock(&reg->lock);
+    return 1;
+}
+
+void gs_ftr_active(gs_ftr_registry_t *reg, int chain, char *buf, size_t len)
+{
+    pthread_mutex_lock(&reg->lock);
+    snprintf(buf, len, "%s", reg->active[chain]);
+    pthread_mutex_unlock(&reg->lock);
+}
+
+void gs_ftr_registry_destroy(gs_ftr_registry_t *reg)
+{
+    for (int i = 0; i < reg->count; i++)
+    {
+        free(reg->filters[i].text);
+    }
+    free(reg->filters);
+    reg->filters = NULL;
+    reg->count = 0;
+    pthread_mutex_destroy(&reg->lock);
+}
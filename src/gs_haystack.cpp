@@ -15,113 +15,468 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
 #include "gs_haystack.hpp"
+#include "gs_config.hpp"
 #include "meb_debug.hpp"
 #include "phy.hpp"
+#include "gs_netframe.hpp"
+#include "gs_metrics.hpp"
+#include "gs_rt.hpp"
 
-int gs_xband_init(global_data_t *global_data)
+/**
+ * @brief Sends one DATA payload to the server, or spools it if the server cannot take it.
+ *
+ * @param send False to spool it without trying, as at shutdown.
+ */
+static void forward_send(gs_chain_t *chain, const struct iovec *iov, int iovcnt, bool send)
 {
-    if (global_data->rx_modem_ready && global_data->radio_ready)
+    NetData *network_data = chain->global->network_data;
+    if (!send || !network_data->connection_ready)
     {
-        dbprintlf(YELLOW_FG "RX modem and radio marked as ready, but gs_xband_init(...) was called anyway. Canceling redundant initialization.");
-        return -1;
+        gs_spool_append(chain->spool, iov, iovcnt);
+    }
+    else if (gs_netframe_sendv(network_data, NetType::DATA, NetVertex::CLIENT, iov, iovcnt) < 0)
+    {
+        chain->forward_send_errors++;
+        gs_spool_append(chain->spool, iov, iovcnt);
     }
+}
 
-    if (!global_data->rx_modem_ready)
+/**
+ * @brief Sends the chain's batch as one DATA frame, if it holds anything, and empties it.
+ *
+ */
+static void forward_batch_send(gs_chain_t *chain, bool send)
+{
+    gs_batch_t *batch = chain->batch;
+    if (batch->packets == 0)
     {
-        // Initialize.
-        if (rxmodem_init(global_data->rx_modem, uio_get_id("rx_ipcore"), uio_get_id("rx_dma")) < 0)
-        {
-            dbprintlf(RED_FG "RX modem initialization failure.");
-            return -1;
-        }
-        dbprintlf(GREEN_FG "RX modem initialized.");
-        global_data->rx_modem_ready = true;
+        return;
     }
+    uint8_t chain_byte = chain->index;
+    struct iovec iov[2] = {{batch->data, batch->len}, {&chain_byte, sizeof(chain_byte)}};
+    forward_send(chain, iov, chain->global->num_chains > 1 ? 2 : 1, send);
+    gs_batch_reset(batch);
+}
 
-    if (!global_data->radio_ready)
+/**
+ * @brief Sends one received packet in a DATA frame of its own, or adds it to the batch.
+ *
+ */
+static void forward_packet(gs_chain_t *chain, gs_buf_t *buf, bool send)
+{
+    uint8_t chain_byte = chain->index;
+    int chain_iov = chain->global->num_chains > 1 ? 1 : 0;
+    gs_batch_t *batch = chain->batch;
+    if (!gs_batch_enabled(batch))
+    {
+        struct iovec iov[2] = {{buf->data, (size_t)buf->len}, {&chain_byte, sizeof(chain_byte)}};
+        forward_send(chain, iov, 1 + chain_iov, send);
+        return;
+    }
+
+    if (!gs_batch_fits(batch, buf->len))
+    {
+        forward_batch_send(chain, send);
+    }
+    if (gs_batch_fits(batch, buf->len))
     {
-        if (adradio_init(global_data->radio) < 0)
+        uint64_t now = gs_metrics_now_ns();
+        gs_batch_add(batch, buf->data, buf->len, now);
+        // Also checks the deadline, which a steady trickle of packets would otherwise hold off.
+        if (gs_batch_due(batch, now))
         {
-            dbprintlf(RED_FG "Radio initialization failure.");
-            return -3;
+            forward_batch_send(chain, send);
         }
-        dbprintlf(GREEN_FG "Radio initialized.");
-        global_data->radio_ready = true;
+        return;
+    }
+
+    // Too large for any batch: a batch of one, sent without copying.
+    uint8_t prefix[GS_BATCH_PREFIX_LEN];
+    gs_batch_prefix(prefix, buf->len);
+    struct iovec iov[3] = {{prefix, sizeof(prefix)}, {buf->data, (size_t)buf->len}, {&chain_byte, sizeof(chain_byte)}};
+    forward_send(chain, iov, 2 + chain_iov, send);
+}
+
+int gs_chain_init(gs_chain_t *chain, global_data_t *global, int index, const gs_backend_t *backend)
+{
+    chain->index = index;
+    chain->global = global;
+    chain->backend = backend;
+    chain->rx_efd = -1;
+    chain->spool->fd = -1;
+
+    // Each chain writes its own capture stream; with several, their files are told apart by prefix.
+    gs_capture_config_t capture_config[1];
+    gs_capture_config_load(capture_config);
+    capture_config->chain = index;
+    snprintf(capture_config->dir, sizeof(capture_config->dir), "%s", gs_chain_env_str(index, "CAPTURE_DIR", capture_config->dir));
+    if (global->num_chains > 1)
+    {
+        char prefix[sizeof(capture_config->prefix)];
+        snprintf(prefix, sizeof(prefix), "%s", capture_config->prefix);
+        snprintf(capture_config->prefix, sizeof(capture_config->prefix), "%.56s_ch%d", prefix, index);
+    }
+    if (gs_capture_init(chain->capture, capture_config) < 0)
+    {
+        dbprintlf(RED_FG "Could not start the chain %d capture writer, received data will not be saved.", index);
+    }
+
+    if (gs_status_init(chain->status) < 0 || gs_radio_config_init(chain->radio_config) < 0)
+    {
+        dbprintlf(RED_FG "Could not set up the chain %d status cache.", index);
+        return -1;
+    }
+
+    if (gs_stage_init(chain->forward, "Forward", gs_chain_env_int(index, "FORWARD_QUEUE", GS_STAGE_DEFAULT_DEPTH),
+                      gs_stage_policy_env("HAYSTACK_FORWARD_POLICY", GS_STAGE_DROP), gs_env_int("HAYSTACK_FORWARD_BLOCK_MS", GS_STAGE_DEFAULT_BLOCK_MS)) < 0)
+    {
+        dbprintlf(RED_FG "Could not set up the chain %d network forward stage.", index);
+        return -1;
+    }
+
+    gs_spool_config_t spool_config[1];
+    gs_spool_config_load(spool_config, index, global->num_chains);
+    if (gs_spool_init(chain->spool, spool_config) < 0)
+    {
+        dbprintlf(RED_FG "Chain %d will drop received data while the server is unreachable.", index);
+    }
+
+    gs_batch_config_t batch_config[1];
+    gs_batch_config_load(batch_config, index);
+    if (gs_batch_init(chain->batch, batch_config) < 0)
+    {
+        dbprintlf(RED_FG "Chain %d will send each received packet in its own frame.", index);
+    }
+    else if (gs_batch_enabled(chain->batch))
+    {
+        dbprintlf(GREEN_FG "Chain %d batching received packets into %zu byte frames, sent within %d ms.", index, batch_config->bytes, batch_config->max_delay_ms);
+    }
+
+    gs_deframe_config_t deframe_config[1];
+    gs_deframe_config_load(deframe_config, index);
+    gs_fec_config_t fec_config[1];
+    gs_fec_config_load(fec_config, index);
+    if (fec_config->enabled && deframe_config->mode == GS_DEFRAME_OFF)
+    {
+        dbprintlf(YELLOW_FG "Chain %d has HAYSTACK_FEC set but not HAYSTACK_DEFRAME; not decoding.", index);
+        fec_config->enabled = false;
+    }
+    if (gs_fec_init(chain->fec, fec_config, deframe_config, chain->forward, index) < 0)
+    {
+        dbprintlf(RED_FG "Chain %d will forward received data without decoding or deframing.", index);
+        deframe_config->mode = GS_DEFRAME_OFF;
+    }
+    else if (chain->fec->running)
+    {
+        // The receive worker only finds the codeblocks; the decoders check and keep or drop the frames.
+        deframe_config->frame_len = chain->fec->block_len;
+        deframe_config->crc = false;
+        deframe_config->derandomize = false;
+        deframe_config->mode = GS_DEFRAME_KEEP;
+    }
+    if (deframe_config->mode != GS_DEFRAME_OFF && gs_deframe_init(chain->deframe, deframe_config) < 0)
+    {
+        dbprintlf(RED_FG "Chain %d will forward received data without deframing.", index);
+        gs_fec_destroy(chain->fec);
+        deframe_config->mode = GS_DEFRAME_OFF;
+    }
+    chain->deframe->config.mode = deframe_config->mode;
+
+    // Deframed output is up to a frame longer than the read it came from; leave room so it stays in the pool.
+    ssize_t buf_size = gs_chain_env_int(index, "POOL_BUF_SIZE", GS_BUFPOOL_DEFAULT_BUF_SIZE);
+    if (deframe_config->mode != GS_DEFRAME_OFF)
+    {
+        buf_size += deframe_config->frame_len;
+    }
+    if (gs_bufpool_init(chain->rx_pool, gs_chain_env_int(index, "POOL_BUFFERS", GS_BUFPOOL_DEFAULT_COUNT), buf_size) < 0)
+    {
+        dbprintlf(RED_FG "Could not allocate the chain %d receive buffer pool.", index);
+        return -1;
+    }
+    chain->rx_discard = (uint8_t *)malloc(chain->rx_pool->buf_size);
+    if (chain->rx_discard == NULL)
+    {
+        dbprintlf(RED_FG "Could not allocate the chain %d receive buffer pool.", index);
+        return -1;
     }
 
-    dbprintlf(GREEN_FG "Automatic initialization complete.");
+    // Started now so arming does not wait on thread creation or stack faults.
+    chain->rx_state = GS_RX_DISARMED;
+    chain->rx_efd = eventfd(0, EFD_CLOEXEC);
+    if (chain->rx_efd < 0)
+    {
+        erprintlf(errno);
+        return -1;
+    }
+    int err = gs_rt_thread_create(&chain->rx_tid, GS_RT_RX, index, gs_xband_rx_thread, chain);
+    if (err != 0)
+    {
+        dbprintlf(RED_FG "Could not start the chain %d receive worker.", index);
+        erprintlf(err);
+        close(chain->rx_efd);
+        chain->rx_efd = -1;
+        return -1;
+    }
     return 1;
 }
 
-void *gs_xband_rx_thread(void *args)
+void gs_chain_destroy(gs_chain_t *chain)
 {
-    global_data_t *global = (global_data_t *)args;
+    if (gs_xband_rx_exit(chain) < 0)
+    {
+        // The worker may still be pushing into the decoders, forward stage, capture and pool; only the forward thread's own state goes.
+        forward_batch_send(chain, false);
+        gs_batch_destroy(chain->batch);
+        gs_spool_destroy(chain->spool);
+        return;
+    }
+    gs_fec_destroy(chain->fec);
 
-    while ((!global->rx_modem_ready || !global->radio_ready) && global->network_data->thread_status > 0)
+    // Whatever the forward thread did not get to is sent on the next run rather than lost.
+    gs_buf_t *buf;
+    while ((buf = gs_stage_try_pop(chain->forward)) != NULL)
     {
-        // if (gs_xband_init(global) < 0)
+        forward_packet(chain, buf, false);
+        gs_buf_release(buf);
+    }
+    forward_batch_send(chain, false);
+    gs_batch_destroy(chain->batch);
+    gs_spool_destroy(chain->spool);
+    gs_stage_destroy(chain->forward);
+    gs_status_destroy(chain->status);
+    gs_radio_config_destroy(chain->radio_config);
+    gs_capture_destroy(chain->capture);
+    gs_bufpool_destroy(chain->rx_pool);
+    free(chain->rx_discard);
+    chain->rx_discard = NULL;
+}
+
+/**
+ * @brief Parks the receive worker until rx_efd is written or timeout_ms passes (-1 for no timeout).
+ *
+ */
+static void rx_park(gs_chain_t *chain, int timeout_ms)
+{
+    struct pollfd pfd = {chain->rx_efd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) > 0)
+    {
+        uint64_t count;
+        if (read(chain->rx_efd, &count, sizeof(count)) < 0 && errno != EAGAIN)
         {
-            dbprintlf(RED_FG "Receive thread aborting, radio cannot initialize.");
-            usleep(5 SEC);
-            continue;
+            erprintlf(errno);
         }
     }
+}
 
-    while (global->network_data->thread_status > 0 && global->rx_modem_ready && global->radio_ready)
+/**
+ * @brief Queues the CCSDS frames in a received buffer for forwarding, in place of the buffer itself.
+ *
+ */
+static void rx_deframe(gs_chain_t *chain, gs_buf_t *rx_buf)
+{
+    gs_deframe_t *deframe = chain->deframe;
+    gs_buf_t *frames = gs_bufpool_acquire(chain->rx_pool, rx_buf->len + deframe->config.frame_len);
+    if (frames == NULL)
     {
-        static bool last_receive_successful = false;
+        // Counted as pool_exhausted; the frames will be missing from the pass.
+        return;
+    }
+
+    gs_deframe_stats_t before = deframe->stats;
+    frames->len = gs_deframe(deframe, rx_buf->data, rx_buf->len, frames->data);
+    frames->meta = rx_buf->meta;
+    gs_metric_add(GS_CTR_DEFRAME_FRAMES, deframe->stats.frames - before.frames);
+    gs_metric_add(GS_CTR_DEFRAME_CRC_ERRORS, deframe->stats.crc_errors - before.crc_errors);
+    gs_metric_add(GS_CTR_DEFRAME_SKIPPED_BYTES, deframe->stats.skipped - before.skipped);
 
-        if (!global->PLL_ready)
+    if (frames->len > 0)
+    {
+        if (chain->fec->running)
         {
-            dbprintlf(YELLOW_FG "PLL not initialized.");
+            gs_fec_submit(chain->fec, frames);
+        }
+        else
+        {
+            gs_stage_push(chain->forward, frames);
+        }
+    }
+    gs_buf_release(frames);
+}
+
+void *gs_xband_rx_thread(void *args)
+{
+    gs_chain_t *chain = (gs_chain_t *)args;
+
+    bool last_receive_successful = false;
+    // Whether this pass has started, and whether its first packet has arrived; for the arm and disarm latencies.
+    bool active = false;
+    bool first_packet = false;
+    // Armed before the modem was ready, so gs_xband_rx_arm(...) could not start it.
+    bool needs_start = false;
+    // Decoder counts when this pass started.
+    gs_fec_stats_t fec_start;
+    memset(&fec_start, 0x0, sizeof(fec_start));
+    uint64_t fec_crc_start = 0;
+
+    while (chain->rx_state != GS_RX_EXIT)
+    {
+        if (chain->rx_state != GS_RX_ARMED)
+        {
+            needs_start = false;
+            if (active)
+            {
+                active = false;
+                uint64_t ns = gs_metrics_now_ns() - chain->rx_cmd_ns;
+                gs_metric_time(GS_HIST_RX_DISARM, ns);
+                dbprintlf(GREEN_FG "Chain %d receive worker parked %.1f us after disarm.", chain->index, ns / 1e3);
+                const gs_deframe_stats_t *stats = &chain->deframe->stats;
+                if (chain->fec->running)
+                {
+                    // Frame CRCs are checked by the decoders; buffers they still hold are not counted yet.
+                    dbprintlf(GREEN_FG "Chain %d pass: %llu codeblocks, %llu bytes out of sync; so far %llu codewords decoded, %llu symbols corrected, %llu uncorrectable, %llu frame CRC errors.",
+                              chain->index, (unsigned long long)stats->frames, (unsigned long long)stats->skipped,
+                              (unsigned long long)(chain->fec->codewords - fec_start.codewords), (unsigned long long)(chain->fec->corrected - fec_start.corrected),
+                              (unsigned long long)(chain->fec->uncorrectable - fec_start.uncorrectable), (unsigned long long)(chain->fec->crc_errors - fec_crc_start));
+                }
+                else if (chain->deframe->config.mode != GS_DEFRAME_OFF)
+                {
+                    dbprintlf(GREEN_FG "Chain %d pass: %llu frames, %llu CRC errors, %llu bytes out of sync.", chain->index,
+                              (unsigned long long)stats->frames, (unsigned long long)stats->crc_errors, (unsigned long long)stats->skipped);
+                    if (stats->frames > 0 && stats->crc_errors == stats->frames && !chain->deframe->config.derandomize)
+                    {
+                        dbprintlf(YELLOW_FG "Chain %d: every frame failed its CRC; if the link is randomized, set HAYSTACK_DEFRAME_DERANDOMIZE=1.", chain->index);
+                    }
+                }
+            }
+            rx_park(chain, -1);
+            continue;
         }
 
-        if (!global->rx_armed)
+        if (!chain->rx_modem_ready || !chain->radio_ready)
         {
-            dbprintlf(YELLOW_FG "RX IS NOT ARMED: CANNOT RECEIVE OR READ UNTIL ARMED!");
-            usleep(5 SEC);
+            dbprintlf(RED_FG "Chain %d armed, but the radio is not initialized; waiting.", chain->index);
+            needs_start = needs_start || !chain->rx_modem_ready;
+            rx_park(chain, GS_RX_NOT_READY_MS);
             continue;
         }
 
+        if (needs_start && chain->backend->rx_start(chain) < 0)
+        {
+            dbprintlf(RED_FG "Chain %d RX modem failed to start; retrying.", chain->index);
+            rx_park(chain, GS_RX_NOT_READY_MS);
+            continue;
+        }
+        needs_start = false;
+
+        if (!active)
+        {
+            active = true;
+            first_packet = false;
+            gs_deframe_reset(chain->deframe);
+            fec_start.codewords = chain->fec->codewords;
+            fec_start.corrected = chain->fec->corrected;
+            fec_start.uncorrectable = chain->fec->uncorrectable;
+            fec_crc_start = chain->fec->crc_errors;
+            uint64_t ns = gs_metrics_now_ns() - chain->rx_cmd_ns;
+            gs_metric_time(GS_HIST_RX_ARM, ns);
+            dbprintlf(GREEN_FG "Chain %d receiving %.1f us after arm.", chain->index, ns / 1e3);
+        }
+
+        if (!chain->PLL_ready)
+        {
+            dbprintlf(YELLOW_FG "PLL not initialized.");
+        }
+
         dbprintlf(GREEN_FG "W A I T I N G   T O   R E C E I V E . . .");
-        ssize_t buffer_size = rxmodem_receive(global->rx_modem);
+        uint64_t start = gs_metrics_now_ns();
+        ssize_t buffer_size = chain->backend->rx_receive(chain);
+        gs_metric_time(GS_HIST_RX_RECEIVE, gs_metrics_now_ns() - start);
+        struct timespec rx_time;
+        clock_gettime(CLOCK_REALTIME, &rx_time);
         dbprintlf("Done receive.");
 
+        // Disarmed while waiting: rx_stop(...) cut the receive short, or this packet is not wanted.
+        if (chain->rx_state != GS_RX_ARMED)
+        {
+            continue;
+        }
+
         // Store the rxmodem_receive return for our next status send.
         if (!last_receive_successful)
         {
-            global->last_rx_status = buffer_size;
+            chain->last_rx_status = buffer_size;
         }
 
         last_receive_successful = false;
         
         if (buffer_size > 0)
         {
-            global->last_rx_status = buffer_size;
+            chain->last_rx_status = buffer_size;
             last_receive_successful = true;
         }
 
         if (buffer_size <= 0)
         {
-            dbprintlf(YELLOW_FG "Bad receive, receive returned %d, ignoring (could be WiFi).", buffer_size);
+            gs_metric_add(GS_CTR_RX_ERRORS, 1);
+            dbprintlf(YELLOW_FG "Bad receive, receive returned %zd, ignoring (could be WiFi).", buffer_size);
             continue;
         }
 
-        uint8_t *buffer = (uint8_t *)malloc(buffer_size * sizeof(char));
-        memset(buffer, 0x0, buffer_size);
+        gs_buf_t *rx_buf = gs_bufpool_acquire(chain->rx_pool, buffer_size);
+        if (rx_buf == NULL)
+        {
+            if (buffer_size <= chain->rx_pool->buf_size)
+            {
+                // Every buffer is queued downstream; the packet still has to come out of the modem. Counted as pool_exhausted.
+                chain->last_read_status = chain->backend->rx_read(chain, chain->rx_discard, buffer_size);
+            }
+            else
+            {
+                dbprintlf(RED_FG "Out of memory for a %zd byte receive buffer.", buffer_size);
+            }
+            continue;
+        }
+        uint8_t *buffer = rx_buf->data;
 
         ssize_t read_size = 0;
-        read_size = rxmodem_read(global->rx_modem, buffer, buffer_size);
+        start = gs_metrics_now_ns();
+        read_size = chain->backend->rx_read(chain, buffer, buffer_size);
+        gs_metric_time(GS_HIST_RX_READ, gs_metrics_now_ns() - start);
 
         // Store the rx_modem_read return for our next status send.
-        global->last_read_status = read_size;
+        chain->last_read_status = read_size;
 
         if (read_size != buffer_size)
         {
-            dbprintlf(RED_FG "Read %d of %d bytes.", read_size, buffer_size);
+            gs_metric_add(GS_CTR_RX_ERRORS, 1);
+            dbprintlf(RED_FG "Read %zd of %zd bytes.", read_size, buffer_size);
+            gs_buf_release(rx_buf);
             continue;
         }
+        if (chain->rx_state != GS_RX_ARMED)
+        {
+            gs_buf_release(rx_buf);
+            continue;
+        }
+        if (!first_packet)
+        {
+            first_packet = true;
+            dbprintlf(GREEN_FG "Chain %d first packet %.3f ms after arm.", chain->index, (gs_metrics_now_ns() - chain->rx_cmd_ns) / 1e6);
+        }
+        rx_buf->len = read_size;
+        gs_metric_add(GS_CTR_RX_PACKETS, 1);
+        gs_metric_add(GS_CTR_RX_BYTES, read_size);
+        rx_buf->meta.timestamp_ns = rx_time.tv_sec * 1000000000ULL + rx_time.tv_nsec;
+        rx_buf->meta.seq = chain->rx_seq++;
+        rx_buf->meta.rx_status = chain->last_rx_status;
+        rx_buf->meta.LO = chain->rx_LO;
+        rx_buf->meta.samp = chain->rx_samp;
+        rx_buf->meta.bw = chain->rx_bw;
 
         // dbprintlf(GREEN_FG "Read in the following buffer and will send it to the Network's GUI Client.");
         // for (int i = 0; i < buffer_size; i++)
@@ -131,389 +486,384 @@ void *gs_xband_rx_thread(void *args)
         // printf("(END)\n");
 
         dbprintlf(GREEN_FG "Read in the following buffer and will send it to the Network's GUI Client.");
-        for (int i = 0; i < buffer_size; i++)
-        {
-            printf("%c", buffer[i]);
-        }
-        printf("(END)\n");
+        dbhexdump(buffer, buffer_size);
 
-        static int receive_fp_index = 0;
-        static char filename[256] = {0};
-        snprintf(filename, sizeof(filename), "rxdata%d.bin", receive_fp_index++);
-        FILE *fp = fopen(filename, "wb");
-        if (fp != NULL)
+        // Hand off to the persist and forward stages; drops are counted there and reported in the status frame.
+        gs_capture_submit(chain->capture, rx_buf);
+        if (chain->deframe->config.mode == GS_DEFRAME_OFF)
         {
-            fwrite(buffer, 1, buffer_size, fp);
-            fclose(fp);
+            gs_stage_push(chain->forward, rx_buf);
         }
         else
         {
-            dbprintlf(RED_FG "Failed to open file to log buffer.");
+            rx_deframe(chain, rx_buf);
         }
 
-        NetFrame *network_frame = new NetFrame((unsigned char *)buffer, buffer_size * sizeof(char), NetType::DATA, NetVertex::CLIENT);
-        network_frame->sendFrame(global->network_data);
-        delete network_frame;
-
-        free(buffer);
+        gs_buf_release(rx_buf);
     }
+    return NULL;
+}
 
-    if (global->network_data->thread_status > 0)
+static void rx_wake(gs_chain_t *chain)
+{
+    uint64_t one = 1;
+    if (write(chain->rx_efd, &one, sizeof(one)) < 0)
     {
-        global->network_data->thread_status = 0;
+        erprintlf(errno);
     }
-    return NULL;
 }
 
-void *gs_network_rx_thread(void *args)
+int gs_xband_rx_arm(gs_chain_t *chain)
 {
-    global_data_t *global = (global_data_t *)args;
-    NetDataClient *network_data = global->network_data;
-
-    // PLL initialization data.
-    global->PLL->spi_bus = 0;
-    global->PLL->spi_cs = 1;
-    global->PLL->spi_cs_internal = 1;
-    global->PLL->cs_gpio = -1;
-    global->PLL->single = 1;
-    global->PLL->muxval = 6;
+    chain->rx_cmd_ns = gs_metrics_now_ns();
+    if (chain->rx_modem_ready && chain->backend->rx_start(chain) < 0)
+    {
+        return -1;
+    }
+    chain->rx_state = GS_RX_ARMED;
+    rx_wake(chain);
+    return 1;
+}
 
-    // Haystack is a network client to the GS Server, and so should be very similar in socketry to ground_station.
+int gs_xband_rx_disarm(gs_chain_t *chain)
+{
+    chain->rx_cmd_ns = gs_metrics_now_ns();
+    chain->rx_state = GS_RX_DISARMED;
+    return chain->rx_modem_ready ? chain->backend->rx_stop(chain) : 1;
+}
 
-    while (network_data->recv_active && network_data->thread_status > 0)
+int gs_xband_rx_exit(gs_chain_t *chain)
+{
+    if (chain->rx_stuck)
     {
-        if (!network_data->connection_ready)
-        {
-            usleep(5 SEC);
-            continue;
-        }
+        return -1;
+    }
+    if (chain->rx_efd < 0)
+    {
+        return 1;
+    }
+    chain->rx_state = GS_RX_EXIT;
+    rx_wake(chain);
+    if (chain->rx_modem_ready)
+    {
+        chain->backend->rx_stop(chain);
+    }
+    // A modem library that never returns from a receive must not hang shutdown.
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += GS_RX_EXIT_SEC;
+    if (pthread_timedjoin_np(chain->rx_tid, NULL, &deadline) != 0)
+    {
+        dbprintlf(RED_FG "Chain %d receive worker did not exit; leaving it and everything it uses.", chain->index);
+        chain->rx_stuck = true;
+        return -1;
+    }
+    close(chain->rx_efd);
+    chain->rx_efd = -1;
+    return 1;
+}
 
-        int read_size = 0;
+void *gs_xband_forward_thread(void *args)
+{
+    gs_chain_t *chain = (gs_chain_t *)args;
+    global_data_t *global = chain->global;
+    // After a failed drain, so a connection that is going down is not hammered.
+    uint64_t drain_after_ns = 0;
 
-        while (read_size >= 0 && network_data->recv_active && network_data->thread_status > 0)
+    while (chain->forward_running)
+    {
+        // Live frames first; the backlog only goes out while none are waiting.
+        uint64_t now = gs_metrics_now_ns();
+        bool drain = gs_spool_pending(chain->spool) && global->network_data->connection_ready && now >= drain_after_ns;
+        gs_buf_t *buf = drain ? gs_stage_try_pop(chain->forward) : gs_stage_pop(chain->forward, gs_batch_timeout_ms(chain->batch, now, 100));
+        if (buf == NULL)
         {
-            dbprintlf(BLUE_BG "Waiting to receive...");
-
-            NetFrame *netframe = new NetFrame();
-            read_size = netframe->recvFrame(network_data);
-
-            dbprintlf("Read %d bytes.", read_size);
-
-            if (read_size >= 0)
+            if (chain->batch->packets > 0)
             {
-                dbprintlf("Received the following NetFrame:");
-                netframe->print();
-                netframe->printNetstat();
-
-                // Extract the payload into a buffer.
-                int payload_size = netframe->getPayloadSize();
-                unsigned char *payload = (unsigned char *)malloc(payload_size);
-                if (netframe->retrievePayload(payload, payload_size) < 0)
+                // Nothing more came in time, or the backlog is waiting behind it.
+                if (drain || gs_batch_due(chain->batch, gs_metrics_now_ns()))
                 {
-                    dbprintlf(RED_FG "Error retrieving data.");
-                    continue;
+                    forward_batch_send(chain, true);
                 }
-
-                switch (netframe->getType())
-                {
-                case NetType::XBAND_CONFIG:
-                {
-                    dbprintlf(BLUE_FG "Received an X-Band CONFIG frame!");
-                    if (!global->radio_ready)
-                    {
-                        // TODO: Send a packet indicating this.
-                        dbprintlf(RED_FG "Cannot configure radio: radio not ready, does not exist, or failed to initialize.");
-                        break;
-                    }
-
-                    if (netframe->getDestination() == NetVertex::HAYSTACK)
-                    {
-                        // xband_set_data_t *config = (xband_set_data_t *)payload;
-                        // adradio_set_tx_lo(global_data->tx_modem, config->LO);
-                        phy_config_t *config = (phy_config_t *)payload;
-
-                        if (global->rx_armed && config->mode == SLEEP)
-                        {
-                            dbprintlf(RED_BG "ATTENTION: CONFIGURATION ABORTED! CANNOT PUT RADIO TO SLEEP WHILE RX IS ARMED!");
-                            break;
-                        }
-
-                        // TODO: Figure out how to configure the X-Band radio.
-
-                        // RECONFIGURE XBAND
-                        adradio_set_ensm_mode(global->radio, (ensm_mode)config->mode);
-                        adradio_set_rx_lo(global->radio, config->LO);
-                        adradio_set_samp(global->radio, config->samp);
-                        adradio_set_rx_bw(global->radio, config->bw);
-                        char filter_name[256];
-                        // TODO: Keep track of the return value of the load filter thing in the status.
-                        snprintf(filter_name, sizeof(filter_name), "/home/sunip/%s.ftr", config->ftr_name);
-                        adradio_set_tx_hardwaregain(global->radio, -85);
-                        adradio_set_rx_hardwaregainmode(global->radio, strcmp("fast_attack", config->curr_gainmode) ? SLOW_ATTACK : FAST_ATTACK);
-                    }
-                    else
-                    {
-                        dbprintlf(YELLOW_FG "Incorrectly received a configuration for Roof X-Band.");
-                    }
-                    break;
-                }
-                case NetType::XBAND_COMMAND:
-                {
-                    dbprintlf(BLUE_FG "Received XBAND command.");
-                    XBAND_COMMAND *command = (XBAND_COMMAND *)payload;
-
-                    static pthread_t xband_rx_tid;
-
-                    switch (*command)
-                    {
-                    case XBC_INIT_PLL:
-                    {
-                        dbprintlf("Received PLL initialize command.");
-                        if (global->PLL_ready)
-                        {
-                            dbprintlf(YELLOW_FG "PLL already initialized, canceling.");
-                            break;
-                        }
-
-                        if (adf4355_init(global->PLL) < 0)
-                        {
-                            dbprintlf(RED_FG "PLL initialization failure.");
-                        }
-                        else if (adf4355_set_rx(global->PLL) < 0)
-                        {
-                            dbprintlf(RED_FG "PLL set RX failure.");
-                        }
-                        else
-                        {
-                            dbprintlf(GREEN_FG "PLL initialization success.");
-                            global->PLL_ready = true;
-                        }
-                        break;
-                    }
-                    case XBC_DISABLE_PLL:
-                    {
-                        dbprintlf("Received Disable PLL command.");
-                        if (!global->PLL_ready)
-                        {
-                            dbprintlf(YELLOW_FG "PLL already disabled, canceling.");
-                            break;
-                        }
-
-                        if (adf4355_pw_down(global->PLL) < 0)
-                        {
-                            dbprintlf(RED_FG "PLL shutdown failure.");
-                        }
-                        else
-                        {
-                            dbprintlf(GREEN_FG "PLL shutdown success.");
-                        }
-                        break;
-                    }
-                    case XBC_ARM_RX:
-                    {
-                        dbprintlf("Received Arm RX command.");
-                        if (global->rx_armed)
-                        {
-                            dbprintlf(YELLOW_FG "RX already armed, canceling.");
-                            break;
-                        }
-                        else
-                        {
-                            if (!pthread_create(&xband_rx_tid, NULL, gs_xband_rx_thread, global))
-                            {
-                                dbprintlf("Armed RX.");
-                                global->rx_armed = true;
-                            }
-                            else
-                            {
-                                dbprintlf(RED_FG "Failed to arm RX.");
-                            }
-                        }
-
-                        // if (rxmodem_start(global->rx_modem) < 0)
-                        // {
-                        //     dbprintlf(RED_FG "Failed to arm RX.");
-                        // }
-                        // else
-                        // {
-                        //     dbprintlf("Armed RX.");
-                        //     global->rx_armed = true;
-                        // }
-                        break;
-                    }
-                    case XBC_DISARM_RX:
-                    {
-                        dbprintlf("Received Disarm RX command.");
-                        if (!global->rx_armed)
-                        {
-                            dbprintlf(YELLOW_FG "RX already disarmed, canceling.");
-                            break;
-                        }
-
-                        if (rxmodem_stop(global->rx_modem) < 0)
-                        {
-                            dbprintlf(RED_FG "Failed to disable RX.");
-                        }
-
-                        pthread_cancel(*(global->rx_modem->thr));
-                        pthread_cancel(xband_rx_tid);
-                        usleep(100000);
-
-                        dbprintlf("Disarmed RX.");
-                        global->rx_armed = false;
-
-                        break;
-                    }
-                    }
-
-                    break;
-                }
-                case NetType::ACK:
-                {
-                    dbprintlf(BLUE_FG "Received an ACK frame!");
-                    break;
-                }
-                case NetType::NACK:
-                {
-                    dbprintlf(BLUE_FG "Received a NACK frame!");
-                    break;
-                }
-                default:
-                {
-                    break;
-                }
-                }
-                free(payload);
             }
-            else
+            else if (!drain)
             {
-                break;
+                gs_spool_flush(chain->spool);
+            }
+            else if (gs_spool_drain(chain->spool, global->network_data, chain->forward) < 0)
+            {
+                drain_after_ns = gs_metrics_now_ns() + 100000000ULL;
             }
-
-            delete netframe;
-        }
-        if (read_size == -404)
-        {
-            dbprintlf(RED_BG "Connection forcibly closed by the server.");
-            strcpy(network_data->disconnect_reason, "SERVER-FORCED");
-            network_data->connection_ready = false;
-            continue;
-        }
-        else if (errno == EAGAIN)
-        {
-            dbprintlf(YELLOW_BG "Active connection timed-out (%d).", read_size);
-            strcpy(network_data->disconnect_reason, "TIMED-OUT");
-            network_data->connection_ready = false;
             continue;
         }
-        erprintlf(errno);
+
+        forward_packet(chain, buf, true);
+        gs_buf_release(buf);
     }
 
-    network_data->recv_active = false;
-    dbprintlf(FATAL "DANGER! NETWORK RECEIVE THREAD IS RETURNING!");
+    return NULL;
+}
 
-    if (global->network_data->thread_status > 0)
+/**
+ * @brief Finds the chain a frame is addressed to by the optional byte after its fixed-size body.
+ *
+ * @return gs_chain_t* NULL if the frame names a chain which does not exist.
+ */
+static gs_chain_t *network_frame_chain(global_data_t *global, const unsigned char *payload, int payload_size, int body_size)
+{
+    int index = payload_size > body_size ? payload[body_size] : 0;
+    if (index >= global->num_chains)
     {
-        global->network_data->thread_status = 0;
+        dbprintlf(RED_FG "Frame addressed to chain %d, but there are only %d.", index, global->num_chains);
+        return NULL;
     }
-    return NULL;
+    return &global->chain[index];
 }
 
-void *xband_status_thread(void *args)
+void gs_network_handle_frame(global_data_t *global, NetType type, NetVertex destination, const unsigned char *payload, int payload_size)
 {
-    global_data_t *global = (global_data_t *)args;
-    NetDataClient *network_data = global->network_data;
-
-    while ((!global->rx_modem_ready || !global->radio_ready) && global->network_data->thread_status > 0)
+    switch (type)
     {
-        if (gs_xband_init(global) < 0)
+    case NetType::XBAND_CONFIG:
+    {
+        dbprintlf(BLUE_FG "Received an X-Band CONFIG frame!");
+        if (payload_size < (int)sizeof(phy_config_t))
         {
-            dbprintlf(RED_FG "Receive thread aborting, radio cannot initialize.");
-            usleep(5 SEC);
-            continue;
+            dbprintlf(RED_FG "Configuration frame too short (%d of %zu bytes).", payload_size, sizeof(phy_config_t));
+            break;
+        }
+        gs_chain_t *chain = network_frame_chain(global, payload, payload_size, sizeof(phy_config_t));
+        if (chain == NULL)
+        {
+            break;
+        }
+        if (!chain->radio_ready)
+        {
+            // TODO: Send a packet indicating this.
+            dbprintlf(RED_FG "Cannot configure radio: radio not ready, does not exist, or failed to initialize.");
+            break;
         }
-    }
 
-    while (network_data->recv_active && network_data->thread_status > 0)
+        if (destination == NetVertex::HAYSTACK)
+        {
+            // xband_set_data_t *config = (xband_set_data_t *)payload;
+            // adradio_set_tx_lo(global_data->tx_modem, config->LO);
+            const phy_config_t *config = (const phy_config_t *)payload;
+
+            if (chain->rx_state == GS_RX_ARMED && config->mode == SLEEP)
+            {
+                dbprintlf(RED_BG "ATTENTION: CONFIGURATION ABORTED! CANNOT PUT RADIO TO SLEEP WHILE RX IS ARMED!");
+                break;
+            }
+
+            // RECONFIGURE XBAND
+            if (gs_radio_config_apply(chain, config) < 0)
+            {
+                dbprintlf(RED_FG "Radio configuration failed and was rolled back.");
+            }
+
+            // Re-read what we just set and push it to the client now.
+            gs_status_invalidate(chain->status, GS_STATUS_STABLE);
+        }
+        else
+        {
+            dbprintlf(YELLOW_FG "Incorrectly received a configuration for Roof X-Band.");
+        }
+        break;
+    }
+    case NetType::XBAND_COMMAND:
     {
-        if (!global->radio_ready)
+        dbprintlf(BLUE_FG "Received XBAND command.");
+        if (payload_size < (int)sizeof(XBAND_COMMAND))
         {
-            dbprintlf(RED_FG "Cannot send radio config: radio not ready, does not exist, or failed to initialize.");
-            usleep(2 SEC);
-            continue;
+            dbprintlf(RED_FG "Command frame too short (%d bytes).", payload_size);
+            break;
         }
+        // The payload may sit unaligned in the receive buffer.
+        XBAND_COMMAND command;
+        memcpy(&command, payload, sizeof(command));
 
-        if (network_data->connection_ready)
+        gs_chain_t *chain = network_frame_chain(global, payload, payload_size, sizeof(XBAND_COMMAND));
+        if (chain == NULL)
         {
-            phy_status_t status[1];
-            memset(status, 0x0, sizeof(phy_status_t));
+            break;
+        }
 
-            adradio_get_rx_bw(global->radio, (long long *)&status->bw);
-            adradio_get_rx_hardwaregain(global->radio, &status->gain);
-            adradio_get_rx_hardwaregainmode(global->radio, status->curr_gainmode, sizeof(status->curr_gainmode));
-            adradio_get_rx_lo(global->radio, (long long *)&status->LO);
-            adradio_get_rssi(global->radio, &status->rssi);
-            adradio_get_samp(global->radio, (long long *)&status->samp);
-            adradio_get_temp(global->radio, (long long *)&status->temp);
+        switch (command)
+        {
+        case XBC_INIT_PLL:
+        {
+            dbprintlf("Received PLL initialize command.");
+            if (chain->PLL_ready)
+            {
+                dbprintlf(YELLOW_FG "PLL already initialized, canceling.");
+                break;
+            }
+            if (gs_startup_busy(global->startup, GS_STARTUP_PLL, chain->index))
+            {
+                dbprintlf(YELLOW_FG "PLL is still being brought up at startup, canceling.");
+                break;
+            }
 
-            char buf[32];
-            memset(buf, 0x0, 32);
-            adradio_get_ensm_mode(global->radio, buf, sizeof(buf));
-            if (strcmp(buf, "sleep") == 0)
+            if (chain->backend->pll_init(chain) < 0)
             {
-                status->mode = 0;
+                dbprintlf(RED_FG "PLL initialization failure.");
             }
-            else if (strcmp(buf, "fdd") == 0)
+            else if (chain->backend->pll_set_rx(chain) < 0)
             {
-                status->mode = 1;
+                dbprintlf(RED_FG "PLL set RX failure.");
             }
-            else if (strcmp(buf, "tdd") == 0)
+            else
+            {
+                dbprintlf(GREEN_FG "PLL initialization success.");
+                chain->PLL_ready = true;
+                gs_status_kick(chain->status);
+            }
+            break;
+        }
+        case XBC_DISABLE_PLL:
+        {
+            dbprintlf("Received Disable PLL command.");
+            if (!chain->PLL_ready)
+            {
+                dbprintlf(YELLOW_FG "PLL already disabled, canceling.");
+                break;
+            }
+
+            if (chain->backend->pll_pw_down(chain) < 0)
             {
-                status->mode = 2;
+                dbprintlf(RED_FG "PLL shutdown failure.");
             }
             else
             {
-                status->mode = -1;
+                dbprintlf(GREEN_FG "PLL shutdown success.");
+                gs_status_kick(chain->status);
+            }
+            break;
+        }
+        case XBC_ARM_RX:
+        {
+            dbprintlf("Received Arm RX command.");
+            if (chain->rx_state == GS_RX_ARMED)
+            {
+                dbprintlf(YELLOW_FG "RX already armed, canceling.");
+                break;
             }
 
-            status->modem_ready = global->rx_modem_ready;
-            status->PLL_ready = global->PLL_ready;
-            status->radio_ready = global->radio_ready;
-            status->rx_armed = global->rx_armed;
-            status->last_rx_status = global->last_rx_status;
-            status->last_read_status = global->last_read_status;
-
-            // dbprintlf(GREEN_FG "Sending the following X-Band status data:");
-            // dbprintlf(GREEN_FG "mode %d", status->mode);
-            // dbprintlf(GREEN_FG "pll_freq %d", status->pll_freq);
-            // dbprintlf(GREEN_FG "LO %lld", status->LO);
-            // dbprintlf(GREEN_FG "samp %lld", status->samp);
-            // dbprintlf(GREEN_FG "bw %lld", status->bw);
-            // dbprintlf(GREEN_FG "ftr_name %s", status->ftr_name);
-            // dbprintlf(GREEN_FG "temp %lld", status->temp);
-            // dbprintlf(GREEN_FG "rssi %f", status->rssi);
-            // dbprintlf(GREEN_FG "gain %f", status->gain);
-            // dbprintlf(GREEN_FG "curr_gainmode %s", status->curr_gainmode);
-            // dbprintlf(GREEN_FG "pll_lock %d", status->pll_lock);
-            // dbprintlf(GREEN_FG "modem_ready %d", status->modem_ready);
-            // dbprintlf(GREEN_FG "PLL_ready %d", status->PLL_ready);
-            // dbprintlf(GREEN_FG "radio_ready %d", status->radio_ready);
-            // dbprintlf(GREEN_FG "rx_armed %d", status->rx_armed);
-            // dbprintlf(GREEN_FG "last_rx_status %d", status->last_rx_status);
-            // dbprintlf(GREEN_FG "MTU %d", status->MTU);
-
-            NetFrame *status_frame = new NetFrame((unsigned char *)status, sizeof(phy_status_t), NetType::XBAND_DATA, NetVertex::CLIENT);
-            status_frame->sendFrame(network_data);
-            delete status_frame;
-        }
-
-        usleep(network_data->polling_rate SEC);
-    }
-
-    dbprintlf(FATAL "XBAND_STATUS_THREAD IS EXITING (%d)!", network_data->thread_status);
-    if (network_data->thread_status > 0)
-    {
-        network_data->thread_status = 0;
+            if (gs_xband_rx_arm(chain) < 0)
+            {
+                dbprintlf(RED_FG "Failed to arm RX.");
+                break;
+            }
+            dbprintlf("Armed RX.");
+            gs_status_kick(chain->status);
+            break;
+        }
+        case XBC_DISARM_RX:
+        {
+            dbprintlf("Received Disarm RX command.");
+            if (chain->rx_state != GS_RX_ARMED)
+            {
+                dbprintlf(YELLOW_FG "RX already disarmed, canceling.");
+                break;
+            }
+
+            if (gs_xband_rx_disarm(chain) < 0)
+            {
+                dbprintlf(RED_FG "Failed to disable RX.");
+            }
+
+            dbprintlf("Disarmed RX.");
+            gs_status_kick(chain->status);
+            break;
+        }
+        }
+
+        break;
     }
-    return NULL;
-}
\ No newline at end of file
+    case NetType::ACK:
+    {
+        dbprintlf(BLUE_FG "Received an ACK frame!");
+        break;
+    }
+    case NetType::NACK:
+    {
+        dbprintlf(BLUE_FG "Received a NACK frame!");
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+}
+
+int gs_xband_status_tick(gs_chain_t *chain, phy_status_t *last, struct timespec *last_send, bool kicked)
+{
+    phy_status_t status[1];
+    memset(status, 0x0, sizeof(phy_status_t));
+
+    gs_status_refresh(chain, status);
+
+    status->modem_ready = chain->rx_modem_ready;
+    status->PLL_ready = chain->PLL_ready;
+    status->radio_ready = chain->radio_ready;
+    status->rx_armed = chain->rx_state == GS_RX_ARMED;
+    status->last_rx_status = chain->last_rx_status;
+    status->last_read_status = chain->last_read_status;
+    status->pool_in_use = chain->rx_pool->in_use;
+    status->pool_exhausted = chain->rx_pool->exhausted;
+    status->pool_oversize = chain->rx_pool->oversize;
+    status->persist_queued = chain->capture->running ? gs_stage_occupancy(chain->capture->queue) : 0;
+    status->persist_dropped = chain->capture->running ? (uint32_t)chain->capture->queue->dropped : 0;
+    status->forward_queued = gs_stage_occupancy(chain->forward);
+    status->forward_dropped = chain->forward->dropped;
+    status->forward_send_errors = chain->forward_send_errors;
+    status->fec_codewords = chain->fec->codewords;
+    status->fec_corrected = chain->fec->corrected;
+    status->fec_uncorrectable = chain->fec->uncorrectable;
+    status->fec_dropped = chain->fec->dropped;
+    status->spool_frames = chain->spool->depth_frames;
+    status->spool_kb = chain->spool->depth_bytes >> 10;
+    status->spool_drain_kbps = chain->spool->drain_rate >> 10;
+    status->spool_dropped = chain->spool->dropped;
+    gs_radio_config_report(chain->radio_config, status);
+    gs_ftr_active(chain->global->ftr, chain->index, status->ftr_name, sizeof(status->ftr_name));
+
+    // dbprintlf(GREEN_FG "Sending the following X-Band status data:");
+    // dbprintlf(GREEN_FG "mode %d", status->mode);
+    // dbprintlf(GREEN_FG "pll_freq %d", status->pll_freq);
+    // dbprintlf(GREEN_FG "LO %lld", status->LO);
+    // dbprintlf(GREEN_FG "samp %lld", status->samp);
+    // dbprintlf(GREEN_FG "bw %lld", status->bw);
+    // dbprintlf(GREEN_FG "ftr_name %s", status->ftr_name);
+    // dbprintlf(GREEN_FG "temp %lld", status->temp);
+    // dbprintlf(GREEN_FG "rssi %f", status->rssi);
+    // dbprintlf(GREEN_FG "gain %f", status->gain);
+    // dbprintlf(GREEN_FG "curr_gainmode %s", status->curr_gainmode);
+    // dbprintlf(GREEN_FG "pll_lock %d", status->pll_lock);
+    // dbprintlf(GREEN_FG "modem_ready %d", status->modem_ready);
+    // dbprintlf(GREEN_FG "PLL_ready %d", status->PLL_ready);
+    // dbprintlf(GREEN_FG "radio_ready %d", status->radio_ready);
+    // dbprintlf(GREEN_FG "rx_armed %d", status->rx_armed);
+    // dbprintlf(GREEN_FG "last_rx_status %d", status->last_rx_status);
+    // dbprintlf(GREEN_FG "MTU %d", status->MTU);
+
+    // Only send when something changed, or as a keepalive.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (kicked || last_send->tv_sec == 0 || gs_status_changed(chain->status, last, status) ||
+        now.tv_sec - last_send->tv_sec >= chain->status->keepalive_sec)
+    {
+        uint8_t chain_byte = chain->index;
+        struct iovec iov[2] = {{status, sizeof(phy_status_t)}, {&chain_byte, sizeof(chain_byte)}};
+        if (gs_netframe_sendv(chain->global->network_data, NetType::XBAND_DATA, NetVertex::CLIENT, iov, chain->global->num_chains > 1 ? 2 : 1) >= 0)
+        {
+            memcpy(last, status, sizeof(phy_status_t));
+            *last_send = now;
+            return 1;
+        }
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,430 @@
+/**
+ * @file gs_iio.cpp
+ * @brief Batched AD9361 attribute access through libiio.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <iio.h>
+#include "gs_iio.hpp"
+#include "meb_debug.hpp"
+
+enum
+{
+    IIO_PHY,
+    IIO_RX_LO,
+    IIO_RX,
+    IIO_TX,
+    IIO_TEMP,
+    IIO_GROUPS
+};
+
+typedef struct
+{
+    uint32_t bit;
+    int group;
+    const char *name;
+    bool writable;
+} iio_attr_t;
+
+static const iio_attr_t iio_attrs[] = {
+    {GS_RADIO_ENSM_MODE, IIO_PHY, "ensm_mode", true},
+    {GS_RADIO_RX_LO, IIO_RX_LO, "frequency", true},
+    {GS_RADIO_SAMP, IIO_RX, "sampling_frequency", true},
+    {GS_RADIO_RX_BW, IIO_RX, "rf_bandwidth", true},
+    {GS_RADIO_RX_GAINMODE, IIO_RX, "gain_control_mode", true},
+    {GS_RADIO_RX_GAIN, IIO_RX, "hardwaregain", false},
+    {GS_RADIO_RSSI, IIO_RX, "rssi", false},
+    {GS_RADIO_TEMP, IIO_TEMP, "input", false},
+    {GS_RADIO_TX_GAIN, IIO_TX, "hardwaregain", true},
+};
+
+#define IIO_NUM_ATTRS (sizeof(iio_attrs) / sizeof(iio_attrs[0]))
+
+typedef struct
+{
+    gs_radio_attrs_t *out;
+    const gs_radio_attrs_t *in;
+    int group;
+    uint32_t want;
+    uint32_t done;
+} iio_batch_t;
+
+static const iio_attr_t *iio_lookup(int group, const char *name, uint32_t want)
+{
+    for (size_t i = 0; i < IIO_NUM_ATTRS; i++)
+    {
+        if (iio_attrs[i].group == group && (iio_attrs[i].bit & want) && strcmp(iio_attrs[i].name, name) == 0)
+        {
+            return &iio_attrs[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t iio_group_mask(int group, bool writable_only)
+{
+    uint32_t mask = 0;
+    for (size_t i = 0; i < IIO_NUM_ATTRS; i++)
+    {
+        if (iio_attrs[i].group == group && (!writable_only || iio_attrs[i].writable))
+        {
+            mask |= iio_attrs[i].bit;
+        }
+    }
+    return mask;
+}
+
+static struct iio_channel *iio_group_channel(gs_iio_t *iio, int group)
+{
+    switch (group)
+    {
+    case IIO_RX_LO:
+        return iio->rx_lo;
+    case IIO_RX:
+        return iio->rx;
+    case IIO_TX:
+        return iio->tx;
+    case IIO_TEMP:
+        return iio->temp;
+    }
+    return NULL;
+}
+
+static void iio_copy_str(char *dst, size_t size, const char *src)
+{
+    size_t len = strcspn(src, "\n");
+    if (len >= size)
+    {
+        len = size - 1;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static void iio_parse(gs_radio_attrs_t *attrs, uint32_t bit, const char *val)
+{
+    switch (bit)
+    {
+    case GS_RADIO_ENSM_MODE:
+        iio_copy_str(attrs->ensm_mode, sizeof(attrs->ensm_mode), val);
+        break;
+    case GS_RADIO_RX_LO:
+        attrs->rx_lo = strtoll(val, NULL, 10);
+        break;
+    case GS_RADIO_SAMP:
+        attrs->samp = strtoll(val, NULL, 10);
+        break;
+    case GS_RADIO_RX_BW:
+        attrs->rx_bw = strtoll(val, NULL, 10);
+        break;
+    case GS_RADIO_RX_GAINMODE:
+        iio_copy_str(attrs->rx_gainmode, sizeof(attrs->rx_gainmode), val);
+        break;
+    case GS_RADIO_RX_GAIN:
+        attrs->rx_gain = strtod(val, NULL);
+        break;
+    case GS_RADIO_RSSI:
+        attrs->rssi = strtod(val, NULL);
+        break;
+    case GS_RADIO_TEMP:
+        attrs->temp = strtoll(val, NULL, 10);
+        break;
+    case GS_RADIO_TX_GAIN:
+        attrs->tx_gain = strtod(val, NULL);
+        break;
+    }
+}
+
+/**
+ * @brief Formats one attribute for writing.
+ *
+ * @return ssize_t Length including the terminating NUL, as iio_*_attr_write sends it.
+ */
+static ssize_t iio_format(const gs_radio_attrs_t *attrs, uint32_t bit, char *buf, size_t len)
+{
+    int ret = -1;
+    switch (bit)
+    {
+    case GS_RADIO_ENSM_MODE:
+        ret = snprintf(buf, len, "%s", attrs->ensm_mode);
+        break;
+    case GS_RADIO_RX_LO:
+        ret = snprintf(buf, len, "%lld", attrs->rx_lo);
+        break;
+    case GS_RADIO_SAMP:
+        ret = snprintf(buf, len, "%lld", attrs->samp);
+        break;
+    case GS_RADIO_RX_BW:
+        ret = snprintf(buf, len, "%lld", attrs->rx_bw);
+        break;
+    case GS_RADIO_RX_GAINMODE:
+        ret = snprintf(buf, len, "%s", attrs->rx_gainmode);
+        break;
+    case GS_RADIO_TX_GAIN:
+        ret = snprintf(buf, len, "%f", attrs->tx_gain);
+        break;
+    }
+    if (ret < 0 || (size_t)ret >= len)
+    {
+        return -ENOSPC;
+    }
+    return ret + 1;
+}
+
+static int iio_read_cb(const char *attr, const char *val, void *d)
+{
+    iio_batch_t *batch = (iio_batch_t *)d;
+    const iio_attr_t *entry = iio_lookup(batch->group, attr, batch->want);
+    if (entry != NULL)
+    {
+        iio_parse(batch->out, entry->bit, val);
+        batch->done |= entry->bit;
+    }
+    return 0;
+}
+
+static int iio_read_dev_cb(struct iio_device *dev, const char *attr, const char *val, size_t len, void *d)
+{
+    return iio_read_cb(attr, val, d);
+}
+
+static int iio_read_chn_cb(struct iio_channel *chn, const char *attr, const char *val, size_t len, void *d)
+{
+    return iio_read_cb(attr, val, d);
+}
+
+static ssize_t iio_write_cb(const char *attr, void *buf, size_t len, void *d)
+{
+    iio_batch_t *batch = (iio_batch_t *)d;
+    const iio_attr_t *entry = iio_lookup(batch->group, attr, batch->want);
+    if (entry == NULL || !entry->writable)
+    {
+        // Zero length leaves the attribute untouched.
+        return 0;
+    }
+    ssize_t ret = iio_format(batch->in, entry->bit, (char *)buf, len);
+    if (ret > 0)
+    {
+        batch->done |= entry->bit;
+    }
+    return ret;
+}
+
+static ssize_t iio_write_dev_cb(struct iio_device *dev, const char *attr, void *buf, size_t len, void *d)
+{
+    return iio_write_cb(attr, buf, len, d);
+}
+
+static ssize_t iio_write_chn_cb(struct iio_channel *chn, const char *attr, void *buf, size_t len, void *d)
+{
+    return iio_write_cb(attr, buf, len, d);
+}
+
+/**
+ * @brief One attribute at a time, for contexts without the bulk calls.
+ *
+ */
+static uint32_t iio_read_single(gs_iio_t *iio, int group, gs_radio_attrs_t *attrs, uint32_t want)
+{
+    uint32_t done = 0;
+    for (size_t i = 0; i < IIO_NUM_ATTRS; i++)
+    {
+        const iio_attr_t *entry = &iio_attrs[i];
+        if (entry->group != group || !(entry->bit & want))
+        {
+            continue;
+        }
+
+        char val[64];
+        ssize_t ret = group == IIO_PHY ? iio_device_attr_read(iio->phy, entry->name, val, sizeof(val))
+                                       : iio_channel_attr_read(iio_group_channel(iio, group), entry->name, val, sizeof(val));
+        if (ret > 0)
+        {
+            iio_parse(attrs, entry->bit, val);
+            done |= entry->bit;
+        }
+    }
+    return done;
+}
+
+static uint32_t iio_write_single(gs_iio_t *iio, int group, const gs_radio_attrs_t *attrs, uint32_t want)
+{
+    uint32_t done = 0;
+    for (size_t i = 0; i < IIO_NUM_ATTRS; i++)
+    {
+        const iio_attr_t *entry = &iio_attrs[i];
+        if (entry->group != group || !(entry->bit & want) || !entry->writable)
+        {
+            continue;
+        }
+
+        char val[64];
+        if (iio_format(attrs, entry->bit, val, sizeof(val)) < 0)
+        {
+            continue;
+        }
+        ssize_t ret = group == IIO_PHY ? iio_device_attr_write(iio->phy, entry->name, val)
+                                       : iio_channel_attr_write(iio_group_channel(iio, group), entry->name, val);
+        if (ret > 0)
+        {
+            done |= entry->bit;
+        }
+    }
+    return done;
+}
+
+static void iio_bulk_failed(gs_iio_t *iio, int ret)
+{
+    if (iio->bulk)
+    {
+        dbprintlf(YELLOW_FG "IIO context rejected a bulk attribute transfer (%d), using single attribute access.", ret);
+        iio->bulk = false;
+    }
+}
+
+int gs_iio_init(gs_iio_t *iio, const char *uri)
+{
+    memset(iio, 0x0, sizeof(gs_iio_t));
+    pthread_mutex_init(&iio->lock, NULL);
+
+    iio->ctx = uri != NULL ? iio_create_context_from_uri(uri) : iio_create_default_context();
+    if (iio->ctx == NULL)
+    {
+        dbprintlf(RED_FG "Could not open IIO context %s.", uri != NULL ? uri : "(default)");
+        return -1;
+    }
+
+    iio->phy = iio_context_find_device(iio->ctx, GS_IIO_PHY_NAME);
+    if (iio->phy == NULL)
+    {
+        dbprintlf(RED_FG "IIO context has no %s device.", GS_IIO_PHY_NAME);
+        iio_context_destroy(iio->ctx);
+        iio->ctx = NULL;
+        return -1;
+    }
+
+    iio->rx = iio_device_find_channel(iio->phy, "voltage0", false);
+    iio->rx_lo = iio_device_find_channel(iio->phy, "altvoltage0", true);
+    iio->tx = iio_device_find_channel(iio->phy, "voltage0", true);
+    iio->temp = iio_device_find_channel(iio->phy, "temp0", false);
+    iio->bulk = true;
+
+    dbprintlf(GREEN_FG "Batched IIO attribute access on %s.", GS_IIO_PHY_NAME);
+    return 1;
+}
+
+int gs_iio_read(gs_iio_t *iio, gs_radio_attrs_t *attrs, uint32_t mask)
+{
+    if (iio->phy == NULL)
+    {
+        return -1;
+    }
+
+    uint32_t done = 0;
+    pthread_mutex_lock(&iio->lock);
+    for (int group = 0; group < IIO_GROUPS; group++)
+    {
+        uint32_t want = mask & iio_group_mask(group, false);
+        struct iio_channel *chn = iio_group_channel(iio, group);
+        if (!want || (group != IIO_PHY && chn == NULL))
+        {
+            continue;
+        }
+
+        if (iio->bulk)
+        {
+            iio_batch_t batch = {attrs, NULL, group, want, 0};
+            int ret = group == IIO_PHY ? iio_device_attr_read_all(iio->phy, iio_read_dev_cb, &batch)
+                                       : iio_channel_attr_read_all(chn, iio_read_chn_cb, &batch);
+            if (ret >= 0)
+            {
+                done |= batch.done;
+                continue;
+            }
+            iio_bulk_failed(iio, ret);
+        }
+        done |= iio_read_single(iio, group, attrs, want);
+    }
+    pthread_mutex_unlock(&iio->lock);
+
+    return done;
+}
+
+int gs_iio_write(gs_iio_t *iio, const gs_radio_attrs_t *attrs, uint32_t mask)
+{
+    if (iio->phy == NULL)
+    {
+        return -1;
+    }
+
+    uint32_t done = 0;
+    pthread_mutex_lock(&iio->lock);
+    for (int group = 0; group < IIO_GROUPS; group++)
+    {
+        uint32_t want = mask & iio_group_mask(group, true);
+        struct iio_channel *chn = iio_group_channel(iio, group);
+        if (!want || (group != IIO_PHY && chn == NULL))
+        {
+            continue;
+        }
+
+        if (iio->bulk)
+        {
+            iio_batch_t batch = {NULL, attrs, group, want, 0};
+            int ret = group == IIO_PHY ? iio_device_attr_write_all(iio->phy, iio_write_dev_cb, &batch)
+                                       : iio_channel_attr_write_all(chn, iio_write_chn_cb, &batch);
+            if (ret >= 0)
+            {
+                done |= batch.done;
+                continue;
+            }
+            iio_bulk_failed(iio, ret);
+        }
+        done |= iio_write_single(iio, group, attrs, want);
+    }
+    pthread_mutex_unlock(&iio->lock);
+
+    return done;
+}
+
+int gs_iio_load_filter(gs_iio_t *iio, const char *ftr, size_t len)
+{
+    if (iio->phy == NULL)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&iio->lock);
+    ssize_t ret = iio_device_attr_write_raw(iio->phy, "filter_fir_config", ftr, len);
+    if (ret >= 0)
+    {
+        ret = iio_device_attr_write(iio->phy, "in_out_voltage_filter_fir_en", "1");
+    }
+    pthread_mutex_unlock(&iio->lock);
+
+    if (ret < 0)
+    {
+        dbprintlf(RED_FG "Failed to load FIR filter (%zd).", ret);
+        return -1;
+    }
+    return 1;
+}
+
+void gs_iio_destroy(gs_iio_t *iio)
+{
+    if (iio->ctx != NULL)
+    {
+        iio_context_destroy(iio->ctx);
+    }
+    iio->ctx = NULL;
+    iio->phy = NULL;
+    pthread_mutex_destroy(&iio->lock);
+}
@@ -0,0 +1,409 @@
+/**
+ * @file gs_metrics.cpp
+ * @brief Per-thread latency histograms and counters.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <atomic>
+#include "gs_metrics.hpp"
+#include "gs_rt.hpp"
+#include "meb_debug.hpp"
+
+typedef struct
+{
+    std::atomic<bool> in_use;
+    std::atomic<uint64_t> counters[GS_CTR_NUM];
+    std::atomic<uint64_t> count[GS_HIST_NUM];
+    std::atomic<uint64_t> sum[GS_HIST_NUM];
+    std::atomic<uint64_t> max[GS_HIST_NUM];
+    std::atomic<uint64_t> buckets[GS_HIST_NUM][GS_METRICS_BUCKETS];
+} metrics_shard_t;
+
+// One shard per live thread, plus a shared one (with atomic adds) once those run out.
+static metrics_shard_t metrics_shards[GS_METRICS_MAX_THREADS + 1];
+static metrics_shard_t *const metrics_shared = &metrics_shards[GS_METRICS_MAX_THREADS];
+
+static const char *metrics_hist_names[GS_HIST_NUM] = {"rx_receive", "rx_read", "capture_write", "net_send", "config_apply", "status_read", "compress_frame", "sched_wakeup", "rx_arm", "rx_disarm", "fec_decode"};
+static const char *metrics_hist_help[GS_HIST_NUM] = {
+    "Time spent in rx_receive (rxmodem_receive).",
+    "Time spent in rx_read (rxmodem_read).",
+    "Time to write one batch of captured packets and their index records.",
+    "Time to send one frame to the server.",
+    "Time to apply one XBAND_CONFIG.",
+    "Time to read the radio attributes for one status frame.",
+    "Time to compress one frame of a sealed capture segment.",
+    "How late a thread with the RX scheduling settings woke up from an absolute sleep.",
+    "Time from an arm command until the receive worker is waiting on the modem.",
+    "Time from a disarm command until the receive worker is parked.",
+    "Time to decode the Reed-Solomon codeblocks of one receive buffer.",
+};
+static const char *metrics_counter_names[GS_CTR_NUM] = {
+    "rx_packets", "rx_bytes", "rx_errors", "capture_packets", "capture_bytes", "capture_errors",
+    "net_frames", "net_bytes", "net_errors", "config_passes", "config_failures", "status_reads", "status_errors",
+    "compress_segments", "compress_in_bytes", "compress_out_bytes", "compress_errors",
+    "deframe_frames", "deframe_crc_errors", "deframe_skipped_bytes",
+    "fec_codewords", "fec_corrected_symbols", "fec_uncorrectable", "fec_dropped",
+    "spool_frames", "spool_bytes", "spool_drained_frames", "spool_drained_bytes", "spool_dropped", "spool_errors",
+    "forward_batches", "forward_batched_packets"};
+static const char *metrics_counter_help[GS_CTR_NUM] = {
+    "Packets received from the modem.",
+    "Bytes received from the modem.",
+    "Failed or short modem receives and reads.",
+    "Packets written to the capture store.",
+    "Bytes written to the capture store.",
+    "Failed capture writes.",
+    "Frames sent to the server.",
+    "Bytes sent to the server, framing included.",
+    "Failed sends to the server.",
+    "XBAND_CONFIG passes.",
+    "XBAND_CONFIG passes which failed and were rolled back.",
+    "Status attribute reads.",
+    "Status attribute reads which left some attribute unread.",
+    "Capture segments compressed.",
+    "Capture bytes read for compression.",
+    "Compressed capture bytes written.",
+    "Capture segments which failed to compress and were left raw.",
+    "CCSDS transfer frames found in received data.",
+    "CCSDS transfer frames whose CRC did not check.",
+    "Received bytes outside any CCSDS transfer frame.",
+    "Reed-Solomon codewords decoded.",
+    "Symbols corrected by the Reed-Solomon decoders.",
+    "Reed-Solomon codewords with more errors than could be corrected.",
+    "Receive buffers dropped because the Reed-Solomon decoders were behind.",
+    "DATA frames spooled to disk because the server could not take them.",
+    "Payload bytes spooled to disk.",
+    "Spooled DATA frames sent to the server.",
+    "Spooled payload bytes sent to the server.",
+    "DATA frames lost because the spool was off, full or failed.",
+    "Failed spool file reads and writes.",
+    "Batched DATA frames sent or spooled.",
+    "Received packets sent or spooled in batched DATA frames.",
+};
+
+// Upper bounds of the exported Prometheus buckets, in seconds.
+static const double metrics_prom_le[] = {1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1, 10};
+
+/**
+ * @brief Returns the thread's shard to the pool when the thread exits; its totals stay.
+ *
+ */
+struct metrics_owner
+{
+    metrics_shard_t *shard = nullptr;
+    ~metrics_owner()
+    {
+        if (shard != nullptr && shard != metrics_shared)
+        {
+            shard->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+static thread_local metrics_owner metrics_this_thread;
+
+static metrics_shard_t *metrics_shard()
+{
+    metrics_shard_t *shard = metrics_this_thread.shard;
+    if (shard != nullptr)
+    {
+        return shard;
+    }
+
+    shard = metrics_shared;
+    for (int i = 0; i < GS_METRICS_MAX_THREADS; i++)
+    {
+        bool expected = false;
+        if (metrics_shards[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            shard = &metrics_shards[i];
+            break;
+        }
+    }
+    metrics_this_thread.shard = shard;
+    return shard;
+}
+
+static inline void metrics_bump(metrics_shard_t *shard, std::atomic<uint64_t> &value, uint64_t n)
+{
+    if (shard == metrics_shared)
+    {
+        value.fetch_add(n, std::memory_order_relaxed);
+    }
+    else
+    {
+        // Only this thread writes its shard.
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+}
+
+static inline int metrics_bucket(uint64_t ns)
+{
+    if (ns < (1ULL << GS_METRICS_SUB_BITS))
+    {
+        return ns;
+    }
+    int exp = 63 - __builtin_clzll(ns);
+    if (exp >= GS_METRICS_MAX_EXP)
+    {
+        return GS_METRICS_BUCKETS - 1;
+    }
+    int sub = (ns >> (exp - GS_METRICS_SUB_BITS)) & ((1 << GS_METRICS_SUB_BITS) - 1);
+    return ((exp - GS_METRICS_SUB_BITS + 1) << GS_METRICS_SUB_BITS) + sub;
+}
+
+/**
+ * @brief Largest value which lands in bucket i.
+ *
+ */
+static uint64_t metrics_bucket_max(int i)
+{
+    if (i < (1 << GS_METRICS_SUB_BITS))
+    {
+        return i;
+    }
+    int exp = (i >> GS_METRICS_SUB_BITS) + GS_METRICS_SUB_BITS - 1;
+    uint64_t sub = i & ((1 << GS_METRICS_SUB_BITS) - 1);
+    return (((1ULL << GS_METRICS_SUB_BITS) + sub + 1) << (exp - GS_METRICS_SUB_BITS)) - 1;
+}
+
+void gs_metric_time(gs_hist_t hist, uint64_t ns)
+{
+    metrics_shard_t *shard = metrics_shard();
+    metrics_bump(shard, shard->buckets[hist][metrics_bucket(ns)], 1);
+    metrics_bump(shard, shard->count[hist], 1);
+    metrics_bump(shard, shard->sum[hist], ns);
+
+    uint64_t max = shard->max[hist].load(std::memory_order_relaxed);
+    if (shard != metrics_shared)
+    {
+        if (ns > max)
+        {
+            shard->max[hist].store(ns, std::memory_order_relaxed);
+        }
+        return;
+    }
+    while (ns > max && !shard->max[hist].compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void gs_metric_add(gs_counter_t counter, uint64_t n)
+{
+    metrics_shard_t *shard = metrics_shard();
+    metrics_bump(shard, shard->counters[counter], n);
+}
+
+void gs_metrics_snapshot(gs_metrics_snapshot_t *snap)
+{
+    memset(snap, 0x0, sizeof(gs_metrics_snapshot_t));
+    for (int s = 0; s <= GS_METRICS_MAX_THREADS; s++)
+    {
+        metrics_shard_t *shard = &metrics_shards[s];
+        for (int c = 0; c < GS_CTR_NUM; c++)
+        {
+            snap->counters[c] += shard->counters[c].load(std::memory_order_relaxed);
+        }
+        for (int h = 0; h < GS_HIST_NUM; h++)
+        {
+            uint64_t count = shard->count[h].load(std::memory_order_relaxed);
+            if (count == 0)
+            {
+                continue;
+            }
+            gs_hist_snapshot_t *out = &snap->hist[h];
+            out->count += count;
+            out->sum_ns += shard->sum[h].load(std::memory_order_relaxed);
+            uint64_t max = shard->max[h].load(std::memory_order_relaxed);
+            out->max_ns = max > out->max_ns ? max : out->max_ns;
+            for (int b = 0; b < GS_METRICS_BUCKETS; b++)
+            {
+                out->buckets[b] += shard->buckets[h][b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+uint64_t gs_metrics_quantile(const gs_hist_snapshot_t *hist, double q)
+{
+    if (hist->count == 0)
+    {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(q * hist->count + 0.5);
+    target = target < 1 ? 1 : target;
+
+    uint64_t seen = 0;
+    for (int b = 0; b < GS_METRICS_BUCKETS; b++)
+    {
+        seen += hist->buckets[b];
+        if (seen >= target)
+        {
+            uint64_t value = metrics_bucket_max(b);
+            return value < hist->max_ns ? value : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+void gs_metrics_frame(const gs_metrics_snapshot_t *snap, gs_metrics_frame_t *frame)
+{
+    memset(frame, 0x0, sizeof(gs_metrics_frame_t));
+    frame->version = GS_METRICS_FRAME_VERSION;
+    for (int c = 0; c < GS_CTR_NUM; c++)
+    {
+        frame->counters[c] = snap->counters[c];
+    }
+    for (int h = 0; h < GS_HIST_NUM; h++)
+    {
+        const gs_hist_snapshot_t *hist = &snap->hist[h];
+        frame->hist[h].count = hist->count;
+        frame->hist[h].sum_ns = hist->sum_ns;
+        frame->hist[h].p50_ns = gs_metrics_quantile(hist, 0.5);
+        frame->hist[h].p90_ns = gs_metrics_quantile(hist, 0.9);
+        frame->hist[h].p99_ns = gs_metrics_quantile(hist, 0.99);
+        frame->hist[h].p999_ns = gs_metrics_quantile(hist, 0.999);
+        frame->hist[h].max_ns = hist->max_ns;
+    }
+}
+
+size_t gs_metrics_format(const gs_metrics_snapshot_t *snap, char *buf, size_t len)
+{
+    size_t off = 0;
+#define METRICS_PRINT(...)                                              \
+    do                                                                  \
+    {                                                                   \
+        if (off < len)                                                  \
+        {                                                               \
+            int n = snprintf(buf + off, len - off, __VA_ARGS__);        \
+            off = n < 0 ? len : (off + n < len ? off + n : len - 1);    \
+        }                                                               \
+    } while (0)
+
+    for (int c = 0; c < GS_CTR_NUM; c++)
+    {
+        METRICS_PRINT("# HELP haystack_%s_total %s\n# TYPE haystack_%s_total counter\nhaystack_%s_total %llu\n",
+                      metrics_counter_names[c], metrics_counter_help[c], metrics_counter_names[c], metrics_counter_names[c],
+                      (unsigned long long)snap->counters[c]);
+    }
+
+    uint64_t compress_in = snap->counters[GS_CTR_COMPRESS_IN_BYTES];
+    uint64_t compress_out = snap->counters[GS_CTR_COMPRESS_OUT_BYTES];
+    uint64_t compress_ns = snap->hist[GS_HIST_COMPRESS_FRAME].sum_ns;
+    METRICS_PRINT("# HELP haystack_compress_ratio Capture bytes in per compressed byte out, since start.\n# TYPE haystack_compress_ratio gauge\nhaystack_compress_ratio %.3f\n",
+                  compress_out ? (double)compress_in / compress_out : 0.0);
+    METRICS_PRINT("# HELP haystack_compress_bytes_per_second Capture bytes compressed per second of compression time, per worker.\n# TYPE haystack_compress_bytes_per_second gauge\nhaystack_compress_bytes_per_second %.0f\n",
+                  compress_ns ? compress_in / (compress_ns / 1e9) : 0.0);
+
+    for (int h = 0; h < GS_HIST_NUM; h++)
+    {
+        const gs_hist_snapshot_t *hist = &snap->hist[h];
+        const char *name = metrics_hist_names[h];
+        METRICS_PRINT("# HELP haystack_%s_seconds %s\n# TYPE haystack_%s_seconds histogram\n", name, metrics_hist_help[h], name);
+
+        // Each HDR bucket counts toward the first exported bound at or above its largest value.
+        uint64_t cumulative = 0;
+        int b = 0;
+        for (size_t i = 0; i < sizeof(metrics_prom_le) / sizeof(metrics_prom_le[0]); i++)
+        {
+            uint64_t le_ns = (uint64_t)(metrics_prom_le[i] * 1e9);
+            while (b < GS_METRICS_BUCKETS && metrics_bucket_max(b) <= le_ns)
+            {
+                cumulative += hist->buckets[b++];
+            }
+            METRICS_PRINT("haystack_%s_seconds_bucket{le=\"%g\"} %llu\n", name, metrics_prom_le[i], (unsigned long long)cumulative);
+        }
+        METRICS_PRINT("haystack_%s_seconds_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)hist->count);
+        METRICS_PRINT("haystack_%s_seconds_sum %.9f\n", name, hist->sum_ns / 1e9);
+        METRICS_PRINT("haystack_%s_seconds_count %llu\n", name, (unsigned long long)hist->count);
+    }
+#undef METRICS_PRINT
+    return off;
+}
+
+int gs_metrics_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0x0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        dbprintlf(RED_FG "Metrics socket path %s is too long.", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        // Left behind by a previous run.
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        erprintlf(errno);
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 4) < 0)
+    {
+        erprintlf(errno);
+        close(fd);
+        return -1;
+    }
+    dbprintlf(GREEN_FG "Serving metrics on %s.", path);
+    return fd;
+}
+
+void gs_metrics_serve(int listen_fd)
+{
+    // Large, and only ever used from the one thread serving the socket.
+    static gs_metrics_snapshot_t snap;
+    static char text[32768];
+
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            erprintlf(errno);
+        }
+        return;
+    }
+
+    // A reader that stalls must not hold up the caller for long.
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    gs_metrics_snapshot(&snap);
+    size_t len = gs_metrics_format(&snap, text, sizeof(text));
+    len += gs_rt_format(text + len, sizeof(text) - len);
+
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t ret = send(fd, text + done, len - done, MSG_NOSIGNAL);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        done += ret;
+    }
+    close(fd);
+}
@@ -0,0 +1,403 @@
+/**
+ * @file gs_netframe.cpp
+ * @brief Copy-free NetFrame sends from caller-owned payloads.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <atomic>
+#include "gs_netframe.hpp"
+#include "gs_crc.hpp"
+#include "gs_metrics.hpp"
+#include "meb_debug.hpp"
+
+static std::atomic<bool> netframe_direct(false);
+static uint8_t netframe_netstat = 0;
+static pthread_mutex_t netframe_send_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t netframe_build(gs_netframe_header_t *header, gs_netframe_footer_t *footer, NetType type, NetVertex destination, const struct iovec *payload, int iovcnt)
+{
+    size_t total = 0;
+    uint16_t crc = GS_CRC16_INIT;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        crc = gs_crc16(crc, payload[i].iov_base, payload[i].iov_len);
+        total += payload[i].iov_len;
+    }
+
+    header->guid = GS_NETFRAME_GUID;
+    header->origin = NetVertex::HAYSTACK;
+    header->destination = destination;
+    header->type = type;
+    header->netstat = netframe_netstat;
+    header->payload_size = total;
+    header->crc1 = crc;
+    footer->crc2 = crc;
+    footer->termination = GS_NETFRAME_TERMINATOR;
+    return total;
+}
+
+/**
+ * @brief Writes every iovec in full, resuming after partial sends.
+ *
+ */
+static ssize_t netframe_write(int fd, struct iovec *iov, int iovcnt)
+{
+    ssize_t sent = 0;
+    struct msghdr msg;
+    memset(&msg, 0x0, sizeof(msg));
+
+    while (iovcnt > 0)
+    {
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        ssize_t ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        sent += ret;
+
+        while (iovcnt > 0 && (size_t)ret >= iov->iov_len)
+        {
+            ret -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (uint8_t *)iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+    return sent;
+}
+
+/**
+ * @brief Sends through NetFrame, gathering the payload first if it is split.
+ *
+ */
+static ssize_t netframe_send_copy(NetData *network_data, NetType type, NetVertex destination, const struct iovec *payload, int iovcnt)
+{
+    uint8_t *data = (uint8_t *)(iovcnt > 0 ? payload[0].iov_base : NULL);
+    size_t total = iovcnt > 0 ? payload[0].iov_len : 0;
+    bool gathered = false;
+
+    if (iovcnt > 1)
+    {
+        total = 0;
+        for (int i = 0; i < iovcnt; i++)
+        {
+            total += payload[i].iov_len;
+        }
+        data = (uint8_t *)malloc(total);
+        if (data == NULL)
+        {
+            return -1;
+        }
+        size_t off = 0;
+        for (int i = 0; i < iovcnt; i++)
+        {
+            memcpy(data + off, payload[i].iov_base, payload[i].iov_len);
+            off += payload[i].iov_len;
+        }
+        gathered = true;
+    }
+
+    NetFrame *frame = new NetFrame(data, total, type, destination);
+    pthread_mutex_lock(&netframe_send_lock);
+    ssize_t ret = frame->sendFrame(network_data);
+    pthread_mutex_unlock(&netframe_send_lock);
+    delete frame;
+
+    if (gathered)
+    {
+        free(data);
+    }
+    return ret;
+}
+
+int gs_netframe_selftest()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+    {
+        erprintlf(errno);
+        return 0;
+    }
+
+    uint8_t payload[64];
+    for (int i = 0; i < (int)sizeof(payload); i++)
+    {
+        payload[i] = i * 7 + 3;
+    }
+
+    NetDataClient *probe = new NetDataClient(NetPort::HAYSTACK, 1);
+    probe->socket = sv[0];
+    probe->connection_ready = true;
+    NetFrame *frame = new NetFrame(payload, sizeof(payload), NetType::DATA, NetVertex::CLIENT);
+    frame->sendFrame(probe);
+    delete frame;
+    probe->socket = -1;
+    probe->connection_ready = false;
+    delete probe;
+
+    uint8_t theirs[256];
+    ssize_t len = recv(sv[1], theirs, sizeof(theirs), MSG_DONTWAIT);
+    close(sv[0]);
+    close(sv[1]);
+
+    gs_netframe_header_t header;
+    gs_netframe_footer_t footer;
+    struct iovec iov = {payload, sizeof(payload)};
+    netframe_build(&header, &footer, NetType::DATA, NetVertex::CLIENT, &iov, 1);
+
+    const size_t expected = sizeof(header) + sizeof(payload) + sizeof(footer);
+    if (len == (ssize_t)expected)
+    {
+        // Adopt whatever status byte NetFrame puts on client frames.
+        header.netstat = ((gs_netframe_header_t *)theirs)->netstat;
+        netframe_netstat = header.netstat;
+    }
+
+    if (len != (ssize_t)expected ||
+        memcmp(theirs, &header, sizeof(header)) != 0 ||
+        memcmp(theirs + sizeof(header), payload, sizeof(payload)) != 0 ||
+        memcmp(theirs + sizeof(header) + sizeof(payload), &footer, sizeof(footer)) != 0)
+    {
+        dbprintlf(YELLOW_FG "NetFrame wire format differs from gs_netframe (%zd of %zu bytes), sending through NetFrame.", len, expected);
+        netframe_direct = false;
+        return 0;
+    }
+
+    dbprintlf(GREEN_FG "Copy-free NetFrame sends enabled.");
+    netframe_direct = true;
+    return 1;
+}
+
+/**
+ * @brief Sends header, caller's payload and footer in one sendmsg(...).
+ *
+ */
+static ssize_t netframe_send_direct(NetData *network_data, NetType type, NetVertex destination, const struct iovec *payload, int iovcnt)
+{
+    gs_netframe_header_t header;
+    gs_netframe_footer_t footer;
+    netframe_build(&header, &footer, type, destination, payload, iovcnt);
+
+    struct iovec iov[GS_NETFRAME_MAX_IOV + 2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    memcpy(&iov[1], payload, iovcnt * sizeof(struct iovec));
+    iov[iovcnt + 1].iov_base = &footer;
+    iov[iovcnt + 1].iov_len = sizeof(footer);
+
+    pthread_mutex_lock(&netframe_send_lock);
+    ssize_t ret = netframe_write(network_data->socket, iov, iovcnt + 2);
+    pthread_mutex_unlock(&netframe_send_lock);
+
+    if (ret < 0)
+    {
+        erprintlf(errno);
+    }
+    return ret;
+}
+
+bool gs_netframe_is_direct()
+{
+    return netframe_direct.load(std::memory_order_relaxed);
+}
+
+ssize_t gs_netframe_sendv(NetData *network_data, NetType type, NetVertex destination, const struct iovec *payload, int iovcnt)
+{
+    if (!network_data->connection_ready || iovcnt > GS_NETFRAME_MAX_IOV)
+    {
+        return -1;
+    }
+
+    uint64_t start = gs_metrics_now_ns();
+    ssize_t ret;
+    if (!netframe_direct.load(std::memory_order_relaxed))
+    {
+        ret = netframe_send_copy(network_data, type, destination, payload, iovcnt);
+    }
+    else
+    {
+        ret = netframe_send_direct(network_data, type, destination, payload, iovcnt);
+    }
+    gs_metric_time(GS_HIST_NET_SEND, gs_metrics_now_ns() - start);
+
+    if (ret < 0)
+    {
+        gs_metric_add(GS_CTR_NET_ERRORS, 1);
+    }
+    else
+    {
+        gs_metric_add(GS_CTR_NET_FRAMES, 1);
+        gs_metric_add(GS_CTR_NET_BYTES, ret);
+    }
+    return ret;
+}
+
+ssize_t gs_netframe_send(NetData *network_data, NetType type, NetVertex destination, const void *payload, size_t len)
+{
+    struct iovec iov = {(void *)payload, len};
+    return gs_netframe_sendv(network_data, type, destination, &iov, len > 0 ? 1 : 0);
+}
+
+ssize_t gs_netframe_send_batch(NetData *network_data, NetType type, NetVertex destination, const struct iovec *payloads, int count)
+{
+    if (!network_data->connection_ready || count < 0 || count > GS_NETFRAME_MAX_BATCH)
+    {
+        return -1;
+    }
+
+    ssize_t ret = 0;
+    if (!netframe_direct.load(std::memory_order_relaxed))
+    {
+        for (int i = 0; i < count && ret >= 0; i++)
+        {
+            ssize_t sent = netframe_send_copy(network_data, type, destination, &payloads[i], 1);
+            ret = sent < 0 ? -1 : ret + sent;
+        }
+    }
+    else
+    {
+        gs_netframe_header_t headers[GS_NETFRAME_MAX_BATCH];
+        gs_netframe_footer_t footers[GS_NETFRAME_MAX_BATCH];
+        struct iovec iov[GS_NETFRAME_MAX_BATCH * 3];
+        for (int i = 0; i < count; i++)
+        {
+            netframe_build(&headers[i], &footers[i], type, destination, &payloads[i], 1);
+            iov[i * 3].iov_base = &headers[i];
+            iov[i * 3].iov_len = sizeof(headers[i]);
+            iov[i * 3 + 1] = payloads[i];
+            iov[i * 3 + 2].iov_base = &footers[i];
+            iov[i * 3 + 2].iov_len = sizeof(footers[i]);
+        }
+
+        pthread_mutex_lock(&netframe_send_lock);
+        ret = netframe_write(network_data->socket, iov, count * 3);
+        pthread_mutex_unlock(&netframe_send_lock);
+        if (ret < 0)
+        {
+            erprintlf(errno);
+        }
+    }
+
+    if (ret < 0)
+    {
+        gs_metric_add(GS_CTR_NET_ERRORS, 1);
+    }
+    else
+    {
+        gs_metric_add(GS_CTR_NET_FRAMES, count);
+        gs_metric_add(GS_CTR_NET_BYTES, ret);
+    }
+    return ret;
+}
+
+void gs_netframe_disconnect(NetData *network_data, const char *reason)
+{
+    pthread_mutex_lock(&netframe_send_lock);
+    network_data->connection_ready = false;
+    if (network_data->socket >= 0)
+    {
+        close(network_data->socket);
+        network_data->socket = -1;
+    }
+    snprintf(network_data->disconnect_reason, sizeof(network_data->disconnect_reason), "%s", reason);
+    pthread_mutex_unlock(&netframe_send_lock);
+}
+
+void gs_netframe_rx_reset(gs_netframe_rx_t *rx)
+{
+    rx->len = 0;
+    rx->consumed = 0;
+}
+
+ssize_t gs_netframe_recv(NetData *network_data, gs_netframe_rx_t *rx)
+{
+    if (rx->consumed > 0)
+    {
+        // Frames are small next to the buffer, so the leftover partial frame is a short move.
+        memmove(rx->buf, rx->buf + rx->consumed, rx->len - rx->consumed);
+        rx->len -= rx->consumed;
+        rx->consumed = 0;
+    }
+
+    ssize_t ret;
+    do
+    {
+        ret = recv(network_data->socket, rx->buf + rx->len, sizeof(rx->buf) - rx->len, MSG_DONTWAIT);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret == 0)
+    {
+        return -404;
+    }
+    if (ret < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    rx->len += ret;
+    return ret;
+}
+
+int gs_netframe_next(gs_netframe_rx_t *rx, const gs_netframe_header_t **header, const uint8_t **payload)
+{
+    while (rx->len - rx->consumed >= sizeof(gs_netframe_header_t))
+    {
+        const uint8_t *frame = rx->buf + rx->consumed;
+        const gs_netframe_header_t *hdr = (const gs_netframe_header_t *)frame;
+
+        if (hdr->guid != GS_NETFRAME_GUID || hdr->payload_size < 0 ||
+            (size_t)hdr->payload_size > GS_NETFRAME_RX_SIZE - sizeof(gs_netframe_header_t) - sizeof(gs_netframe_footer_t))
+        {
+            dbprintlf(RED_FG "Bad frame header (guid 0x%04x, %d byte payload).", hdr->guid, hdr->payload_size);
+            return -1;
+        }
+
+        size_t total = sizeof(gs_netframe_header_t) + hdr->payload_size + sizeof(gs_netframe_footer_t);
+        if (rx->len - rx->consumed < total)
+        {
+            return 0;
+        }
+
+        const gs_netframe_footer_t *ftr = (const gs_netframe_footer_t *)(frame + total - sizeof(gs_netframe_footer_t));
+        if (ftr->termination != GS_NETFRAME_TERMINATOR)
+        {
+            dbprintlf(RED_FG "Bad frame terminator 0x%04x.", ftr->termination);
+            return -1;
+        }
+        rx->consumed += total;
+
+        uint16_t crc = gs_crc16(GS_CRC16_INIT, frame + sizeof(gs_netframe_header_t), hdr->payload_size);
+        if (crc != hdr->crc1 || crc != ftr->crc2)
+        {
+            rx->bad_crc++;
+            dbprintlf(YELLOW_FG "Dropping frame with bad CRC (0x%04x, expected 0x%04x).", hdr->crc1, crc);
+            continue;
+        }
+
+        rx->frames++;
+        *header = hdr;
+        *payload = frame + sizeof(gs_netframe_header_t);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file gs_pipeline.cpp
+ * @brief Bounded hand-off between the receive, persist and forward stages.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include "gs_pipeline.hpp"
+#include "gs_config.hpp"
+#include "meb_debug.hpp"
+
+gs_stage_policy_t gs_stage_policy_env(const char *name, gs_stage_policy_t fallback)
+{
+    const char *val = gs_env_str(name, NULL);
+    if (val == NULL)
+    {
+        return fallback;
+    }
+    if (strcasecmp(val, "drop") == 0)
+    {
+        return GS_STAGE_DROP;
+    }
+    if (strcasecmp(val, "block") == 0)
+    {
+        return GS_STAGE_BLOCK;
+    }
+    dbprintlf(YELLOW_FG "Ignoring invalid %s=\"%s\", expected drop or block.", name, val);
+    return fallback;
+}
+
+int gs_stage_init(gs_stage_t *stage, const char *name, int depth, gs_stage_policy_t policy, int block_ms)
+{
+    snprintf(stage->name, sizeof(stage->name), "%s", name);
+    stage->policy = policy;
+    stage->block_ms = block_ms;
+    stage->waiting = false;
+    stage->space_waiting = false;
+    stage->efd = -1;
+    stage->space_efd = -1;
+    stage->pushed = 0;
+    stage->dropped = 0;
+    stage->high_water = 0;
+
+    if (stage->ring.init(depth > 0 ? depth : 1) < 0)
+    {
+        dbprintlf(RED_FG "Failed to allocate the %s stage ring.", name);
+        return -1;
+    }
+
+    stage->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    stage->space_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stage->efd < 0 || stage->space_efd < 0)
+    {
+        erprintlf(errno);
+        return -1;
+    }
+
+    dbprintlf(GREEN_FG "%s stage: depth %u, %s when full.", name, stage->ring.capacity(), policy == GS_STAGE_BLOCK ? "block" : "drop");
+    return 1;
+}
+
+static inline void stage_notify(gs_stage_t *stage)
+{
+    if (stage->waiting.load(std::memory_order_seq_cst))
+    {
+        uint64_t one = 1;
+        ssize_t ret = write(stage->efd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+/**
+ * @brief Pops for the consumer, and wakes a producer waiting for the room it leaves.
+ *
+ */
+static inline bool stage_pop(gs_stage_t *stage, gs_buf_t **buf)
+{
+    if (!stage->ring.pop(buf))
+    {
+        return false;
+    }
+    if (stage->space_waiting.load(std::memory_order_seq_cst))
+    {
+        uint64_t one = 1;
+        ssize_t ret = write(stage->space_efd, &one, sizeof(one));
+        (void)ret;
+    }
+    return true;
+}
+
+/**
+ * @brief Sleeps until the consumer makes room or block_ms passes, then tries once more.
+ *
+ */
+static bool stage_push_wait(gs_stage_t *stage, gs_buf_t *buf)
+{
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool queued = false;
+    while (!queued)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t left_ms = stage->block_ms - ((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000);
+        if (left_ms <= 0)
+        {
+            break;
+        }
+
+        // Announce we are going to sleep, then look once more before doing so.
+        stage->space_waiting.store(true, std::memory_order_seq_cst);
+        stage_notify(stage);
+        queued = stage->ring.push(buf);
+        if (!queued)
+        {
+            struct pollfd pfd = {stage->space_efd, POLLIN, 0};
+            if (poll(&pfd, 1, (int)left_ms) > 0)
+            {
+                uint64_t count;
+                ssize_t ret = read(stage->space_efd, &count, sizeof(count));
+                (void)ret;
+            }
+            queued = stage->ring.push(buf);
+        }
+        stage->space_waiting.store(false, std::memory_order_relaxed);
+    }
+    return queued;
+}
+
+int gs_stage_push(gs_stage_t *stage, gs_buf_t *buf)
+{
+    gs_buf_ref(buf);
+
+    bool queued = stage->ring.push(buf);
+    if (!queued && stage->policy == GS_STAGE_BLOCK)
+    {
+        queued = stage_push_wait(stage, buf);
+    }
+
+    if (!queued)
+    {
+        gs_buf_release(buf);
+        stage->dropped++;
+        return -1;
+    }
+
+    stage->pushed++;
+    uint32_t occupancy = stage->ring.size();
+    if (occupancy > stage->high_water.load(std::memory_order_relaxed))
+    {
+        stage->high_water = occupancy;
+    }
+
+    stage_notify(stage);
+    return 1;
+}
+
+gs_buf_t *gs_stage_try_pop(gs_stage_t *stage)
+{
+    gs_buf_t *buf = NULL;
+    return stage_pop(stage, &buf) ? buf : NULL;
+}
+
+gs_buf_t *gs_stage_pop(gs_stage_t *stage, int timeout_ms)
+{
+    gs_buf_t *buf = NULL;
+    if (stage_pop(stage, &buf))
+    {
+        return buf;
+    }
+
+    // Announce we are going to sleep, then look once more before doing so.
+    stage->waiting.store(true, std::memory_order_seq_cst);
+    if (stage_pop(stage, &buf))
+    {
+        stage->waiting.store(false, std::memory_order_relaxed);
+        return buf;
+    }
+
+    struct pollfd pfd = {stage->efd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) > 0)
+    {
+        uint64_t count;
+        ssize_t ret = read(stage->efd, &count, sizeof(count));
+        (void)ret;
+    }
+    stage->waiting.store(false, std::memory_order_relaxed);
+
+    return stage_pop(stage, &buf) ? buf : NULL;
+}
+
+void gs_stage_wake(gs_stage_t *stage)
+{
+    uint64_t one = 1;
+    ssize_t ret = write(stage->efd, &one, sizeof(one));
+    (void)ret;
+}
+
+uint32_t gs_stage_occupancy(const gs_stage_t *stage)
+{
+    return stage->ring.size();
+}
+
+void gs_stage_destroy(gs_stage_t *stage)
+{
+    gs_buf_t *buf = NULL;
+    while (stage->ring.pop(&buf))
+    {
+        gs_buf_release(buf);
+    }
+    if (stage->efd >= 0)
+    {
+        close(stage->efd);
+        stage->efd = -1;
+    }
+    if (stage->space_efd >= 0)
+    {
+        close(stage->space_efd);
+        stage->space_efd = -1;
+    }
+}
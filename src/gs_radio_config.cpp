@@ -0,0 +1,254 @@
+/**
+ * @file gs_radio_config.cpp
+ * @brief Diff-based, transactional application of XBAND_CONFIG frames.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gs_radio_config.hpp"
+#include "gs_haystack.hpp"
+#include "gs_metrics.hpp"
+#include "meb_debug.hpp"
+
+static_assert(sizeof(((phy_status_t *)0)->config_field_us) / sizeof(uint32_t) == GS_CONFIG_NUM_FIELDS, "phy_status_t.config_field_us must hold every gs_config_field_t");
+
+static const char *rc_field_names[GS_CONFIG_NUM_FIELDS] = {"filter", "samp", "bw", "gain mode", "LO", "TX gain", "mode"};
+static const char *rc_ensm_names[] = {"sleep", "fdd", "tdd"};
+
+static inline uint64_t rc_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+int gs_radio_config_init(gs_radio_config_t *rc)
+{
+    if (pthread_mutex_init(&rc->lock, NULL) != 0)
+    {
+        return -1;
+    }
+    memset(&rc->applied, 0x0, sizeof(rc->applied));
+    rc->have_applied = false;
+    rc->changed = 0;
+    rc->done = 0;
+    rc->failed = 0;
+    rc->rolled_back = 0;
+    rc->unknown = 0;
+    rc->pass_us = 0;
+    memset(rc->field_us, 0x0, sizeof(rc->field_us));
+    return 1;
+}
+
+static bool rc_field_changed(const phy_config_t *a, const phy_config_t *b, int field)
+{
+    switch (field)
+    {
+    case GS_CONFIG_FILTER:
+        return strncmp(a->ftr_name, b->ftr_name, sizeof(a->ftr_name)) != 0;
+    case GS_CONFIG_SAMP:
+        return a->samp != b->samp;
+    case GS_CONFIG_BW:
+        return a->bw != b->bw;
+    case GS_CONFIG_GAINMODE:
+        return strncmp(a->curr_gainmode, b->curr_gainmode, sizeof(a->curr_gainmode)) != 0;
+    case GS_CONFIG_LO:
+        return a->LO != b->LO;
+    case GS_CONFIG_TX_GAIN:
+        return false; // Fixed, see GS_RADIO_CONFIG_TX_GAIN.
+    case GS_CONFIG_MODE:
+        return a->mode != b->mode;
+    }
+    return false;
+}
+
+static int rc_load_filter(gs_chain_t *chain, const char *name)
+{
+    if (name[0] == '\0')
+    {
+        // No filter requested; leave whatever is loaded.
+        return 1;
+    }
+    return gs_ftr_apply(chain->global->ftr, chain, name);
+}
+
+static int rc_write_field(gs_chain_t *chain, const phy_config_t *config, int field)
+{
+    gs_radio_attrs_t attrs;
+    memset(&attrs, 0x0, sizeof(attrs));
+    uint32_t mask = 0;
+
+    switch (field)
+    {
+    case GS_CONFIG_FILTER:
+        return rc_load_filter(chain, config->ftr_name);
+    case GS_CONFIG_SAMP:
+        attrs.samp = config->samp;
+        mask = GS_RADIO_SAMP;
+        break;
+    case GS_CONFIG_BW:
+        attrs.rx_bw = config->bw;
+        mask = GS_RADIO_RX_BW;
+        break;
+    case GS_CONFIG_GAINMODE:
+        snprintf(attrs.rx_gainmode, sizeof(attrs.rx_gainmode), "%s", strncmp("fast_attack", config->curr_gainmode, sizeof(config->curr_gainmode)) ? "slow_attack" : "fast_attack");
+        mask = GS_RADIO_RX_GAINMODE;
+        break;
+    case GS_CONFIG_LO:
+        attrs.rx_lo = config->LO;
+        mask = GS_RADIO_RX_LO;
+        break;
+    case GS_CONFIG_TX_GAIN:
+        attrs.tx_gain = GS_RADIO_CONFIG_TX_GAIN;
+        mask = GS_RADIO_TX_GAIN;
+        break;
+    case GS_CONFIG_MODE:
+        snprintf(attrs.ensm_mode, sizeof(attrs.ensm_mode), "%s", rc_ensm_names[config->mode]);
+        mask = GS_RADIO_ENSM_MODE;
+        break;
+    }
+
+    int done = chain->backend->radio_write_attrs(chain, &attrs, mask);
+    return (done >= 0 && (done & mask)) ? 1 : -1;
+}
+
+int gs_radio_config_apply(gs_chain_t *chain, const phy_config_t *config)
+{
+    gs_radio_config_t *rc = chain->radio_config;
+    uint64_t pass_start = rc_now_us();
+
+    uint16_t changed = 0;
+    for (int field = 0; field < GS_CONFIG_NUM_FIELDS; field++)
+    {
+        if (!rc->have_applied || rc_field_changed(&rc->applied, config, field))
+        {
+            changed |= GS_CONFIG_BIT(field);
+        }
+    }
+
+    uint16_t done = 0;
+    uint16_t failed = 0;
+    uint16_t rolled_back = 0;
+    uint16_t tried = 0;
+    uint32_t field_us[GS_CONFIG_NUM_FIELDS] = {0};
+
+    if ((changed & GS_CONFIG_BIT(GS_CONFIG_MODE)) && (config->mode < SLEEP || config->mode > TDD))
+    {
+        dbprintlf(RED_FG "Rejecting configuration with invalid mode %d.", config->mode);
+        failed = GS_CONFIG_BIT(GS_CONFIG_MODE);
+    }
+    else if ((changed & GS_CONFIG_BIT(GS_CONFIG_FILTER)) && config->ftr_name[0] != '\0' && gs_ftr_find(chain->global->ftr, config->ftr_name) == NULL)
+    {
+        dbprintlf(RED_FG "Rejecting configuration with unknown filter \"%.*s\".", (int)sizeof(config->ftr_name), config->ftr_name);
+        failed = GS_CONFIG_BIT(GS_CONFIG_FILTER);
+    }
+
+    for (int field = 0; field < GS_CONFIG_NUM_FIELDS && failed == 0; field++)
+    {
+        if (!(changed & GS_CONFIG_BIT(field)))
+        {
+            continue;
+        }
+
+        uint64_t start = rc_now_us();
+        tried |= GS_CONFIG_BIT(field);
+        int ret = rc_write_field(chain, config, field);
+        field_us[field] = rc_now_us() - start;
+
+        if (ret < 0)
+        {
+            dbprintlf(RED_FG "Failed to apply %s, rolling back.", rc_field_names[field]);
+            failed = GS_CONFIG_BIT(field);
+            break;
+        }
+        done |= GS_CONFIG_BIT(field);
+    }
+
+    if (failed && rc->have_applied)
+    {
+        for (int field = GS_CONFIG_NUM_FIELDS - 1; field >= 0; field--)
+        {
+            if ((done & GS_CONFIG_BIT(field)) && rc_write_field(chain, &rc->applied, field) >= 0)
+            {
+                rolled_back |= GS_CONFIG_BIT(field);
+            }
+        }
+    }
+
+    uint16_t unknown = 0;
+    if (!failed)
+    {
+        rc->applied = *config;
+        rc->have_applied = true;
+        chain->rx_LO = config->LO;
+        chain->rx_samp = config->samp;
+        chain->rx_bw = config->bw;
+    }
+    else if (!rc->have_applied)
+    {
+        // Nothing to roll back to; the partly written fields stay and are rewritten next time.
+        dbprintlf(YELLOW_FG "No previous configuration to restore.");
+        unknown = tried;
+    }
+    else if (rolled_back != done)
+    {
+        // applied no longer describes the radio, so diffing against it would skip the fields still wrong.
+        unknown = tried & ~rolled_back;
+        dbprintlf(RED_FG "Could not restore 0x%02x; every field will be rewritten next time.", unknown);
+        rc->have_applied = false;
+    }
+
+    uint64_t pass_end = rc_now_us();
+    uint32_t pass_us = pass_end - pass_start;
+    gs_metric_time(GS_HIST_CONFIG_APPLY, (pass_end - pass_start) * 1000);
+    gs_metric_add(GS_CTR_CONFIG_PASSES, 1);
+    if (failed)
+    {
+        gs_metric_add(GS_CTR_CONFIG_FAILURES, 1);
+    }
+
+    pthread_mutex_lock(&rc->lock);
+    rc->changed = changed;
+    rc->done = done;
+    rc->failed = failed;
+    rc->rolled_back = rolled_back;
+    rc->unknown = failed ? rc->unknown | unknown : 0;
+    rc->pass_us = pass_us;
+    memcpy(rc->field_us, field_us, sizeof(field_us));
+    pthread_mutex_unlock(&rc->lock);
+
+    if (failed)
+    {
+        return -1;
+    }
+    dbprintlf(GREEN_FG "Applied configuration: 0x%02x changed, %u us.", changed, pass_us);
+    return 1;
+}
+
+void gs_radio_config_report(gs_radio_config_t *rc, phy_status_t *status)
+{
+    pthread_mutex_lock(&rc->lock);
+    status->config_changed = rc->changed;
+    status->config_applied = rc->done;
+    status->config_failed = rc->failed;
+    status->config_rolled_back = rc->rolled_back;
+    status->config_unknown = rc->unknown;
+    status->config_pass_us = rc->pass_us;
+    for (int field = 0; field < GS_CONFIG_NUM_FIELDS; field++)
+    {
+        status->config_field_us[field] = rc->field_us[field];
+    }
+    pthread_mutex_unlock(&rc->lock);
+}
+
+void gs_radio_config_destroy(gs_radio_config_t *rc)
+{
+    pthread_mutex_destroy(&rc->lock);
+}
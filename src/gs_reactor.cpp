@@ -0,0 +1,471 @@
+/**
+ * @file gs_reactor.cpp
+ * @brief Single-threaded epoll event loop for the server connection.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "gs_reactor.hpp"
+#include "gs_haystack.hpp"
+#include "gs_config.hpp"
+#include "gs_netframe.hpp"
+#include "gs_metrics.hpp"
+#include "meb_debug.hpp"
+
+typedef enum
+{
+    REACTOR_SOCKET = 0,
+    REACTOR_POLL,
+    REACTOR_STATUS,
+    REACTOR_KICK,
+    REACTOR_CONNECT,
+    REACTOR_IDLE,
+    REACTOR_STATS,
+    REACTOR_METRICS,
+} reactor_source_t;
+
+#define REACTOR_MAX_EVENTS 8
+
+// Events carry their source in the low byte and, for per-chain sources, the chain above it.
+#define REACTOR_EVENT(source, chain) ((uint32_t)(source) | ((uint32_t)(chain) << 8))
+#define REACTOR_EVENT_SOURCE(u32) ((reactor_source_t)((u32) & 0xff))
+#define REACTOR_EVENT_CHAIN(u32) ((int)((u32) >> 8))
+
+static int reactor_add_chain(gs_reactor_t *reactor, int fd, reactor_source_t source, int chain)
+{
+    struct epoll_event ev;
+    memset(&ev, 0x0, sizeof(ev));
+    ev.events = source == REACTOR_SOCKET ? (EPOLLIN | EPOLLRDHUP) : EPOLLIN;
+    ev.data.u32 = REACTOR_EVENT(source, chain);
+    return epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static int reactor_add(gs_reactor_t *reactor, int fd, reactor_source_t source)
+{
+    return reactor_add_chain(reactor, fd, source, 0);
+}
+
+/**
+ * @brief Arms a timer to fire after first_ms, then every interval_ms (0 for one-shot).
+ *
+ */
+static void reactor_arm(int tfd, long first_ms, long interval_ms)
+{
+    struct itimerspec spec;
+    // A zero it_value disarms, so "now" is one nanosecond.
+    spec.it_value.tv_sec = first_ms / 1000;
+    spec.it_value.tv_nsec = first_ms > 0 ? (first_ms % 1000) * 1000000L : 1;
+    spec.it_interval.tv_sec = interval_ms / 1000;
+    spec.it_interval.tv_nsec = (interval_ms % 1000) * 1000000L;
+    timerfd_settime(tfd, 0, &spec, NULL);
+}
+
+static void reactor_disarm(int tfd)
+{
+    struct itimerspec spec;
+    memset(&spec, 0x0, sizeof(spec));
+    timerfd_settime(tfd, 0, &spec, NULL);
+}
+
+static void reactor_drain(int fd)
+{
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+    {
+        erprintlf(errno);
+    }
+}
+
+int gs_reactor_init(gs_reactor_t *reactor, global_data_t *global)
+{
+    reactor->epfd = epoll_create1(EPOLL_CLOEXEC);
+    reactor->poll_tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    reactor->status_tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    reactor->connect_tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    reactor->idle_tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    reactor->stats_tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    reactor->metrics_fd = -1;
+    reactor->sock = -1;
+    reactor->idle_sec = gs_env_int("HAYSTACK_NET_IDLE_SEC", RECV_TIMEOUT);
+    reactor->stats_sec = gs_env_int("HAYSTACK_STATS_SEC", GS_METRICS_DEFAULT_FRAME_SEC);
+    gs_backoff_init(reactor->connect_backoff, (uint32_t)gs_metrics_now_ns());
+    memset(reactor->last_status, 0x0, sizeof(reactor->last_status));
+    memset(reactor->last_send, 0x0, sizeof(reactor->last_send));
+    memset(reactor->rx, 0x0, sizeof(gs_netframe_rx_t));
+
+    if (reactor->epfd < 0 || reactor->poll_tfd < 0 || reactor->status_tfd < 0 || reactor->connect_tfd < 0 ||
+        reactor->idle_tfd < 0 || reactor->stats_tfd < 0 ||
+        reactor_add(reactor, reactor->poll_tfd, REACTOR_POLL) < 0 ||
+        reactor_add(reactor, reactor->status_tfd, REACTOR_STATUS) < 0 ||
+        reactor_add(reactor, reactor->connect_tfd, REACTOR_CONNECT) < 0 ||
+        reactor_add(reactor, reactor->idle_tfd, REACTOR_IDLE) < 0 ||
+        reactor_add(reactor, reactor->stats_tfd, REACTOR_STATS) < 0)
+    {
+        erprintlf(errno);
+        gs_reactor_destroy(reactor);
+        return -1;
+    }
+    for (int i = 0; i < global->num_chains; i++)
+    {
+        if (reactor_add_chain(reactor, global->chain[i].status->kick_fd, REACTOR_KICK, i) < 0)
+        {
+            erprintlf(errno);
+            gs_reactor_destroy(reactor);
+            return -1;
+        }
+    }
+
+    const char *metrics_path = gs_env_str("HAYSTACK_METRICS_SOCKET", GS_METRICS_DEFAULT_SOCKET);
+    if (strcmp(metrics_path, "none") != 0)
+    {
+        reactor->metrics_fd = gs_metrics_listen(metrics_path);
+        if (reactor->metrics_fd >= 0 && reactor_add(reactor, reactor->metrics_fd, REACTOR_METRICS) < 0)
+        {
+            erprintlf(errno);
+            close(reactor->metrics_fd);
+            reactor->metrics_fd = -1;
+        }
+        if (reactor->metrics_fd < 0)
+        {
+            dbprintlf(YELLOW_FG "Metrics will only be sent to the server.");
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Registers a freshly connected socket and restarts the per-connection state.
+ *
+ */
+static int reactor_attach(gs_reactor_t *reactor, global_data_t *global)
+{
+    reactor->sock = global->network_data->socket;
+    if (reactor_add(reactor, reactor->sock, REACTOR_SOCKET) < 0)
+    {
+        erprintlf(errno);
+        reactor->sock = -1;
+        return -1;
+    }
+    gs_netframe_rx_reset(reactor->rx);
+    if (reactor->idle_sec > 0)
+    {
+        reactor_arm(reactor->idle_tfd, reactor->idle_sec * 1000L, 0);
+    }
+
+    // The first status frame on a new connection always goes out.
+    memset(reactor->last_send, 0x0, sizeof(reactor->last_send));
+    return 1;
+}
+
+/**
+ * @brief Stops watching the socket, leaving the connection itself alone.
+ *
+ */
+static void reactor_release(gs_reactor_t *reactor)
+{
+    if (reactor->sock >= 0)
+    {
+        epoll_ctl(reactor->epfd, EPOLL_CTL_DEL, reactor->sock, NULL);
+        reactor->sock = -1;
+    }
+    reactor_disarm(reactor->idle_tfd);
+}
+
+static void reactor_disconnect(gs_reactor_t *reactor, global_data_t *global, const char *reason)
+{
+    reactor_release(reactor);
+    gs_netframe_disconnect(global->network_data, reason);
+    reactor_arm(reactor->connect_tfd, gs_backoff_next_ms(reactor->connect_backoff), 0);
+}
+
+static bool reactor_connect(gs_reactor_t *reactor, global_data_t *global)
+{
+    if (gs_connect_to_server(global->network_data) != 1)
+    {
+        int ms = gs_backoff_next_ms(reactor->connect_backoff);
+        dbprintlf(RED_FG "Failed to establish connection to server, retrying in %d ms.", ms);
+        reactor_arm(reactor->connect_tfd, ms, 0);
+        return false;
+    }
+    if (reactor_attach(reactor, global) < 0)
+    {
+        reactor_disconnect(reactor, global, "EPOLL-FAILED");
+        return false;
+    }
+    dbprintlf(GREEN_FG "Connected to server.");
+    gs_startup_ready(global->startup, GS_STARTUP_SERVER, -1, reactor->connect_backoff->attempts + 1);
+    gs_backoff_reset(reactor->connect_backoff);
+    return true;
+}
+
+static void reactor_receive_failed(gs_reactor_t *reactor, global_data_t *global, ssize_t read_size)
+{
+    if (read_size == -404)
+    {
+        dbprintlf(RED_BG "Connection forcibly closed by the server.");
+        reactor_disconnect(reactor, global, "SERVER-FORCED");
+    }
+    else if (errno == EAGAIN)
+    {
+        dbprintlf(YELLOW_BG "Active connection timed-out (%zd).", read_size);
+        reactor_disconnect(reactor, global, "TIMED-OUT");
+    }
+    else
+    {
+        erprintlf(errno);
+        reactor_disconnect(reactor, global, "RECV-ERROR");
+    }
+}
+
+/**
+ * @brief Reads one frame through NetFrame, for when our framing does not match its own.
+ *
+ */
+static void reactor_receive_netframe(gs_reactor_t *reactor, global_data_t *global)
+{
+    NetFrame *netframe = new NetFrame();
+    int read_size = netframe->recvFrame(global->network_data);
+    if (read_size < 0)
+    {
+        delete netframe;
+        reactor_receive_failed(reactor, global, read_size);
+        return;
+    }
+
+    if (reactor->idle_sec > 0)
+    {
+        reactor_arm(reactor->idle_tfd, reactor->idle_sec * 1000L, 0);
+    }
+
+    int payload_size = netframe->getPayloadSize();
+    unsigned char *payload = (unsigned char *)malloc(payload_size > 0 ? payload_size : 1);
+    if (payload == NULL || netframe->retrievePayload(payload, payload_size) < 0)
+    {
+        dbprintlf(RED_FG "Error retrieving data.");
+    }
+    else
+    {
+        gs_network_handle_frame(global, netframe->getType(), netframe->getDestination(), payload, payload_size);
+    }
+    free(payload);
+    delete netframe;
+}
+
+/**
+ * @brief Reads what the socket has and handles every complete frame in place.
+ *
+ */
+static void reactor_receive(gs_reactor_t *reactor, global_data_t *global)
+{
+    if (!gs_netframe_is_direct())
+    {
+        reactor_receive_netframe(reactor, global);
+        return;
+    }
+
+    ssize_t read_size = gs_netframe_recv(global->network_data, reactor->rx);
+    if (read_size < 0)
+    {
+        reactor_receive_failed(reactor, global, read_size);
+        return;
+    }
+
+    const gs_netframe_header_t *header;
+    const uint8_t *payload;
+    int ret;
+    while ((ret = gs_netframe_next(reactor->rx, &header, &payload)) > 0)
+    {
+        if (reactor->idle_sec > 0)
+        {
+            reactor_arm(reactor->idle_tfd, reactor->idle_sec * 1000L, 0);
+        }
+        gs_network_handle_frame(global, header->type, header->destination, payload, header->payload_size);
+    }
+
+    if (ret < 0)
+    {
+        // Nothing after a bad header can be trusted to start a frame.
+        reactor_disconnect(reactor, global, "BAD-FRAME");
+    }
+}
+
+static void reactor_send_stats(global_data_t *global)
+{
+    // Too large for comfort on the stack, and only this thread sends stats.
+    static gs_metrics_snapshot_t snap;
+    gs_metrics_frame_t frame;
+    gs_metrics_snapshot(&snap);
+    gs_metrics_frame(&snap, &frame);
+    gs_netframe_send(global->network_data, GS_NETTYPE_STATS, NetVertex::CLIENT, &frame, sizeof(frame));
+}
+
+void *gs_network_reactor_thread(void *args)
+{
+    global_data_t *global = (global_data_t *)args;
+    gs_reactor_t *reactor = global->reactor;
+    NetDataClient *network_data = global->network_data;
+
+    if (network_data->connection_ready)
+    {
+        reactor_attach(reactor, global);
+    }
+    else
+    {
+        reactor_arm(reactor->connect_tfd, 0, 0);
+    }
+    reactor_arm(reactor->poll_tfd, network_data->polling_rate * 1000L, network_data->polling_rate * 1000L);
+    reactor_arm(reactor->status_tfd, network_data->polling_rate * 1000L, network_data->polling_rate * 1000L);
+    if (reactor->stats_sec > 0)
+    {
+        reactor_arm(reactor->stats_tfd, reactor->stats_sec * 1000L, reactor->stats_sec * 1000L);
+    }
+
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    while (network_data->recv_active && network_data->thread_status > 0)
+    {
+        int nfds = epoll_wait(reactor->epfd, events, REACTOR_MAX_EVENTS, -1);
+        if (nfds < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            erprintlf(errno);
+            break;
+        }
+
+        // Chains, by bit, whose status is due and which of those must be sent regardless of change.
+        uint32_t send_status = 0;
+        uint32_t kicked = 0;
+        const uint32_t all_chains = (1u << global->num_chains) - 1;
+
+        for (int i = 0; i < nfds; i++)
+        {
+            switch (REACTOR_EVENT_SOURCE(events[i].data.u32))
+            {
+            case REACTOR_SOCKET:
+            {
+                // Read first even on hangup, so the server's last frames are not lost.
+                if (reactor->sock >= 0)
+                {
+                    reactor_receive(reactor, global);
+                }
+                break;
+            }
+            case REACTOR_POLL:
+            {
+                reactor_drain(reactor->poll_tfd);
+                if (network_data->connection_ready)
+                {
+                    gs_netframe_send(network_data, NetType::POLL, NetVertex::SERVER, NULL, 0);
+                }
+                break;
+            }
+            case REACTOR_STATUS:
+            {
+                reactor_drain(reactor->status_tfd);
+                send_status = all_chains;
+                break;
+            }
+            case REACTOR_KICK:
+            {
+                int chain = REACTOR_EVENT_CHAIN(events[i].data.u32);
+                if (gs_status_take_kick(global->chain[chain].status))
+                {
+                    kicked |= 1u << chain;
+                    send_status |= 1u << chain;
+                }
+                break;
+            }
+            case REACTOR_CONNECT:
+            {
+                reactor_drain(reactor->connect_tfd);
+                if (!network_data->connection_ready && reactor_connect(reactor, global))
+                {
+                    send_status = kicked = all_chains;
+                }
+                break;
+            }
+            case REACTOR_IDLE:
+            {
+                reactor_drain(reactor->idle_tfd);
+                if (network_data->connection_ready)
+                {
+                    dbprintlf(YELLOW_BG "Active connection timed-out, nothing received in %d seconds.", reactor->idle_sec);
+                    reactor_disconnect(reactor, global, "TIMED-OUT");
+                }
+                break;
+            }
+            case REACTOR_STATS:
+            {
+                reactor_drain(reactor->stats_tfd);
+                if (network_data->connection_ready)
+                {
+                    reactor_send_stats(global);
+                }
+                break;
+            }
+            case REACTOR_METRICS:
+            {
+                gs_metrics_serve(reactor->metrics_fd);
+                break;
+            }
+            }
+        }
+
+        for (int c = 0; c < global->num_chains && network_data->connection_ready; c++)
+        {
+            if (!(send_status & (1u << c)))
+            {
+                continue;
+            }
+            if (!global->chain[c].radio_ready)
+            {
+                dbprintlf(RED_FG "Cannot send chain %d radio config: radio not ready, does not exist, or failed to initialize.", c);
+            }
+            else
+            {
+                gs_xband_status_tick(&global->chain[c], &reactor->last_status[c], &reactor->last_send[c], kicked & (1u << c));
+            }
+        }
+    }
+
+    // Keep the connection for the next run; only stop watching it.
+    reactor_release(reactor);
+    reactor_disarm(reactor->poll_tfd);
+    reactor_disarm(reactor->status_tfd);
+    reactor_disarm(reactor->connect_tfd);
+    reactor_disarm(reactor->stats_tfd);
+
+    network_data->recv_active = false;
+    dbprintlf(FATAL "DANGER! NETWORK REACTOR THREAD IS RETURNING (%d)!", network_data->thread_status);
+    if (network_data->thread_status > 0)
+    {
+        network_data->thread_status = 0;
+    }
+    return NULL;
+}
+
+void gs_reactor_destroy(gs_reactor_t *reactor)
+{
+    int *fds[] = {&reactor->epfd, &reactor->poll_tfd, &reactor->status_tfd, &reactor->connect_tfd, &reactor->idle_tfd, &reactor->stats_tfd,
+                  &reactor->metrics_fd};
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+    {
+        if (*fds[i] >= 0)
+        {
+            close(*fds[i]);
+            *fds[i] = -1;
+        }
+    }
+    reactor->sock = -1;
+}
@@ -0,0 +1,465 @@
+/**
+ * @file gs_rs.cpp
+ * @brief CCSDS Reed-Solomon (255,223) encoder and decoder.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Berlekamp-Massey, Chien search and Forney, after Phil Karn's decode_rs.
+ *
+ * The syndromes are the only part that runs for every codeword. The vector
+ * versions keep all 32 in one (AVX2) or two (SSSE3, NEON) registers and add
+ * each symbol r times the 32 root powers for its position. A GF(256) product
+ * r * c is r * (c & 0x0F) ^ r * (c & 0xF0), so with a 16 entry table of each
+ * for r, a byte shuffle indexed by the nibbles of the 32 powers multiplies
+ * them all at once. The tables for a dual basis symbol convert it as well.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include "gs_rs.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define RS_A0 GS_RS_N // Log of zero.
+#define RS_GFPOLY 0x187
+#define RS_FCR 112
+#define RS_PRIM 11
+#define RS_IPRIM 116 // RS_PRIM * RS_IPRIM = 1 mod 255.
+
+static uint8_t rs_alpha[256];                   // alpha^i; rs_alpha[RS_A0] = 0.
+static uint8_t rs_index[256];                   // log_alpha; rs_index[0] = RS_A0.
+static uint8_t rs_genpoly[GS_RS_PARITY + 1];    // Generator polynomial, log form.
+static uint8_t rs_root[GS_RS_PARITY];           // log of the generator's roots.
+static uint8_t rs_tal[256];                     // Conventional to dual basis.
+static uint8_t rs_tal1[256];                    // Dual to conventional basis.
+
+// [dual basis][r][n]: r * n and r * (n << 4), r converted from the dual basis first if asked.
+alignas(16) static uint8_t rs_mul_lo[2][256][16];
+alignas(16) static uint8_t rs_mul_hi[2][256][16];
+// [e][i]: low and high nibbles of root i to the power e.
+alignas(32) static uint8_t rs_pow_lo[GS_RS_N][GS_RS_PARITY];
+alignas(32) static uint8_t rs_pow_hi[GS_RS_N][GS_RS_PARITY];
+
+static inline int rs_modnn(int x)
+{
+    while (x >= GS_RS_N)
+    {
+        x -= GS_RS_N;
+        x = (x >> 8) + (x & GS_RS_N);
+    }
+    return x;
+}
+
+static inline uint8_t rs_mul(uint8_t a, uint8_t b)
+{
+    return (a == 0 || b == 0) ? 0 : rs_alpha[rs_modnn(rs_index[a] + rs_index[b])];
+}
+
+typedef void (*rs_syndromes_fn)(const uint8_t *codeword, size_t stride, int pad, bool dual_basis, uint8_t syndromes[GS_RS_PARITY]);
+
+static rs_syndromes_fn rs_syndromes = gs_rs_syndromes_scalar;
+static const char *rs_syndromes_name = "scalar";
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("ssse3"))) static void rs_syndromes_ssse3(const uint8_t *codeword, size_t stride, int pad, bool dual_basis, uint8_t syndromes[GS_RS_PARITY])
+{
+    const int len = GS_RS_N - pad;
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    for (int m = 0; m < len; m++)
+    {
+        uint8_t r = codeword[m * stride];
+        int e = len - 1 - m;
+        __m128i lo = _mm_load_si128((const __m128i *)rs_mul_lo[dual_basis][r]);
+        __m128i hi = _mm_load_si128((const __m128i *)rs_mul_hi[dual_basis][r]);
+        acc0 = _mm_xor_si128(acc0, _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_load_si128((const __m128i *)rs_pow_lo[e])),
+                                                 _mm_shuffle_epi8(hi, _mm_load_si128((const __m128i *)rs_pow_hi[e]))));
+        acc1 = _mm_xor_si128(acc1, _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_load_si128((const __m128i *)(rs_pow_lo[e] + 16))),
+                                                 _mm_shuffle_epi8(hi, _mm_load_si128((const __m128i *)(rs_pow_hi[e] + 16)))));
+    }
+    _mm_storeu_si128((__m128i *)syndromes, acc0);
+    _mm_storeu_si128((__m128i *)(syndromes + 16), acc1);
+}
+
+__attribute__((target("avx2"))) static void rs_syndromes_avx2(const uint8_t *codeword, size_t stride, int pad, bool dual_basis, uint8_t syndromes[GS_RS_PARITY])
+{
+    const int len = GS_RS_N - pad;
+    __m256i acc = _mm256_setzero_si256();
+    for (int m = 0; m < len; m++)
+    {
+        uint8_t r = codeword[m * stride];
+        int e = len - 1 - m;
+        __m256i lo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)rs_mul_lo[dual_basis][r]));
+        __m256i hi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)rs_mul_hi[dual_basis][r]));
+        acc = _mm256_xor_si256(acc, _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_load_si256((const __m256i *)rs_pow_lo[e])),
+                                                     _mm256_shuffle_epi8(hi, _mm256_load_si256((const __m256i *)rs_pow_hi[e]))));
+    }
+    _mm256_storeu_si256((__m256i *)syndromes, acc);
+}
+#endif
+
+#if defined(__ARM_NEON)
+static void rs_syndromes_neon(const uint8_t *codeword, size_t stride, int pad, bool dual_basis, uint8_t syndromes[GS_RS_PARITY])
+{
+    const int len = GS_RS_N - pad;
+#if defined(__aarch64__)
+    uint8x16_t acc0 = vdupq_n_u8(0);
+    uint8x16_t acc1 = vdupq_n_u8(0);
+    for (int m = 0; m < len; m++)
+    {
+        uint8_t r = codeword[m * stride];
+        int e = len - 1 - m;
+        uint8x16_t lo = vld1q_u8(rs_mul_lo[dual_basis][r]);
+        uint8x16_t hi = vld1q_u8(rs_mul_hi[dual_basis][r]);
+        acc0 = veorq_u8(acc0, veorq_u8(vqtbl1q_u8(lo, vld1q_u8(rs_pow_lo[e])), vqtbl1q_u8(hi, vld1q_u8(rs_pow_hi[e]))));
+        acc1 = veorq_u8(acc1, veorq_u8(vqtbl1q_u8(lo, vld1q_u8(rs_pow_lo[e] + 16)), vqtbl1q_u8(hi, vld1q_u8(rs_pow_hi[e] + 16))));
+    }
+    vst1q_u8(syndromes, acc0);
+    vst1q_u8(syndromes + 16, acc1);
+#else
+    // ARMv7 (the Zynq's Cortex-A9): vtbl2 looks up 8 lanes in a 16 byte table.
+    uint8x8_t acc[4] = {vdup_n_u8(0), vdup_n_u8(0), vdup_n_u8(0), vdup_n_u8(0)};
+    for (int m = 0; m < len; m++)
+    {
+        uint8_t r = codeword[m * stride];
+        int e = len - 1 - m;
+        uint8x8x2_t lo = {{vld1_u8(rs_mul_lo[dual_basis][r]), vld1_u8(rs_mul_lo[dual_basis][r] + 8)}};
+        uint8x8x2_t hi = {{vld1_u8(rs_mul_hi[dual_basis][r]), vld1_u8(rs_mul_hi[dual_basis][r] + 8)}};
+        for (int g = 0; g < 4; g++)
+        {
+            acc[g] = veor_u8(acc[g], veor_u8(vtbl2_u8(lo, vld1_u8(rs_pow_lo[e] + 8 * g)), vtbl2_u8(hi, vld1_u8(rs_pow_hi[e] + 8 * g))));
+        }
+    }
+    for (int g = 0; g < 4; g++)
+    {
+        vst1_u8(syndromes + 8 * g, acc[g]);
+    }
+#endif
+}
+#endif
+
+static struct rs_tables_init
+{
+    rs_tables_init()
+    {
+        int sr = 1;
+        rs_index[0] = RS_A0;
+        rs_alpha[RS_A0] = 0;
+        for (int i = 0; i < GS_RS_N; i++)
+        {
+            rs_index[sr] = i;
+            rs_alpha[i] = sr;
+            sr <<= 1;
+            if (sr & 0x100)
+            {
+                sr ^= RS_GFPOLY;
+            }
+            sr &= 0xFF;
+        }
+
+        uint8_t genpoly[GS_RS_PARITY + 1];
+        genpoly[0] = 1;
+        for (int i = 0, root = RS_FCR * RS_PRIM; i < GS_RS_PARITY; i++, root += RS_PRIM)
+        {
+            rs_root[i] = rs_modnn(root);
+            genpoly[i + 1] = 1;
+            for (int j = i; j > 0; j--)
+            {
+                genpoly[j] = genpoly[j] != 0 ? genpoly[j - 1] ^ rs_alpha[rs_modnn(rs_index[genpoly[j]] + root)] : genpoly[j - 1];
+            }
+            genpoly[0] = rs_alpha[rs_modnn(rs_index[genpoly[0]] + root)];
+        }
+        for (int i = 0; i <= GS_RS_PARITY; i++)
+        {
+            rs_genpoly[i] = rs_index[genpoly[i]];
+        }
+
+        // Rows of the CCSDS 131.0-B basis conversion matrix.
+        static const uint8_t tal[8] = {0x8D, 0xEF, 0xEC, 0x86, 0xFA, 0x99, 0xAF, 0x7B};
+        for (int i = 0; i < 256; i++)
+        {
+            uint8_t t = 0;
+            for (int k = 0; k < 8; k++)
+            {
+                if (i & (1 << k))
+                {
+                    t ^= tal[7 - k];
+                }
+            }
+            rs_tal[i] = t;
+            rs_tal1[t] = i;
+        }
+
+        for (int dual = 0; dual < 2; dual++)
+        {
+            for (int r = 0; r < 256; r++)
+            {
+                uint8_t conv = dual ? rs_tal1[r] : r;
+                for (int n = 0; n < 16; n++)
+                {
+                    rs_mul_lo[dual][r][n] = rs_mul(conv, n);
+                    rs_mul_hi[dual][r][n] = rs_mul(conv, n << 4);
+                }
+            }
+        }
+        for (int e = 0; e < GS_RS_N; e++)
+        {
+            for (int i = 0; i < GS_RS_PARITY; i++)
+            {
+                uint8_t c = rs_alpha[(rs_root[i] * e) % GS_RS_N];
+                rs_pow_lo[e][i] = c & 0x0F;
+                rs_pow_hi[e][i] = c >> 4;
+            }
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2"))
+        {
+            rs_syndromes = rs_syndromes_avx2;
+            rs_syndromes_name = "avx2";
+        }
+        else if (__builtin_cpu_supports("ssse3"))
+        {
+            rs_syndromes = rs_syndromes_ssse3;
+            rs_syndromes_name = "ssse3";
+        }
+#elif defined(__ARM_NEON)
+        rs_syndromes = rs_syndromes_neon;
+        rs_syndromes_name = "neon";
+#endif
+    }
+} rs_tables_init_once;
+
+void gs_rs_syndromes_scalar(const uint8_t *codeword, size_t stride, int pad, bool dual_basis, uint8_t syndromes[GS_RS_PARITY])
+{
+    const int len = GS_RS_N - pad;
+    memset(syndromes, 0x0, GS_RS_PARITY);
+    for (int m = 0; m < len; m++)
+    {
+        uint8_t r = dual_basis ? rs_tal1[codeword[m * stride]] : codeword[m * stride];
+        for (int i = 0; i < GS_RS_PARITY; i++)
+        {
+            syndromes[i] = syndromes[i] == 0 ? r : r ^ rs_alpha[rs_modnn(rs_index[syndromes[i]] + rs_root[i])];
+        }
+    }
+}
+
+void gs_rs_syndromes(const uint8_t *codeword, size_t stride, int pad, bool dual_basis, uint8_t syndromes[GS_RS_PARITY])
+{
+    rs_syndromes(codeword, stride, pad, dual_basis, syndromes);
+}
+
+const char *gs_rs_syndromes_name()
+{
+    return rs_syndromes_name;
+}
+
+void gs_rs_encode(uint8_t *codeword, size_t stride, int pad, bool dual_basis)
+{
+    const int len = GS_RS_K - pad;
+    uint8_t bb[GS_RS_PARITY];
+    memset(bb, 0x0, sizeof(bb));
+
+    for (int m = 0; m < len; m++)
+    {
+        uint8_t d = dual_basis ? rs_tal1[codeword[m * stride]] : codeword[m * stride];
+        int feedback = rs_index[d ^ bb[0]];
+        if (feedback != RS_A0)
+        {
+            for (int j = 1; j < GS_RS_PARITY; j++)
+            {
+                bb[j] ^= rs_alpha[rs_modnn(feedback + rs_genpoly[GS_RS_PARITY - j])];
+            }
+        }
+        memmove(&bb[0], &bb[1], GS_RS_PARITY - 1);
+        bb[GS_RS_PARITY - 1] = feedback != RS_A0 ? rs_alpha[rs_modnn(feedback + rs_genpoly[0])] : 0;
+    }
+
+    for (int j = 0; j < GS_RS_PARITY; j++)
+    {
+        codeword[(len + j) * stride] = dual_basis ? rs_tal[bb[j]] : bb[j];
+    }
+}
+
+int gs_rs_decode(uint8_t *codeword, size_t stride, int pad, bool dual_basis)
+{
+    uint8_t s[GS_RS_PARITY];
+    gs_rs_syndromes(codeword, stride, pad, dual_basis, s);
+
+    uint8_t syn_error = 0;
+    for (int i = 0; i < GS_RS_PARITY; i++)
+    {
+        syn_error |= s[i];
+        s[i] = rs_index[s[i]];
+    }
+    if (syn_error == 0)
+    {
+        return 0;
+    }
+
+    // Berlekamp-Massey: the error locator lambda(x).
+    uint8_t lambda[GS_RS_PARITY + 1];
+    uint8_t b[GS_RS_PARITY + 1];
+    uint8_t t[GS_RS_PARITY + 1];
+    memset(lambda, 0x0, sizeof(lambda));
+    lambda[0] = 1;
+    for (int i = 0; i <= GS_RS_PARITY; i++)
+    {
+        b[i] = rs_index[lambda[i]];
+    }
+
+    int el = 0;
+    for (int r = 1; r <= GS_RS_PARITY; r++)
+    {
+        uint8_t discr = 0;
+        for (int i = 0; i < r; i++)
+        {
+            if (lambda[i] != 0 && s[r - i - 1] != RS_A0)
+            {
+                discr ^= rs_alpha[rs_modnn(rs_index[lambda[i]] + s[r - i - 1])];
+            }
+        }
+        int discr_r = rs_index[discr];
+        if (discr_r == RS_A0)
+        {
+            memmove(&b[1], b, GS_RS_PARITY);
+            b[0] = RS_A0;
+            continue;
+        }
+
+        t[0] = lambda[0];
+        for (int i = 0; i < GS_RS_PARITY; i++)
+        {
+            t[i + 1] = b[i] != RS_A0 ? lambda[i + 1] ^ rs_alpha[rs_modnn(discr_r + b[i])] : lambda[i + 1];
+        }
+        if (2 * el <= r - 1)
+        {
+            el = r - el;
+            for (int i = 0; i <= GS_RS_PARITY; i++)
+            {
+                b[i] = lambda[i] == 0 ? RS_A0 : rs_modnn(rs_index[lambda[i]] - discr_r + GS_RS_N);
+            }
+        }
+        else
+        {
+            memmove(&b[1], b, GS_RS_PARITY);
+            b[0] = RS_A0;
+        }
+        memcpy(lambda, t, sizeof(lambda));
+    }
+
+    int deg_lambda = 0;
+    for (int i = 0; i <= GS_RS_PARITY; i++)
+    {
+        lambda[i] = rs_index[lambda[i]];
+        if (lambda[i] != RS_A0)
+        {
+            deg_lambda = i;
+        }
+    }
+    if (deg_lambda == 0 || deg_lambda > GS_RS_PARITY / 2)
+    {
+        return -1;
+    }
+
+    // Chien search: the roots of lambda(x) are the inverse error locations.
+    uint8_t reg[GS_RS_PARITY + 1];
+    int root[GS_RS_PARITY];
+    int loc[GS_RS_PARITY];
+    int count = 0;
+    memcpy(&reg[1], &lambda[1], GS_RS_PARITY);
+    for (int i = 1, k = RS_IPRIM - 1; i <= GS_RS_N; i++, k = rs_modnn(k + RS_IPRIM))
+    {
+        uint8_t q = 1; // lambda[0] is always 0 in log form.
+        for (int j = deg_lambda; j > 0; j--)
+        {
+            if (reg[j] != RS_A0)
+            {
+                reg[j] = rs_modnn(reg[j] + j);
+                q ^= rs_alpha[reg[j]];
+            }
+        }
+        if (q != 0)
+        {
+            continue;
+        }
+        root[count] = i;
+        loc[count] = k;
+        if (++count == deg_lambda)
+        {
+            break;
+        }
+    }
+    if (count != deg_lambda)
+    {
+        return -1;
+    }
+
+    // Forney: omega(x) = s(x) * lambda(x) mod x^32, then each error's value.
+    uint8_t omega[GS_RS_PARITY + 1];
+    int deg_omega = deg_lambda - 1;
+    for (int i = 0; i <= deg_omega; i++)
+    {
+        uint8_t tmp = 0;
+        for (int j = i; j >= 0; j--)
+        {
+            if (s[i - j] != RS_A0 && lambda[j] != RS_A0)
+            {
+                tmp ^= rs_alpha[rs_modnn(s[i - j] + lambda[j])];
+            }
+        }
+        omega[i] = rs_index[tmp];
+    }
+
+    uint8_t err[GS_RS_PARITY];
+    int corrected = 0;
+    for (int j = 0; j < count; j++)
+    {
+        uint8_t num1 = 0;
+        for (int i = deg_omega; i >= 0; i--)
+        {
+            if (omega[i] != RS_A0)
+            {
+                num1 ^= rs_alpha[rs_modnn(omega[i] + i * root[j])];
+            }
+        }
+        uint8_t num2 = rs_alpha[rs_modnn(root[j] * (RS_FCR - 1) + GS_RS_N)];
+        uint8_t den = 0;
+        // lambda[i + 1] for even i is the formal derivative of lambda(x).
+        for (int i = (deg_lambda < GS_RS_PARITY - 1 ? deg_lambda : GS_RS_PARITY - 1) & ~1; i >= 0; i -= 2)
+        {
+            if (lambda[i + 1] != RS_A0)
+            {
+                den ^= rs_alpha[rs_modnn(lambda[i + 1] + i * root[j])];
+            }
+        }
+        err[j] = 0;
+        if (num1 == 0)
+        {
+            continue;
+        }
+        // An error in the shortened-away symbols means the codeword was not decodable.
+        if (den == 0 || loc[j] < pad)
+        {
+            return -1;
+        }
+        err[j] = rs_alpha[rs_modnn(rs_index[num1] + rs_index[num2] + GS_RS_N - rs_index[den])];
+        corrected++;
+    }
+
+    for (int j = 0; j < count; j++)
+    {
+        if (err[j] != 0)
+        {
+            uint8_t *sym = codeword + (loc[j] - pad) * stride;
+            *sym = dual_basis ? rs_tal[rs_tal1[*sym] ^ err[j]] : *sym ^ err[j];
+        }
+    }
+    return corrected;
+}
@@ -0,0 +1,573 @@
+/**
+ * @file gs_rt.cpp
+ * @brief Scheduling policy, CPU affinity and memory locking for the Haystack threads.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <dirent.h>
+#include <alloca.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include "gs_rt.hpp"
+#include "gs_config.hpp"
+#include "gs_metrics.hpp"
+#include "meb_debug.hpp"
+
+#define RT_DEFAULT_PRIORITY 50 // For fifo or rr without a priority.
+
+typedef struct
+{
+    int policy;
+    int priority;
+    cpu_set_t cpus;
+    bool pinned;
+} rt_settings_t;
+
+typedef struct
+{
+    bool used;
+    gs_rt_role_t role;
+    int chain;
+    pid_t tid;
+    char sched[16]; // As applied, e.g. fifo:80.
+    char cpus[64];  // As applied, e.g. 2-3.
+} rt_thread_t;
+
+typedef struct
+{
+    gs_rt_role_t role;
+    int chain;
+    void *(*fn)(void *);
+    void *arg;
+} rt_start_t;
+
+static const char *rt_role_names[GS_RT_NUM_ROLES] = {"rx", "forward", "network", "writer", "compress", "fec", "probe"};
+static const char *rt_role_env[GS_RT_NUM_ROLES] = {"RX", "FORWARD", "NETWORK", "WRITER", "COMPRESS", "FEC", "RX"};
+static const bool rt_role_per_chain[GS_RT_NUM_ROLES] = {true, true, false, true, false, true, true};
+
+static pthread_once_t rt_once = PTHREAD_ONCE_INIT;
+static size_t rt_stack_size;  // 0 for the default.
+static cpu_set_t rt_process_cpus; // As started, e.g. by taskset.
+static cpu_set_t rt_default_cpus; // For roles without CPUs of their own.
+static bool rt_other_cpus;        // HAYSTACK_RT_OTHER_CPUS is set and usable.
+
+static pthread_mutex_t rt_lock = PTHREAD_MUTEX_INITIALIZER;
+static rt_thread_t rt_threads[GS_RT_MAX_THREADS];
+
+static pthread_t rt_probe_tid;
+static std::atomic<bool> rt_probe_running(false);
+static long rt_probe_ns;
+
+/**
+ * @brief Parses a CPU list such as "2", "2,3" or "0,4-7", keeping only CPUs the process may use.
+ *
+ * @return int Number of usable CPUs, negative if the list is malformed.
+ */
+static int rt_parse_cpus(const char *list, cpu_set_t *cpus)
+{
+    CPU_ZERO(cpus);
+    const char *p = list;
+    while (*p != '\0')
+    {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0 || first >= CPU_SETSIZE)
+        {
+            return -1;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-')
+        {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first || last >= CPU_SETSIZE)
+            {
+                return -1;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++)
+        {
+            CPU_SET(cpu, cpus);
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+        else if (*p != '\0')
+        {
+            return -1;
+        }
+    }
+    CPU_AND(cpus, cpus, &rt_process_cpus);
+    return CPU_COUNT(cpus);
+}
+
+static void rt_format_cpus(const cpu_set_t *cpus, char *buf, size_t len)
+{
+    size_t off = 0;
+    buf[0] = '\0';
+    for (int cpu = 0; cpu < CPU_SETSIZE && off < len; cpu++)
+    {
+        if (!CPU_ISSET(cpu, cpus))
+        {
+            continue;
+        }
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, cpus))
+        {
+            last++;
+        }
+        int ret = last > cpu ? snprintf(buf + off, len - off, "%s%d-%d", off ? "," : "", cpu, last)
+                             : snprintf(buf + off, len - off, "%s%d", off ? "," : "", cpu);
+        off += ret > 0 ? ret : 0;
+        cpu = last;
+    }
+}
+
+static void rt_format_sched(int policy, int priority, char *buf, size_t len)
+{
+    if (policy == SCHED_FIFO)
+    {
+        snprintf(buf, len, "fifo:%d", priority);
+    }
+    else if (policy == SCHED_RR)
+    {
+        snprintf(buf, len, "rr:%d", priority);
+    }
+    else
+    {
+        snprintf(buf, len, "other");
+    }
+}
+
+static void rt_config()
+{
+    int64_t stack_kb = gs_env_int("HAYSTACK_RT_STACK_KB", GS_RT_DEFAULT_STACK_KB);
+    rt_stack_size = stack_kb > 0 ? (size_t)stack_kb << 10 : 0;
+    if (rt_stack_size > 0 && rt_stack_size < (size_t)PTHREAD_STACK_MIN)
+    {
+        rt_stack_size = (size_t)PTHREAD_STACK_MIN;
+    }
+
+    if (sched_getaffinity(0, sizeof(rt_process_cpus), &rt_process_cpus) < 0)
+    {
+        erprintlf(errno);
+        CPU_ZERO(&rt_process_cpus);
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            CPU_SET(cpu, &rt_process_cpus);
+        }
+    }
+    rt_default_cpus = rt_process_cpus;
+
+    const char *other = gs_env_str("HAYSTACK_RT_OTHER_CPUS", NULL);
+    cpu_set_t cpus;
+    if (other != NULL)
+    {
+        if (rt_parse_cpus(other, &cpus) > 0)
+        {
+            rt_default_cpus = cpus;
+            rt_other_cpus = true;
+        }
+        else
+        {
+            dbprintlf(YELLOW_FG "Ignoring HAYSTACK_RT_OTHER_CPUS=\"%s\", which names no CPU this process may use.", other);
+        }
+    }
+}
+
+static const char *rt_env(gs_rt_role_t role, int chain, const char *setting, char *name, size_t len)
+{
+    if (rt_role_per_chain[role])
+    {
+        chain = role == GS_RT_PROBE || chain < 0 ? 0 : chain;
+        snprintf(name, len, "RT_%s_%s", rt_role_env[role], setting);
+        const char *value = gs_chain_env_str(chain, name, NULL);
+        // Named in full for the warnings.
+        snprintf(name, len, "HAYSTACK_RT_%s_%s (chain %d)", rt_role_env[role], setting, chain);
+        return value;
+    }
+    snprintf(name, len, "HAYSTACK_RT_%s_%s", rt_role_env[role], setting);
+    return gs_env_str(name, NULL);
+}
+
+static void rt_load(gs_rt_role_t role, int chain, rt_settings_t *settings)
+{
+    char name[64];
+    settings->policy = SCHED_OTHER;
+    settings->priority = 0;
+    settings->pinned = false;
+    settings->cpus = rt_default_cpus;
+
+    const char *sched = rt_env(role, chain, "SCHED", name, sizeof(name));
+    if (sched != NULL && strcasecmp(sched, "other") != 0)
+    {
+        int policy = strncasecmp(sched, "fifo", 4) == 0 ? SCHED_FIFO : strncasecmp(sched, "rr", 2) == 0 ? SCHED_RR : -1;
+        const char *colon = strchr(sched, ':');
+        int priority = colon != NULL ? atoi(colon + 1) : RT_DEFAULT_PRIORITY;
+        if (policy < 0 || priority < sched_get_priority_min(policy) || priority > sched_get_priority_max(policy))
+        {
+            dbprintlf(YELLOW_FG "Ignoring invalid %s=\"%s\", expected other, fifo:<1-99> or rr:<1-99>.", name, sched);
+        }
+        else
+        {
+            settings->policy = policy;
+            settings->priority = priority;
+        }
+    }
+
+    const char *cpus = rt_env(role, chain, "CPUS", name, sizeof(name));
+    if (cpus != NULL)
+    {
+        if (rt_parse_cpus(cpus, &settings->cpus) > 0)
+        {
+            settings->pinned = true;
+        }
+        else
+        {
+            dbprintlf(YELLOW_FG "Ignoring %s=\"%s\", which names no CPU this process may use.", name, cpus);
+            settings->cpus = rt_default_cpus;
+        }
+    }
+}
+
+/**
+ * @brief Touches len bytes of the calling thread's stack so they are resident before they are needed.
+ *
+ */
+static void __attribute__((noinline)) rt_prefault(size_t len)
+{
+    volatile uint8_t *stack = (volatile uint8_t *)alloca(len);
+    size_t page = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < len; i += page)
+    {
+        stack[i] = 0;
+    }
+}
+
+static int rt_register(gs_rt_role_t role, int chain)
+{
+    int policy;
+    struct sched_param param;
+    cpu_set_t cpus;
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+    int slot = -1;
+    pthread_mutex_lock(&rt_lock);
+    for (int i = 0; i < GS_RT_MAX_THREADS; i++)
+    {
+        if (!rt_threads[i].used)
+        {
+            slot = i;
+            rt_thread_t *t = &rt_threads[i];
+            t->used = true;
+            t->role = role;
+            t->chain = chain;
+            t->tid = syscall(SYS_gettid);
+            rt_format_sched(policy, param.sched_priority, t->sched, sizeof(t->sched));
+            rt_format_cpus(&cpus, t->cpus, sizeof(t->cpus));
+            break;
+        }
+    }
+    pthread_mutex_unlock(&rt_lock);
+    return slot;
+}
+
+static void rt_unregister(void *arg)
+{
+    int slot = (int)(intptr_t)arg;
+    if (slot < 0)
+    {
+        return;
+    }
+    pthread_mutex_lock(&rt_lock);
+    rt_threads[slot].used = false;
+    pthread_mutex_unlock(&rt_lock);
+}
+
+static void *rt_thread_start(void *args)
+{
+    rt_start_t start = *(rt_start_t *)args;
+    free(args);
+
+    if (rt_stack_size > 0)
+    {
+        // The top half; the rest is left for deep calls into libraries.
+        rt_prefault(rt_stack_size / 2);
+    }
+
+    void *ret = NULL;
+    int slot = rt_register(start.role, start.chain);
+    // Freed however the thread ends, including pthread_exit or cancellation inside a library call.
+    pthread_cleanup_push(rt_unregister, (void *)(intptr_t)slot);
+    ret = start.fn(start.arg);
+    pthread_cleanup_pop(1);
+    return ret;
+}
+
+int gs_rt_thread_create(pthread_t *tid, gs_rt_role_t role, int chain, void *(*fn)(void *), void *arg)
+{
+    pthread_once(&rt_once, rt_config);
+
+    rt_start_t *start = (rt_start_t *)malloc(sizeof(rt_start_t));
+    if (start == NULL)
+    {
+        return ENOMEM;
+    }
+    start->role = role;
+    start->chain = chain;
+    start->fn = fn;
+    start->arg = arg;
+
+    rt_settings_t settings;
+    rt_load(role, chain, &settings);
+
+    // Always explicit: a new thread would otherwise inherit its creator's policy and CPUs.
+    pthread_attr_t attr;
+    struct sched_param param;
+    memset(&param, 0x0, sizeof(param));
+    param.sched_priority = settings.priority;
+    pthread_attr_init(&attr);
+    if (rt_stack_size > 0)
+    {
+        pthread_attr_setstacksize(&attr, rt_stack_size);
+    }
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, settings.policy);
+    pthread_attr_setschedparam(&attr, &param);
+    pthread_attr_setaffinity_np(&attr, sizeof(settings.cpus), &settings.cpus);
+
+    int err = pthread_create(tid, &attr, rt_thread_start, start);
+    if (err == EPERM || err == EINVAL)
+    {
+        char sched[16], cpus[64];
+        rt_format_sched(settings.policy, settings.priority, sched, sizeof(sched));
+        rt_format_cpus(&settings.cpus, cpus, sizeof(cpus));
+        dbprintlf(YELLOW_FG "Could not start the %s thread with %s on CPUs %s (%s); using the default policy.", rt_role_names[role], sched, cpus, strerror(err));
+
+        param.sched_priority = 0;
+        pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+        pthread_attr_setschedparam(&attr, &param);
+        pthread_attr_setaffinity_np(&attr, sizeof(rt_process_cpus), &rt_process_cpus);
+        err = pthread_create(tid, &attr, rt_thread_start, start);
+    }
+    pthread_attr_destroy(&attr);
+
+    if (err != 0)
+    {
+        free(start);
+    }
+    return err;
+}
+
+static void *rt_probe_thread(void *args)
+{
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (rt_probe_running)
+    {
+        next.tv_nsec += rt_probe_ns;
+        while (next.tv_nsec >= 1000000000L)
+        {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+            ;
+
+        uint64_t due = next.tv_sec * 1000000000ULL + next.tv_nsec;
+        uint64_t now = gs_metrics_now_ns();
+        gs_metric_time(GS_HIST_SCHED_WAKEUP, now > due ? now - due : 0);
+    }
+    return NULL;
+}
+
+int gs_rt_init()
+{
+    pthread_once(&rt_once, rt_config);
+    int retval = 1;
+
+    // Threads already running (main, logging) keep off the role CPUs too.
+    if (rt_other_cpus)
+    {
+        DIR *dir = opendir("/proc/self/task");
+        struct dirent *entry;
+        while (dir != NULL && (entry = readdir(dir)) != NULL)
+        {
+            pid_t tid = atoi(entry->d_name);
+            if (tid > 0 && sched_setaffinity(tid, sizeof(rt_default_cpus), &rt_default_cpus) < 0)
+            {
+                erprintlf(errno);
+            }
+        }
+        if (dir != NULL)
+        {
+            closedir(dir);
+        }
+    }
+
+    if (gs_env_int("HAYSTACK_RT_MLOCK", 0) != 0)
+    {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0)
+        {
+            dbprintlf(RED_FG "Could not lock memory; check RLIMIT_MEMLOCK or CAP_IPC_LOCK.");
+            erprintlf(errno);
+            retval = -1;
+        }
+        else
+        {
+            dbprintlf(GREEN_FG "Memory locked.");
+        }
+    }
+
+    rt_probe_ns = gs_env_int("HAYSTACK_RT_PROBE_US", 0) * 1000L;
+    if (rt_probe_ns > 0)
+    {
+        rt_probe_running = true;
+        if (gs_rt_thread_create(&rt_probe_tid, GS_RT_PROBE, 0, rt_probe_thread, NULL) != 0)
+        {
+            dbprintlf(RED_FG "Could not start the wakeup probe.");
+            rt_probe_running = false;
+        }
+    }
+    return retval;
+}
+
+/**
+ * @brief Reads a thread's time spent waiting on a runqueue and its involuntary context switches.
+ *
+ * @return bool false if the kernel does not report them.
+ */
+static bool rt_thread_stats(pid_t tid, uint64_t *wait_ns, uint64_t *involuntary)
+{
+    char path[64];
+    unsigned long long run = 0, wait = 0, slices = 0;
+    snprintf(path, sizeof(path), "/proc/self/task/%d/schedstat", tid);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        return false;
+    }
+    bool ok = fscanf(fp, "%llu %llu %llu", &run, &wait, &slices) == 3;
+    fclose(fp);
+    *wait_ns = wait;
+
+    *involuntary = 0;
+    snprintf(path, sizeof(path), "/proc/self/task/%d/status", tid);
+    fp = fopen(path, "r");
+    if (fp != NULL)
+    {
+        char line[128];
+        while (fgets(line, sizeof(line), fp) != NULL)
+        {
+            unsigned long long n;
+            if (sscanf(line, "nonvoluntary_ctxt_switches: %llu", &n) == 1)
+            {
+                *involuntary = n;
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    return ok;
+}
+
+size_t gs_rt_format(char *buf, size_t len)
+{
+    size_t off = 0;
+#define RT_PRINT(...)                                                  \
+    do                                                                 \
+    {                                                                  \
+        if (off < len)                                                 \
+        {                                                              \
+            int ret = snprintf(buf + off, len - off, __VA_ARGS__);     \
+            off += ret > 0 ? ((size_t)ret < len - off ? ret : len - off - 1) : 0; \
+        }                                                              \
+    } while (0)
+
+    rt_thread_t threads[GS_RT_MAX_THREADS];
+    pthread_mutex_lock(&rt_lock);
+    memcpy(threads, rt_threads, sizeof(threads));
+    pthread_mutex_unlock(&rt_lock);
+
+    RT_PRINT("# HELP haystack_thread_runqueue_wait_seconds_total Time the thread was runnable but waiting for a CPU.\n"
+             "# TYPE haystack_thread_runqueue_wait_seconds_total counter\n");
+    for (int i = 0; i < GS_RT_MAX_THREADS; i++)
+    {
+        uint64_t wait_ns, involuntary;
+        if (threads[i].used && rt_thread_stats(threads[i].tid, &wait_ns, &involuntary))
+        {
+            RT_PRINT("haystack_thread_runqueue_wait_seconds_total{role=\"%s\",chain=\"%d\",sched=\"%s\",cpus=\"%s\"} %.6f\n",
+                     rt_role_names[threads[i].role], threads[i].chain, threads[i].sched, threads[i].cpus, wait_ns / 1e9);
+        }
+    }
+    RT_PRINT("# HELP haystack_thread_involuntary_switches_total Times the thread was preempted.\n"
+             "# TYPE haystack_thread_involuntary_switches_total counter\n");
+    for (int i = 0; i < GS_RT_MAX_THREADS; i++)
+    {
+        uint64_t wait_ns, involuntary;
+        if (threads[i].used && rt_thread_stats(threads[i].tid, &wait_ns, &involuntary))
+        {
+            RT_PRINT("haystack_thread_involuntary_switches_total{role=\"%s\",chain=\"%d\",sched=\"%s\",cpus=\"%s\"} %llu\n",
+                     rt_role_names[threads[i].role], threads[i].chain, threads[i].sched, threads[i].cpus, (unsigned long long)involuntary);
+        }
+    }
+#undef RT_PRINT
+    return off;
+}
+
+void gs_rt_report()
+{
+    rt_thread_t threads[GS_RT_MAX_THREADS];
+    pthread_mutex_lock(&rt_lock);
+    memcpy(threads, rt_threads, sizeof(threads));
+    pthread_mutex_unlock(&rt_lock);
+
+    for (int i = 0; i < GS_RT_MAX_THREADS; i++)
+    {
+        uint64_t wait_ns = 0, involuntary = 0;
+        if (!threads[i].used)
+        {
+            continue;
+        }
+        rt_thread_stats(threads[i].tid, &wait_ns, &involuntary);
+        dbprintlf(BLUE_FG "Thread %-8s chain %d tid %d: %s on CPUs %s, %.3f ms waiting for a CPU, %llu preemptions.",
+                  rt_role_names[threads[i].role], threads[i].chain, threads[i].tid, threads[i].sched, threads[i].cpus,
+                  wait_ns / 1e6, (unsigned long long)involuntary);
+    }
+
+    if (rt_probe_running)
+    {
+        // Too large for the stack; reports come from one thread at a time.
+        static gs_metrics_snapshot_t snap;
+        gs_metrics_snapshot(&snap);
+        const gs_hist_snapshot_t *hist = &snap.hist[GS_HIST_SCHED_WAKEUP];
+        dbprintlf(BLUE_FG "Wakeup latency over %llu probes: p50 %llu us, p99 %llu us, p99.9 %llu us, max %llu us.",
+                  (unsigned long long)hist->count, (unsigned long long)gs_metrics_quantile(hist, 0.5) / 1000,
+                  (unsigned long long)gs_metrics_quantile(hist, 0.99) / 1000, (unsigned long long)gs_metrics_quantile(hist, 0.999) / 1000,
+                  (unsigned long long)hist->max_ns / 1000);
+    }
+}
+
+void gs_rt_destroy()
+{
+    if (rt_probe_running)
+    {
+        rt_probe_running = false;
+        pthread_join(rt_probe_tid, NULL);
+    }
+}
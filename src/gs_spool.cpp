@@ -0,0 +1,499 @@
+/**
+ * @file gs_spool.cpp
+ * @brief On-disk store-and-forward ring for DATA frames the server could not take.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "gs_spool.hpp"
+#include "gs_config.hpp"
+#include "gs_metrics.hpp"
+#include "meb_debug.hpp"
+
+void gs_spool_config_load(gs_spool_config_t *config, int chain, int num_chains)
+{
+    config->enabled = gs_chain_env_int(chain, "SPOOL", 1) != 0;
+    const char *dir = gs_chain_env_str(chain, "SPOOL_DIR", GS_SPOOL_DEFAULT_DIR);
+    if (num_chains > 1)
+    {
+        snprintf(config->path, sizeof(config->path), "%s/haystack_ch%d.spool", dir, chain);
+    }
+    else
+    {
+        snprintf(config->path, sizeof(config->path), "%s/haystack.spool", dir);
+    }
+    int64_t mb = gs_chain_env_int(chain, "SPOOL_MB", GS_SPOOL_DEFAULT_MB);
+    config->capacity = (uint64_t)(mb < 1 ? 1 : mb) << 20;
+    config->chain = chain;
+}
+
+static int spool_pwrite(int fd, const void *buf, size_t len, off_t off)
+{
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t ret = pwrite(fd, (const uint8_t *)buf + done, len - done, off + done);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        done += ret;
+    }
+    return 1;
+}
+
+/**
+ * @brief Reads up to len bytes, fewer only at the end of the file (the ring past a pad record may never have been written).
+ *
+ */
+static ssize_t spool_pread(int fd, void *buf, size_t len, off_t off)
+{
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t ret = pread(fd, (uint8_t *)buf + done, len - done, off + done);
+        if (ret < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ret < 0)
+        {
+            return -1;
+        }
+        if (ret == 0)
+        {
+            break;
+        }
+        done += ret;
+    }
+    return done;
+}
+
+static void spool_error(gs_spool_t *spool)
+{
+    spool->errors++;
+    gs_metric_add(GS_CTR_SPOOL_ERRORS, 1);
+    erprintlf(errno);
+}
+
+/**
+ * @brief Records head and the on-disk tail. Only called once the records up to flushed are on disk.
+ *
+ */
+static void spool_write_header(gs_spool_t *spool)
+{
+    gs_spool_header_t header;
+    memset(&header, 0x0, sizeof(header));
+    header.magic = GS_SPOOL_MAGIC;
+    header.version = GS_SPOOL_VERSION;
+    header.capacity = spool->capacity;
+    header.head = spool->head;
+    header.tail = spool->flushed;
+    header.records = spool->records - spool->stage_records;
+    if (spool_pwrite(spool->fd, &header, sizeof(header), 0) < 0)
+    {
+        spool_error(spool);
+    }
+}
+
+static void spool_update_depth(gs_spool_t *spool)
+{
+    spool->depth_bytes = spool->tail - spool->head;
+    spool->depth_frames = spool->records;
+}
+
+static void spool_rate_update(gs_spool_t *spool, uint64_t now)
+{
+    uint64_t elapsed = now - spool->window_start_ns;
+    if (elapsed >= 1000000000ULL)
+    {
+        spool->drain_rate = spool->window_bytes * 1000000000ULL / elapsed;
+        spool->window_start_ns = now;
+        spool->window_bytes = 0;
+    }
+}
+
+/**
+ * @brief Writes the staged records at flushed, syncs them, then moves the header's tail past them.
+ *
+ * The stage never crosses the end of the ring: gs_spool_append(...) flushes
+ * before every wrap.
+ *
+ */
+static int spool_flush(gs_spool_t *spool)
+{
+    if (spool->stage_len == 0)
+    {
+        return 1;
+    }
+
+    off_t off = GS_SPOOL_HEADER_SIZE + spool->flushed % spool->capacity;
+    if (spool_pwrite(spool->fd, spool->stage, spool->stage_len, off) < 0 || fdatasync(spool->fd) < 0)
+    {
+        dbprintlf(RED_FG "Chain %d lost %llu spooled frames writing %s.", spool->config.chain, (unsigned long long)spool->stage_records, spool->config.path);
+        spool_error(spool);
+        spool->dropped += spool->stage_records;
+        gs_metric_add(GS_CTR_SPOOL_DROPPED, spool->stage_records);
+        spool->records -= spool->stage_records;
+        spool->tail = spool->flushed;
+        spool->stage_len = 0;
+        spool->stage_records = 0;
+        spool_update_depth(spool);
+        return -1;
+    }
+
+    spool->flushed = spool->tail;
+    spool->stage_len = 0;
+    spool->stage_records = 0;
+    spool_write_header(spool);
+    return 1;
+}
+
+int gs_spool_init(gs_spool_t *spool, const gs_spool_config_t *config)
+{
+    spool->config = *config;
+    spool->fd = -1;
+    spool->capacity = config->capacity;
+    spool->head = 0;
+    spool->tail = 0;
+    spool->flushed = 0;
+    spool->records = 0;
+    spool->stage = NULL;
+    spool->stage_len = 0;
+    spool->stage_records = 0;
+    spool->read_buf = NULL;
+    spool->full = false;
+    spool->draining = false;
+    spool->window_start_ns = gs_metrics_now_ns();
+    spool->window_bytes = 0;
+    spool->depth_bytes = 0;
+    spool->depth_frames = 0;
+    spool->drain_rate = 0;
+    spool->spooled = 0;
+    spool->drained = 0;
+    spool->dropped = 0;
+    spool->errors = 0;
+
+    if (!config->enabled)
+    {
+        return 0;
+    }
+
+    spool->stage = (uint8_t *)malloc(GS_SPOOL_STAGE_SIZE);
+    spool->read_buf = (uint8_t *)malloc(GS_SPOOL_READ_SIZE);
+    spool->fd = open(config->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (spool->stage == NULL || spool->read_buf == NULL || spool->fd < 0)
+    {
+        dbprintlf(RED_FG "Could not open the chain %d spool %s.", config->chain, config->path);
+        erprintlf(errno);
+        gs_spool_destroy(spool);
+        return -1;
+    }
+
+    gs_spool_header_t header;
+    memset(&header, 0x0, sizeof(header));
+    ssize_t len = pread(spool->fd, &header, sizeof(header), 0);
+    if (len == (ssize_t)sizeof(header) && header.magic == GS_SPOOL_MAGIC && header.version == GS_SPOOL_VERSION &&
+        header.capacity >= GS_SPOOL_STAGE_SIZE && header.head <= header.tail && header.tail - header.head <= header.capacity)
+    {
+        // A backlog keeps the ring as it was written, whatever HAYSTACK_SPOOL_MB now says.
+        if (header.records > 0)
+        {
+            if (header.capacity != config->capacity)
+            {
+                dbprintlf(YELLOW_FG "Spool %s is %llu MB, not resizing it while it holds a backlog.", config->path, (unsigned long long)(header.capacity >> 20));
+            }
+            spool->capacity = header.capacity;
+            spool->head = header.head;
+            spool->tail = header.tail;
+            spool->records = header.records;
+            dbprintlf(YELLOW_FG "Chain %d spool holds %llu frames (%.1f MB) from an earlier run.", config->chain,
+                      (unsigned long long)spool->records, (spool->tail - spool->head) / 1e6);
+        }
+    }
+    else if (len > 0)
+    {
+        dbprintlf(YELLOW_FG "%s is not a spool this version can read; starting it afresh.", config->path);
+    }
+    spool->flushed = spool->tail;
+    spool_write_header(spool);
+    spool_update_depth(spool);
+
+    dbprintlf(GREEN_FG "Chain %d spooling unsent frames to %s (%llu MB).", config->chain, config->path, (unsigned long long)(spool->capacity >> 20));
+    return 1;
+}
+
+int gs_spool_append(gs_spool_t *spool, const struct iovec *payload, int iovcnt)
+{
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        len += payload[i].iov_len;
+    }
+    size_t need = sizeof(gs_spool_record_t) + len;
+    spool_rate_update(spool, gs_metrics_now_ns());
+
+    uint64_t rem = spool->capacity - spool->tail % spool->capacity;
+    uint64_t gap = rem < need ? rem : 0;
+    if (spool->fd < 0 || need > GS_SPOOL_STAGE_SIZE || spool->tail + gap + need - spool->head > spool->capacity)
+    {
+        if (spool->fd >= 0 && !spool->full)
+        {
+            dbprintlf(RED_FG "Chain %d spool is full; dropping frames until the server takes some.", spool->config.chain);
+            spool->full = true;
+        }
+        spool->dropped++;
+        gs_metric_add(GS_CTR_SPOOL_DROPPED, 1);
+        return -1;
+    }
+
+    if ((gap > 0 || spool->stage_len + need > GS_SPOOL_STAGE_SIZE) && spool_flush(spool) < 0)
+    {
+        spool->dropped++;
+        gs_metric_add(GS_CTR_SPOOL_DROPPED, 1);
+        return -1;
+    }
+    if (gap > 0)
+    {
+        if (gap >= sizeof(gs_spool_record_t))
+        {
+            gs_spool_record_t pad = {GS_SPOOL_PAD_MAGIC, 0};
+            if (spool_pwrite(spool->fd, &pad, sizeof(pad), GS_SPOOL_HEADER_SIZE + spool->tail % spool->capacity) < 0)
+            {
+                spool_error(spool);
+            }
+        }
+        spool->tail += gap;
+        spool->flushed = spool->tail;
+    }
+
+    gs_spool_record_t record = {GS_SPOOL_RECORD_MAGIC, (uint32_t)len};
+    memcpy(spool->stage + spool->stage_len, &record, sizeof(record));
+    spool->stage_len += sizeof(record);
+    for (int i = 0; i < iovcnt; i++)
+    {
+        memcpy(spool->stage + spool->stage_len, payload[i].iov_base, payload[i].iov_len);
+        spool->stage_len += payload[i].iov_len;
+    }
+    spool->tail += need;
+    spool->records++;
+    spool->stage_records++;
+    spool->spooled++;
+    spool_update_depth(spool);
+    gs_metric_add(GS_CTR_SPOOL_FRAMES, 1);
+    gs_metric_add(GS_CTR_SPOOL_BYTES, len);
+    return 1;
+}
+
+void gs_spool_flush(gs_spool_t *spool)
+{
+    spool_rate_update(spool, gs_metrics_now_ns());
+    if (spool->fd >= 0)
+    {
+        spool_flush(spool);
+    }
+}
+
+/**
+ * @brief Sends count frames and moves head past them (and the consumed bytes).
+ *
+ */
+static int spool_send(gs_spool_t *spool, NetData *network_data, const struct iovec *iov, int count, uint64_t consumed)
+{
+    if (count == 0)
+    {
+        spool->head += consumed;
+        return 1;
+    }
+    if (gs_netframe_send_batch(network_data, NetType::DATA, NetVertex::CLIENT, iov, count) < 0)
+    {
+        return -1;
+    }
+    uint64_t bytes = 0;
+    for (int i = 0; i < count; i++)
+    {
+        bytes += iov[i].iov_len;
+    }
+    spool->head += consumed;
+    spool->records -= count;
+    spool->full = false;
+    spool->drained += bytes;
+    spool->window_bytes += bytes;
+    gs_metric_add(GS_CTR_SPOOL_DRAINED_FRAMES, count);
+    gs_metric_add(GS_CTR_SPOOL_DRAINED_BYTES, bytes);
+    return 1;
+}
+
+/**
+ * @brief Gives up on a backlog that cannot be read back, so it does not hold up new frames.
+ *
+ */
+static void spool_discard(gs_spool_t *spool)
+{
+    spool->dropped += spool->records;
+    gs_metric_add(GS_CTR_SPOOL_DROPPED, spool->records);
+    spool->records = 0;
+    spool->head = spool->tail;
+}
+
+int gs_spool_drain(gs_spool_t *spool, NetData *network_data, gs_stage_t *live)
+{
+    if (spool->fd < 0 || spool->records == 0)
+    {
+        return 0;
+    }
+    spool_flush(spool);
+
+    uint64_t now = gs_metrics_now_ns();
+    if (!spool->draining)
+    {
+        spool->draining = true;
+        spool->drain_start_ns = now;
+        spool->drain_start_bytes = spool->drained;
+        dbprintlf(GREEN_FG "Chain %d sending %llu spooled frames (%.1f MB).", spool->config.chain,
+                  (unsigned long long)spool->records, (spool->tail - spool->head) / 1e6);
+    }
+
+    uint64_t pos = spool->head % spool->capacity;
+    uint64_t rem = spool->capacity - pos;
+    size_t len = GS_SPOOL_READ_SIZE;
+    len = rem < len ? rem : len;
+    len = spool->tail - spool->head < len ? spool->tail - spool->head : len;
+
+    int sent = 0;
+    int ret = 0;
+    ssize_t got = 0;
+    if (len == 0)
+    {
+        spool_discard(spool); // A header counting records that are not there.
+    }
+    else if (rem < sizeof(gs_spool_record_t))
+    {
+        spool->head += rem;
+    }
+    else if ((got = spool_pread(spool->fd, spool->read_buf, len, GS_SPOOL_HEADER_SIZE + pos)) < (ssize_t)sizeof(gs_spool_record_t))
+    {
+        dbprintlf(RED_FG "Chain %d could not read its spool; dropping %llu frames.", spool->config.chain, (unsigned long long)spool->records);
+        spool_error(spool);
+        spool_discard(spool);
+    }
+    else
+    {
+        struct iovec iov[GS_NETFRAME_MAX_BATCH];
+        int count = 0;
+        size_t off = 0;
+        size_t batch_start = 0;
+        len = got;
+        while (off + sizeof(gs_spool_record_t) <= len)
+        {
+            gs_spool_record_t record;
+            memcpy(&record, spool->read_buf + off, sizeof(record));
+            if (record.magic == GS_SPOOL_PAD_MAGIC)
+            {
+                // Nothing more before the end of the ring.
+                off = rem;
+                break;
+            }
+            if (record.magic != GS_SPOOL_RECORD_MAGIC || sizeof(record) + record.length > GS_SPOOL_STAGE_SIZE)
+            {
+                dbprintlf(RED_FG "Chain %d spool is corrupt at %llu; dropping %llu frames.", spool->config.chain,
+                          (unsigned long long)(spool->head + off), (unsigned long long)spool->records);
+                errno = EILSEQ;
+                spool_error(spool);
+                count = 0;
+                spool_discard(spool);
+                break;
+            }
+            if (off + sizeof(record) + record.length > len)
+            {
+                break; // Read from here next time.
+            }
+            iov[count].iov_base = spool->read_buf + off + sizeof(record);
+            iov[count].iov_len = record.length;
+            count++;
+            off += sizeof(record) + record.length;
+
+            if (count == GS_NETFRAME_MAX_BATCH)
+            {
+                if (spool_send(spool, network_data, iov, count, off - batch_start) < 0)
+                {
+                    count = 0;
+                    ret = -1;
+                    break;
+                }
+                sent += count;
+                count = 0;
+                batch_start = off;
+                if (gs_stage_occupancy(live) > 0)
+                {
+                    break;
+                }
+            }
+        }
+        if (ret == 0 && spool->records > 0)
+        {
+            if (spool_send(spool, network_data, iov, count, off - batch_start) < 0)
+            {
+                ret = -1;
+            }
+            else
+            {
+                sent += count;
+            }
+        }
+    }
+
+    if (spool->records == 0)
+    {
+        spool->head = spool->tail;
+    }
+    spool_write_header(spool);
+    spool_update_depth(spool);
+    spool_rate_update(spool, gs_metrics_now_ns());
+
+    if (spool->records == 0 && spool->draining)
+    {
+        spool->draining = false;
+        double sec = (gs_metrics_now_ns() - spool->drain_start_ns) / 1e9;
+        double mb = (spool->drained - spool->drain_start_bytes) / 1e6;
+        dbprintlf(GREEN_FG "Chain %d spool drained: %.1f MB in %.1f s (%.1f MB/s).", spool->config.chain, mb, sec, sec > 0 ? mb / sec : 0);
+    }
+    return ret < 0 ? ret : sent;
+}
+
+void gs_spool_destroy(gs_spool_t *spool)
+{
+    if (spool->fd >= 0)
+    {
+        spool_flush(spool);
+        spool_write_header(spool);
+        if (fdatasync(spool->fd) < 0)
+        {
+            spool_error(spool);
+        }
+        if (spool->records > 0)
+        {
+            dbprintlf(YELLOW_FG "Chain %d left %llu frames (%.1f MB) in %s for the next run.", spool->config.chain,
+                      (unsigned long long)spool->records, (spool->tail - spool->head) / 1e6, spool->config.path);
+        }
+        close(spool->fd);
+        spool->fd = -1;
+    }
+    free(spool->stage);
+    spool->stage = NULL;
+    free(spool->read_buf);
+    spool->read_buf = NULL;
+}
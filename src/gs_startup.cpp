@@ -0,0 +1,311 @@
+/**
+ * @file gs_startup.cpp
+ * @brief Brings up the server connection and every chain's RX modem, radio and PLL at once.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gs_startup.hpp"
+#include "gs_haystack.hpp"
+#include "gs_config.hpp"
+#include "gs_metrics.hpp"
+#include "meb_debug.hpp"
+
+static const char *startup_part_names[GS_STARTUP_NUM_PARTS] = {"server", "RX modem", "radio", "PLL"};
+
+void gs_backoff_init(gs_backoff_t *backoff, uint32_t seed)
+{
+    backoff->min_ms = gs_env_int("HAYSTACK_RETRY_MIN_MS", GS_BACKOFF_DEFAULT_MIN_MS);
+    backoff->max_ms = gs_env_int("HAYSTACK_RETRY_MAX_MS", GS_BACKOFF_DEFAULT_MAX_MS);
+    if (backoff->min_ms < 1)
+    {
+        backoff->min_ms = 1;
+    }
+    if (backoff->max_ms < backoff->min_ms)
+    {
+        backoff->max_ms = backoff->min_ms;
+    }
+    backoff->attempts = 0;
+    backoff->rng = seed != 0 ? seed : 1;
+}
+
+int gs_backoff_next_ms(gs_backoff_t *backoff)
+{
+    int64_t ms = backoff->max_ms;
+    if (backoff->attempts < 31)
+    {
+        ms = (int64_t)backoff->min_ms << backoff->attempts;
+        if (ms > backoff->max_ms)
+        {
+            ms = backoff->max_ms;
+        }
+    }
+    backoff->attempts++;
+
+    // xorshift32
+    uint32_t x = backoff->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    backoff->rng = x;
+    return ms - (int64_t)(x % (ms / 2 + 1));
+}
+
+static gs_startup_task_t *startup_task(gs_startup_t *startup, gs_startup_part_t part, int chain)
+{
+    if (part == GS_STARTUP_SERVER)
+    {
+        return &startup->task[0];
+    }
+    return &startup->task[1 + chain * (GS_STARTUP_NUM_PARTS - 1) + part - 1];
+}
+
+/**
+ * @brief One attempt at bringing up a task's part.
+ *
+ */
+static int startup_attempt(gs_startup_task_t *task)
+{
+    gs_chain_t *chain = task->chain;
+    switch (task->part)
+    {
+    case GS_STARTUP_MODEM:
+        if (chain->backend->rx_init(chain) < 0)
+        {
+            return -1;
+        }
+        chain->rx_modem_ready = true;
+        return 1;
+    case GS_STARTUP_RADIO:
+        if (chain->backend->radio_init(chain) < 0)
+        {
+            return -1;
+        }
+        chain->radio_ready = true;
+        return 1;
+    case GS_STARTUP_PLL:
+        if (chain->backend->pll_init(chain) < 0 || chain->backend->pll_set_rx(chain) < 0)
+        {
+            return -1;
+        }
+        chain->PLL_ready = true;
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+static void *startup_thread(void *args)
+{
+    gs_startup_task_t *task = (gs_startup_task_t *)args;
+    gs_startup_t *startup = task->startup;
+    gs_chain_t *chain = task->chain;
+    gs_backoff_t backoff;
+    gs_backoff_init(&backoff, (uint32_t)startup->start_ns ^ (uint32_t)(task - startup->task) * 0x9e3779b9);
+    int attempts = 0;
+
+    while (true)
+    {
+        attempts++;
+        if (startup_attempt(task) >= 0)
+        {
+            gs_startup_ready(startup, task->part, chain->index, attempts);
+            pthread_mutex_lock(&startup->lock);
+            task->busy = false;
+            pthread_mutex_unlock(&startup->lock);
+            gs_status_kick(chain->status);
+            return NULL;
+        }
+
+        int ms = gs_backoff_next_ms(&backoff);
+        dbprintlf(RED_FG "Chain %d %s initialization failed (attempt %d), retrying in %d ms.", chain->index, startup_part_names[task->part], attempts, ms);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += ms / 1000;
+        deadline.tv_nsec += (ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&startup->lock);
+        while (startup->running && pthread_cond_timedwait(&startup->cond, &startup->lock, &deadline) == 0)
+        {
+        }
+        bool running = startup->running;
+        if (!running)
+        {
+            task->attempts = attempts;
+            task->busy = false;
+        }
+        pthread_mutex_unlock(&startup->lock);
+        if (!running)
+        {
+            return NULL;
+        }
+    }
+}
+
+int gs_startup_start(gs_startup_t *startup, global_data_t *global, uint64_t start_ns)
+{
+    startup->start_ns = start_ns;
+    startup->num_tasks = 1 + global->num_chains * (GS_STARTUP_NUM_PARTS - 1);
+    startup->pending = 0;
+    startup->running = true;
+    pthread_mutex_init(&startup->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&startup->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    bool pll = gs_env_int("HAYSTACK_STARTUP_PLL", 1) != 0;
+    for (int i = 0; i < startup->num_tasks; i++)
+    {
+        gs_startup_task_t *task = &startup->task[i];
+        task->startup = startup;
+        task->part = i == 0 ? GS_STARTUP_SERVER : (gs_startup_part_t)(1 + (i - 1) % (GS_STARTUP_NUM_PARTS - 1));
+        task->chain = i == 0 ? NULL : &global->chain[(i - 1) / (GS_STARTUP_NUM_PARTS - 1)];
+        task->wanted = task->part != GS_STARTUP_PLL || pll;
+        task->started = false;
+        task->busy = false;
+        task->ready = false;
+        task->ready_ns = 0;
+        task->attempts = 0;
+        startup->pending += task->wanted;
+    }
+
+    // Short-lived, so plain threads rather than a gs_rt role.
+    for (int i = 1; i < startup->num_tasks; i++)
+    {
+        gs_startup_task_t *task = &startup->task[i];
+        if (!task->wanted)
+        {
+            continue;
+        }
+        task->busy = true;
+        int err = pthread_create(&task->tid, NULL, startup_thread, task);
+        if (err != 0)
+        {
+            dbprintlf(RED_FG "Could not start the chain %d %s initialization worker.", task->chain->index, startup_part_names[task->part]);
+            erprintlf(err);
+            task->busy = false;
+            return -1;
+        }
+        task->started = true;
+    }
+    return 1;
+}
+
+void gs_startup_ready(gs_startup_t *startup, gs_startup_part_t part, int chain, int attempts)
+{
+    gs_startup_task_t *task = startup_task(startup, part, chain);
+    pthread_mutex_lock(&startup->lock);
+    if (task->ready)
+    {
+        pthread_mutex_unlock(&startup->lock);
+        return;
+    }
+    task->ready_ns = gs_metrics_now_ns() - startup->start_ns;
+    task->attempts = attempts;
+    task->ready = true;
+    bool all = task->wanted && --startup->pending == 0;
+    pthread_mutex_unlock(&startup->lock);
+
+    if (part == GS_STARTUP_SERVER)
+    {
+        dbprintlf(GREEN_FG "Server connection ready %.3f s after start (%d attempt(s)).", task->ready_ns / 1e9, attempts);
+    }
+    else
+    {
+        dbprintlf(GREEN_FG "Chain %d %s ready %.3f s after start (%d attempt(s)).", chain, startup_part_names[part], task->ready_ns / 1e9, attempts);
+    }
+    if (!all)
+    {
+        return;
+    }
+
+    // Every task is ready and stays so; nothing below changes under us.
+    uint64_t slowest = 0;
+    for (int i = 0; i < startup->num_tasks; i++)
+    {
+        const gs_startup_task_t *t = &startup->task[i];
+        if (t->wanted && t->ready_ns > slowest)
+        {
+            slowest = t->ready_ns;
+        }
+    }
+    dbprintlf(GREEN_FG "Ready for a pass %.3f s after start.", slowest / 1e9);
+
+    // One line for the server and one per chain, each well inside a log slot.
+    for (int i = 0; i < startup->num_tasks;)
+    {
+        const gs_chain_t *owner = startup->task[i].chain;
+        char line[128];
+        int len = 0;
+        for (; i < startup->num_tasks && startup->task[i].chain == owner; i++)
+        {
+            const gs_startup_task_t *t = &startup->task[i];
+            if (!t->wanted || len >= (int)sizeof(line))
+            {
+                continue;
+            }
+            len += snprintf(line + len, sizeof(line) - len, "%s%s %.3f s (%d)", len > 0 ? ", " : "", startup_part_names[t->part], t->ready_ns / 1e9, t->attempts);
+        }
+        if (len == 0)
+        {
+            continue;
+        }
+        if (owner == NULL)
+        {
+            dbprintlf(GREEN_FG "  %s.", line);
+        }
+        else
+        {
+            dbprintlf(GREEN_FG "  ch%d: %s.", owner->index, line);
+        }
+    }
+}
+
+bool gs_startup_busy(gs_startup_t *startup, gs_startup_part_t part, int chain)
+{
+    if (startup->num_tasks == 0)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&startup->lock);
+    bool busy = startup_task(startup, part, chain)->busy;
+    pthread_mutex_unlock(&startup->lock);
+    return busy;
+}
+
+void gs_startup_stop(gs_startup_t *startup)
+{
+    if (startup->num_tasks == 0)
+    {
+        return;
+    }
+    pthread_mutex_lock(&startup->lock);
+    startup->running = false;
+    pthread_cond_broadcast(&startup->cond);
+    pthread_mutex_unlock(&startup->lock);
+
+    for (int i = 0; i < startup->num_tasks; i++)
+    {
+        if (startup->task[i].started)
+        {
+            pthread_join(startup->task[i].tid, NULL);
+            startup->task[i].started = false;
+        }
+    }
+    pthread_cond_destroy(&startup->cond);
+    pthread_mutex_destroy(&startup->lock);
+    startup->num_tasks = 0;
+}
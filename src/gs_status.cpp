@@ -0,0 +1,185 @@
+/**
+ * @file gs_status.cpp
+ * @brief Cached radio status for the network reactor's status frames.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "gs_status.hpp"
+#include "gs_haystack.hpp"
+#include "gs_config.hpp"
+#include "gs_metrics.hpp"
+#include "meb_debug.hpp"
+
+int gs_status_init(gs_status_cache_t *cache)
+{
+    cache->kick_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (cache->kick_fd < 0 || pthread_mutex_init(&cache->lock, NULL) != 0)
+    {
+        dbprintlf(RED_FG "Failed to set up the status cache.");
+        return -1;
+    }
+
+    cache->stale = GS_STATUS_STABLE;
+    memset(&cache->attrs, 0x0, sizeof(cache->attrs));
+    cache->keepalive_sec = gs_env_int("HAYSTACK_STATUS_KEEPALIVE_SEC", GS_STATUS_DEFAULT_KEEPALIVE_SEC);
+    cache->rssi_deadband = gs_env_double("HAYSTACK_STATUS_RSSI_DB", GS_STATUS_DEFAULT_RSSI_DB);
+    cache->temp_deadband = gs_env_int("HAYSTACK_STATUS_TEMP_MC", GS_STATUS_DEFAULT_TEMP_MC);
+    cache->gain_deadband = gs_env_double("HAYSTACK_STATUS_GAIN_DB", GS_STATUS_DEFAULT_GAIN_DB);
+    return 1;
+}
+
+void gs_status_invalidate(gs_status_cache_t *cache, uint32_t fields)
+{
+    pthread_mutex_lock(&cache->lock);
+    cache->stale |= fields;
+    pthread_mutex_unlock(&cache->lock);
+
+    uint64_t one = 1;
+    if (write(cache->kick_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    {
+        erprintlf(errno);
+    }
+}
+
+void gs_status_kick(gs_status_cache_t *cache)
+{
+    gs_status_invalidate(cache, 0);
+}
+
+bool gs_status_take_kick(gs_status_cache_t *cache)
+{
+    uint64_t count = 0;
+    return read(cache->kick_fd, &count, sizeof(count)) == sizeof(count) && count > 0;
+}
+
+static int status_parse_mode(const char *mode)
+{
+    if (strcmp(mode, "sleep") == 0)
+    {
+        return 0;
+    }
+    else if (strcmp(mode, "fdd") == 0)
+    {
+        return 1;
+    }
+    else if (strcmp(mode, "tdd") == 0)
+    {
+        return 2;
+    }
+    return -1;
+}
+
+void gs_status_refresh(gs_chain_t *chain, phy_status_t *status)
+{
+    gs_status_cache_t *cache = chain->status;
+    const gs_backend_t *backend = chain->backend;
+
+    pthread_mutex_lock(&cache->lock);
+    uint32_t stale = cache->stale;
+    cache->stale = 0;
+    pthread_mutex_unlock(&cache->lock);
+
+    // Reads happen outside the lock; anything invalidated meanwhile is picked up next time.
+    gs_radio_attrs_t attrs = cache->attrs;
+    uint32_t want = stale | GS_STATUS_VOLATILE;
+    uint64_t start = gs_metrics_now_ns();
+    int ret = backend->radio_read_attrs(chain, &attrs, want);
+    gs_metric_time(GS_HIST_STATUS_READ, gs_metrics_now_ns() - start);
+    uint32_t done = ret < 0 ? 0 : ret;
+    gs_metric_add(GS_CTR_STATUS_READS, 1);
+    if (want & ~done)
+    {
+        gs_metric_add(GS_CTR_STATUS_ERRORS, 1);
+    }
+
+    if (done & GS_RADIO_ENSM_MODE)
+    {
+        memcpy(cache->attrs.ensm_mode, attrs.ensm_mode, sizeof(attrs.ensm_mode));
+    }
+    if (done & GS_RADIO_RX_LO)
+    {
+        cache->attrs.rx_lo = attrs.rx_lo;
+        chain->rx_LO = attrs.rx_lo;
+    }
+    if (done & GS_RADIO_SAMP)
+    {
+        cache->attrs.samp = attrs.samp;
+        chain->rx_samp = attrs.samp;
+    }
+    if (done & GS_RADIO_RX_BW)
+    {
+        cache->attrs.rx_bw = attrs.rx_bw;
+        chain->rx_bw = attrs.rx_bw;
+    }
+    if (done & GS_RADIO_RX_GAINMODE)
+    {
+        memcpy(cache->attrs.rx_gainmode, attrs.rx_gainmode, sizeof(attrs.rx_gainmode));
+    }
+
+    if (stale & ~done)
+    {
+        // Try again on the next refresh rather than caching a bad read.
+        pthread_mutex_lock(&cache->lock);
+        cache->stale |= stale & ~done;
+        pthread_mutex_unlock(&cache->lock);
+    }
+
+    status->mode = status_parse_mode(cache->attrs.ensm_mode);
+    status->LO = cache->attrs.rx_lo;
+    status->samp = cache->attrs.samp;
+    status->bw = cache->attrs.rx_bw;
+    memcpy(status->curr_gainmode, cache->attrs.rx_gainmode, sizeof(status->curr_gainmode));
+    status->curr_gainmode[sizeof(status->curr_gainmode) - 1] = '\0';
+
+    // Volatile.
+    status->gain = attrs.rx_gain;
+    status->rssi = attrs.rssi;
+    status->temp = attrs.temp;
+}
+
+bool gs_status_changed(const gs_status_cache_t *cache, const phy_status_t *last, const phy_status_t *status)
+{
+    if (fabs(status->rssi - last->rssi) >= cache->rssi_deadband ||
+        llabs(status->temp - last->temp) >= cache->temp_deadband ||
+        fabs(status->gain - last->gain) >= cache->gain_deadband)
+    {
+        return true;
+    }
+
+    // Radio settings and state only.
+    return status->mode != last->mode ||
+           status->pll_freq != last->pll_freq ||
+           status->LO != last->LO ||
+           status->samp != last->samp ||
+           status->bw != last->bw ||
+           strncmp(status->ftr_name, last->ftr_name, sizeof(status->ftr_name)) != 0 ||
+           strncmp(status->curr_gainmode, last->curr_gainmode, sizeof(status->curr_gainmode)) != 0 ||
+           status->pll_lock != last->pll_lock ||
+           status->modem_ready != last->modem_ready ||
+           status->PLL_ready != last->PLL_ready ||
+           status->radio_ready != last->radio_ready ||
+           status->rx_armed != last->rx_armed ||
+           status->MTU != last->MTU ||
+           status->config_changed != last->config_changed ||
+           status->config_applied != last->config_applied ||
+           status->config_failed != last->config_failed ||
+           status->config_rolled_back != last->config_rolled_back ||
+           status->config_unknown != last->config_unknown;
+}
+
+void gs_status_destroy(gs_status_cache_t *cache)
+{
+    close(cache->kick_fd);
+    cache->kick_fd = -1;
+    pthread_mutex_destroy(&cache->lock);
+}
@@ -15,9 +15,16 @@
 #include "rxmodem.h"
 #include "meb_debug.hpp"
 #include "gs_haystack.hpp"
+#include "gs_config.hpp"
+#include "gs_netframe.hpp"
+#include "gs_rt.hpp"
+#include "gs_metrics.hpp"
 
 int main(int argc, char **argv)
 {
+    // Time-to-ready is counted from here (see gs_startup.hpp).
+    uint64_t start_ns = gs_metrics_now_ns();
+
     // Ignores broken pipe signal, which is sent to the calling process when writing to a nonexistent socket (
     // see: https://www.linuxquestions.org/questions/programming-9/how-to-detect-broken-pipe-in-c-linux-292898/
     // and
@@ -27,59 +34,128 @@ int main(int argc, char **argv)
     signal(SIGPIPE, SIG_IGN);
 
     // Set up global data.
-    global_data_t global[1] = {0};
+    static global_data_t global[1];
     global->network_data = new NetDataClient(NetPort::HAYSTACK, SERVER_POLL_RATE);
+    global->num_chains = gs_env_int("HAYSTACK_CHAINS", 1);
+    if (global->num_chains < 1 || global->num_chains > GS_MAX_CHAINS)
+    {
+        dbprintlf(FATAL "HAYSTACK_CHAINS must be between 1 and %d.", GS_MAX_CHAINS);
+        return -1;
+    }
+#ifdef GS_BACKEND_SIM
+    const gs_backend_t *backend = &gs_backend_sim;
+#else
+    const gs_backend_t *backend = &gs_backend_hw;
+#endif
+
+    // Recorded captures in place of the RX modem for chains given a path; the rest of the pipeline is unchanged.
+    static gs_backend_t replay_backend[GS_MAX_CHAINS];
+    const gs_backend_t *chain_backend[GS_MAX_CHAINS];
+    for (int i = 0; i < global->num_chains; i++)
+    {
+        chain_backend[i] = backend;
+        gs_replay_config_t replay_config[1];
+        gs_replay_config_load(replay_config, i);
+        if (replay_config->path[0] != '\0')
+        {
+            if (gs_backend_replay_init(&replay_backend[i], backend, replay_config, i) < 0)
+            {
+                dbprintlf(FATAL "Nothing to replay from %s.", replay_config->path);
+                return -1;
+            }
+            chain_backend[i] = &replay_backend[i];
+        }
+        dbprintlf(GREEN_FG "Chain %d uses the %s radio backend.", i, chain_backend[i]->name);
+    }
+
+    gs_netframe_selftest();
+
+    // Before any role thread starts, so each is created with its own settings.
+    gs_rt_init();
+
+    for (int i = 0; i < global->num_chains; i++)
+    {
+        if (gs_chain_init(&global->chain[i], global, i, chain_backend[i]) < 0)
+        {
+            dbprintlf(FATAL "Could not set up receive chain %d.", i);
+            return -1;
+        }
+    }
+
+    // Missing or empty is not fatal; configs naming a filter are then rejected.
+    gs_ftr_registry_load(global->ftr, gs_env_str("HAYSTACK_FTR_DIR", GS_FTR_DEFAULT_DIR));
+
+    for (int i = 0; i < global->num_chains; i++)
+    {
+        gs_chain_t *chain = &global->chain[i];
+        chain->forward_running = true;
+        gs_rt_thread_create(&chain->forward_tid, GS_RT_FORWARD, i, gs_xband_forward_thread, chain);
+    }
+
+    if (gs_reactor_init(global->reactor, global) < 0)
+    {
+        dbprintlf(FATAL "Could not set up the network reactor.");
+        return -1;
+    }
 
-    // Create Ground Station Network thread IDs.
-    pthread_t net_polling_tid, net_rx_tid, xband_rx_tid, xband_status_tid;
+    // The modems, radios and PLLs come up on their own workers while the reactor connects.
+    if (gs_startup_start(global->startup, global, start_ns) < 0)
+    {
+        dbprintlf(FATAL "Could not start bringing up the radios.");
+        return -1;
+    }
+
+    // Create Ground Station Network thread ID.
+    pthread_t net_reactor_tid;
 
-    // Start the RX threads, and restart them should it be necessary.
-    // Only gets-out if a thread declares an unrecoverable emergency and sets its status to -1.
+    // Start the network reactor, and restart it should it be necessary.
+    // Only gets-out if it declares an unrecoverable emergency and sets its status to -1.
     while (global->network_data->thread_status > -1)
     {
         // 1 = All good, 0 = recoverable failure, -1 = fatal failure (close program)
         global->network_data->thread_status = 1;
         global->network_data->recv_active = true;
 
-        // Initialize and begin socket communication to the server.
-        if (!global->network_data->connection_ready)
-        {
-            // TODO: Check if this is the desired functionality.
-            // Currently, the program will not proceed past this point if it cannot connect to the server.
-            // NOTE: Loss of connection to server is regained via gs_polling_thread's constant connection_ready check.
-            while (gs_connect_to_server(global->network_data) != 1)
-            {
-                dbprintlf(RED_FG "Failed to establish connection to server.");
-                usleep(5 SEC);
-            }
-        }
-
-        // Start the threads.
-        pthread_create(&net_polling_tid, NULL, gs_polling_thread, global->network_data);
-        pthread_create(&net_rx_tid, NULL, gs_network_rx_thread, global);
-        // pthread_create(&xband_rx_tid, NULL, gs_xband_rx_thread, global);
-        pthread_create(&xband_status_tid, NULL, xband_status_thread, global);
+        // Connects to the server, and reconnects whenever the connection is lost.
+        gs_rt_thread_create(&net_reactor_tid, GS_RT_NETWORK, -1, gs_network_reactor_thread, global);
 
         void *thread_return;
-        pthread_join(net_polling_tid, &thread_return);
-        pthread_join(net_rx_tid, &thread_return);
-        // pthread_join(xband_rx_tid, &thread_return);
-        pthread_join(xband_status_tid, &thread_return);
+        pthread_join(net_reactor_tid, &thread_return);
 
         dbprintlf(RED_BG "thread_status: %d, recv_active: %d", global->network_data->thread_status, global->network_data->recv_active);
 
         usleep(5 SEC);
-        // Loop will begin again, restarting the threads.
+        // Loop will begin again, restarting the reactor.
     }
 
-    // Shutdown the X-Band radio.
-    rxmodem_stop(global->rx_modem);
-    rxmodem_destroy(global->rx_modem);
-    adf4355_pw_down(global->PLL);
-    adf4355_destroy(global->PLL);
-    adradio_destroy(global->radio);
+    // Shutdown the X-Band radios, once nothing is still bringing them up.
+    gs_startup_stop(global->startup);
+    for (int i = 0; i < global->num_chains; i++)
+    {
+        gs_chain_t *chain = &global->chain[i];
+        // A worker stuck in the modem keeps it.
+        if (gs_xband_rx_exit(chain) >= 0)
+        {
+            chain->backend->rx_destroy(chain);
+        }
+        chain->backend->pll_pw_down(chain);
+        chain->backend->pll_destroy(chain);
+        chain->backend->radio_destroy(chain);
+    }
 
     // Destroy other things.
+    for (int i = 0; i < global->num_chains; i++)
+    {
+        gs_chain_t *chain = &global->chain[i];
+        chain->forward_running = false;
+        gs_stage_wake(chain->forward);
+        pthread_join(chain->forward_tid, NULL);
+        gs_chain_destroy(chain);
+    }
+    gs_rt_report();
+    gs_rt_destroy();
+    gs_reactor_destroy(global->reactor);
+    gs_ftr_registry_destroy(global->ftr);
     close(global->network_data->socket);
 
     int retval = global->network_data->thread_status;
@@ -0,0 +1,337 @@
+/**
+ * @file meb_debug.cpp
+ * @brief Asynchronous backend for the dbprintlf family of macros.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Every logging thread owns a single-producer/single-consumer ring of fixed
+ * size slots. The producer formats straight into a slot and publishes it by
+ * advancing head; the drain thread is the only consumer, and it batches
+ * everything pending into one writev to stderr. Each slot carries a number
+ * from one global counter, and the drain merges the rings by it, so messages
+ * from different threads come out in the order they were logged. Nothing on
+ * the logging path takes a lock or makes a system call. Rings of exited
+ * threads are reused.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <new>
+#include "meb_debug.hpp"
+
+#define MEB_LOG_SLOTS 256 // Per thread, power of two.
+#define MEB_LOG_SLOT_SIZE 256
+#define MEB_LOG_DRAIN_INTERVAL_NS 5000000
+
+typedef struct
+{
+    uint64_t seq; // From meb_log_seq; the drain merges rings by it.
+    uint16_t len;
+    char text[MEB_LOG_SLOT_SIZE - sizeof(uint64_t) - sizeof(uint16_t)];
+} meb_log_slot_t;
+
+typedef struct meb_log_ring_t
+{
+    alignas(64) std::atomic<uint32_t> head; // Written by the owning thread.
+    alignas(64) std::atomic<uint32_t> tail; // Written by the drain thread.
+    std::atomic<uint32_t> dropped;
+    std::atomic<bool> in_use;
+    uint32_t drained; // Drain thread only: next slot to write out.
+    uint32_t limit;   // Drain thread only: head when the drain started.
+    struct meb_log_ring_t *next;
+    meb_log_slot_t slots[MEB_LOG_SLOTS];
+} meb_log_ring_t;
+
+std::atomic<int> meb_log_level(MEB_LOG_DEBUG);
+
+static std::atomic<meb_log_ring_t *> meb_log_rings(nullptr);
+static std::atomic<uint64_t> meb_log_seq(0);
+static pthread_mutex_t meb_log_drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t meb_log_once = PTHREAD_ONCE_INIT;
+static std::atomic<bool> meb_log_async(false);
+
+static void meb_log_drain();
+
+static void *meb_log_thread(void *)
+{
+    struct timespec interval = {0, MEB_LOG_DRAIN_INTERVAL_NS};
+    while (true)
+    {
+        meb_log_drain();
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+static void meb_log_init()
+{
+    const char *level = getenv("HAYSTACK_LOG_LEVEL");
+    if (level != NULL && level[0] >= '0' && level[0] <= '4')
+    {
+        meb_log_level = level[0] - '0';
+    }
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, meb_log_thread, NULL) == 0)
+    {
+        pthread_detach(tid);
+        meb_log_async = true;
+        atexit(meb_log_flush);
+    }
+}
+
+/**
+ * @brief Releases the thread's ring for reuse once the thread exits.
+ *
+ */
+struct meb_log_owner
+{
+    meb_log_ring_t *ring = nullptr;
+    ~meb_log_owner()
+    {
+        if (ring != nullptr)
+        {
+            ring->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+static thread_local meb_log_owner meb_log_this_thread;
+
+static meb_log_ring_t *meb_log_ring()
+{
+    meb_log_ring_t *ring = meb_log_this_thread.ring;
+    if (ring != nullptr)
+    {
+        return ring;
+    }
+
+    // Reuse a ring left behind by an exited thread.
+    for (ring = meb_log_rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+    {
+        bool expected = false;
+        if (ring->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        {
+            meb_log_this_thread.ring = ring;
+            return ring;
+        }
+    }
+
+    ring = (meb_log_ring_t *)aligned_alloc(64, sizeof(meb_log_ring_t));
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+    new (&ring->head) std::atomic<uint32_t>(0);
+    new (&ring->tail) std::atomic<uint32_t>(0);
+    new (&ring->dropped) std::atomic<uint32_t>(0);
+    new (&ring->in_use) std::atomic<bool>(true);
+
+    // Rings are never freed, so a lock-free push is safe.
+    ring->next = meb_log_rings.load(std::memory_order_relaxed);
+    while (!meb_log_rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed))
+        ;
+
+    meb_log_this_thread.ring = ring;
+    return ring;
+}
+
+static void meb_log_emit(int level, const char *file, int line, const char *func, const char *format, va_list args)
+{
+    meb_log_ring_t *ring = NULL;
+    if (level != MEB_LOG_FATAL && meb_log_async.load(std::memory_order_relaxed))
+    {
+        ring = meb_log_ring();
+    }
+
+    if (ring == NULL)
+    {
+        if (level == MEB_LOG_FATAL && meb_log_async.load(std::memory_order_relaxed))
+        {
+            // Keep earlier messages ahead of this one.
+            meb_log_drain();
+        }
+        fprintf(stderr, "[%s:%d | %s] ", file, line, func);
+        vfprintf(stderr, format, args);
+        fflush(stderr);
+        return;
+    }
+
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= MEB_LOG_SLOTS)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    meb_log_slot_t *slot = &ring->slots[head & (MEB_LOG_SLOTS - 1)];
+    slot->seq = meb_log_seq.fetch_add(1, std::memory_order_relaxed);
+    int len = snprintf(slot->text, sizeof(slot->text), "[%s:%d | %s] ", file, line, func);
+    if (len >= 0 && len < (int)sizeof(slot->text))
+    {
+        int ret = vsnprintf(slot->text + len, sizeof(slot->text) - len, format, args);
+        len += ret > 0 ? ret : 0;
+    }
+    if (len >= (int)sizeof(slot->text))
+    {
+        // Truncated; keep the color reset and newline.
+        len = sizeof(slot->text) - 1;
+        memcpy(slot->text + len - 5, "\x1b[0m\n", 5);
+    }
+    slot->len = len > 0 ? len : 0;
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void meb_log_write(int level, const char *file, int line, const char *func, const char *format, ...)
+{
+    pthread_once(&meb_log_once, meb_log_init);
+
+    va_list args;
+    va_start(args, format);
+    meb_log_emit(level, file, line, func, format, args);
+    va_end(args);
+}
+
+static void meb_log_emitf(int level, const char *file, int line, const char *func, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    meb_log_emit(level, file, line, func, format, args);
+    va_end(args);
+}
+
+void meb_log_hexdump(int level, const char *file, int line, const char *func, const void *buf, size_t len)
+{
+    static std::atomic<int64_t> window(0);
+    static std::atomic<int> count(0);
+    static std::atomic<uint32_t> suppressed(0);
+
+    pthread_once(&meb_log_once, meb_log_init);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    int64_t sec = now.tv_sec;
+    int64_t prev = window.load(std::memory_order_relaxed);
+    if (prev != sec && window.compare_exchange_strong(prev, sec))
+    {
+        count = 0;
+    }
+    if (count.fetch_add(1, std::memory_order_relaxed) >= MEB_HEXDUMP_PER_SEC)
+    {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const uint8_t *data = (const uint8_t *)buf;
+    size_t shown = len < MEB_HEXDUMP_MAX_BYTES ? len : MEB_HEXDUMP_MAX_BYTES;
+    meb_log_emitf(level, file, line, func, "%zu bytes (%u dumps suppressed):\x1b[0m\n", len, suppressed.exchange(0));
+    for (size_t off = 0; off < shown; off += 16)
+    {
+        char hex[16 * 3 + 1];
+        size_t n = shown - off < 16 ? shown - off : 16;
+        for (size_t i = 0; i < n; i++)
+        {
+            snprintf(hex + i * 3, 4, "%02x ", data[off + i]);
+        }
+        hex[n * 3] = '\0';
+        meb_log_emitf(level, file, line, func, "%04zx: %s\x1b[0m\n", off, hex);
+    }
+}
+
+void meb_log_set_level(int level)
+{
+    if (level < MEB_LOG_FATAL)
+    {
+        level = MEB_LOG_FATAL;
+    }
+    if (level > MEB_LOG_DEBUG)
+    {
+        level = MEB_LOG_DEBUG;
+    }
+    meb_log_level = level;
+}
+
+static void meb_log_drain()
+{
+    struct iovec iov[64];
+    int iovcnt = 0;
+
+    pthread_mutex_lock(&meb_log_drain_lock);
+    meb_log_ring_t *rings = meb_log_rings.load(std::memory_order_acquire);
+    for (meb_log_ring_t *ring = rings; ring != nullptr; ring = ring->next)
+    {
+        ring->drained = ring->tail.load(std::memory_order_relaxed);
+        ring->limit = ring->head.load(std::memory_order_acquire);
+    }
+
+    while (true)
+    {
+        // Take the oldest pending message across all rings.
+        meb_log_ring_t *next = NULL;
+        meb_log_slot_t *slot = NULL;
+        for (meb_log_ring_t *ring = rings; ring != nullptr; ring = ring->next)
+        {
+            if (ring->drained == ring->limit)
+            {
+                continue;
+            }
+            meb_log_slot_t *candidate = &ring->slots[ring->drained & (MEB_LOG_SLOTS - 1)];
+            if (slot == NULL || candidate->seq < slot->seq)
+            {
+                next = ring;
+                slot = candidate;
+            }
+        }
+
+        if (slot != NULL)
+        {
+            iov[iovcnt].iov_base = slot->text;
+            iov[iovcnt].iov_len = slot->len;
+            iovcnt++;
+            next->drained++;
+        }
+
+        if (iovcnt == 64 || (slot == NULL && iovcnt > 0))
+        {
+            // Slots may be reused as soon as tail moves, so write before releasing them.
+            ssize_t ret = writev(STDERR_FILENO, iov, iovcnt);
+            (void)ret;
+            iovcnt = 0;
+            for (meb_log_ring_t *ring = rings; ring != nullptr; ring = ring->next)
+            {
+                ring->tail.store(ring->drained, std::memory_order_release);
+            }
+        }
+
+        if (slot == NULL)
+        {
+            break;
+        }
+    }
+
+    for (meb_log_ring_t *ring = rings; ring != nullptr; ring = ring->next)
+    {
+        uint32_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            char msg[96];
+            int len = snprintf(msg, sizeof(msg), "\x1b[33m[meb_debug] %u log messages dropped, ring full.\x1b[0m\n", dropped);
+            ssize_t ret = write(STDERR_FILENO, msg, len);
+            (void)ret;
+        }
+    }
+    pthread_mutex_unlock(&meb_log_drain_lock);
+}
+
+void meb_log_flush()
+{
+    meb_log_drain();
+}